@@ -36,6 +36,29 @@ FIRM_API void ir_estimate_execfreq(ir_graph *irg);
 /** Returns execution frequency of block @p block. */
 FIRM_API double get_block_execfreq(const ir_node *block);
 
+/**
+ * Instruments all irgs in the program with profile code.
+ * The final code will have a counter for each basic block which is
+ * incremented in that block. After the program has run the info is written
+ * to @p filename.
+ *
+ * @return the graph initializing the profiling code or NULL
+ */
+FIRM_API ir_graph *ir_profile_instrument(const char *filename);
+
+/**
+ * Reads the profile info file @p filename if it exists.
+ * The blocks are identified by their order in the graphs, so the profile
+ * must be read at the same point of the optimization pipeline at which the
+ * program was instrumented.
+ *
+ * @return true if the profile was read
+ */
+FIRM_API int ir_profile_read(const char *filename);
+
+/** Frees the profile info. */
+FIRM_API void ir_profile_free(void);
+
 /** @} */
 
 #include "end.h"
@@ -85,6 +85,31 @@ FIRM_API ir_node *part_block_edges(ir_node *node);
  */
 FIRM_API void kill_node(ir_node *node);
 
+/**
+ * Splits the control flow edge entering @p block at predecessor position
+ * @p pos by inserting a new block containing only a Jmp.
+ * Consistent dominance, post dominance and loop information are updated
+ * instead of being invalidated.
+ *
+ * @param block  the block whose incoming edge is split
+ * @param pos    the predecessor position of the edge
+ * @return the new block
+ */
+FIRM_API ir_node *split_cf_edge(ir_node *block, int pos);
+
+/**
+ * Replaces the control flow predecessor @p pos of @p block by @p pred.
+ * @p pred may be a Bad to remove the edge. The Phis of @p block are not
+ * touched.
+ * Consistent dominance information is updated incrementally if block out
+ * edges are activated, post dominance and loop information are invalidated.
+ *
+ * @param block  the block whose incoming edge is replaced
+ * @param pos    the predecessor position of the edge
+ * @param pred   the new control flow predecessor
+ */
+FIRM_API void replace_cf_edge(ir_node *block, int pos, ir_node *pred);
+
 /**
  * Creates a copy of the subgraph starting at node @p n.
  * This currently only works for subgraphs containing only arithmetic nodes
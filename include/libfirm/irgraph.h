@@ -397,6 +397,22 @@ typedef enum ir_graph_properties_t {
 	IR_GRAPH_PROPERTY_CONSISTENT_ENTITY_USAGE        = 1U << 11,
 	/** graph contains as many returns as possible */
 	IR_GRAPH_PROPERTY_MANY_RETURNS                   = 1U << 12,
+	/** points-to information (compute_irp_points_to()) is up to date */
+	IR_GRAPH_PROPERTY_CONSISTENT_POINTS_TO           = 1U << 13,
+	/**
+	 * memoized results of get_alias_relation() are up to date. Changing the
+	 * inputs of a node clears this property. The results also depend on the
+	 * disambiguator options, entity usage and points-to information, so code
+	 * changing those without using the corresponding analysis functions has
+	 * to clear this property.
+	 */
+	IR_GRAPH_PROPERTY_CONSISTENT_ALIAS_CACHE         = 1U << 14,
+	/**
+	 * memoized induction variables and trip counts of loops (scalar
+	 * evolution) are up to date. This is cleared whenever the loop tree is
+	 * rebuilt or freed and whenever node inputs change.
+	 */
+	IR_GRAPH_PROPERTY_CONSISTENT_SCEV                = 1U << 15,
 
 	/**
 	 * List of all graph properties that are only affected by control flow
@@ -421,7 +437,10 @@ typedef enum ir_graph_properties_t {
 		| IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES
 		| IR_GRAPH_PROPERTY_CONSISTENT_OUTS
 		| IR_GRAPH_PROPERTY_CONSISTENT_ENTITY_USAGE
-		| IR_GRAPH_PROPERTY_MANY_RETURNS,
+		| IR_GRAPH_PROPERTY_MANY_RETURNS
+		| IR_GRAPH_PROPERTY_CONSISTENT_POINTS_TO
+		| IR_GRAPH_PROPERTY_CONSISTENT_ALIAS_CACHE
+		| IR_GRAPH_PROPERTY_CONSISTENT_SCEV,
 
 } ir_graph_properties_t;
 ENUM_BITSET(ir_graph_properties_t)
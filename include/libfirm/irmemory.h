@@ -139,6 +139,64 @@ FIRM_API void set_irp_memory_disambiguator_options(ir_disambiguator_options opti
  */
 FIRM_API void mark_private_methods(void);
 
+/** Algorithms for the whole program points-to analysis. */
+typedef enum ir_points_to_algorithm {
+	ir_points_to_steensgaard, /**< unification based, almost linear time */
+	ir_points_to_andersen,    /**< inclusion based, more precise but slower */
+} ir_points_to_algorithm;
+
+/**
+ * Computes which memory objects the pointers of all graphs of the program
+ * may point to. The memory disambiguator uses the result to disambiguate
+ * addresses until free_irp_points_to() is called. The result of a graph
+ * becomes invalid when the graph is changed, which is tracked by
+ * IR_GRAPH_PROPERTY_CONSISTENT_POINTS_TO.
+ *
+ * @param algorithm  the algorithm used to solve the points-to constraints
+ */
+FIRM_API void compute_irp_points_to(ir_points_to_algorithm algorithm);
+
+/**
+ * Computes the points-to information with @p algorithm if there is none or
+ * the result of some graph became invalid.
+ */
+FIRM_API void assure_irp_points_to(ir_points_to_algorithm algorithm);
+
+/** Frees the results of compute_irp_points_to(). */
+FIRM_API void free_irp_points_to(void);
+
+/** Possible memory accesses of a call to some memory. */
+typedef enum ir_mod_ref {
+	ir_mod_ref_none    = 0,      /**< the memory is not accessed */
+	ir_mod_ref_ref     = 1 << 0, /**< the memory may be read */
+	ir_mod_ref_mod     = 1 << 1, /**< the memory may be written */
+	ir_mod_ref_mod_ref = ir_mod_ref_ref | ir_mod_ref_mod,
+} ir_mod_ref;
+ENUM_BITSET(ir_mod_ref)
+
+/**
+ * Computes for all methods of the program which memory they and their
+ * callees may read and write. Accesses through pointers are resolved with
+ * assure_irp_points_to(), whose result is kept. The summaries are used by
+ * get_call_mod_ref() until free_irp_mod_ref() is called. They stay valid as long as
+ * transformations do not add accesses to memory visible outside of a method
+ * and the type of the method entity is not changed.
+ */
+FIRM_API void compute_irp_mod_ref(void);
+
+/** Frees the results of compute_irp_mod_ref(). */
+FIRM_API void free_irp_mod_ref(void);
+
+/**
+ * Determines whether a call may read or write the memory at an address.
+ * Without the results of compute_irp_mod_ref() only the properties of the
+ * called methods are used.
+ *
+ * @param call  the Call node
+ * @param addr  an address in the graph of the call
+ */
+FIRM_API ir_mod_ref get_call_mod_ref(const ir_node *call, const ir_node *addr);
+
 /** @} */
 
 #include "end.h"
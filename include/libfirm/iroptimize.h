@@ -182,6 +182,25 @@ FIRM_API void optimize_load_store(ir_graph *irg);
  */
 FIRM_API void combine_memops(ir_graph *irg);
 
+/**
+ * Superword level parallelism vectorization within general purpose registers.
+ *
+ * Combines isomorphic operations on adjacent memory locations inside a basic
+ * block into operations on the widest integer mode fitting a general purpose
+ * register.  Stores to adjacent addresses are packed together with the Loads,
+ * bitwise operations (And, Or, Eor, Not), truncating Convs and constants
+ * computing their values if a simple cost model predicts fewer instructions.
+ *
+ * No vector registers are used: arithmetic whose lanes may carry into each
+ * other (additions, multiplications, reductions) and floating point operations
+ * are not packed.  Unlike combine_memops(), which merges pairs of Stores of
+ * already combined values, this handles whole chains of memory operations
+ * including the computations between them.
+ *
+ * @param irg  the graph
+ */
+FIRM_API void opt_slp_vectorize(ir_graph *irg);
+
 /**
  * New experimental alternative to optimize_load_store.
  * Based on a dataflow analysis, so load/stores are moved out of loops
@@ -189,6 +208,17 @@ FIRM_API void combine_memops(ir_graph *irg);
  */
 FIRM_API void opt_ldst(ir_graph *irg);
 
+/**
+ * Global dead store elimination for frame entities.
+ *
+ * Removes Stores to non-escaping frame entities which are overwritten on all
+ * paths or never read before the function returns, and shrinks CopyBs and
+ * memset calls writing such entities to the byte range which is read later.
+ *
+ * @param irg  the graph
+ */
+FIRM_API void opt_dead_stores(ir_graph *irg);
+
 /**
  * Optimize the frame type of an irg by removing
  * never touched entities.
@@ -300,6 +330,20 @@ FIRM_API void remove_phi_cycles(ir_graph *irg);
  */
 FIRM_API void proc_cloning(float threshold);
 
+/**
+ * Interprocedural constant propagation. Propagates constants, known bits
+ * and value ranges from the call sites into the parameters of methods of
+ * which all calls are known, and constant results back into the callers.
+ * The facts are available at the parameters via vrp_get_param_info() and
+ * used by constbits, combo and vrp. Constant parameters, arguments and
+ * results are replaced by Consts. Afterwards proc_cloning() specializes
+ * methods called with different constants and the clones are propagated
+ * again.
+ *
+ * @param clone_threshold  the threshold for proc_cloning()
+ */
+FIRM_API void ipcp(float clone_threshold);
+
 /**
  * Reassociation.
  *
@@ -369,6 +413,18 @@ FIRM_API void normalize_n_returns(ir_graph *irg);
  */
 FIRM_API void scalar_replacement_opt(ir_graph *irg);
 
+/**
+ * Converts heap objects which do not escape to frame entities.
+ *
+ * Objects allocated by Alloc nodes or calls of malloc with a small constant
+ * size whose address does not escape the graph, or the callees it is passed
+ * to, are replaced by frame entities and their free calls are removed.
+ * Scalar replacement is performed afterwards.
+ *
+ * @param irg  the graph which should be optimized
+ */
+FIRM_API void opt_heap_to_stack(ir_graph *irg);
+
 /**
  * Optimizes tail-recursion calls by converting them into loops.
  * Depends on the flag opt_tail_recursion.
@@ -385,6 +441,24 @@ FIRM_API void scalar_replacement_opt(ir_graph *irg);
  */
 FIRM_API void opt_tail_rec_irg(ir_graph *irg);
 
+/**
+ * Marks Calls whose results are returned directly by the calling function as
+ * tail calls (see set_Call_tail_call()), so backends may jump to the callee
+ * instead of calling it, reusing the stack frame of the caller.
+ *
+ * Calls are only marked if no address of a local variable escapes, the
+ * calling function is not variadic and neither function has compound
+ * parameters or results.
+ *
+ * The conditions are only checked here, so this has to run at the end of the
+ * optimization pipeline: after inlining, which may add local variables and
+ * Allocs of the inlined functions, and after opt_tail_rec_irg(), which handles
+ * recursive calls better. Calls copied into other graphs lose their mark.
+ *
+ * @param irg   the graph to be analysed
+ */
+FIRM_API void mark_tail_calls(ir_graph *irg);
+
 /**
  * CLiff Click's combo algorithm from
  *   "Combining Analyses, combining Optimizations".
@@ -413,6 +487,43 @@ typedef void (*opt_ptr)(ir_graph *irg);
 FIRM_API void inline_functions(unsigned maxsize, int inline_threshold,
                                opt_ptr after_inline_opt);
 
+/**
+ * Profile guided heuristic inliner. Works like inline_functions(), but
+ * weights the benefice of calls by their execution counts if a profile was
+ * read with ir_profile_read() and never inlines non-trivial functions at
+ * calls which were not executed. The code growth caused by inlining is
+ * limited per method and for the whole program.
+ *
+ * @param maxsize             Do not inline any calls if a method has more than
+ *                            maxsize firm nodes.  It may reach this limit by
+ *                            inlining.
+ * @param inline_threshold    inlining threshold
+ * @param caller_growth       maximum growth of a method in percent of its
+ *                            size before inlining
+ * @param unit_growth         maximum growth of the whole program in percent
+ * @param after_inline_opt    optimizations performed immediately after inlining
+ *                            some calls
+ */
+FIRM_API void inline_functions_profiled(unsigned maxsize, int inline_threshold,
+                                        unsigned caller_growth,
+                                        unsigned unit_growth,
+                                        opt_ptr after_inline_opt);
+
+/**
+ * Partial inliner. Methods which start with a cheap test leading to an early
+ * return are split: the test and the early exit are inlined into all direct
+ * callers, the remainder is moved into a new method which the inlined code
+ * calls. The remainder executes the test again, so the test must not write
+ * memory.
+ *
+ * @param max_stub_size       Do not inline more than max_stub_size firm
+ *                            nodes of a method.
+ * @param after_inline_opt    optimizations performed on the graphs that
+ *                            changed
+ */
+FIRM_API void partial_inline_functions(unsigned max_stub_size,
+                                       opt_ptr after_inline_opt);
+
 /**
  * Combines congruent blocks into one.
  *
@@ -439,6 +550,93 @@ FIRM_API void do_loop_unrolling(ir_graph *irg);
  */
 FIRM_API void do_loop_peeling(ir_graph *irg);
 
+/**
+ * Perform loop unswitching on a given graph.
+ * A loop containing a Cond with a loop invariant selector is duplicated and
+ * the Cond is evaluated once before entering the original loop or its copy,
+ * in which the Cond is replaced by the corresponding jump. Loops are only
+ * unswitched if the execution frequencies promise a benefit and the code
+ * growth stays within a budget.
+ */
+FIRM_API void do_loop_unswitching(ir_graph *irg);
+
+/**
+ * Promotes memory locations stored inside loops to registers.
+ * A location with a loop invariant address, which is not accessed through
+ * other pointers inside the loop, is loaded before the loop and stored on
+ * every exit of the loop. Its Loads and Stores inside the loop are replaced
+ * by the value kept in a register.
+ *
+ * @param irg  the graph
+ */
+FIRM_API void opt_scalar_promotion(ir_graph *irg);
+
+/**
+ * Fuses adjacent innermost counted loops.
+ *
+ * A loop is merged into the loop executed directly before it, if both
+ * execute the same number of iterations, the second loop does not use values
+ * computed by the first one and their memory accesses either do not alias or
+ * access the same address in the same iteration.  This reduces the number of
+ * passes over memory.
+ *
+ * @param irg  the graph
+ */
+FIRM_API void opt_loop_fusion(ir_graph *irg);
+
+/**
+ * Distributes innermost counted loops mixing vectorizable and other Stores.
+ *
+ * The Stores with unit stride, whose values are computed from unit stride
+ * Loads and loop invariant values, are moved into a copy of the loop executed
+ * before the original loop, if no dependence is reversed.  The copy can be
+ * vectorized by opt_loop_vectorize().
+ *
+ * @param irg  the graph
+ */
+FIRM_API void opt_loop_distribution(ir_graph *irg);
+
+/**
+ * Removes and hoists range checks of induction variables in loops.
+ *
+ * A Cond comparing an induction variable plus a constant with a value is
+ * removed if its outcome follows from the range of the induction variable
+ * and the facts known from dominating Conds, Confirms and value range
+ * propagation. Checks which cannot be proven, but fail by leaving the loop
+ * and only depend on values defined outside of it, are replaced by one test
+ * before the loop: the loop is versioned and its original is only entered if
+ * all checks succeed, while the copy keeping the checks is the fallback.
+ *
+ * @param irg  the graph
+ */
+FIRM_API void opt_bounds_checks(ir_graph *irg);
+
+/**
+ * Vectorizes simple innermost counted loops.
+ *
+ * A guarded copy of the loop processes several iterations at once: runtime
+ * checks ensure that the memory ranges accessed do not overlap, memory
+ * operations on adjacent addresses are combined by SLP vectorization and
+ * reductions use one accumulator per lane.  The original loop executes the
+ * remaining iterations.
+ *
+ * @param irg  the graph
+ */
+FIRM_API void opt_loop_vectorize(ir_graph *irg);
+
+/**
+ * Inserts software prefetches for strided Loads in innermost loops.
+ *
+ * The addresses of Loads which change by a constant stride per iteration are
+ * prefetched @p distance bytes (rounded up to whole iterations) ahead. Loops
+ * with a small constant trip count are skipped. Should be run late, as the
+ * prefetch Builtins restrict other memory optimizations.
+ *
+ * @param irg       the graph
+ * @param distance  the number of bytes to prefetch ahead, e.g. 256
+ */
+FIRM_API void opt_prefetch(ir_graph *irg, unsigned distance);
+
 /**
  * Removes all entities which are unused.
  *
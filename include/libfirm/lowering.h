@@ -80,7 +80,9 @@ FIRM_API void lower_CopyB(ir_graph *irg, unsigned max_small_size,
 
 /**
  * Lowers all Switches (Cond nodes with non-boolean mode) depending on spare_size.
- * They will either remain the same or be converted into if-cascades.
+ * They will either remain the same or be converted into if-cascades, which
+ * dispatch between clusters of cases.  Dense clusters keep a jump table,
+ * small sets of cases with few targets are tested with bit masks.
  *
  * @param irg        The ir graph to be lowered.
  * @param small_switch  If switch has <= cases then change it to an if-cascade.
@@ -11,6 +11,8 @@
 #ifndef VRP_H
 #define VRP_H
 
+#include <stddef.h>
+
 #include "firm_types.h"
 #include "begin.h"
 
@@ -72,6 +74,18 @@ FIRM_API ir_relation vrp_cmp(const ir_node *left, const ir_node *right);
  */
 FIRM_API vrp_attr *vrp_get_info(const ir_node *n);
 
+/**
+ * Returns the facts about parameter @p pos of @p irg which hold at all call
+ * sites or NULL if nothing is known. They are computed by ipcp() and stay
+ * valid as long as no calls with other arguments are added and the type of
+ * the method entity is not changed.
+ *
+ * @param irg: the graph
+ * @param pos: the number of the parameter
+ * @return a pointer to the facts or NULL if there are none
+ */
+FIRM_API const vrp_attr *vrp_get_param_info(const ir_graph *irg, size_t pos);
+
 /** @} */
 
 #include "end.h"
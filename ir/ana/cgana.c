@@ -523,6 +523,8 @@ static void callee_ana_proj(ir_node *node, unsigned n, pset *methods)
 		pset_insert_ptr(methods, get_unknown_entity()); /* free method -> unknown */
 		break;
 	}
+	/* release the node, it may be reached from other calls */
+	set_irn_link(node, NULL);
 }
 
 /**
@@ -599,6 +601,7 @@ static void callee_ana_node(ir_node *node, pset *methods)
 	default:
 		panic("invalid opcode or opcode not implemented");
 	}
+	set_irn_link(node, NULL);
 }
 
 /**
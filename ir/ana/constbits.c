@@ -16,6 +16,7 @@
 #include "irnode_t.h"
 #include "irnodemap.h"
 #include "iropt.h"
+#include "vrp.h"
 #include <assert.h>
 
 #ifndef VERIFY_CONSTBITS
@@ -737,6 +738,16 @@ undefined:
 						o = b->o;
 						goto set_info;
 					}
+					ir_graph *const irg = get_irn_irg(irn);
+					if (pred == get_irg_args(irg)) {
+						/* Arguments may be known from all call sites. */
+						vrp_attr const *const param = vrp_get_param_info(irg, get_Proj_num(irn));
+						if (param != NULL) {
+							z = param->bits_not_set;
+							o = param->bits_set;
+							goto set_info;
+						}
+					}
 					goto cannot_analyse;
 				}
 
@@ -0,0 +1,639 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2017 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Dependence analysis for memory accesses in loop nests.
+ */
+#include "dependence.h"
+
+#include <stdlib.h>
+
+#include "debug.h"
+#include "irloop_t.h"
+#include "irmemory.h"
+#include "irnode_t.h"
+#include "scev.h"
+#include "target.h"
+#include "tv.h"
+#include "type_t.h"
+#include "util.h"
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg;)
+
+/** Maximum number of variables in an address. */
+#define MAX_TERMS       8
+/** Maximum depth of an address expression. */
+#define MAX_EXPR_DEPTH  16
+/** Maximum absolute value of coefficients and offsets. */
+#define MAX_VALUE       (1L << 40)
+/** Values from this magnitude on are considered infinite. */
+#define INF             (1L << 61)
+
+/**
+ * A variable of an affine function: the iteration number of a loop or a
+ * value which does not change inside the loop nest.
+ */
+typedef struct dep_term_t {
+	void const *var;   /**< an ir_loop or an ir_node */
+	long        coeff;
+} dep_term_t;
+
+/** An affine function offset + sum(coeff * var). */
+typedef struct affine_t {
+	long       offset;
+	unsigned   n_terms;
+	dep_term_t terms[MAX_TERMS];
+} affine_t;
+
+static bool is_loop_var(void const *var)
+{
+	return *(firm_kind const*)var == k_ir_loop;
+}
+
+static bool is_root_loop(const ir_loop *loop)
+{
+	return get_loop_outer_loop(loop) == loop;
+}
+
+static bool loop_contains(const ir_loop *loop, const ir_loop *inner)
+{
+	if (inner == NULL)
+		return false;
+	unsigned const depth = get_loop_depth(loop);
+	while (get_loop_depth(inner) > depth)
+		inner = get_loop_outer_loop(inner);
+	return inner == loop;
+}
+
+/** Checks whether @p value is a valid coefficient or offset. */
+static bool is_bounded(long value)
+{
+	return -MAX_VALUE <= value && value <= MAX_VALUE;
+}
+
+/** Adds @p factor times @p var to @p a. */
+static bool add_term(affine_t *a, void const *var, long factor)
+{
+	for (unsigned i = 0; i < a->n_terms; ++i) {
+		dep_term_t *const term = &a->terms[i];
+		if (term->var != var)
+			continue;
+		term->coeff += factor;
+		if (term->coeff == 0)
+			*term = a->terms[--a->n_terms];
+		return is_bounded(factor) && is_bounded(term->coeff);
+	}
+	if (factor == 0)
+		return true;
+	if (a->n_terms >= MAX_TERMS || !is_bounded(factor))
+		return false;
+	a->terms[a->n_terms++] = (dep_term_t){ var, factor };
+	return true;
+}
+
+/** Adds @p factor times @p b to @p a. */
+static bool add_affine(affine_t *a, affine_t const *b, long factor)
+{
+	if (!is_bounded(factor) || !is_bounded(b->offset))
+		return false;
+	a->offset += b->offset * factor;
+	if (!is_bounded(a->offset))
+		return false;
+	for (unsigned i = 0; i < b->n_terms; ++i) {
+		long const coeff = b->terms[i].coeff;
+		if (labs(coeff) > MAX_VALUE / MAX(labs(factor), 1)
+		    || !add_term(a, b->terms[i].var, coeff * factor))
+			return false;
+	}
+	return true;
+}
+
+/** Checks whether @p a depends on the iteration of a loop. */
+static bool varies(affine_t const *a)
+{
+	for (unsigned i = 0; i < a->n_terms; ++i) {
+		if (is_loop_var(a->terms[i].var))
+			return true;
+	}
+	return false;
+}
+
+static bool get_long(ir_tarval *tv, long *value)
+{
+	if (!tarval_is_long(tv))
+		return false;
+	*value = get_tarval_long(tv);
+	return is_bounded(*value);
+}
+
+static scev_trip_count_t const *get_trip_count(ir_loop *loop)
+{
+	loop_element element = get_loop_element(loop, 0);
+	while (*element.kind == k_ir_loop)
+		element = get_loop_element(element.son, 0);
+	return scev_get_trip_count(get_irn_irg(element.node), loop);
+}
+
+/**
+ * Returns the largest iteration number of @p loop or INF if it is not
+ * known.
+ */
+static long get_max_iteration(ir_loop *loop)
+{
+	scev_trip_count_t const *const tc = get_trip_count(loop);
+	if (tc == NULL || !tarval_is_long(tc->count))
+		return INF;
+	long const count = get_tarval_long(tc->count);
+	return count <= 0 || count > MAX_VALUE ? INF : count - 1;
+}
+
+/**
+ * Returns an upper bound of the iteration numbers of @p loop or INF.  If the
+ * trip count is not known, a loop counting by one towards a bound is limited
+ * by the range of its counter.
+ */
+static long get_iteration_bound(ir_loop *loop)
+{
+	long const last = get_max_iteration(loop);
+	if (last < INF)
+		return last;
+	scev_trip_count_t const *const tc = get_trip_count(loop);
+	long                           start;
+	long                           step;
+	if (tc == NULL || tc->latest
+	    || !get_long(tc->iv->start_tv, &start)
+	    || !get_long(tc->iv->step_tv, &step))
+		return INF;
+	ir_mode *const mode = get_irn_mode(tc->iv->phi);
+	long           limit;
+	if (step == 1 && tc->relation == ir_relation_less
+	    && get_long(get_mode_max(mode), &limit))
+		return limit - 1 - start;
+	if (step == -1 && tc->relation == ir_relation_greater
+	    && get_long(get_mode_min(mode), &limit))
+		return start - limit - 1;
+	return INF;
+}
+
+/**
+ * Checks whether the values of @p a stay within the range of @p mode, i.e.
+ * computing them in @p mode does not wrap around.
+ */
+static bool fits_mode(affine_t const *a, ir_mode *mode)
+{
+	if (get_mode_size_bytes(mode) >= ir_target_pointer_size()
+	    || !mode_is_int(mode))
+		return true;
+	long min = a->offset;
+	long max = a->offset;
+	for (unsigned i = 0; i < a->n_terms; ++i) {
+		dep_term_t const *const term = &a->terms[i];
+		if (!is_loop_var(term->var))
+			return false;
+		long const last = get_iteration_bound((ir_loop*)term->var);
+		if (last < 0 || last >= INF || labs(term->coeff) > INF / MAX(last, 1))
+			return false;
+		if (term->coeff > 0)
+			max += term->coeff * last;
+		else
+			min += term->coeff * last;
+		if (!is_bounded(min) || !is_bounded(max))
+			return false;
+	}
+	long mode_min;
+	long mode_max;
+	if (!get_long(get_mode_min(mode), &mode_min)
+	    || !get_long(get_mode_max(mode), &mode_max))
+		return false;
+	return mode_min <= min && max <= mode_max;
+}
+
+/**
+ * Checks whether @p node does not change inside the loops containing
+ * @p loop.
+ */
+static bool is_invariant(ir_node const *node, ir_loop const *loop)
+{
+	ir_loop const *const node_loop = get_irn_loop(get_block_const(node));
+	for (; !is_root_loop(loop); loop = get_loop_outer_loop(loop)) {
+		if (loop_contains(loop, node_loop))
+			return false;
+	}
+	return true;
+}
+
+static bool get_affine(ir_node *node, ir_loop *loop, unsigned depth,
+                       affine_t *result);
+
+/**
+ * Expresses the induction variable @p phi of a loop containing @p loop by
+ * its start value and the iteration number.
+ */
+static bool get_iv_affine(ir_node *phi, ir_loop *loop, unsigned depth,
+                          affine_t *result)
+{
+	scev_t const *const iv = scev_get_phi(phi);
+	long                step;
+	if (iv == NULL || !loop_contains(iv->loop, loop)
+	    || !get_long(iv->step_tv, &step)
+	    || !get_affine(iv->start, loop, depth + 1, result)
+	    || !add_term(result, iv->loop, step))
+		return false;
+
+	ir_mode *const mode = get_irn_mode(phi);
+	if (fits_mode(result, mode))
+		return true;
+	/* a counter incremented by one while below a bound does not wrap */
+	scev_trip_count_t const *const tc
+		= scev_get_trip_count(get_irn_irg(phi), iv->loop);
+	return tc != NULL && tc->iv == iv && !tc->latest
+	    && ((step == 1 && tc->relation == ir_relation_less)
+	        || (step == -1 && tc->relation == ir_relation_greater));
+}
+
+/**
+ * Expresses @p node used inside @p loop as an affine function of the
+ * iteration numbers of the loops containing @p loop.
+ */
+static bool get_affine(ir_node *node, ir_loop *loop, unsigned depth,
+                       affine_t *result)
+{
+	*result = (affine_t){ .offset = 0 };
+	if (depth >= MAX_EXPR_DEPTH)
+		return false;
+
+	affine_t left;
+	affine_t right;
+	long     value;
+	switch (get_irn_opcode(node)) {
+	case iro_Const:
+		return get_long(get_Const_tarval(node), &result->offset);
+	case iro_Phi:
+		if (!is_invariant(node, loop))
+			return get_iv_affine(node, loop, depth, result);
+		break;
+	case iro_Add:
+	case iro_Sub:
+		if (!get_affine(get_binop_left(node), loop, depth + 1, &left)
+		    || !get_affine(get_binop_right(node), loop, depth + 1, &right))
+			return false;
+		*result = left;
+		if (!add_affine(result, &right, is_Add(node) ? 1 : -1))
+			return false;
+		goto check_wrap;
+	case iro_Mul: {
+		ir_node *factor = get_Mul_right(node);
+		ir_node *op     = get_Mul_left(node);
+		if (is_Const(op)) {
+			factor = op;
+			op     = get_Mul_right(node);
+		}
+		if (!is_Const(factor)
+		    || !get_long(get_Const_tarval(factor), &value))
+			break;
+		if (!get_affine(op, loop, depth + 1, &left)
+		    || !add_affine(result, &left, value))
+			return false;
+		goto check_wrap;
+	}
+	case iro_Shl:
+		if (!is_Const(get_Shl_right(node))
+		    || !get_long(get_Const_tarval(get_Shl_right(node)), &value)
+		    || value < 0 || value >= 32)
+			break;
+		if (!get_affine(get_Shl_left(node), loop, depth + 1, &left)
+		    || !add_affine(result, &left, 1L << value))
+			return false;
+		goto check_wrap;
+	case iro_Conv: {
+		ir_node *const op      = get_Conv_op(node);
+		ir_mode *const op_mode = get_irn_mode(op);
+		if (!mode_is_int(op_mode) && !mode_is_reference(op_mode))
+			break;
+		if (!get_affine(op, loop, depth + 1, result))
+			return false;
+		/* truncation or a change of the signedness might change the
+		 * value, e.g. a negative value converted to unsigned and then
+		 * zero extended */
+		ir_mode *const mode = get_irn_mode(node);
+		if (get_mode_size_bits(mode) < get_mode_size_bits(op_mode)
+		    || mode_is_signed(mode) != mode_is_signed(op_mode))
+			goto check_wrap;
+		return true;
+	}
+	case iro_Member:
+		if (!get_affine(get_Member_ptr(node), loop, depth + 1, result))
+			return false;
+		result->offset += get_entity_offset(get_Member_entity(node));
+		return is_bounded(result->offset);
+	case iro_Sel: {
+		ir_type *const type = get_Sel_type(node);
+		long const     size = get_type_size(get_array_element_type(type));
+		if (!get_affine(get_Sel_ptr(node), loop, depth + 1, result)
+		    || !get_affine(get_Sel_index(node), loop, depth + 1, &right))
+			return false;
+		return add_affine(result, &right, size);
+	}
+	default:
+		break;
+	}
+	/* other values must not change inside the loop nest */
+	if (!is_invariant(node, loop))
+		return false;
+	return add_term(result, node, 1);
+
+check_wrap:
+	/* arithmetic in modes smaller than a pointer might wrap around */
+	return !varies(result) || fits_mode(result, get_irn_mode(node));
+}
+
+static ir_node *get_memop_ptr(ir_node const *node)
+{
+	return is_Load(node) ? get_Load_ptr(node) : get_Store_ptr(node);
+}
+
+static ir_type *get_memop_type(ir_node const *node)
+{
+	return is_Load(node) ? get_Load_type(node) : get_Store_type(node);
+}
+
+static long get_memop_size(ir_node const *node)
+{
+	ir_mode *const mode = is_Load(node) ? get_Load_mode(node)
+	                                    : get_irn_mode(get_Store_value(node));
+	return get_mode_size_bytes(mode);
+}
+
+/** Collects the loops containing @p loop, outermost first. */
+static unsigned get_loop_nest(ir_loop *loop, ir_loop **nest)
+{
+	unsigned n = 0;
+	for (; !is_root_loop(loop); loop = get_loop_outer_loop(loop)) {
+		if (n >= DEP_MAX_DEPTH)
+			return DEP_MAX_DEPTH + 1;
+		nest[n++] = loop;
+	}
+	for (unsigned i = 0; i < n / 2; ++i) {
+		ir_loop *const tmp = nest[i];
+		nest[i]         = nest[n - 1 - i];
+		nest[n - 1 - i] = tmp;
+	}
+	return n;
+}
+
+static long get_coeff(affine_t const *a, void const *var)
+{
+	for (unsigned i = 0; i < a->n_terms; ++i) {
+		if (a->terms[i].var == var)
+			return a->terms[i].coeff;
+	}
+	return 0;
+}
+
+static long sat_add(long a, long b)
+{
+	return MAX(-INF, MIN(INF, a + b));
+}
+
+static long sat_mul(long a, long b)
+{
+	if (a == 0 || b == 0)
+		return 0;
+	if (labs(a) >= INF / labs(b))
+		return (a < 0) != (b < 0) ? -INF : INF;
+	return a * b;
+}
+
+static long gcd(long a, long b)
+{
+	a = labs(a);
+	b = labs(b);
+	while (b != 0) {
+		long const t = a % b;
+		a = b;
+		b = t;
+	}
+	return a;
+}
+
+/** Bounds and divisor of the difference of two addresses. */
+typedef struct dep_bounds_t {
+	long min;
+	long max;
+	long divisor;
+} dep_bounds_t;
+
+static void add_values(dep_bounds_t *bounds, long const *values, unsigned n)
+{
+	long min = values[0];
+	long max = values[0];
+	for (unsigned i = 1; i < n; ++i) {
+		min = MIN(min, values[i]);
+		max = MAX(max, values[i]);
+	}
+	bounds->min = sat_add(bounds->min, min);
+	bounds->max = sat_add(bounds->max, max);
+}
+
+/**
+ * Adds the bounds of a * i - b * j for the iteration numbers i of the source
+ * and j of the destination in [0, last] with i @p dir j to @p bounds.
+ * Returns false if no such iterations exist.
+ */
+static bool add_bounds(dep_bounds_t *bounds, long a, long b, long last,
+                       dep_direction_t dir)
+{
+	/* the extremes of a linear function are at the vertices */
+	switch (dir) {
+	case dep_dir_equal: {
+		long const values[] = { 0, sat_mul(a - b, last) };
+		add_values(bounds, values, ARRAY_SIZE(values));
+		bounds->divisor = gcd(bounds->divisor, a - b);
+		return true;
+	}
+	case dep_dir_less: {
+		/* j = i + 1 + t */
+		if (last < 1)
+			return false;
+		long const values[] = {
+			-b, sat_add(sat_mul(a - b, last - 1), -b), sat_mul(-b, last)
+		};
+		add_values(bounds, values, ARRAY_SIZE(values));
+		break;
+	}
+	case dep_dir_greater: {
+		/* i = j + 1 + t */
+		if (last < 1)
+			return false;
+		long const values[] = {
+			a, sat_add(sat_mul(a - b, last - 1), a), sat_mul(a, last)
+		};
+		add_values(bounds, values, ARRAY_SIZE(values));
+		break;
+	}
+	default: {
+		long const values[] = {
+			0, sat_mul(a, last), sat_mul(-b, last), sat_mul(a - b, last)
+		};
+		add_values(bounds, values, ARRAY_SIZE(values));
+		break;
+	}
+	}
+	bounds->divisor = gcd(bounds->divisor, gcd(a, b));
+	return true;
+}
+
+/**
+ * Checks whether src - dst + @p offset can lie in [@p lo, @p hi] for the
+ * given bounds of src - dst.
+ */
+static bool may_overlap(dep_bounds_t const *bounds, long offset, long lo,
+                        long hi)
+{
+	lo = MAX(lo, sat_add(bounds->min, offset));
+	hi = MIN(hi, sat_add(bounds->max, offset));
+	if (lo > hi)
+		return false;
+	long const divisor = bounds->divisor;
+	if (divisor == 0)
+		return lo <= offset && offset <= hi;
+	/* the smallest value >= lo congruent to offset */
+	long const rem   = ((offset - lo) % divisor + divisor) % divisor;
+	return lo + rem <= hi;
+}
+
+dep_result_t get_dependence(ir_node *src, ir_node *dst, ir_dependence_t *dep)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.ana.dependence");
+	ir_loop *const src_loop = get_irn_loop(get_nodes_block(src));
+	ir_loop *const dst_loop = get_irn_loop(get_nodes_block(dst));
+	ir_loop       *src_nest[DEP_MAX_DEPTH];
+	ir_loop       *dst_nest[DEP_MAX_DEPTH];
+	unsigned const n_src = get_loop_nest(src_loop, src_nest);
+	unsigned const n_dst = get_loop_nest(dst_loop, dst_nest);
+	long     const src_size = get_memop_size(src);
+	long     const dst_size = get_memop_size(dst);
+
+	affine_t src_addr;
+	affine_t dst_addr;
+	if (n_src > DEP_MAX_DEPTH || n_dst > DEP_MAX_DEPTH
+	    || !get_affine(get_memop_ptr(src), src_loop, 0, &src_addr)
+	    || !get_affine(get_memop_ptr(dst), dst_loop, 0, &dst_addr))
+		goto unknown;
+
+	/* the invariant parts of the addresses have to cancel out */
+	affine_t diff = src_addr;
+	if (!add_affine(&diff, &dst_addr, -1))
+		goto unknown;
+	for (unsigned i = 0; i < diff.n_terms; ++i) {
+		if (!is_loop_var(diff.terms[i].var))
+			goto unknown;
+	}
+
+	unsigned n_common = 0;
+	while (n_common < MIN(n_src, n_dst)
+	       && src_nest[n_common] == dst_nest[n_common])
+		++n_common;
+
+	/* the loops containing only one of the operations */
+	dep_bounds_t base = { 0, 0, 0 };
+	for (unsigned i = n_common; i < n_src; ++i) {
+		long const a = get_coeff(&src_addr, src_nest[i]);
+		add_bounds(&base, a, 0, get_max_iteration(src_nest[i]), dep_dir_any);
+	}
+	for (unsigned i = n_common; i < n_dst; ++i) {
+		long const b = get_coeff(&dst_addr, dst_nest[i]);
+		add_bounds(&base, 0, b, get_max_iteration(dst_nest[i]), dep_dir_any);
+	}
+
+	/* test all direction vectors of the common loops */
+	long     const offset = diff.offset;
+	long           last[DEP_MAX_DEPTH];
+	unsigned       n_vectors = 1;
+	for (unsigned i = 0; i < n_common; ++i) {
+		dep->loops[i]        = src_nest[i];
+		dep->directions[i]   = 0;
+		dep->has_distance[i] = false;
+		last[i]              = get_max_iteration(src_nest[i]);
+		n_vectors           *= 3;
+	}
+	dep->n_loops = n_common;
+	bool found = false;
+	for (unsigned v = 0; v < n_vectors; ++v) {
+		dep_direction_t dirs[DEP_MAX_DEPTH];
+		dep_bounds_t    bounds = base;
+		bool            same   = true;
+		bool            empty  = false;
+		for (unsigned i = 0, code = v; i < n_common; ++i, code /= 3) {
+			dirs[i] = (dep_direction_t)(1U << (code % 3));
+			same   &= dirs[i] == dep_dir_equal;
+			long const a = get_coeff(&src_addr, src_nest[i]);
+			long const b = get_coeff(&dst_addr, dst_nest[i]);
+			empty |= !add_bounds(&bounds, a, b, last[i], dirs[i]);
+		}
+		/* an operation does not depend on itself */
+		if (empty || (same && src == dst))
+			continue;
+		/* the accessed ranges overlap if -dst_size < src - dst < src_size */
+		if (!may_overlap(&bounds, offset, 1 - dst_size, src_size - 1))
+			continue;
+		found = true;
+		for (unsigned i = 0; i < n_common; ++i)
+			dep->directions[i] |= dirs[i];
+	}
+	if (!found) {
+		DB((dbg, LEVEL_2, "no dependence between %+F and %+F\n", src, dst));
+		return dep_none;
+	}
+
+	/* a uniform dependence carried by a single loop has a known distance */
+	for (unsigned i = 0; i < n_common; ++i) {
+		if (dep->directions[i] == dep_dir_equal) {
+			dep->has_distance[i] = true;
+			dep->distances[i]    = 0;
+		}
+	}
+	unsigned carrier = n_common;
+	bool     uniform = src_addr.n_terms == dst_addr.n_terms;
+	for (unsigned i = 0; i < src_addr.n_terms && uniform; ++i) {
+		void const *const var = src_addr.terms[i].var;
+		if (get_coeff(&dst_addr, var) != src_addr.terms[i].coeff) {
+			uniform = false;
+		} else if (is_loop_var(var)) {
+			/* the loop must be common and the only one with a term */
+			unsigned level = 0;
+			while (level < n_common && src_nest[level] != var)
+				++level;
+			uniform = level < n_common && carrier == n_common;
+			carrier = level;
+		}
+	}
+	if (uniform && carrier < n_common) {
+		/* src - dst = -a * distance + offset */
+		long const a  = get_coeff(&src_addr, src_nest[carrier]);
+		long const lo = offset - (src_size - 1);
+		long const hi = offset + (dst_size - 1);
+		/* distances d with lo <= a * d <= hi */
+		long const al = a > 0 ? lo : -hi;
+		long const ah = a > 0 ? hi : -lo;
+		long const aa = labs(a);
+		long const d_lo = al >= 0 ? (al + aa - 1) / aa : -(-al / aa);
+		long const d_hi = ah >= 0 ? ah / aa : -((-ah + aa - 1) / aa);
+		if (d_lo == d_hi) {
+			dep->has_distance[carrier] = true;
+			dep->distances[carrier]    = d_lo;
+		}
+	}
+	DB((dbg, LEVEL_2, "dependence between %+F and %+F\n", src, dst));
+	return dep_exists;
+
+unknown:
+	if (get_alias_relation(get_memop_ptr(src), get_memop_type(src),
+	                       src_size, get_memop_ptr(dst), get_memop_type(dst),
+	                       dst_size) == ir_no_alias)
+		return dep_none;
+	return dep_unknown;
+}
@@ -0,0 +1,73 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2017 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Dependence analysis for memory accesses in loop nests.
+ *
+ * The address of a Load or Store is expressed as an affine function of the
+ * iteration numbers of the loops containing it, using the induction variables
+ * found by the scalar evolution analysis. For a pair of memory operations the
+ * GCD test and Banerjee's inequalities determine in which relation the
+ * iterations of the common loops can be, when both access the same memory.
+ *
+ * The iteration number of a loop counts the executions of its header during
+ * one execution of the loop, starting with 0.
+ */
+#ifndef FIRM_ANA_DEPENDENCE_H
+#define FIRM_ANA_DEPENDENCE_H
+
+#include <stdbool.h>
+#include "firm_types.h"
+
+/** Maximum depth of the loop nests analysed. */
+#define DEP_MAX_DEPTH 4
+
+/**
+ * Relation of the iteration of the source to the iteration of the
+ * destination of a dependence.
+ */
+typedef enum dep_direction_t {
+	dep_dir_less    = 1U << 0, /**< the source is executed in an earlier
+	                                iteration */
+	dep_dir_equal   = 1U << 1, /**< both are executed in the same iteration */
+	dep_dir_greater = 1U << 2, /**< the source is executed in a later
+	                                iteration */
+	dep_dir_any     = dep_dir_less | dep_dir_equal | dep_dir_greater,
+} dep_direction_t;
+
+/** Result of a dependence test. */
+typedef enum dep_result_t {
+	dep_none,    /**< the operations never access the same memory */
+	dep_unknown, /**< the addresses could not be analysed */
+	dep_exists,  /**< the operations may access the same memory */
+} dep_result_t;
+
+/** A dependence between two memory operations in a loop nest. */
+typedef struct ir_dependence_t {
+	unsigned  n_loops;                   /**< number of common loops */
+	ir_loop  *loops[DEP_MAX_DEPTH];      /**< common loops, outermost first */
+	/** The possible dep_direction_t per common loop. */
+	unsigned  directions[DEP_MAX_DEPTH];
+	/** The distance of a loop is known. */
+	bool      has_distance[DEP_MAX_DEPTH];
+	/** Iteration of the destination minus iteration of the source. */
+	long      distances[DEP_MAX_DEPTH];
+} ir_dependence_t;
+
+/**
+ * Tests whether the memory operations @p src and @p dst (Loads or Stores)
+ * may access the same memory and describes in which iterations of the loops
+ * containing both this happens. A memory operation does not depend on itself
+ * in the same iteration. Requires consistent loop information.
+ *
+ * @param src  the memory operation of the source
+ * @param dst  the memory operation of the destination
+ * @param dep  receives the common loops, directions and distances if the
+ *             result is dep_exists
+ */
+dep_result_t get_dependence(ir_node *src, ir_node *dst, ir_dependence_t *dep);
+
+#endif
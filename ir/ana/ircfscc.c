@@ -20,6 +20,7 @@
 #include "irnode_t.h"
 #include "irprog_t.h"
 #include "pmap.h"
+#include "scev.h"
 
 /** The outermost graph the scc is computed for */
 static ir_graph *outermost_ir_graph;
@@ -580,12 +581,18 @@ void free_loop_information(ir_graph *irg)
 {
 	irg_walk_graph(irg, loop_reset_node, NULL, NULL);
 	set_irg_loop(irg, NULL);
-	clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO);
+	clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO
+	                        | IR_GRAPH_PROPERTY_CONSISTENT_SCEV);
+	free_irg_scev_cache(irg);
 	/* We cannot free the loop nodes, they are on the obstack. */
 }
 
 void construct_cf_backedges(ir_graph *irg)
 {
+	/* the memoized scalar evolution refers to the old loops */
+	clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_SCEV);
+	free_irg_scev_cache(irg);
+
 	outermost_ir_graph = irg;
 
 	struct obstack temp;
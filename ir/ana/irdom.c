@@ -18,10 +18,15 @@
 #include "irgwalk.h"
 #include "irnode_t.h"
 #include "irouts_t.h"
+#include "pqueue.h"
+#include "pset_new.h"
 #include "util.h"
 #include "xmalloc.h"
 #include <string.h>
 
+static void assure_dom_tree_numbers(ir_graph *irg);
+static void assure_pdom_tree_numbers(ir_graph *irg);
+
 static inline ir_dom_info *get_dom_info(ir_node *block)
 {
 	assert(is_Block(block));
@@ -138,27 +143,32 @@ void set_Block_postdom_depth(ir_node *block, int depth)
 
 unsigned get_Block_dom_tree_pre_num(const ir_node *block)
 {
+	assure_dom_tree_numbers(get_irn_irg(block));
 	return get_dom_info_const(block)->tree_pre_num;
 }
 
 unsigned get_Block_dom_max_subtree_pre_num(const ir_node *block)
 {
+	assure_dom_tree_numbers(get_irn_irg(block));
 	return get_dom_info_const(block)->max_subtree_pre_num;
 }
 
 unsigned get_Block_pdom_tree_pre_num(const ir_node *block)
 {
+	assure_pdom_tree_numbers(get_irn_irg(block));
 	return get_pdom_info_const(block)->tree_pre_num;
 }
 
 unsigned get_Block_pdom_max_subtree_pre_num(const ir_node *block)
 {
+	assure_pdom_tree_numbers(get_irn_irg(block));
 	return get_pdom_info_const(block)->max_subtree_pre_num;
 }
 
 int block_dominates(const ir_node *a, const ir_node *b)
 {
 	assert(irg_has_properties(get_irn_irg(a), IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE));
+	assure_dom_tree_numbers(get_irn_irg(a));
 	const ir_dom_info *ai = get_dom_info_const(a);
 	const ir_dom_info *bi = get_dom_info_const(b);
 	return bi->tree_pre_num - ai->tree_pre_num
@@ -207,6 +217,7 @@ ir_node *get_Block_dominated_next(const ir_node *block)
 int block_postdominates(const ir_node *a, const ir_node *b)
 {
 	assert(irg_has_properties(get_irn_irg(a), IR_GRAPH_PROPERTY_CONSISTENT_POSTDOMINANCE));
+	assure_pdom_tree_numbers(get_irn_irg(a));
 	const ir_dom_info *ai = get_pdom_info_const(a);
 	const ir_dom_info *bi = get_pdom_info_const(b);
 	return bi->tree_pre_num - ai->tree_pre_num
@@ -497,46 +508,45 @@ static void count_and_init_blocks_dom(ir_node *block, void *env)
 	set_Block_dom_depth(block, -1);
 }
 
-void compute_doms(ir_graph *irg)
+/**
+ * Returns the temporary info of @p block or NULL if @p block was not
+ * visited by the depth first search filling @p tdi_list.
+ */
+static tmp_dom_info *get_tmp_dom_info(tmp_dom_info *tdi_list, int n_blocks,
+                                      const ir_node *block)
 {
-	assert(!irg_is_constrained(irg, IR_GRAPH_CONSTRAINT_CONSTRUCTION));
-
-	/* We need the out data structure. */
-	assure_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUTS
-	                         | IR_GRAPH_PROPERTY_NO_TUPLES);
-
-	/* Count the number of blocks in the graph. */
-	int n_blocks = 0;
-	irg_block_walk_graph(irg, count_and_init_blocks_dom, NULL, &n_blocks);
-
-	/* Memory for temporary information. */
-	tmp_dom_info *tdi_list = XMALLOCN(tmp_dom_info, n_blocks);
-
-	/* this with a standard walker as passing the parent to the sons isn't
-	   simple. */
-	ir_reserve_resources(irg, IR_RESOURCE_BLOCK_VISITED);
-	inc_irg_block_visited(irg);
-	int used = 0;
-	init_tmp_dom_info(get_irg_start_block(irg), NULL, tdi_list, &used, n_blocks);
-	ir_free_resources(irg, IR_RESOURCE_BLOCK_VISITED);
-	/* If not all blocks are reachable from Start by out edges this assertion
-	   fails. */
-	assert(used <= n_blocks);
-	n_blocks = used;
+	int pre_num = get_Block_dom_pre_num(block);
+	if (pre_num < 0 || pre_num >= n_blocks || tdi_list[pre_num].block != block)
+		return NULL;
+	return &tdi_list[pre_num];
+}
 
+/**
+ * Runs the semidominator steps of the Lengauer-Tarjan algorithm on the
+ * blocks in @p tdi_list (in depth first search pre-order) and leaves the
+ * immediate dominator of every non-root block in its dom field.
+ * Predecessors not contained in @p tdi_list are ignored.
+ */
+static void compute_tmp_doms(ir_graph *irg, tmp_dom_info *tdi_list,
+                             int n_blocks)
+{
 	for (int i = n_blocks; i-- > 1; ) {  /* Don't iterate the root, it's done. */
 		tmp_dom_info  *w     = &tdi_list[i];
 		const ir_node *block = w->block;
 
 		/* Step 2 */
 		for (int j = 0, arity = get_irn_arity(block); j < arity; j++) {
-			const ir_node *pred       = get_Block_cfgpred(block, j);
-			const ir_node *pred_block = get_nodes_block(pred);
+			const ir_node *pred = get_Block_cfgpred(block, j);
+			if (is_Bad(pred))
+				continue;    /* unreachable */
 
-			if (is_Bad(pred) || get_Block_dom_pre_num(pred_block) == -1)
+			const ir_node *pred_block = get_nodes_block(pred);
+			tmp_dom_info  *pred_tdi
+				= get_tmp_dom_info(tdi_list, n_blocks, pred_block);
+			if (pred_tdi == NULL)
 				continue;    /* unreachable */
 
-			const tmp_dom_info *u = dom_eval(&tdi_list[get_Block_dom_pre_num(pred_block)]);
+			const tmp_dom_info *u = dom_eval(pred_tdi);
 			if (u->semi < w->semi)
 				w->semi = u->semi;
 		}
@@ -544,10 +554,14 @@ void compute_doms(ir_graph *irg)
 		/* handle keep-alives if we are at the end block */
 		if (block == get_irg_end_block(irg)) {
 			foreach_irn_in(get_irg_end(irg), j, pred) {
-				if (!is_Block(pred) || get_Block_dom_pre_num(pred) == -1)
+				if (!is_Block(pred))
+					continue;
+				tmp_dom_info *pred_tdi
+					= get_tmp_dom_info(tdi_list, n_blocks, pred);
+				if (pred_tdi == NULL)
 					continue;   /* unreachable */
 
-				const tmp_dom_info *u = dom_eval(&tdi_list[get_Block_dom_pre_num(pred)]);
+				const tmp_dom_info *u = dom_eval(pred_tdi);
 				if (u->semi < w->semi)
 					w->semi = u->semi;
 			}
@@ -574,8 +588,46 @@ void compute_doms(ir_graph *irg)
 				v->dom = w->parent;
 		}
 	}
-	/* Step 4 */
+
+	/* first half of step 4 */
 	tdi_list[0].dom = NULL;
+	for (int i = 1; i < n_blocks; i++) {
+		tmp_dom_info *w = &tdi_list[i];
+		if (w->dom != NULL && w->dom != w->semi)
+			w->dom = w->dom->dom;
+	}
+}
+
+void compute_doms(ir_graph *irg)
+{
+	assert(!irg_is_constrained(irg, IR_GRAPH_CONSTRAINT_CONSTRUCTION));
+
+	/* We need the out data structure. */
+	assure_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUTS
+	                         | IR_GRAPH_PROPERTY_NO_TUPLES);
+
+	/* Count the number of blocks in the graph. */
+	int n_blocks = 0;
+	irg_block_walk_graph(irg, count_and_init_blocks_dom, NULL, &n_blocks);
+
+	/* Memory for temporary information. */
+	tmp_dom_info *tdi_list = XMALLOCN(tmp_dom_info, n_blocks);
+
+	/* this with a standard walker as passing the parent to the sons isn't
+	   simple. */
+	ir_reserve_resources(irg, IR_RESOURCE_BLOCK_VISITED);
+	inc_irg_block_visited(irg);
+	int used = 0;
+	init_tmp_dom_info(get_irg_start_block(irg), NULL, tdi_list, &used, n_blocks);
+	ir_free_resources(irg, IR_RESOURCE_BLOCK_VISITED);
+	/* If not all blocks are reachable from Start by out edges this assertion
+	   fails. */
+	assert(used <= n_blocks);
+	n_blocks = used;
+
+	compute_tmp_doms(irg, tdi_list, n_blocks);
+
+	/* Step 4 */
 	set_Block_idom(tdi_list[0].block, NULL);
 	set_Block_dom_depth(tdi_list[0].block, 1);
 	for (int i = 1; i < n_blocks; i++) {
@@ -583,8 +635,6 @@ void compute_doms(ir_graph *irg)
 		if (w->dom == NULL)
 			continue; /* control dead */
 
-		if (w->dom != w->semi)
-			w->dom = w->dom->dom;
 		set_Block_idom(w->block, w->dom->block);
 
 		/* blocks dominated by dead one's are still dead */
@@ -600,6 +650,7 @@ void compute_doms(ir_graph *irg)
 	add_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE);
 
 	/* Do a walk over the tree and assign the tree pre orders. */
+	irg->dom_numbers_outdated = false;
 	unsigned tree_pre_order = 0;
 	dom_tree_walk(get_irg_start_block(irg), assign_tree_dom_pre_order,
 	              assign_tree_dom_pre_order_max, &tree_pre_order);
@@ -704,7 +755,395 @@ void compute_postdoms(ir_graph *irg)
 	add_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_POSTDOMINANCE);
 
 	/* Do a walk over the tree and assign the tree pre orders. */
+	irg->pdom_numbers_outdated = false;
+	unsigned tree_pre_order = 0;
+	postdom_tree_walk(get_irg_end_block(irg), assign_tree_postdom_pre_order,
+	                  assign_tree_postdom_pre_order_max, &tree_pre_order);
+}
+
+static void assure_dom_tree_numbers(ir_graph *irg)
+{
+	if (!irg->dom_numbers_outdated)
+		return;
+	irg->dom_numbers_outdated = false;
+	unsigned tree_pre_order = 0;
+	dom_tree_walk(get_irg_start_block(irg), assign_tree_dom_pre_order,
+	              assign_tree_dom_pre_order_max, &tree_pre_order);
+}
+
+static void assure_pdom_tree_numbers(ir_graph *irg)
+{
+	if (!irg->pdom_numbers_outdated)
+		return;
+	irg->pdom_numbers_outdated = false;
 	unsigned tree_pre_order = 0;
 	postdom_tree_walk(get_irg_end_block(irg), assign_tree_postdom_pre_order,
 	                  assign_tree_postdom_pre_order_max, &tree_pre_order);
 }
+
+typedef ir_dom_info *(*get_dom_info_func)(ir_node *block);
+
+/** Removes @p block from the list of blocks its parent in the tree
+ * immediately (post)dominates. */
+static void tree_unlink(ir_node *block, get_dom_info_func get_info)
+{
+	ir_dom_info *bi     = get_info(block);
+	ir_node     *parent = bi->idom;
+	if (parent == NULL)
+		return;
+
+	ir_node **prev = &get_info(parent)->first;
+	while (*prev != block)
+		prev = &get_info(*prev)->next;
+	*prev    = bi->next;
+	bi->next = NULL;
+	bi->idom = NULL;
+}
+
+/** Makes @p parent the immediate (post)dominator of @p block. */
+static void tree_set_parent(ir_node *block, ir_node *parent,
+                            get_dom_info_func get_info)
+{
+	ir_dom_info *bi = get_info(block);
+	if (bi->idom == parent)
+		return;
+	tree_unlink(block, get_info);
+
+	ir_dom_info *pi = get_info(parent);
+	bi->idom  = parent;
+	bi->next  = pi->first;
+	pi->first = block;
+}
+
+/** Sets the depth of @p block and fixes the depths of its subtree. */
+static void tree_set_depth(ir_node *block, int depth,
+                           get_dom_info_func get_info)
+{
+	ir_dom_info *bi = get_info(block);
+	bi->dom_depth = depth;
+	for (ir_node *p = bi->first; p != NULL; p = get_info(p)->next) {
+		tree_set_depth(p, depth + 1, get_info);
+	}
+}
+
+/** Checks whether @p a (post)dominates @p b by walking up the tree. */
+static bool tree_dominates(ir_node *a, ir_node *b, get_dom_info_func get_info)
+{
+	int depth = get_info(a)->dom_depth;
+	while (get_info(b)->dom_depth > depth)
+		b = get_info(b)->idom;
+	return a == b;
+}
+
+static bool is_kept_alive(const ir_node *block)
+{
+	ir_graph *irg = get_irn_irg(block);
+	foreach_irn_in(get_irg_end(irg), i, kept) {
+		if (kept == block)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Fills @p blocks with the blocks reachable from @p block over blocks deeper
+ * than @p level in the dominator tree, in depth first search pre-order.
+ * The parent of every visited block in the search tree is recorded in
+ * @p parents and the position in @p blocks in the dom pre_num field.
+ */
+static void collect_dom_subtree(ir_node *block, int parent, int level,
+                                pset_new_t *kept, ir_node ***blocks,
+                                int **parents)
+{
+	int num = (int)ARR_LEN(*blocks);
+	set_Block_dom_pre_num(block, num);
+	ARR_APP1(ir_node*, *blocks, block);
+	ARR_APP1(int, *parents, parent);
+
+	ir_graph *irg       = get_irn_irg(block);
+	ir_node  *end_block = get_irg_end_block(irg);
+	foreach_block_succ(block, edge) {
+		ir_node *succ    = get_edge_src_irn(edge);
+		int      pre_num = get_Block_dom_pre_num(succ);
+		if (get_Block_dom_depth(succ) <= level)
+			continue;
+		if (pre_num >= 0 && pre_num < (int)ARR_LEN(*blocks)
+		    && (*blocks)[pre_num] == succ)
+			continue;
+		collect_dom_subtree(succ, num, level, kept, blocks, parents);
+	}
+	if (pset_new_contains(kept, block)) {
+		int pre_num = get_Block_dom_pre_num(end_block);
+		if (!(pre_num >= 0 && pre_num < (int)ARR_LEN(*blocks)
+		      && (*blocks)[pre_num] == end_block))
+			collect_dom_subtree(end_block, num, level, kept, blocks, parents);
+	}
+}
+
+/**
+ * Recomputes the dominator subtree below @p top with the Lengauer-Tarjan
+ * algorithm restricted to the blocks dominated by @p top.
+ */
+static void rebuild_dom_subtree(ir_node *top)
+{
+	ir_graph *irg       = get_irn_irg(top);
+	ir_node  *end_block = get_irg_end_block(irg);
+	int       level     = get_Block_dom_depth(top);
+
+	pset_new_t kept;
+	pset_new_init(&kept);
+	if (get_Block_dom_depth(end_block) > level) {
+		foreach_irn_in(get_irg_end(irg), i, pred) {
+			if (is_Block(pred))
+				pset_new_insert(&kept, pred);
+		}
+	}
+
+	ir_node **blocks  = NEW_ARR_F(ir_node*, 0);
+	int      *parents = NEW_ARR_F(int, 0);
+	collect_dom_subtree(top, -1, level, &kept, &blocks, &parents);
+	pset_new_destroy(&kept);
+
+	int           n_blocks = (int)ARR_LEN(blocks);
+	tmp_dom_info *tdi_list = XMALLOCN(tmp_dom_info, n_blocks);
+	for (int i = 0; i < n_blocks; ++i) {
+		tmp_dom_info *tdi = &tdi_list[i];
+		tdi->block       = blocks[i];
+		tdi->semi        = tdi;
+		tdi->parent      = parents[i] < 0 ? NULL : &tdi_list[parents[i]];
+		tdi->label       = tdi;
+		tdi->ancestor    = NULL;
+		tdi->dom         = NULL;
+		tdi->bucket      = NULL;
+		tdi->unreachable = 0;
+	}
+	DEL_ARR_F(parents);
+	DEL_ARR_F(blocks);
+
+	compute_tmp_doms(irg, tdi_list, n_blocks);
+	for (int i = 1; i < n_blocks; ++i) {
+		tmp_dom_info *w = &tdi_list[i];
+		tree_set_parent(w->block, w->dom->block, get_dom_info);
+	}
+	free(tdi_list);
+
+	tree_set_depth(top, level, get_dom_info);
+	irg->dom_numbers_outdated = true;
+}
+
+static bool can_update_doms(ir_graph *irg)
+{
+	if (!irg_has_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE))
+		return false;
+	if (!edges_activated_kind(irg, EDGE_KIND_BLOCK)) {
+		clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE);
+		return false;
+	}
+	return true;
+}
+
+void dom_insert_cf_edge(ir_node *from, ir_node *to)
+{
+	ir_graph *irg = get_irn_irg(from);
+	if (!can_update_doms(irg))
+		return;
+
+	/* edges leaving dead code do not change dominance */
+	if (get_Block_dom_depth(from) <= 0)
+		return;
+	if (get_Block_dom_depth(to) <= 0) {
+		/* dead code became reachable */
+		clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE);
+		return;
+	}
+
+	ir_node *nca = ir_deepest_common_dominator(from, to);
+	if (nca == to || nca == get_dom_info(to)->idom)
+		return;
+
+	/* Depth based search: every block which is reachable from to over blocks
+	 * deeper than the new immediate dominator of to and which is not deeper
+	 * than a block on such a path is now immediately dominated by nca. */
+	int        nca_depth   = get_Block_dom_depth(nca);
+	pqueue_t  *bucket      = new_pqueue();
+	ir_node  **affected    = NEW_ARR_F(ir_node*, 0);
+	ir_node  **unaffected  = NEW_ARR_F(ir_node*, 0);
+	ir_node   *end_block   = get_irg_end_block(irg);
+	pset_new_t visited;
+	pset_new_init(&visited);
+	pset_new_insert(&visited, to);
+	pqueue_put(bucket, to, get_Block_dom_depth(to));
+	while (!pqueue_empty(bucket)) {
+		ir_node *block = (ir_node*)pqueue_pop_front(bucket);
+		int      depth = get_Block_dom_depth(block);
+		ARR_APP1(ir_node*, affected, block);
+
+		for (;;) {
+			ir_node *kept_succ = is_kept_alive(block) ? end_block : NULL;
+			foreach_block_succ(block, edge) {
+				ir_node *succ       = get_edge_src_irn(edge);
+				int      succ_depth = get_Block_dom_depth(succ);
+				if (succ_depth <= nca_depth + 1
+				    || !pset_new_insert(&visited, succ))
+					continue;
+				if (succ_depth > depth)
+					ARR_APP1(ir_node*, unaffected, succ);
+				else
+					pqueue_put(bucket, succ, succ_depth);
+			}
+			if (kept_succ != NULL
+			    && get_Block_dom_depth(kept_succ) > nca_depth + 1
+			    && pset_new_insert(&visited, kept_succ)) {
+				if (get_Block_dom_depth(kept_succ) > depth)
+					ARR_APP1(ir_node*, unaffected, kept_succ);
+				else
+					pqueue_put(bucket, kept_succ,
+					           get_Block_dom_depth(kept_succ));
+			}
+
+			if (ARR_LEN(unaffected) == 0)
+				break;
+			size_t n_unaffected = ARR_LEN(unaffected);
+			block = unaffected[n_unaffected - 1];
+			ARR_SHRINKLEN(unaffected, n_unaffected - 1);
+		}
+	}
+	pset_new_destroy(&visited);
+	DEL_ARR_F(unaffected);
+	del_pqueue(bucket);
+
+	for (size_t i = 0, n = ARR_LEN(affected); i < n; ++i) {
+		tree_set_parent(affected[i], nca, get_dom_info);
+	}
+	DEL_ARR_F(affected);
+
+	tree_set_depth(nca, nca_depth, get_dom_info);
+	irg->dom_numbers_outdated = true;
+}
+
+/**
+ * Checks whether @p block has a predecessor which is not dominated by
+ * @p block, so @p block is reachable without the deleted edge.
+ */
+static bool has_proper_support(ir_node *block)
+{
+	for (int i = 0, n = get_Block_n_cfgpreds(block); i < n; ++i) {
+		ir_node *pred = get_Block_cfgpred_block(block, i);
+		if (pred == NULL || get_Block_dom_depth(pred) <= 0)
+			continue;
+		if (ir_deepest_common_dominator(block, pred) != block)
+			return true;
+	}
+	ir_graph *irg = get_irn_irg(block);
+	if (block == get_irg_end_block(irg)) {
+		foreach_irn_in(get_irg_end(irg), i, pred) {
+			if (!is_Block(pred) || get_Block_dom_depth(pred) <= 0)
+				continue;
+			if (ir_deepest_common_dominator(block, pred) != block)
+				return true;
+		}
+	}
+	return false;
+}
+
+void dom_delete_cf_edge(ir_node *from, ir_node *to)
+{
+	ir_graph *irg = get_irn_irg(from);
+	if (!can_update_doms(irg))
+		return;
+
+	if (get_Block_dom_depth(from) <= 0 || get_Block_dom_depth(to) <= 0)
+		return;
+
+	ir_node *nca = ir_deepest_common_dominator(from, to);
+	/* removing an edge to a dominator (a loop back edge) changes nothing */
+	if (nca == to)
+		return;
+
+	if (get_dom_info(to)->idom == from && !has_proper_support(to)) {
+		/* to and the blocks it dominates may have become dead */
+		clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE);
+		return;
+	}
+
+	rebuild_dom_subtree(nca);
+}
+
+void dom_split_cf_edge(ir_node *from, ir_node *split, ir_node *to)
+{
+	ir_graph *irg = get_irn_irg(from);
+	if (!irg_has_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE))
+		return;
+
+	memset(get_dom_info(split), 0, sizeof(ir_dom_info));
+	set_Block_dom_pre_num(split, -1);
+	int depth = get_Block_dom_depth(from);
+	if (depth <= 0) {
+		set_Block_dom_depth(split, -1);
+		return;
+	}
+	tree_set_parent(split, from, get_dom_info);
+	set_Block_dom_depth(split, depth + 1);
+
+	/* split dominates to if all other live predecessors of to are dominated
+	 * by to */
+	bool single = true;
+	for (int i = 0, n = get_Block_n_cfgpreds(to); i < n; ++i) {
+		ir_node *pred = get_Block_cfgpred_block(to, i);
+		if (pred != NULL && pred != split && get_Block_dom_depth(pred) > 0
+		    && !tree_dominates(to, pred, get_dom_info))
+			single = false;
+	}
+	if (to == get_irg_end_block(irg)) {
+		foreach_irn_in(get_irg_end(irg), i, pred) {
+			if (is_Block(pred) && get_Block_dom_depth(pred) > 0)
+				single = false;
+		}
+	}
+	if (single) {
+		tree_set_parent(to, split, get_dom_info);
+		tree_set_depth(to, depth + 2, get_dom_info);
+	}
+	irg->dom_numbers_outdated = true;
+}
+
+void pdom_split_cf_edge(ir_node *from, ir_node *split, ir_node *to)
+{
+	ir_graph *irg = get_irn_irg(from);
+	if (!irg_has_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_POSTDOMINANCE))
+		return;
+
+	memset(get_pdom_info(split), 0, sizeof(ir_dom_info));
+	set_Block_postdom_pre_num(split, -1);
+	int depth = get_Block_postdom_depth(to);
+	if (depth <= 0) {
+		set_Block_postdom_depth(split, -1);
+		return;
+	}
+
+	/* split postdominates from if all other successors of from reaching the
+	 * End block are postdominated by from */
+	bool single = true;
+	if (is_kept_alive(from)) {
+		clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_POSTDOMINANCE);
+		return;
+	} else if (edges_activated_kind(irg, EDGE_KIND_BLOCK)) {
+		foreach_block_succ(from, edge) {
+			ir_node *succ = get_edge_src_irn(edge);
+			if (succ != split && get_Block_postdom_depth(succ) > 0
+			    && !tree_dominates(from, succ, get_pdom_info))
+				single = false;
+		}
+	} else if (!is_Jmp(get_Block_cfgpred(split, 0))) {
+		clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_POSTDOMINANCE);
+		return;
+	}
+
+	tree_set_parent(split, to, get_pdom_info);
+	set_Block_postdom_depth(split, depth + 1);
+	if (single && get_Block_postdom_depth(from) > 0) {
+		tree_set_parent(from, split, get_pdom_info);
+		tree_set_depth(from, depth + 2, get_pdom_info);
+	}
+	irg->pdom_numbers_outdated = true;
+}
@@ -59,6 +59,34 @@ unsigned get_Block_pdom_max_subtree_pre_num(const ir_node *bl);
 
 void ir_free_dominance_frontiers(ir_graph *irg);
 
+/**
+ * Updates the dominator tree after the control flow edge from block @p from
+ * to block @p to has been added to the graph.
+ * Dominance is invalidated if it cannot be maintained (no block out edges or
+ * dead code becoming live).
+ */
+void dom_insert_cf_edge(ir_node *from, ir_node *to);
+
+/**
+ * Updates the dominator tree after the control flow edge from block @p from
+ * to block @p to has been removed from the graph.
+ * Dominance is invalidated if it cannot be maintained (no block out edges or
+ * @p to possibly becoming dead).
+ */
+void dom_delete_cf_edge(ir_node *from, ir_node *to);
+
+/**
+ * Updates the dominator tree after the control flow edge from block @p from
+ * to block @p to has been split by the new block @p split.
+ */
+void dom_split_cf_edge(ir_node *from, ir_node *split, ir_node *to);
+
+/**
+ * Updates the post dominator tree after the control flow edge from block
+ * @p from to block @p to has been split by the new block @p split.
+ */
+void pdom_split_cf_edge(ir_node *from, ir_node *split, ir_node *to);
+
 /**
  * Iterate over all nodes which are immediately dominated by a given
  * node.
@@ -12,6 +12,7 @@
 #include "irloop_t.h"
 
 #include "irprog_t.h"
+#include "util.h"
 #include <stdlib.h>
 
 void add_loop_son(ir_loop *loop, ir_loop *son)
@@ -55,6 +56,16 @@ void mature_loops(ir_loop *loop, struct obstack *obst)
 	}
 }
 
+void add_mature_loop_node(ir_loop *loop, ir_node *n, struct obstack *obst)
+{
+	assert(loop->kind == k_ir_loop);
+	size_t        n_children = ARR_LEN(loop->children);
+	loop_element *children   = NEW_ARR_D(loop_element, obst, n_children + 1);
+	MEMCPY(children, loop->children, n_children);
+	children[n_children].node = n;
+	loop->children = children;
+}
+
 ir_loop *(get_loop_outer_loop)(const ir_loop *loop)
 {
 	return _get_loop_outer_loop(loop);
@@ -73,6 +73,12 @@ void set_irn_loop(ir_node *n, ir_loop *loop);
  */
 void mature_loops(ir_loop *loop, struct obstack *obst);
 
+/**
+ * Adds a node to a loop whose children have already been matured by
+ * mature_loops(). The enlarged array is allocated on @p obst.
+ */
+void add_mature_loop_node(ir_loop *loop, ir_node *n, struct obstack *obst);
+
 /* -------- inline functions -------- */
 
 static inline int _is_ir_loop(const void *thing)
@@ -12,6 +12,7 @@
 #include "irmemory_t.h"
 
 #include "adt/pmap.h"
+#include "adt/set.h"
 #include "debug.h"
 #include "hashptr.h"
 #include "irflag.h"
@@ -26,8 +27,10 @@
 #include "type_t.h"
 #include "typerep.h"
 #include "util.h"
+#include "xmalloc.h"
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 
 /** The debug handle. */
 DEBUG_ONLY(static firm_dbg_module_t *dbg = NULL;)
@@ -48,6 +51,14 @@ const char *get_ir_alias_relation_name(ir_alias_relation rel)
 	panic("unknown alias relation");
 }
 
+/** Clears the memoized alias queries of all graphs. */
+static void invalidate_alias_caches(void)
+{
+	foreach_irp_irg(i, irg) {
+		clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_ALIAS_CACHE);
+	}
+}
+
 ir_disambiguator_options get_irg_memory_disambiguator_options(
 		ir_graph const *const irg)
 {
@@ -61,11 +72,13 @@ void set_irg_memory_disambiguator_options(ir_graph *irg,
                                           ir_disambiguator_options options)
 {
 	irg->mem_disambig_opt = options & ~aa_opt_inherited;
+	clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_ALIAS_CACHE);
 }
 
 void set_irp_memory_disambiguator_options(ir_disambiguator_options options)
 {
 	global_mem_disamgig_opt = options;
+	invalidate_alias_caches();
 }
 
 ir_storage_class_class_t get_base_sc(ir_storage_class_class_t x)
@@ -116,8 +129,7 @@ static const ir_node *find_base_addr(const ir_node *node, ir_entity **pEnt)
  *
  * @return true, if @c compound contains @c member
  */
-static bool type_contains(const ir_type *compound,
-                          const ir_type *member)
+bool type_contains(const ir_type *compound, const ir_type *member)
 {
 	if (is_Array_type(compound)) {
 		ir_type *elem = get_array_element_type(compound);
@@ -294,8 +306,95 @@ follow_ptr:
 	}
 }
 
-static ir_alias_relation _get_alias_relation(const ir_node *addr1, const ir_type *const objt1, unsigned size1,
-                                             const ir_node *addr2, const ir_type *const objt2, unsigned size2)
+/**
+ * Determines the alias relation of two objects by looking at the storage
+ * classes of their base addresses.
+ */
+static ir_alias_relation get_storage_alias_relation(
+		const ir_node *const base1, ir_storage_class_class_t const mod1,
+		const ir_node *const base2, ir_storage_class_class_t const mod2)
+{
+	const ir_storage_class_class_t class1 = get_base_sc(mod1);
+	const ir_storage_class_class_t class2 = get_base_sc(mod2);
+	ir_storage_class_class_t other_class;
+	ir_storage_class_class_t other_mod;
+	if (class1 == ir_sc_pointer) {
+		other_class = class2;
+		other_mod   = mod2;
+		goto pointer;
+	} else if (class2 == ir_sc_pointer) {
+		other_class = class1;
+		other_mod   = mod1;
+pointer:
+		/* a pointer and an object whose address was never taken */
+		if (other_mod & ir_sc_modifier_nottaken)
+			return ir_no_alias;
+		/* the null pointer aliases nothing */
+		if (other_class == ir_sc_null)
+			return ir_no_alias;
+	} else if (class1 != class2) {
+		/* objects from different memory spaces cannot alias */
+		return ir_no_alias;
+	} else {
+		/* both classes are equal */
+		if (class1 == ir_sc_globalvar) {
+			ir_entity *entity1 = get_Address_entity(base1);
+			ir_entity *entity2 = get_Address_entity(base2);
+			return entity1 != entity2 ? ir_no_alias : ir_may_alias;
+		} else if (class1 == ir_sc_localvar) {
+			ir_entity *entity1 = get_Member_entity(base1);
+			ir_entity *entity2 = get_Member_entity(base2);
+			return entity1 != entity2 ? ir_no_alias : ir_may_alias;
+		} else if (class1 == ir_sc_malloced) {
+			return base1 == base2 ? ir_sure_alias : ir_no_alias;
+		}
+	}
+	return ir_may_alias;
+}
+
+/** Address information of a node as used by the disambiguator. */
+typedef struct alias_address_t {
+	address_info   info;
+	const ir_node *base;       /**< base address after skipping Sels/Members */
+	ir_entity     *entity;     /**< entity of the outermost Member or NULL */
+	unsigned       generation; /**< alias cache generation, 0 if not cached */
+} alias_address_t;
+
+static alias_address_t analyze_address(const ir_node *const addr)
+{
+	alias_address_t address;
+	address.info       = get_address_info(addr);
+	address.entity     = NULL;
+	address.base       = find_base_addr(address.info.base, &address.entity);
+	address.generation = 0;
+	return address;
+}
+
+const ir_node *get_base_address(const ir_node *const addr)
+{
+	return analyze_address(addr).base;
+}
+
+bool objects_may_alias(const ir_node *const addr1, const ir_node *const addr2)
+{
+	alias_address_t const address1 = analyze_address(addr1);
+	alias_address_t const address2 = analyze_address(addr2);
+	const ir_node  *const base1    = address1.base;
+	const ir_node  *const base2    = address2.base;
+	if (base1 == base2)
+		return true;
+	ir_storage_class_class_t const mod1 = classify_pointer(base1, base1);
+	ir_storage_class_class_t const mod2 = classify_pointer(base2, base2);
+	if (get_storage_alias_relation(base1, mod1, base2, mod2) == ir_no_alias)
+		return false;
+	return get_points_to_alias_relation(address1.info.base, address2.info.base)
+	       != ir_no_alias;
+}
+
+static ir_alias_relation _get_alias_relation(const ir_node *addr1, const alias_address_t *const address1,
+                                             const ir_type *const objt1, unsigned size1,
+                                             const ir_node *addr2, const alias_address_t *const address2,
+                                             const ir_type *const objt2, unsigned size2)
 {
 	if (addr1 == addr2)
 		return ir_sure_alias;
@@ -315,8 +414,8 @@ static ir_alias_relation _get_alias_relation(const ir_node *addr1, const ir_type
 	 * offset can be handled.  To extend this, change
 	 * sym_offset to be a set, and compare the sets.
 	 */
-	address_info const info1   = get_address_info(addr1);
-	address_info const info2   = get_address_info(addr2);
+	address_info const info1   = address1->info;
+	address_info const info2   = address2->info;
 	long               offset1 = info1.offset;
 	long               offset2 = info2.offset;
 	addr1 = info1.base;
@@ -344,10 +443,10 @@ static ir_alias_relation _get_alias_relation(const ir_node *addr1, const ir_type
 	}
 
 	/* skip Sels/Members */
-	ir_entity     *ent1  = NULL;
-	ir_entity     *ent2  = NULL;
-	const ir_node *base1 = find_base_addr(addr1, &ent1);
-	const ir_node *base2 = find_base_addr(addr2, &ent2);
+	ir_entity     *const ent1  = address1->entity;
+	ir_entity     *const ent2  = address2->entity;
+	const ir_node *const base1 = address1->base;
+	const ir_node *const base2 = address2->base;
 
 	/* two struct accesses -> compare entities */
 	if (ent1 != NULL && ent2 != NULL) {
@@ -386,50 +485,25 @@ check_classes:;
 	    == (ir_sc_modifier_obj_comp | ir_sc_modifier_obj_prim))
 		return ir_no_alias;
 
-	const ir_storage_class_class_t class1 = mod1 & ~ir_sc_modifiers;
-	const ir_storage_class_class_t class2 = mod2 & ~ir_sc_modifiers;
-	ir_storage_class_class_t other_class;
-	ir_storage_class_class_t other_mod;
-	if (class1 == ir_sc_pointer) {
-		other_class = class2;
-		other_mod   = mod2;
-		goto pointer;
-	} else if (class2 == ir_sc_pointer) {
-		other_class = class1;
-		other_mod   = mod1;
-pointer:
-		/* a pointer and an object whose address was never taken */
-		if (other_mod & ir_sc_modifier_nottaken)
-			return ir_no_alias;
-		/* the null pointer aliases nothing */
-		if (other_class == ir_sc_null)
-			return ir_no_alias;
-	} else if (class1 != class2) {
-		/* objects from different memory spaces cannot alias */
-		return ir_no_alias;
-	} else {
-		/* both classes are equal */
-		if (class1 == ir_sc_globalvar) {
-			ir_entity *entity1 = get_Address_entity(base1);
-			ir_entity *entity2 = get_Address_entity(base2);
-			return entity1 != entity2 ? ir_no_alias : ir_may_alias;
-		} else if (class1 == ir_sc_localvar) {
-			ir_entity *entity1 = get_Member_entity(base1);
-			ir_entity *entity2 = get_Member_entity(base2);
-			return entity1 != entity2 ? ir_no_alias : ir_may_alias;
-		} else if (class1 == ir_sc_globaladdr) {
-			offset1 += get_Const_long(base1);
-			offset2 += get_Const_long(base2);
+	if (get_base_sc(mod1) == ir_sc_globaladdr
+	 && get_base_sc(mod2) == ir_sc_globaladdr) {
+		offset1 += get_Const_long(base1);
+		offset2 += get_Const_long(base2);
 
-			unsigned type_size = MAX(size1, size2);
-			if ((unsigned long)labs(offset2 - offset1) >= type_size)
-				return ir_no_alias;
-			else
-				return ir_sure_alias;
-		} else if (class1 == ir_sc_malloced) {
-			return base1 == base2 ? ir_sure_alias : ir_no_alias;
-		}
+		unsigned type_size = MAX(size1, size2);
+		if ((unsigned long)labs(offset2 - offset1) >= type_size)
+			return ir_no_alias;
+		else
+			return ir_sure_alias;
 	}
+	ir_alias_relation const rel = get_storage_alias_relation(base1, mod1,
+	                                                         base2, mod2);
+	if (rel != ir_may_alias)
+		return rel;
+
+	/* whole program points-to analysis */
+	if (get_points_to_alias_relation(addr1, addr2) == ir_no_alias)
+		return ir_no_alias;
 
 	/* Type based alias analysis */
 	if (options & aa_opt_type_based) {
@@ -474,10 +548,132 @@ leave_type_based_alias:;
 	return ir_may_alias;
 }
 
+/** A memoized alias query. */
+typedef struct alias_query_t {
+	unsigned           idx1;
+	unsigned           idx2;
+	unsigned           size1;
+	unsigned           size2;
+	const ir_type     *type1;
+	const ir_type     *type2;
+	ir_alias_relation  relation;
+} alias_query_t;
+
+/**
+ * Memoized alias queries of a graph, valid as long as the graph has
+ * IR_GRAPH_PROPERTY_CONSISTENT_ALIAS_CACHE. Losing the property starts a new
+ * generation instead of clearing the addresses, so frequent graph changes do
+ * not clear the whole array each time.
+ */
+struct ir_alias_cache {
+	alias_address_t *addresses;   /**< address information by node index */
+	unsigned         n_addresses;
+	unsigned         generation;  /**< generation of the valid addresses */
+	set             *queries;     /**< set of alias_query_t */
+};
+
+static int cmp_alias_query(const void *elt, const void *key, size_t size)
+{
+	(void)size;
+	const alias_query_t *const q1 = (const alias_query_t*)elt;
+	const alias_query_t *const q2 = (const alias_query_t*)key;
+	return q1->idx1 != q2->idx1 || q1->idx2 != q2->idx2
+	    || q1->size1 != q2->size1 || q1->size2 != q2->size2
+	    || q1->type1 != q2->type1 || q1->type2 != q2->type2;
+}
+
+static unsigned hash_alias_query(const alias_query_t *const query)
+{
+	unsigned hash = hash_combine(query->idx1, query->idx2);
+	hash = hash_combine(hash, hash_ptr(query->type1) ^ query->size1);
+	return hash_combine(hash, hash_ptr(query->type2) ^ query->size2);
+}
+
+void free_irg_alias_cache(ir_graph *const irg)
+{
+	ir_alias_cache *const cache = irg->alias_cache;
+	if (cache == NULL)
+		return;
+	del_set(cache->queries);
+	free(cache->addresses);
+	free(cache);
+	irg->alias_cache = NULL;
+}
+
+static ir_alias_cache *get_irg_alias_cache(ir_graph *const irg)
+{
+	ir_alias_cache *cache = irg->alias_cache;
+	if (cache == NULL) {
+		cache             = XMALLOCZ(ir_alias_cache);
+		cache->generation = 1;
+		cache->queries    = new_set(cmp_alias_query, 64);
+		irg->alias_cache  = cache;
+		add_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_ALIAS_CACHE);
+	} else if (!irg_has_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_ALIAS_CACHE)) {
+		del_set(cache->queries);
+		cache->queries = new_set(cmp_alias_query, 64);
+		if (++cache->generation == 0) {
+			memset(cache->addresses, 0,
+			       cache->n_addresses * sizeof(*cache->addresses));
+			cache->generation = 1;
+		}
+		add_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_ALIAS_CACHE);
+	}
+	return cache;
+}
+
+static alias_address_t get_cached_address(ir_alias_cache *const cache,
+                                          const ir_node *const addr)
+{
+	unsigned const idx = get_irn_idx(addr);
+	if (idx >= cache->n_addresses) {
+		unsigned const n_old = cache->n_addresses;
+		unsigned const n_new = MAX(MAX(idx + 1, n_old * 2),
+		                           get_irg_last_idx(get_irn_irg(addr)));
+		cache->addresses = XREALLOC(cache->addresses, alias_address_t, n_new);
+		memset(&cache->addresses[n_old], 0,
+		       (n_new - n_old) * sizeof(*cache->addresses));
+		cache->n_addresses = n_new;
+	}
+	alias_address_t *const address = &cache->addresses[idx];
+	if (address->generation != cache->generation) {
+		*address            = analyze_address(addr);
+		address->generation = cache->generation;
+	}
+	return *address;
+}
+
 ir_alias_relation get_alias_relation(const ir_node *const addr1, const ir_type *const type1, unsigned size1,
                                      const ir_node *const addr2, const ir_type *const type2, unsigned size2)
 {
-	ir_alias_relation rel = _get_alias_relation(addr1, type1, size1, addr2, type2, size2);
+	ir_graph *const irg = get_irn_irg(addr1);
+	ir_alias_relation rel;
+	if (get_irn_irg(addr2) != irg) {
+		alias_address_t const address1 = analyze_address(addr1);
+		alias_address_t const address2 = analyze_address(addr2);
+		rel = _get_alias_relation(addr1, &address1, type1, size1,
+		                          addr2, &address2, type2, size2);
+	} else {
+		ir_alias_cache *const cache = get_irg_alias_cache(irg);
+		alias_query_t         query = {
+			get_irn_idx(addr1), get_irn_idx(addr2), size1, size2, type1, type2,
+			ir_may_alias
+		};
+		unsigned       const hash  = hash_alias_query(&query);
+		alias_query_t *const found = set_find(alias_query_t, cache->queries,
+		                                      &query, sizeof(query), hash);
+		if (found != NULL) {
+			rel = found->relation;
+		} else {
+			alias_address_t const address1 = get_cached_address(cache, addr1);
+			alias_address_t const address2 = get_cached_address(cache, addr2);
+			rel = _get_alias_relation(addr1, &address1, type1, size1,
+			                          addr2, &address2, type2, size2);
+			query.relation = rel;
+			(void)set_insert(alias_query_t, cache->queries, &query,
+			                 sizeof(query), hash);
+		}
+	}
 	DB((dbg, LEVEL_1, "alias(%+F, %+F) = %s\n", addr1, addr2,
 	    get_ir_alias_relation_name(rel)));
 	return rel;
@@ -664,6 +860,7 @@ static void analyse_irg_entity_usage(ir_graph *irg)
 
 	/* now computed */
 	add_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_ENTITY_USAGE);
+	clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_ALIAS_CACHE);
 }
 
 void assure_irg_entity_usage_computed(ir_graph *irg)
@@ -847,6 +1044,7 @@ static void analyse_irp_globals_entity_usage(void)
 
 	/* now computed */
 	irp->globals_entity_usage_state = ir_entity_usage_computed;
+	invalidate_alias_caches();
 }
 
 ir_entity_usage_computed_state get_irp_globals_entity_usage_state(void)
@@ -22,6 +22,9 @@ void firm_init_memory_disambiguator(void);
 
 bool is_partly_volatile(ir_node *ptr);
 
+/** Frees the memoized alias queries of @p irg. */
+void free_irg_alias_cache(ir_graph *irg);
+
 /**
  * Classify storage locations.
  * Except ir_sc_pointer they are all disjoint.
@@ -60,4 +63,34 @@ ir_storage_class_class_t get_base_sc(ir_storage_class_class_t x);
 ir_storage_class_class_t classify_pointer(const ir_node *addr,
                                           const ir_node *base);
 
+/**
+ * Returns the base address of @p addr after skipping address arithmetic and
+ * Sels/Members.
+ */
+const ir_node *get_base_address(const ir_node *addr);
+
+/**
+ * Returns true if the memory objects containing @p addr1 and @p addr2 may be
+ * the same, regardless of the offsets into the objects.
+ */
+bool objects_may_alias(const ir_node *addr1, const ir_node *addr2);
+
+/** Returns true if @p compound contains a member of type @p member. */
+bool type_contains(const ir_type *compound, const ir_type *member);
+
+/**
+ * Determines the alias relation of two addresses using the results of
+ * compute_irp_points_to(). Returns ir_may_alias if there are no results for
+ * the addresses.
+ */
+ir_alias_relation get_points_to_alias_relation(const ir_node *addr1,
+                                               const ir_node *addr2);
+
+/**
+ * Appends the global entities @p addr may point to according to the results
+ * of compute_irp_points_to() to @p entities. Returns false if @p addr may
+ * point to other memory or there are no results for it.
+ */
+bool get_points_to_globals(const ir_node *addr, ir_entity ***entities);
+
 #endif
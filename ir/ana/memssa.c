@@ -0,0 +1,534 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2017 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Memory SSA overlay over the memory chain of a graph.
+ *
+ * Definitions are found by walking the memory chain upwards from a memory
+ * value and skipping every node which cannot modify the class in question.
+ * A memory Phi or Sync produces a merge definition of the class, which is
+ * created before its operands are visited so that loops terminate. Merges
+ * whose operands all reach the same definition are replaced by it, following
+ * the construction of Braun et al. ("Simple and Efficient Construction of
+ * Static Single Assignment Form").
+ */
+#include "memssa.h"
+
+#include "array.h"
+#include "debug.h"
+#include "hashptr.h"
+#include "irgraph_t.h"
+#include "irgwalk.h"
+#include "irmemory.h"
+#include "irnode_t.h"
+#include "irnodehashmap.h"
+#include "obst.h"
+#include "raw_bitset.h"
+#include "set.h"
+#include "type_t.h"
+#include "unionfind.h"
+#include "util.h"
+#include "xmalloc.h"
+
+/**
+ * Maximum number of accesses which are disambiguated pairwise. Graphs with
+ * more accesses put all of them into a single class.
+ */
+#define MAX_ACCESSES 512
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg = NULL;)
+
+/** A Load, Store or CopyB and the memory it accesses. */
+typedef struct access_t access_t;
+struct access_t {
+	ir_node  *node;
+	ir_node  *ptr;
+	ir_type  *type;
+	unsigned  size;
+	bool      write;
+	unsigned  cls;
+	access_t *src;  /**< the source access of a CopyB */
+};
+
+/** An entry of the per (node, class) caches. */
+typedef struct cache_entry_t {
+	const ir_node *node;
+	unsigned       cls;
+	memssa_def_t  *def;
+	ir_mod_ref     mod_ref;
+} cache_entry_t;
+
+struct memssa_t {
+	ir_graph         *irg;
+	struct obstack    obst;
+	access_t        **accesses;  /**< all accesses, flexible array */
+	ir_nodehashmap_t  node_map;  /**< maps nodes to their accesses */
+	unsigned          n_classes;
+	access_t       ***members;   /**< accesses of each class */
+	memssa_def_t    **entries;   /**< entry definitions of each class */
+	memssa_def_t    **merges;    /**< all merges, flexible array */
+	unsigned         *has_users; /**< classes with computed users */
+	set              *values;    /**< definitions of memory values */
+	set              *defs;      /**< definitions created by nodes */
+	set              *mod_refs;  /**< mod/ref of calls for classes */
+};
+
+static int cmp_cache_entry(const void *elt, const void *key, size_t size)
+{
+	(void)size;
+	const cache_entry_t *e1 = (const cache_entry_t*)elt;
+	const cache_entry_t *e2 = (const cache_entry_t*)key;
+	return e1->node != e2->node || e1->cls != e2->cls;
+}
+
+static cache_entry_t *find_entry(set *cache, const ir_node *node,
+                                 unsigned cls)
+{
+	cache_entry_t key = { .node = node, .cls = cls };
+	return set_find(cache_entry_t, cache, &key, sizeof(key),
+	                hash_combine(hash_ptr(node), cls));
+}
+
+static cache_entry_t *insert_entry(set *cache, const ir_node *node,
+                                   unsigned cls)
+{
+	cache_entry_t key = { .node = node, .cls = cls };
+	return set_insert(cache_entry_t, cache, &key, sizeof(key),
+	                  hash_combine(hash_ptr(node), cls));
+}
+
+static access_t *new_access(memssa_t *ms, ir_node *node, ir_node *ptr,
+                            ir_type *type, unsigned size, bool write)
+{
+	access_t *access = OALLOCZ(&ms->obst, access_t);
+	access->node  = node;
+	access->ptr   = ptr;
+	access->type  = type;
+	access->size  = size;
+	access->write = write;
+	ARR_APP1(access_t*, ms->accesses, access);
+	return access;
+}
+
+static void collect_accesses(ir_node *node, void *env)
+{
+	memssa_t *ms     = (memssa_t*)env;
+	access_t *access;
+	switch (get_irn_opcode(node)) {
+	case iro_Load: {
+		ir_mode *mode = get_Load_mode(node);
+		access = new_access(ms, node, get_Load_ptr(node), get_Load_type(node),
+		                    get_mode_size_bytes(mode), false);
+		break;
+	}
+	case iro_Store: {
+		ir_mode *mode = get_irn_mode(get_Store_value(node));
+		access = new_access(ms, node, get_Store_ptr(node),
+		                    get_Store_type(node), get_mode_size_bytes(mode),
+		                    true);
+		break;
+	}
+	case iro_CopyB: {
+		ir_type *type = get_CopyB_type(node);
+		unsigned size = get_type_size(type);
+		access = new_access(ms, node, get_CopyB_dst(node), type, size, true);
+		access->src = new_access(ms, node, get_CopyB_src(node), type, size,
+		                         false);
+		break;
+	}
+	default:
+		return;
+	}
+	ir_nodehashmap_insert(&ms->node_map, node, access);
+}
+
+static bool may_alias(const access_t *a1, const access_t *a2)
+{
+	return get_alias_relation(a1->ptr, a1->type, a1->size,
+	                          a2->ptr, a2->type, a2->size) != ir_no_alias;
+}
+
+/** Partitions the accesses into alias classes. */
+static void compute_classes(memssa_t *ms)
+{
+	size_t const n_accesses = ARR_LEN(ms->accesses);
+	int         *uf         = XMALLOCN(int, n_accesses);
+	uf_init(uf, n_accesses);
+
+	if (n_accesses > MAX_ACCESSES) {
+		DB((dbg, LEVEL_1, "%zu accesses in %+F, using a single class\n",
+		    n_accesses, ms->irg));
+		for (size_t i = 1; i < n_accesses; ++i)
+			uf_union(uf, uf_find(uf, 0), uf_find(uf, i));
+	} else {
+		for (size_t i = 0; i < n_accesses; ++i) {
+			access_t const *a1 = ms->accesses[i];
+			for (size_t j = i + 1; j < n_accesses; ++j) {
+				access_t const *a2 = ms->accesses[j];
+				if (!a1->write && !a2->write)
+					continue;
+				int const r1 = uf_find(uf, i);
+				int const r2 = uf_find(uf, j);
+				if (r1 != r2 && may_alias(a1, a2))
+					uf_union(uf, r1, r2);
+			}
+		}
+	}
+
+	/* number the classes densely */
+	unsigned *numbers = XMALLOCN(unsigned, n_accesses);
+	unsigned  n       = 0;
+	for (size_t i = 0; i < n_accesses; ++i) {
+		if (uf_find(uf, i) == (int)i)
+			numbers[i] = n++;
+	}
+	ms->n_classes = n;
+	ms->members   = XMALLOCN(access_t**, n);
+	for (unsigned c = 0; c < n; ++c)
+		ms->members[c] = NEW_ARR_F(access_t*, 0);
+	for (size_t i = 0; i < n_accesses; ++i) {
+		access_t *access = ms->accesses[i];
+		access->cls = numbers[uf_find(uf, i)];
+		ARR_APP1(access_t*, ms->members[access->cls], access);
+	}
+	DB((dbg, LEVEL_1, "%zu accesses in %u classes in %+F\n", n_accesses, n,
+	    ms->irg));
+
+	free(numbers);
+	free(uf);
+}
+
+memssa_t *memssa_new(ir_graph *irg)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.ana.memssa");
+
+	memssa_t *ms = XMALLOCZ(memssa_t);
+	ms->irg      = irg;
+	obstack_init(&ms->obst);
+	ms->accesses = NEW_ARR_F(access_t*, 0);
+	ms->merges   = NEW_ARR_F(memssa_def_t*, 0);
+	ms->values   = new_set(cmp_cache_entry, 64);
+	ms->defs     = new_set(cmp_cache_entry, 64);
+	ms->mod_refs = new_set(cmp_cache_entry, 16);
+	ir_nodehashmap_init(&ms->node_map);
+
+	irg_walk_graph(irg, NULL, collect_accesses, ms);
+	compute_classes(ms);
+
+	ms->entries   = XMALLOCNZ(memssa_def_t*, ms->n_classes);
+	ms->has_users = rbitset_malloc(ms->n_classes);
+	return ms;
+}
+
+void memssa_free(memssa_t *ms)
+{
+	for (unsigned c = 0; c < ms->n_classes; ++c)
+		DEL_ARR_F(ms->members[c]);
+	free(ms->members);
+	free(ms->entries);
+	free(ms->has_users);
+	DEL_ARR_F(ms->merges);
+	DEL_ARR_F(ms->accesses);
+	del_set(ms->mod_refs);
+	del_set(ms->defs);
+	del_set(ms->values);
+	ir_nodehashmap_destroy(&ms->node_map);
+	obstack_free(&ms->obst, NULL);
+	free(ms);
+}
+
+static access_t *get_access(const memssa_t *ms, const ir_node *node)
+{
+	return ir_nodehashmap_get(access_t, &ms->node_map, node);
+}
+
+unsigned memssa_get_class(const memssa_t *ms, const ir_node *node)
+{
+	access_t const *const access = get_access(ms, node);
+	return access != NULL ? access->cls : MEMSSA_NO_CLASS;
+}
+
+/** Returns how the Call @p call may access memory of class @p cls. */
+static ir_mod_ref get_call_class_mod_ref(memssa_t *ms, const ir_node *call,
+                                         unsigned cls)
+{
+	cache_entry_t *entry = find_entry(ms->mod_refs, call, cls);
+	if (entry != NULL)
+		return entry->mod_ref;
+
+	ir_mod_ref mod_ref = ir_mod_ref_none;
+	for (size_t i = 0, n = ARR_LEN(ms->members[cls]); i < n; ++i) {
+		mod_ref |= get_call_mod_ref(call, ms->members[cls][i]->ptr);
+		if (mod_ref == ir_mod_ref_mod_ref)
+			break;
+	}
+	entry = insert_entry(ms->mod_refs, call, cls);
+	entry->mod_ref = mod_ref;
+	return mod_ref;
+}
+
+/** Checks whether the node @p op may modify memory of class @p cls. */
+static bool may_modify(memssa_t *ms, const ir_node *op, unsigned cls)
+{
+	switch (get_irn_opcode(op)) {
+	case iro_Load:
+		return false;
+	case iro_Store:
+	case iro_CopyB:
+		return get_access(ms, op)->cls == cls;
+	case iro_Call:
+		return get_call_class_mod_ref(ms, op, cls) & ir_mod_ref_mod;
+	default:
+		return !is_memop(op) || !is_irn_const_memory(op);
+	}
+}
+
+/** Checks whether the node @p op may read memory of class @p cls. */
+static bool may_read(memssa_t *ms, const ir_node *op, unsigned cls)
+{
+	switch (get_irn_opcode(op)) {
+	case iro_Load:
+		return get_access(ms, op)->cls == cls;
+	case iro_Store:
+		return false;
+	case iro_CopyB:
+		return get_access(ms, op)->src->cls == cls;
+	case iro_Call:
+		return get_call_class_mod_ref(ms, op, cls) & ir_mod_ref_ref;
+	default:
+		return !is_memop(op) || !is_irn_const_memory(op);
+	}
+}
+
+static memssa_def_t *new_def(memssa_t *ms, memssa_def_kind_t kind,
+                             unsigned cls, ir_node *node)
+{
+	memssa_def_t *def = OALLOCZ(&ms->obst, memssa_def_t);
+	def->kind = kind;
+	def->cls  = cls;
+	def->node = node;
+	return def;
+}
+
+static memssa_def_t *get_entry_def(memssa_t *ms, unsigned cls)
+{
+	memssa_def_t *def = ms->entries[cls];
+	if (def == NULL) {
+		def = new_def(ms, memssa_def_entry, cls, get_irg_start(ms->irg));
+		ms->entries[cls] = def;
+	}
+	return def;
+}
+
+/** Returns the definition of class @p cls created by @p op. */
+static memssa_def_t *get_node_def(memssa_t *ms, ir_node *op, unsigned cls)
+{
+	cache_entry_t *entry = find_entry(ms->defs, op, cls);
+	if (entry == NULL) {
+		entry      = insert_entry(ms->defs, op, cls);
+		entry->def = new_def(ms, memssa_def_node, cls, op);
+	}
+	return entry->def;
+}
+
+static memssa_def_t *resolve(memssa_def_t *def)
+{
+	if (def == NULL || def->replacement == NULL)
+		return def;
+	memssa_def_t *const repl = resolve(def->replacement);
+	def->replacement = repl;
+	return repl;
+}
+
+/**
+ * Replaces the merge @p def by its single operand if all other operands are
+ * the merge itself or Bad.
+ * @return true if the merge was replaced
+ */
+static bool simplify_merge(memssa_def_t *def)
+{
+	if (def->replacement != NULL)
+		return false;
+	memssa_def_t *same = NULL;
+	for (size_t i = 0; i < def->n_ops; ++i) {
+		memssa_def_t *const op = resolve(def->ops[i]);
+		if (op == NULL || op == def || op == same)
+			continue;
+		if (same != NULL)
+			return false;
+		same = op;
+	}
+	/* merges reached by no definition only occur in dead code */
+	if (same == NULL)
+		return false;
+	def->replacement = same;
+	return true;
+}
+
+/** Simplifies the merges created since @p first until a fixpoint. */
+static void simplify_merges(memssa_t *ms, size_t first)
+{
+	bool changed;
+	do {
+		changed = false;
+		for (size_t i = first, n = ARR_LEN(ms->merges); i < n; ++i)
+			changed |= simplify_merge(ms->merges[i]);
+	} while (changed);
+}
+
+static memssa_def_t *get_def(memssa_t *ms, ir_node *mem, unsigned cls);
+
+static memssa_def_t *new_merge(memssa_t *ms, ir_node *node, unsigned cls,
+                               memssa_def_kind_t kind)
+{
+	int const     arity = get_irn_arity(node);
+	memssa_def_t *def   = new_def(ms, kind, cls, node);
+	def->n_ops = arity;
+	def->ops   = OALLOCN(&ms->obst, memssa_def_t*, arity);
+	ARR_APP1(memssa_def_t*, ms->merges, def);
+	/* register the merge before visiting its operands to terminate loops */
+	insert_entry(ms->values, node, cls)->def = def;
+
+	for (int i = 0; i < arity; ++i)
+		def->ops[i] = get_def(ms, get_irn_n(node, i), cls);
+	simplify_merge(def);
+	return def;
+}
+
+/**
+ * Returns the (possibly trivial) definition of class @p cls reaching the
+ * memory value @p mem, or NULL for Bad.
+ */
+static memssa_def_t *get_def(memssa_t *ms, ir_node *mem, unsigned cls)
+{
+	ir_node     **visited = NEW_ARR_F(ir_node*, 0);
+	memssa_def_t *def;
+	for (;;) {
+		cache_entry_t const *const entry = find_entry(ms->values, mem, cls);
+		if (entry != NULL) {
+			def = entry->def;
+			break;
+		}
+		if (is_Phi(mem)) {
+			def = new_merge(ms, mem, cls, memssa_def_phi);
+			break;
+		} else if (is_Sync(mem)) {
+			def = new_merge(ms, mem, cls, memssa_def_sync);
+			break;
+		} else if (is_Bad(mem)) {
+			def = NULL;
+			break;
+		}
+
+		ir_node *const op = is_Proj(mem) ? get_Proj_pred(mem) : mem;
+		if (is_Start(op) || is_NoMem(op) || is_Unknown(op)) {
+			def = get_entry_def(ms, cls);
+			break;
+		} else if (!is_memop(op) || may_modify(ms, op, cls)) {
+			def = get_node_def(ms, op, cls);
+			break;
+		}
+		ARR_APP1(ir_node*, visited, mem);
+		mem = get_memop_mem(op);
+	}
+
+	for (size_t i = 0, n = ARR_LEN(visited); i < n; ++i)
+		insert_entry(ms->values, visited[i], cls)->def = def;
+	DEL_ARR_F(visited);
+	return def;
+}
+
+memssa_def_t *memssa_get_def(memssa_t *ms, ir_node *mem, unsigned cls)
+{
+	assert(cls < ms->n_classes);
+	size_t const        first = ARR_LEN(ms->merges);
+	memssa_def_t *const def   = get_def(ms, mem, cls);
+	simplify_merges(ms, first);
+	return resolve(def);
+}
+
+memssa_def_t *memssa_get_clobber(memssa_t *ms, ir_node *node)
+{
+	return memssa_get_def(ms, get_memop_mem(node), memssa_get_class(ms, node));
+}
+
+static void add_user(memssa_t *ms, memssa_def_t *def, ir_node *node,
+                     memssa_def_t *own)
+{
+	if (def == NULL)
+		return;
+	memssa_use_t *use = OALLOC(&ms->obst, memssa_use_t);
+	use->node  = node;
+	use->def   = own;
+	use->next  = def->users;
+	def->users = use;
+}
+
+/** Collects the nodes consuming memory besides merges and keep-alives. */
+static void collect_consumers(ir_node *node, void *env)
+{
+	ir_node ***consumers = (ir_node***)env;
+	if (is_Phi(node) || is_Sync(node) || is_End(node) || is_Anchor(node)
+	    || is_Proj(node) || is_Block(node))
+		return;
+	foreach_irn_in(node, i, pred) {
+		if (get_irn_mode(pred) == mode_M) {
+			ARR_APP1(ir_node*, *consumers, node);
+			return;
+		}
+	}
+}
+
+static void compute_users(memssa_t *ms, unsigned cls)
+{
+	ir_node **consumers = NEW_ARR_F(ir_node*, 0);
+	irg_walk_graph(ms->irg, NULL, collect_consumers, &consumers);
+
+	/* create all definitions of the class before registering users */
+	size_t const first = ARR_LEN(ms->merges);
+	for (size_t i = 0, n = ARR_LEN(consumers); i < n; ++i) {
+		ir_node *const node = consumers[i];
+		foreach_irn_in(node, p, pred) {
+			if (get_irn_mode(pred) == mode_M)
+				(void)get_def(ms, pred, cls);
+		}
+	}
+	simplify_merges(ms, first);
+
+	for (size_t i = 0, n = ARR_LEN(ms->merges); i < n; ++i) {
+		memssa_def_t *const merge = ms->merges[i];
+		if (merge->cls != cls || merge->replacement != NULL)
+			continue;
+		for (size_t o = 0; o < merge->n_ops; ++o) {
+			memssa_def_t *const op = resolve(merge->ops[o]);
+			if (op != merge)
+				add_user(ms, op, merge->node, merge);
+		}
+	}
+
+	for (size_t i = 0, n = ARR_LEN(consumers); i < n; ++i) {
+		ir_node *const node = consumers[i];
+		bool const     mod  = !is_memop(node) || may_modify(ms, node, cls);
+		if (!mod && !may_read(ms, node, cls))
+			continue;
+		memssa_def_t *const own = mod ? get_node_def(ms, node, cls) : NULL;
+		foreach_irn_in(node, p, pred) {
+			if (get_irn_mode(pred) == mode_M)
+				add_user(ms, resolve(get_def(ms, pred, cls)), node, own);
+		}
+	}
+	DEL_ARR_F(consumers);
+}
+
+memssa_use_t const *memssa_get_users(memssa_t *ms, memssa_def_t *def)
+{
+	assert(def->replacement == NULL);
+	if (!rbitset_is_set(ms->has_users, def->cls)) {
+		rbitset_set(ms->has_users, def->cls);
+		compute_users(ms, def->cls);
+	}
+	return def->users;
+}
@@ -0,0 +1,96 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2017 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Memory SSA overlay over the memory chain of a graph.
+ *
+ * The memory accesses of a graph (Loads, Stores and CopyBs) are partitioned
+ * into alias classes: two accesses which may alias, and one of which writes,
+ * end up in the same class. For every class the overlay links each memory
+ * value to its nearest definition, which is a node that may modify memory of
+ * the class, a per-class memory Phi or Sync merge, or the memory state at
+ * function entry. Merges whose operands all reach the same definition are
+ * skipped, so a Load sees its nearest clobbering Store even across loops
+ * and branches which do not touch its class.
+ *
+ * The overlay is built lazily and does not observe graph changes. Removing
+ * Loads is harmless; any other change invalidates it.
+ */
+#ifndef FIRM_ANA_MEMSSA_H
+#define FIRM_ANA_MEMSSA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "firm_types.h"
+
+/** The class of nodes not accessing memory through an address. */
+#define MEMSSA_NO_CLASS ((unsigned)-1)
+
+typedef enum memssa_def_kind_t {
+	memssa_def_entry, /**< memory state at function entry */
+	memssa_def_node,  /**< a node which may modify memory of the class */
+	memssa_def_phi,   /**< merge of control flow */
+	memssa_def_sync,  /**< merge of unordered memory chains */
+} memssa_def_kind_t;
+
+typedef struct memssa_def_t memssa_def_t;
+typedef struct memssa_use_t memssa_use_t;
+typedef struct memssa_t     memssa_t;
+
+/** A definition of the memory of one alias class. */
+struct memssa_def_t {
+	memssa_def_kind_t kind;
+	unsigned          cls;         /**< the alias class */
+	ir_node          *node;        /**< the modifying node, Phi or Sync */
+	memssa_def_t     *replacement; /**< set if this merge is trivial */
+	size_t            n_ops;       /**< number of merged definitions */
+	memssa_def_t    **ops;         /**< merged definitions, NULL for Bads */
+	memssa_use_t     *users;       /**< see memssa_get_users() */
+};
+
+/** A node reading or overwriting the memory of a definition. */
+struct memssa_use_t {
+	ir_node      *node; /**< the user */
+	memssa_def_t *def;  /**< the definition created by the user or NULL */
+	memssa_use_t *next;
+};
+
+/**
+ * Creates the memory SSA overlay of @p irg.
+ * Requires the entity usage state of the graph if type based or entity
+ * based disambiguation is used.
+ */
+memssa_t *memssa_new(ir_graph *irg);
+
+/** Frees the memory SSA overlay @p ms. */
+void memssa_free(memssa_t *ms);
+
+/**
+ * Returns the alias class of the Load, Store or CopyB @p node. For CopyB the
+ * class of the destination is returned.
+ */
+unsigned memssa_get_class(const memssa_t *ms, const ir_node *node);
+
+/**
+ * Returns the nearest definition of memory of class @p cls reaching the
+ * memory value @p mem.
+ */
+memssa_def_t *memssa_get_def(memssa_t *ms, ir_node *mem, unsigned cls);
+
+/**
+ * Returns the nearest definition reaching the Load, Store or CopyB
+ * @p node in its class.
+ */
+memssa_def_t *memssa_get_clobber(memssa_t *ms, ir_node *node);
+
+/**
+ * Returns the nodes using the definition @p def: all nodes which read memory
+ * of its class, the nodes defining the class next and the merges using it.
+ * The users of all definitions of the class are computed on the first call.
+ */
+memssa_use_t const *memssa_get_users(memssa_t *ms, memssa_def_t *def);
+
+#endif
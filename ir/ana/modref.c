@@ -0,0 +1,587 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2017 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Interprocedural mod/ref summaries of methods.
+ *
+ * The summary of a method describes which memory the method and its callees
+ * may read (ref) and write (mod). Memory is described by the global entities
+ * accessed directly or through pointers resolved by the points-to analysis,
+ * the parameters whose pointees are accessed and a flag for accesses through
+ * any other pointer. Accesses to the frame of the method
+ * and to memory allocated by it are invisible to its callers and ignored.
+ *
+ * The summaries are computed bottom-up over the call graph and iterated to a
+ * fixpoint for recursive methods. A call then only interferes with an
+ * address if the summary of one of its callees, mapped to the arguments of
+ * the call, may access it.
+ */
+#include "irmemory_t.h"
+
+#include "array.h"
+#include "cgana.h"
+#include "debug.h"
+#include "irgraph_t.h"
+#include "irgwalk.h"
+#include "irnode_t.h"
+#include "irprog_t.h"
+#include "obst.h"
+#include "pmap.h"
+#include "pset_new.h"
+#include "raw_bitset.h"
+#include "statev_t.h"
+#include "timing.h"
+#include "type_t.h"
+#include "util.h"
+#include "xmalloc.h"
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg = NULL;)
+
+/** Index of the ref and mod sets of a summary. */
+typedef enum mod_ref_kind_t {
+	MOD_REF_REF,
+	MOD_REF_MOD,
+} mod_ref_kind_t;
+
+/** Memory accessed by a method in one way. */
+typedef struct mod_ref_set_t {
+	pset_new_t  entities; /**< global entities accessed */
+	unsigned   *args;     /**< parameters whose pointees are accessed */
+	bool        unknown;  /**< any other memory may be accessed */
+} mod_ref_set_t;
+
+typedef struct mod_ref_summary_t {
+	ir_type       *mtp;         /**< method type the summary was computed for */
+	size_t         n_params;
+	mod_ref_set_t  sets[2];     /**< indexed by mod_ref_kind_t */
+	ir_node      **memops;      /**< nodes of the graph accessing memory */
+	ir_graph     **callers;     /**< graphs calling the method */
+	bool           in_worklist;
+} mod_ref_summary_t;
+
+typedef struct mod_ref_env_t {
+	struct obstack   obst;
+	pmap            *summaries; /**< ir_entity -> mod_ref_summary_t */
+	ir_graph       **worklist;
+} mod_ref_env_t;
+
+/** The result of the last analysis. */
+static mod_ref_env_t *mod_ref;
+
+static mod_ref_summary_t *get_summary(ir_entity const *const entity)
+{
+	if (mod_ref == NULL)
+		return NULL;
+	mod_ref_summary_t *const summary
+		= pmap_get(mod_ref_summary_t, mod_ref->summaries, entity);
+	/* lowering may change the parameters of a method */
+	if (summary == NULL || summary->mtp != get_entity_type(entity))
+		return NULL;
+	return summary;
+}
+
+static bool set_unknown(mod_ref_set_t *const set)
+{
+	if (set->unknown)
+		return false;
+	set->unknown = true;
+	return true;
+}
+
+static bool add_entity(mod_ref_set_t *const set, ir_entity *const entity)
+{
+	if (set->unknown)
+		return false;
+	return pset_new_insert(&set->entities, entity);
+}
+
+static bool add_arg(mod_ref_set_t *const set, size_t const arg)
+{
+	if (set->unknown || rbitset_is_set(set->args, arg))
+		return false;
+	rbitset_set(set->args, arg);
+	return true;
+}
+
+/**
+ * Returns the parameter number if @p node is a parameter of its graph,
+ * -1 otherwise.
+ */
+static int get_param_num(ir_node const *const node)
+{
+	if (!is_Proj(node))
+		return -1;
+	ir_node const *const args = get_Proj_pred(node);
+	if (!is_Proj(args) || get_Proj_num(args) != pn_Start_T_args
+	 || !is_Start(get_Proj_pred(args)))
+		return -1;
+	return (int)get_Proj_num(node);
+}
+
+/** Records an access of @p summary's method to the memory at @p addr. */
+static bool add_access(mod_ref_summary_t *const summary,
+                       mod_ref_kind_t const kind, ir_node const *const addr)
+{
+	mod_ref_set_t *const set = &summary->sets[kind];
+	if (set->unknown)
+		return false;
+
+	ir_node const *const           base = get_base_address(addr);
+	ir_storage_class_class_t const sc   = get_base_sc(classify_pointer(base, base));
+	switch (sc) {
+	case ir_sc_globalvar:
+	case ir_sc_tls:
+		return add_entity(set, get_Address_entity(base));
+	case ir_sc_localvar:
+	case ir_sc_argument:
+	case ir_sc_malloced:
+	case ir_sc_null:
+		/* the frame and new objects are invisible to the callers */
+		return false;
+	case ir_sc_pointer: {
+		if (is_Proj(base) && is_Alloc(get_Proj_pred(base)))
+			return false;
+		int const param = get_param_num(base);
+		if (param >= 0 && (size_t)param < summary->n_params)
+			return add_arg(set, param);
+
+		ir_entity **globals = NEW_ARR_F(ir_entity*, 0);
+		bool        changed = false;
+		if (get_points_to_globals(addr, &globals)) {
+			for (size_t i = 0, n = ARR_LEN(globals); i < n; ++i) {
+				changed |= add_entity(set, globals[i]);
+			}
+		} else {
+			changed = set_unknown(set);
+		}
+		DEL_ARR_F(globals);
+		return changed;
+	}
+	default:
+		return set_unknown(set);
+	}
+}
+
+/** Adds the effects of a callee without summary with properties @p props. */
+static bool add_unknown_effects(mod_ref_summary_t *const summary,
+                                mtp_additional_properties const props)
+{
+	if (props & mtp_property_pure)
+		return false;
+	bool changed = set_unknown(&summary->sets[MOD_REF_REF]);
+	if (!(props & mtp_property_no_write))
+		changed |= set_unknown(&summary->sets[MOD_REF_MOD]);
+	return changed;
+}
+
+/** Maps the accesses of a callee to the arguments of @p call. */
+static bool merge_set(mod_ref_summary_t *const summary,
+                      mod_ref_kind_t const kind,
+                      mod_ref_summary_t const *const callee,
+                      ir_node const *const call)
+{
+	mod_ref_set_t       *const set        = &summary->sets[kind];
+	mod_ref_set_t const *const callee_set = &callee->sets[kind];
+	if (callee_set->unknown)
+		return set_unknown(set);
+
+	bool changed = false;
+	/* a recursive call cannot add entities to the set being iterated */
+	if (callee != summary) {
+		ir_entity            *entity;
+		pset_new_iterator_t   iter;
+		foreach_pset_new(&callee_set->entities, ir_entity*, entity, iter) {
+			changed |= add_entity(set, entity);
+		}
+	}
+	size_t const n_call_params = get_Call_n_params(call);
+	for (size_t i = 0; i < callee->n_params; ++i) {
+		if (!rbitset_is_set(callee_set->args, i))
+			continue;
+		if (i >= n_call_params)
+			return set_unknown(set) || changed;
+		changed |= add_access(summary, kind, get_Call_param(call, i));
+	}
+	return changed;
+}
+
+static bool add_callee_effects(mod_ref_summary_t *const summary,
+                               ir_node const *const call,
+                               ir_entity *const callee)
+{
+	mtp_additional_properties const props
+		= get_entity_additional_properties(callee)
+		| get_method_additional_properties(get_Call_type(call));
+	mod_ref_summary_t const *const callee_summary = get_summary(callee);
+	if (callee_summary == NULL)
+		return add_unknown_effects(summary, props);
+	if (props & mtp_property_pure)
+		return false;
+	bool changed = merge_set(summary, MOD_REF_REF, callee_summary, call);
+	if (!(props & mtp_property_no_write))
+		changed |= merge_set(summary, MOD_REF_MOD, callee_summary, call);
+	return changed;
+}
+
+static bool add_call_effects(mod_ref_summary_t *const summary,
+                             ir_node const *const call)
+{
+	if (cg_call_has_callees(call)) {
+		bool changed = false;
+		for (size_t i = 0, n = cg_get_call_n_callees(call); i < n; ++i) {
+			ir_entity *const callee = cg_get_call_callee(call, i);
+			if (is_unknown_entity(callee)) {
+				changed |= add_unknown_effects(summary,
+					get_method_additional_properties(get_Call_type(call)));
+			} else {
+				changed |= add_callee_effects(summary, call, callee);
+			}
+		}
+		return changed;
+	}
+	ir_entity *const callee = get_Call_callee(call);
+	if (callee == NULL) {
+		return add_unknown_effects(summary,
+			get_method_additional_properties(get_Call_type(call)));
+	}
+	return add_callee_effects(summary, call, callee);
+}
+
+static bool add_builtin_effects(mod_ref_summary_t *const summary,
+                                ir_node const *const node)
+{
+	switch (get_Builtin_kind(node)) {
+	case ir_bk_return_address:
+	case ir_bk_frame_address:
+	case ir_bk_prefetch:
+	case ir_bk_ffs:
+	case ir_bk_clz:
+	case ir_bk_ctz:
+	case ir_bk_popcount:
+	case ir_bk_parity:
+	case ir_bk_bswap:
+	case ir_bk_may_alias:
+		return false;
+	case ir_bk_compare_swap: {
+		ir_node const *const ptr = get_Builtin_param(node, 0);
+		return add_access(summary, MOD_REF_REF, ptr)
+		     | add_access(summary, MOD_REF_MOD, ptr);
+	}
+	default:
+		return set_unknown(&summary->sets[MOD_REF_REF])
+		     | set_unknown(&summary->sets[MOD_REF_MOD]);
+	}
+}
+
+/** Updates @p summary from the memory operations of its graph, returns true
+ * if it changed. */
+static bool update_summary(mod_ref_summary_t *const summary)
+{
+	bool changed = false;
+	for (size_t i = 0, n = ARR_LEN(summary->memops); i < n; ++i) {
+		ir_node const *const node = summary->memops[i];
+		switch (get_irn_opcode(node)) {
+		case iro_Load:
+			changed |= add_access(summary, MOD_REF_REF, get_Load_ptr(node));
+			break;
+		case iro_Store:
+			changed |= add_access(summary, MOD_REF_MOD, get_Store_ptr(node));
+			break;
+		case iro_CopyB:
+			changed |= add_access(summary, MOD_REF_REF, get_CopyB_src(node));
+			changed |= add_access(summary, MOD_REF_MOD, get_CopyB_dst(node));
+			break;
+		case iro_Call:
+			changed |= add_call_effects(summary, node);
+			break;
+		case iro_Builtin:
+			changed |= add_builtin_effects(summary, node);
+			break;
+		default:
+			changed |= set_unknown(&summary->sets[MOD_REF_REF]);
+			changed |= set_unknown(&summary->sets[MOD_REF_MOD]);
+			break;
+		}
+	}
+	return changed;
+}
+
+static void add_caller(ir_graph *const caller, ir_entity const *const callee)
+{
+	mod_ref_summary_t *const summary = get_summary(callee);
+	if (summary != NULL)
+		ARR_APP1(ir_graph*, summary->callers, caller);
+}
+
+static void collect_memops(ir_node *const node, void *const env)
+{
+	mod_ref_summary_t *const summary = (mod_ref_summary_t*)env;
+	switch (get_irn_opcode(node)) {
+	case iro_Call: {
+		ir_graph *const irg = get_irn_irg(node);
+		if (cg_call_has_callees(node)) {
+			for (size_t i = 0, n = cg_get_call_n_callees(node); i < n; ++i)
+				add_caller(irg, cg_get_call_callee(node, i));
+		} else {
+			ir_entity *const callee = get_Call_callee(node);
+			if (callee != NULL)
+				add_caller(irg, callee);
+		}
+		break;
+	}
+	case iro_Load:
+	case iro_Store:
+	case iro_CopyB:
+	case iro_Builtin:
+	case iro_ASM:
+		break;
+	default:
+		/* Alloc, Free, Div, Mod, ... only touch the frame or no memory */
+		return;
+	}
+	ARR_APP1(ir_node*, summary->memops, node);
+}
+
+static void init_set(mod_ref_env_t *const env, mod_ref_set_t *const set,
+                     size_t const n_params)
+{
+	pset_new_init(&set->entities);
+	set->args    = rbitset_obstack_alloc(&env->obst, n_params);
+	set->unknown = false;
+}
+
+static void push_worklist(mod_ref_env_t *const env, ir_graph *const irg)
+{
+	mod_ref_summary_t *const summary = get_summary(get_irg_entity(irg));
+	if (summary == NULL || summary->in_worklist)
+		return;
+	summary->in_worklist = true;
+	ARR_APP1(ir_graph*, env->worklist, irg);
+}
+
+void compute_irp_mod_ref(void)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.ana.modref");
+	free_irp_mod_ref();
+
+	stat_ev_tim_push();
+	ir_timer_t *const timer = ir_timer_new();
+	ir_timer_start(timer);
+
+	mod_ref_env_t *const env = XMALLOCZ(mod_ref_env_t);
+	obstack_init(&env->obst);
+	env->summaries = pmap_create();
+	env->worklist  = NEW_ARR_F(ir_graph*, 0);
+	mod_ref = env;
+
+	ir_entity **free_methods;
+	cgana(&free_methods);
+	free(free_methods);
+	/* accesses through other pointers than parameters are resolved to the
+	 * global entities they may point to */
+	assure_irp_points_to(ir_points_to_steensgaard);
+
+	foreach_irp_irg(i, irg) {
+		ir_entity         *const entity  = get_irg_entity(irg);
+		ir_type           *const mtp     = get_entity_type(entity);
+		mod_ref_summary_t *const summary = OALLOCZ(&env->obst, mod_ref_summary_t);
+		summary->mtp      = mtp;
+		summary->n_params = get_method_n_params(mtp);
+		init_set(env, &summary->sets[MOD_REF_REF], summary->n_params);
+		init_set(env, &summary->sets[MOD_REF_MOD], summary->n_params);
+		summary->memops   = NEW_ARR_F(ir_node*, 0);
+		summary->callers  = NEW_ARR_F(ir_graph*, 0);
+		pmap_insert(env->summaries, entity, summary);
+	}
+	foreach_irp_irg(i, irg) {
+		mod_ref_summary_t *const summary = get_summary(get_irg_entity(irg));
+		irg_walk_graph(irg, NULL, collect_memops, summary);
+	}
+
+	/* push in reverse order, so that the graphs are processed in program
+	 * order, which tends to be bottom-up for C */
+	for (size_t i = get_irp_n_irgs(); i-- > 0;) {
+		push_worklist(env, get_irp_irg(i));
+	}
+	unsigned long n_updates = 0;
+	while (ARR_LEN(env->worklist) > 0) {
+		size_t             const n       = ARR_LEN(env->worklist);
+		ir_graph          *const irg     = env->worklist[n - 1];
+		mod_ref_summary_t *const summary = get_summary(get_irg_entity(irg));
+		ARR_SHRINKLEN(env->worklist, n - 1);
+		summary->in_worklist = false;
+		++n_updates;
+		if (!update_summary(summary))
+			continue;
+		for (size_t c = 0, n_callers = ARR_LEN(summary->callers);
+		     c < n_callers; ++c) {
+			push_worklist(env, summary->callers[c]);
+		}
+	}
+
+	foreach_pmap(env->summaries, entry) {
+		mod_ref_summary_t *const summary = (mod_ref_summary_t*)entry->value;
+		DEL_ARR_F(summary->memops);
+		DEL_ARR_F(summary->callers);
+		summary->memops  = NULL;
+		summary->callers = NULL;
+		DB((dbg, LEVEL_2, "%+F: ref %zu%s, mod %zu%s\n", entry->key,
+		    pset_new_size(&summary->sets[MOD_REF_REF].entities),
+		    summary->sets[MOD_REF_REF].unknown ? " unknown" : "",
+		    pset_new_size(&summary->sets[MOD_REF_MOD].entities),
+		    summary->sets[MOD_REF_MOD].unknown ? " unknown" : ""));
+	}
+
+	ir_timer_stop(timer);
+	DB((dbg, LEVEL_1, "%lu summary updates, %lu usec\n", n_updates,
+	    ir_timer_elapsed_usec(timer)));
+	ir_timer_free(timer);
+	stat_ev_tim_pop("modref_time");
+	stat_ev_ull("modref_updates", n_updates);
+}
+
+void free_irp_mod_ref(void)
+{
+	mod_ref_env_t *const env = mod_ref;
+	if (env == NULL)
+		return;
+
+	foreach_pmap(env->summaries, entry) {
+		mod_ref_summary_t *const summary = (mod_ref_summary_t*)entry->value;
+		pset_new_destroy(&summary->sets[MOD_REF_REF].entities);
+		pset_new_destroy(&summary->sets[MOD_REF_MOD].entities);
+		if (summary->memops != NULL)
+			DEL_ARR_F(summary->memops);
+		if (summary->callers != NULL)
+			DEL_ARR_F(summary->callers);
+	}
+	DEL_ARR_F(env->worklist);
+	pmap_destroy(env->summaries);
+	obstack_free(&env->obst, NULL);
+	free(env);
+	mod_ref = NULL;
+}
+
+/**
+ * Returns true if memory at @p addr may be accessed by code which does not
+ * see the frame of the graph of @p addr.
+ */
+static bool is_visible(ir_storage_class_class_t const mod)
+{
+	ir_storage_class_class_t const sc = get_base_sc(mod);
+	if (sc == ir_sc_null)
+		return false;
+	if (sc == ir_sc_localvar || sc == ir_sc_argument)
+		return !(mod & ir_sc_modifier_nottaken);
+	return true;
+}
+
+/** Returns true if a method with accesses @p set may access @p addr. */
+static bool set_may_access(mod_ref_summary_t const *const summary,
+                           mod_ref_set_t const *const set,
+                           ir_node const *const call, ir_node const *const addr,
+                           ir_node const *const base,
+                           ir_storage_class_class_t const mod)
+{
+	if (!is_visible(mod))
+		return false;
+	if (set->unknown)
+		return true;
+
+	size_t const n_call_params = get_Call_n_params(call);
+	for (size_t i = 0; i < summary->n_params; ++i) {
+		if (!rbitset_is_set(set->args, i))
+			continue;
+		if (i >= n_call_params
+		 || objects_may_alias(get_Call_param(call, i), addr))
+			return true;
+	}
+
+	switch (get_base_sc(mod)) {
+	case ir_sc_globalvar:
+	case ir_sc_tls:
+		return pset_new_contains(&set->entities, get_Address_entity(base));
+	case ir_sc_pointer:
+	case ir_sc_globaladdr: {
+		/* the pointer may point to any entity whose address was taken */
+		ir_entity           *entity;
+		pset_new_iterator_t  iter;
+		foreach_pset_new(&set->entities, ir_entity*, entity, iter) {
+			if (get_entity_usage(entity) & ir_usage_address_taken)
+				return true;
+		}
+		return false;
+	}
+	default:
+		return false;
+	}
+}
+
+/** Mod/ref of a callee without summary with properties @p props. */
+static ir_mod_ref get_unknown_mod_ref(mtp_additional_properties const props,
+                                      ir_storage_class_class_t const mod)
+{
+	if ((props & mtp_property_pure) || !is_visible(mod))
+		return ir_mod_ref_none;
+	if (props & mtp_property_no_write)
+		return ir_mod_ref_ref;
+	return ir_mod_ref_mod_ref;
+}
+
+static ir_mod_ref get_callee_mod_ref(ir_node const *const call,
+                                     ir_entity const *const callee,
+                                     ir_node const *const addr,
+                                     ir_node const *const base,
+                                     ir_storage_class_class_t const mod)
+{
+	mtp_additional_properties const props
+		= get_entity_additional_properties(callee)
+		| get_method_additional_properties(get_Call_type(call));
+	mod_ref_summary_t const *const summary = get_summary(callee);
+	if (summary == NULL)
+		return get_unknown_mod_ref(props, mod);
+	if (props & mtp_property_pure)
+		return ir_mod_ref_none;
+
+	ir_mod_ref res = ir_mod_ref_none;
+	if (set_may_access(summary, &summary->sets[MOD_REF_REF], call, addr, base,
+	                   mod))
+		res |= ir_mod_ref_ref;
+	if (!(props & mtp_property_no_write)
+	 && set_may_access(summary, &summary->sets[MOD_REF_MOD], call, addr,
+	                   base, mod))
+		res |= ir_mod_ref_mod;
+	return res;
+}
+
+ir_mod_ref get_call_mod_ref(const ir_node *const call, const ir_node *const addr)
+{
+	mtp_additional_properties const call_props
+		= get_method_additional_properties(get_Call_type(call));
+	ir_graph *const irg = get_irn_irg(call);
+	if (get_irg_memory_disambiguator_options(irg) & aa_opt_always_alias)
+		return get_unknown_mod_ref(call_props, ir_sc_pointer);
+
+	ir_node const *const           base = get_base_address(addr);
+	ir_storage_class_class_t const mod  = classify_pointer(base, base);
+	if (cg_call_has_callees(call)) {
+		ir_mod_ref res = ir_mod_ref_none;
+		for (size_t i = 0, n = cg_get_call_n_callees(call); i < n; ++i) {
+			ir_entity *const callee = cg_get_call_callee(call, i);
+			if (is_unknown_entity(callee))
+				res |= get_unknown_mod_ref(call_props, mod);
+			else
+				res |= get_callee_mod_ref(call, callee, addr, base, mod);
+			if (res == ir_mod_ref_mod_ref)
+				break;
+		}
+		return res;
+	}
+	ir_entity const *const callee = get_Call_callee(call);
+	if (callee == NULL)
+		return get_unknown_mod_ref(call_props, mod);
+	return get_callee_mod_ref(call, callee, addr, base, mod);
+}
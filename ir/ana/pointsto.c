@@ -0,0 +1,1372 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2017 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Interprocedural field-sensitive points-to analysis.
+ *
+ * Memory objects are entities, Alloc nodes and calls of malloc-like
+ * functions. Every value which may carry a pointer gets a variable. The
+ * constraints between the variables are collected from all graphs of the
+ * program and solved with either Steensgaard's unification based algorithm
+ * or Andersen's inclusion based algorithm.
+ *
+ * The fields of an object are distinguished by their entity as long as the
+ * object is only accessed through Member nodes of compatible compound types.
+ * Any other access collapses all fields of the object into a single one.
+ *
+ * Everything invisible to the analysis (external functions, externally
+ * visible entities, integer to pointer conversions) is modelled by the
+ * unknown variable. It points to the unknown object and all objects escaping
+ * to it, which in turn contain pointers to all of them.
+ */
+#include "irmemory_t.h"
+
+#include "array.h"
+#include "cgana.h"
+#include "debug.h"
+#include "irgraph_t.h"
+#include "irgwalk.h"
+#include "irnode_t.h"
+#include "irprog_t.h"
+#include "obst.h"
+#include "pmap.h"
+#include "raw_bitset.h"
+#include "statev_t.h"
+#include "timing.h"
+#include "type_t.h"
+#include "util.h"
+#include "xmalloc.h"
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg = NULL;)
+
+/** Andersen falls back to Steensgaard if the points-to sets get larger. */
+#define ANDERSEN_MAX_BITS ((size_t)1 << 29)
+
+/** The variable for values not carrying a pointer. */
+#define VAR_NONE    0
+/** The variable pointing to the unknown object and all escaped objects. */
+#define VAR_UNKNOWN 1
+/** The object representing memory invisible to the analysis. */
+#define OBJ_UNKNOWN 0
+
+typedef enum pta_constraint_kind_t {
+	PTA_ADDR,  /**< dst points to object src */
+	PTA_COPY,  /**< dst points to everything src points to */
+	PTA_LOAD,  /**< dst points to the contents of field of *src */
+	PTA_STORE, /**< field of *dst points to everything src points to */
+	PTA_COPYB, /**< the contents of *dst point to the contents of *src */
+} pta_constraint_kind_t;
+
+typedef struct pta_constraint_t {
+	pta_constraint_kind_t kind;
+	unsigned              dst;
+	unsigned              src;
+	ir_entity            *field;
+} pta_constraint_t;
+
+typedef struct pta_slot_t pta_slot_t;
+struct pta_slot_t {
+	ir_entity  *field; /**< NULL for the slot of a collapsed object */
+	unsigned    var;   /**< variable for the pointers stored in the field */
+	pta_slot_t *next;
+};
+
+/** The fields of an object (Andersen) or a class of objects (Steensgaard). */
+typedef struct pta_layout_t {
+	ir_type    *owner;     /**< outermost compound type of the fields */
+	pta_slot_t *slots;
+	bool        collapsed; /**< fields are not distinguished */
+} pta_layout_t;
+
+/** A global entity in the list of a class. */
+typedef struct pta_global_t pta_global_t;
+struct pta_global_t {
+	ir_entity    *entity;
+	pta_global_t *next;
+};
+
+typedef struct steens_class_t steens_class_t;
+struct steens_class_t {
+	steens_class_t *parent;
+	unsigned        rank;
+	bool            has_objects;
+	bool            has_others;  /**< contains objects besides globals */
+	pta_global_t   *globals;     /**< the global entities of the class */
+	pta_layout_t    layout;
+};
+
+typedef struct pta_object_t {
+	ir_entity const *entity; /**< the entity or NULL for allocation sites */
+	ir_node const   *site;   /**< the allocating node or NULL */
+	pta_layout_t     layout; /**< Andersen */
+	steens_class_t  *cls;    /**< Steensgaard */
+} pta_object_t;
+
+typedef struct pta_var_t {
+	steens_class_t *pointee;     /**< Steensgaard: class pointed to */
+	unsigned       *pts;         /**< Andersen: objects pointed to */
+	unsigned       *done;        /**< Andersen: objects already dereferenced */
+	unsigned       *succs;       /**< Andersen: variables including this one */
+	unsigned       *derefs;      /**< Andersen: constraints dereferencing this */
+	bool            in_worklist;
+} pta_var_t;
+
+/** The variables of the values of a graph. */
+typedef struct pta_value_t {
+	unsigned   var;
+	ir_entity *field; /**< the field addressed by the value or NULL */
+	bool       done;  /**< constraints of the node were generated */
+} pta_value_t;
+
+typedef struct pta_graph_t {
+	pta_value_t *values;  /**< indexed by node index */
+	unsigned     n_values;
+	unsigned    *params;  /**< variables of the parameters */
+	unsigned    *results; /**< variables of the results */
+} pta_graph_t;
+
+typedef struct pta_env_t {
+	struct obstack          obst;
+	ir_points_to_algorithm  algorithm;
+	pta_constraint_t       *constraints;
+	pta_object_t           *objects;
+	pta_var_t              *vars;
+	pmap                   *entity_vars; /**< entity -> variable of address */
+	pmap                   *graphs;      /**< ir_graph -> pta_graph_t */
+	ir_graph               *irg;         /**< the graph being processed */
+	pta_graph_t            *graph;
+	unsigned               *pending;     /**< Steensgaard: pairs to unify */
+	unsigned               *worklist;    /**< Andersen */
+	unsigned               *delta;       /**< Andersen: scratch bitset */
+	unsigned long           n_queries;
+	unsigned long           n_no_alias;
+} pta_env_t;
+
+/** The result of the last analysis. */
+static pta_env_t *points_to;
+
+static unsigned new_var(pta_env_t *const env)
+{
+	pta_var_t const var = { .pointee = NULL };
+	ARR_APP1(pta_var_t, env->vars, var);
+	return (unsigned)ARR_LEN(env->vars) - 1;
+}
+
+static unsigned new_object(pta_env_t *const env, ir_entity const *const entity,
+                           ir_node const *const site)
+{
+	pta_object_t const obj = { .entity = entity, .site = site };
+	ARR_APP1(pta_object_t, env->objects, obj);
+	return (unsigned)ARR_LEN(env->objects) - 1;
+}
+
+static void add_constraint(pta_env_t *const env,
+                           pta_constraint_kind_t const kind,
+                           unsigned const dst, unsigned const src,
+                           ir_entity *const field)
+{
+	if ((kind != PTA_ADDR && src == VAR_NONE) || dst == VAR_NONE)
+		return;
+	if (kind == PTA_COPY && dst == src)
+		return;
+	pta_constraint_t const c = { kind, dst, src, field };
+	ARR_APP1(pta_constraint_t, env->constraints, c);
+}
+
+/** Adds constraints, such that everything @p var points to escapes. */
+static void escape(pta_env_t *const env, unsigned const var)
+{
+	add_constraint(env, PTA_COPY, VAR_UNKNOWN, var, NULL);
+}
+
+/**
+ * Returns the field for memory accesses through an address of @p field.
+ * Unions and accesses of whole compound members do not address a single
+ * field.
+ */
+static ir_entity *get_access_field(ir_entity *const field)
+{
+	if (field == NULL || is_Union_type(get_entity_owner(field)))
+		return NULL;
+	ir_type *type = get_entity_type(field);
+	while (is_Array_type(type))
+		type = get_array_element_type(type);
+	return is_compound_type(type) ? NULL : field;
+}
+
+/**
+ * Returns true if fields of @p owner1 and @p owner2 can be distinguished in
+ * the same object.
+ */
+static bool owners_compatible(ir_type const *const owner1,
+                              ir_type const *const owner2)
+{
+	return owner1 == NULL || owner2 == NULL || owner1 == owner2
+	    || type_contains(owner1, owner2) || type_contains(owner2, owner1);
+}
+
+static ir_type *outer_owner(ir_type *const owner1, ir_type *const owner2)
+{
+	if (owner1 == NULL || (owner2 != NULL && type_contains(owner2, owner1)))
+		return owner2;
+	return owner1;
+}
+
+static void join_vars(pta_env_t *env, unsigned a, unsigned b);
+
+static pta_slot_t *new_slot(pta_env_t *const env, ir_entity *const field)
+{
+	pta_slot_t *const slot = OALLOC(&env->obst, pta_slot_t);
+	slot->field = field;
+	slot->var   = new_var(env);
+	slot->next  = NULL;
+	return slot;
+}
+
+/** Merges all fields of @p layout into a single one. */
+static void collapse_layout(pta_env_t *const env, pta_layout_t *const layout)
+{
+	if (layout->collapsed)
+		return;
+	layout->collapsed = true;
+	layout->owner     = NULL;
+
+	pta_slot_t *const slots = layout->slots;
+	if (slots == NULL)
+		return;
+	for (pta_slot_t *slot = slots->next; slot != NULL; slot = slot->next) {
+		join_vars(env, slots->var, slot->var);
+	}
+	slots->field = NULL;
+	slots->next  = NULL;
+}
+
+/** Returns the variable for the contents of @p field in @p layout. */
+static unsigned get_slot_var(pta_env_t *const env, pta_layout_t *const layout,
+                             ir_entity *const field)
+{
+	if (field == NULL) {
+		collapse_layout(env, layout);
+	} else if (!layout->collapsed) {
+		ir_type *const owner = get_entity_owner(field);
+		if (owners_compatible(layout->owner, owner)) {
+			layout->owner = outer_owner(layout->owner, owner);
+			for (pta_slot_t *slot = layout->slots; slot != NULL;
+			     slot = slot->next) {
+				if (slot->field == field)
+					return slot->var;
+			}
+			pta_slot_t *const slot = new_slot(env, field);
+			slot->next    = layout->slots;
+			layout->slots = slot;
+			return slot->var;
+		}
+		collapse_layout(env, layout);
+	}
+
+	if (layout->slots == NULL)
+		layout->slots = new_slot(env, NULL);
+	return layout->slots->var;
+}
+
+/** Merges @p other into @p layout. */
+static void merge_layouts(pta_env_t *const env, pta_layout_t *const layout,
+                          pta_layout_t *const other)
+{
+	if (layout->collapsed || other->collapsed
+	 || !owners_compatible(layout->owner, other->owner)) {
+		collapse_layout(env, layout);
+		collapse_layout(env, other);
+		if (layout->slots == NULL)
+			layout->slots = other->slots;
+		else if (other->slots != NULL)
+			join_vars(env, layout->slots->var, other->slots->var);
+		return;
+	}
+
+	layout->owner = outer_owner(layout->owner, other->owner);
+	for (pta_slot_t *slot = other->slots, *next; slot != NULL; slot = next) {
+		next = slot->next;
+		pta_slot_t *same = layout->slots;
+		while (same != NULL && same->field != slot->field)
+			same = same->next;
+		if (same != NULL) {
+			join_vars(env, same->var, slot->var);
+		} else {
+			slot->next    = layout->slots;
+			layout->slots = slot;
+		}
+	}
+}
+
+static steens_class_t *steens_find(steens_class_t *cls)
+{
+	steens_class_t *root = cls;
+	while (root->parent != root)
+		root = root->parent;
+	while (cls != root) {
+		steens_class_t *const next = cls->parent;
+		cls->parent = root;
+		cls         = next;
+	}
+	return root;
+}
+
+static steens_class_t *steens_new_class(pta_env_t *const env)
+{
+	steens_class_t *const cls = OALLOCZ(&env->obst, steens_class_t);
+	cls->parent = cls;
+	return cls;
+}
+
+static steens_class_t *steens_get_pointee(pta_env_t *const env,
+                                          unsigned const var)
+{
+	pta_var_t *const v = &env->vars[var];
+	if (v->pointee == NULL)
+		v->pointee = steens_new_class(env);
+	return steens_find(v->pointee);
+}
+
+static steens_class_t *steens_get_object_class(pta_env_t *const env,
+                                               unsigned const obj)
+{
+	pta_object_t *const o = &env->objects[obj];
+	if (o->cls == NULL) {
+		o->cls = steens_new_class(env);
+		o->cls->has_objects = true;
+	}
+	return steens_find(o->cls);
+}
+
+static void steens_unify(pta_env_t *const env, steens_class_t *a,
+                         steens_class_t *b)
+{
+	a = steens_find(a);
+	b = steens_find(b);
+	if (a == b)
+		return;
+	if (a->rank < b->rank) {
+		steens_class_t *const t = a;
+		a = b;
+		b = t;
+	} else if (a->rank == b->rank) {
+		++a->rank;
+	}
+	b->parent       = a;
+	a->has_objects |= b->has_objects;
+	merge_layouts(env, &a->layout, &b->layout);
+}
+
+/** Unifies the pointees of all pending variable pairs. */
+static void steens_flush(pta_env_t *const env)
+{
+	while (ARR_LEN(env->pending) > 0) {
+		size_t   const n = ARR_LEN(env->pending);
+		unsigned const a = env->pending[n - 2];
+		unsigned const b = env->pending[n - 1];
+		ARR_SHRINKLEN(env->pending, n - 2);
+
+		pta_var_t *const va = &env->vars[a];
+		pta_var_t *const vb = &env->vars[b];
+		if (va->pointee == NULL) {
+			va->pointee = steens_get_pointee(env, b);
+		} else if (vb->pointee == NULL) {
+			vb->pointee = steens_find(va->pointee);
+		} else {
+			steens_unify(env, va->pointee, vb->pointee);
+		}
+	}
+}
+
+/** Returns true if @p entity is a global variable. */
+static bool is_global_var(ir_entity const *const entity)
+{
+	ir_type const *const owner = get_entity_owner(entity);
+	return owner == get_glob_type() || owner == get_tls_type();
+}
+
+/** Records the global entities of each class for queries. */
+static void steens_collect_globals(pta_env_t *const env)
+{
+	for (size_t i = 0, n = ARR_LEN(env->objects); i < n; ++i) {
+		pta_object_t const *const obj = &env->objects[i];
+		if (obj->cls == NULL)
+			continue;
+		steens_class_t *const cls = steens_find(obj->cls);
+		if (obj->entity == NULL || !is_global_var(obj->entity)) {
+			cls->has_others = true;
+			continue;
+		}
+		pta_global_t *const global = OALLOC(&env->obst, pta_global_t);
+		global->entity = (ir_entity*)obj->entity;
+		global->next   = cls->globals;
+		cls->globals   = global;
+	}
+}
+
+static void steens_solve(pta_env_t *const env)
+{
+	for (size_t i = 0, n = ARR_LEN(env->constraints); i < n; ++i) {
+		pta_constraint_t const *const c = &env->constraints[i];
+		switch (c->kind) {
+		case PTA_ADDR:
+			steens_unify(env, steens_get_pointee(env, c->dst),
+			             steens_get_object_class(env, c->src));
+			break;
+		case PTA_COPY:
+			join_vars(env, c->dst, c->src);
+			break;
+		case PTA_LOAD: {
+			steens_class_t *const cls  = steens_get_pointee(env, c->src);
+			unsigned        const slot = get_slot_var(env, &cls->layout, c->field);
+			join_vars(env, c->dst, slot);
+			break;
+		}
+		case PTA_STORE: {
+			steens_class_t *const cls  = steens_get_pointee(env, c->dst);
+			unsigned        const slot = get_slot_var(env, &cls->layout, c->field);
+			join_vars(env, slot, c->src);
+			break;
+		}
+		case PTA_COPYB: {
+			steens_class_t *const dst  = steens_get_pointee(env, c->dst);
+			unsigned        const dst_slot = get_slot_var(env, &dst->layout, NULL);
+			steens_flush(env);
+			steens_class_t *const src  = steens_get_pointee(env, c->src);
+			unsigned        const src_slot = get_slot_var(env, &src->layout, NULL);
+			join_vars(env, dst_slot, src_slot);
+			break;
+		}
+		}
+		steens_flush(env);
+	}
+}
+
+static unsigned *andersen_get_pts(pta_env_t *const env, unsigned const var)
+{
+	pta_var_t *const v = &env->vars[var];
+	if (v->pts == NULL)
+		v->pts = rbitset_obstack_alloc(&env->obst, ARR_LEN(env->objects));
+	return v->pts;
+}
+
+static void andersen_push(pta_env_t *const env, unsigned const var)
+{
+	pta_var_t *const v = &env->vars[var];
+	if (v->in_worklist)
+		return;
+	v->in_worklist = true;
+	ARR_APP1(unsigned, env->worklist, var);
+}
+
+/** Adds the objects of @p src to @p dst. Returns true if @p dst changed. */
+static bool andersen_union(unsigned *const dst, unsigned const *const src,
+                           size_t const n_bits)
+{
+	bool changed = false;
+	for (size_t i = 0, n = BITSET_SIZE_ELEMS(n_bits); i < n; ++i) {
+		unsigned const old = dst[i];
+		dst[i] |= src[i];
+		changed |= dst[i] != old;
+	}
+	return changed;
+}
+
+/** Adds the constraint that @p dst includes @p src. */
+static void andersen_add_edge(pta_env_t *const env, unsigned const src,
+                              unsigned const dst)
+{
+	if (src == dst)
+		return;
+	pta_var_t *const v = &env->vars[src];
+	if (v->succs == NULL)
+		v->succs = NEW_ARR_F(unsigned, 0);
+	else if (ARR_LEN(v->succs) > 0 && v->succs[ARR_LEN(v->succs) - 1] == dst)
+		return;
+	ARR_APP1(unsigned, env->vars[src].succs, dst);
+
+	unsigned const *const src_pts = env->vars[src].pts;
+	if (src_pts == NULL)
+		return;
+	unsigned *const dst_pts = andersen_get_pts(env, dst);
+	if (andersen_union(dst_pts, env->vars[src].pts, ARR_LEN(env->objects)))
+		andersen_push(env, dst);
+}
+
+static void andersen_add_deref(pta_env_t *const env, unsigned const var,
+                               unsigned const constraint)
+{
+	pta_var_t *const v = &env->vars[var];
+	if (v->derefs == NULL)
+		v->derefs = NEW_ARR_F(unsigned, 0);
+	ARR_APP1(unsigned, v->derefs, constraint);
+}
+
+static unsigned andersen_get_slot(pta_env_t *const env, unsigned const obj,
+                                  ir_entity *const field)
+{
+	return get_slot_var(env, &env->objects[obj].layout, field);
+}
+
+static void andersen_copyb(pta_env_t *const env, unsigned const dst_obj,
+                           unsigned const src_obj)
+{
+	unsigned const dst = andersen_get_slot(env, dst_obj, NULL);
+	unsigned const src = andersen_get_slot(env, src_obj, NULL);
+	andersen_add_edge(env, src, dst);
+}
+
+static void andersen_process(pta_env_t *const env, unsigned const var)
+{
+	size_t    const n_objs = ARR_LEN(env->objects);
+	unsigned *const pts    = env->vars[var].pts;
+	if (pts == NULL)
+		return;
+
+	/* dereference the newly added objects */
+	pta_var_t *v = &env->vars[var];
+	if (v->derefs != NULL) {
+		if (v->done == NULL)
+			v->done = rbitset_obstack_alloc(&env->obst, n_objs);
+		unsigned *const delta = env->delta;
+		rbitset_copy(delta, pts, n_objs);
+		rbitset_andnot(delta, v->done, n_objs);
+		rbitset_or(v->done, pts, n_objs);
+
+		for (size_t i = 0; i < ARR_LEN(env->vars[var].derefs); ++i) {
+			pta_constraint_t const c
+				= env->constraints[env->vars[var].derefs[i]];
+			rbitset_foreach(delta, n_objs, obj) {
+				switch (c.kind) {
+				case PTA_LOAD:
+					andersen_add_edge(env, andersen_get_slot(env, obj, c.field),
+					                  c.dst);
+					break;
+				case PTA_STORE:
+					andersen_add_edge(env, c.src,
+					                  andersen_get_slot(env, obj, c.field));
+					break;
+				case PTA_COPYB: {
+					unsigned const other = c.dst == var ? c.src : c.dst;
+					unsigned const *const other_pts = env->vars[other].pts;
+					if (other_pts == NULL)
+						break;
+					rbitset_foreach(other_pts, n_objs, other_obj) {
+						if (c.dst == var)
+							andersen_copyb(env, obj, (unsigned)other_obj);
+						if (c.src == var)
+							andersen_copyb(env, (unsigned)other_obj, obj);
+					}
+					break;
+				}
+				case PTA_ADDR:
+				case PTA_COPY:
+					panic("invalid dereference constraint");
+				}
+			}
+		}
+	}
+
+	/* propagate to the including variables */
+	v = &env->vars[var];
+	if (v->succs == NULL)
+		return;
+	for (size_t i = 0; i < ARR_LEN(env->vars[var].succs); ++i) {
+		unsigned  const succ     = env->vars[var].succs[i];
+		unsigned *const succ_pts = andersen_get_pts(env, succ);
+		if (andersen_union(succ_pts, env->vars[var].pts, n_objs))
+			andersen_push(env, succ);
+	}
+}
+
+static void andersen_solve(pta_env_t *const env)
+{
+	size_t const n_objs = ARR_LEN(env->objects);
+	env->worklist = NEW_ARR_F(unsigned, 0);
+	env->delta    = rbitset_malloc(n_objs);
+
+	for (size_t i = 0, n = ARR_LEN(env->constraints); i < n; ++i) {
+		pta_constraint_t const *const c = &env->constraints[i];
+		switch (c->kind) {
+		case PTA_ADDR:
+			rbitset_set(andersen_get_pts(env, c->dst), c->src);
+			andersen_push(env, c->dst);
+			break;
+		case PTA_COPY:
+			andersen_add_edge(env, c->src, c->dst);
+			break;
+		case PTA_LOAD:
+			andersen_add_deref(env, c->src, (unsigned)i);
+			break;
+		case PTA_STORE:
+			andersen_add_deref(env, c->dst, (unsigned)i);
+			break;
+		case PTA_COPYB:
+			andersen_add_deref(env, c->dst, (unsigned)i);
+			if (c->src != c->dst)
+				andersen_add_deref(env, c->src, (unsigned)i);
+			break;
+		}
+	}
+
+	while (ARR_LEN(env->worklist) > 0) {
+		size_t   const n   = ARR_LEN(env->worklist);
+		unsigned const var = env->worklist[n - 1];
+		ARR_SHRINKLEN(env->worklist, n - 1);
+		env->vars[var].in_worklist = false;
+		andersen_process(env, var);
+	}
+
+	DEL_ARR_F(env->worklist);
+	free(env->delta);
+}
+
+static void join_vars(pta_env_t *const env, unsigned const a, unsigned const b)
+{
+	if (a == b)
+		return;
+	if (env->algorithm == ir_points_to_steensgaard) {
+		ARR_APP1(unsigned, env->pending, a);
+		ARR_APP1(unsigned, env->pending, b);
+	} else {
+		andersen_add_edge(env, a, b);
+		andersen_add_edge(env, b, a);
+	}
+}
+
+static bool is_tracked_mode(ir_mode const *const mode)
+{
+	return mode_is_data(mode);
+}
+
+static void generate_node(ir_node *node, void *data);
+
+/**
+ * Returns the value of @p node. Operands are processed on demand, because
+ * walking a graph may reach a node before its operands through the block
+ * inputs.
+ */
+static pta_value_t get_value(pta_env_t *const env, ir_node *const node)
+{
+	assert(get_irn_irg(node) == env->irg);
+	if (!env->graph->values[get_irn_idx(node)].done)
+		generate_node(node, env);
+	return env->graph->values[get_irn_idx(node)];
+}
+
+static unsigned get_value_var(pta_env_t *const env, ir_node *const node)
+{
+	return get_value(env, node).var;
+}
+
+static void set_value(pta_env_t *const env, ir_node const *const node,
+                      unsigned const var, ir_entity *const field)
+{
+	env->graph->values[get_irn_idx(node)] = (pta_value_t){ var, field, true };
+}
+
+static pta_graph_t *get_graph(pta_env_t const *const env, ir_graph const *const irg)
+{
+	return pmap_get(pta_graph_t, env->graphs, irg);
+}
+
+/** Returns the variable pointing to @p entity. */
+static unsigned get_entity_var(pta_env_t *const env, ir_entity *const entity)
+{
+	void *const entry = pmap_get(void, env->entity_vars, entity);
+	if (entry != NULL)
+		return (unsigned)PTR_TO_INT(entry);
+
+	unsigned const var = new_var(env);
+	pmap_insert(env->entity_vars, entity, INT_TO_PTR(var));
+	add_constraint(env, PTA_ADDR, var, new_object(env, entity, NULL), NULL);
+
+	if (is_parameter_entity(entity)) {
+		/* the parameter is passed in the entity */
+		size_t   const num   = get_entity_parameter_number(entity);
+		unsigned const *const params = env->graph->params;
+		if (num >= ARR_LEN(params)) {
+			escape(env, var);
+		} else if (is_compound_type(get_entity_type(entity))) {
+			add_constraint(env, PTA_COPYB, var, params[num], NULL);
+		} else {
+			add_constraint(env, PTA_STORE, var, params[num], NULL);
+		}
+	}
+	return var;
+}
+
+/**
+ * Collects the possible callees of @p call. Returns false if unknown
+ * functions may be called.
+ */
+static bool get_callees(ir_node const *const call, ir_entity ***const callees)
+{
+	*callees = NEW_ARR_F(ir_entity*, 0);
+	if (cg_call_has_callees(call)) {
+		for (size_t i = 0, n = cg_get_call_n_callees(call); i < n; ++i) {
+			ir_entity *const callee = cg_get_call_callee(call, i);
+			if (is_unknown_entity(callee))
+				return false;
+			ARR_APP1(ir_entity*, *callees, callee);
+		}
+		return true;
+	}
+	ir_entity *const callee = get_Call_callee(call);
+	if (callee == NULL)
+		return false;
+	ARR_APP1(ir_entity*, *callees, callee);
+	return true;
+}
+
+static void generate_call(pta_env_t *const env, ir_node *const call)
+{
+	ir_entity **callees;
+	bool const  known   = get_callees(call, &callees);
+	size_t const n_args = get_Call_n_params(call);
+	for (size_t a = 0; a < n_args; ++a) {
+		ir_node *const arg = get_Call_param(call, a);
+		if (!is_tracked_mode(get_irn_mode(arg)))
+			continue;
+		unsigned const var = get_value_var(env, arg);
+		if (!known)
+			escape(env, var);
+		for (size_t i = 0, n = ARR_LEN(callees); i < n; ++i) {
+			ir_graph    *const callee_irg = get_entity_irg(callees[i]);
+			pta_graph_t *const callee     = callee_irg != NULL
+				? get_graph(env, callee_irg) : NULL;
+			if (callee != NULL && a < ARR_LEN(callee->params))
+				add_constraint(env, PTA_COPY, callee->params[a], var, NULL);
+			else
+				escape(env, var);
+		}
+	}
+	DEL_ARR_F(callees);
+}
+
+static unsigned generate_call_result(pta_env_t *const env, ir_node *const call,
+                                     unsigned const pn)
+{
+	ir_entity **callees;
+	bool const  known = get_callees(call, &callees);
+	unsigned    var   = VAR_UNKNOWN;
+	if (known) {
+		var = new_var(env);
+		for (size_t i = 0, n = ARR_LEN(callees); i < n; ++i) {
+			ir_entity   *const callee_ent = callees[i];
+			ir_graph    *const callee_irg = get_entity_irg(callee_ent);
+			pta_graph_t *const callee     = callee_irg != NULL
+				? get_graph(env, callee_irg) : NULL;
+			if (callee != NULL && pn < ARR_LEN(callee->results)) {
+				add_constraint(env, PTA_COPY, var, callee->results[pn], NULL);
+			} else if (get_entity_additional_properties(callee_ent)
+			           & mtp_property_malloc) {
+				add_constraint(env, PTA_ADDR, var,
+				               new_object(env, NULL, call), NULL);
+			} else {
+				add_constraint(env, PTA_COPY, var, VAR_UNKNOWN, NULL);
+			}
+		}
+	}
+	DEL_ARR_F(callees);
+	return var;
+}
+
+static void generate_proj(pta_env_t *const env, ir_node *const proj)
+{
+	ir_mode *const mode = get_irn_mode(proj);
+	if (!is_tracked_mode(mode))
+		return;
+
+	ir_node *const pred = get_Proj_pred(proj);
+	unsigned const pn   = get_Proj_num(proj);
+	unsigned       var  = VAR_UNKNOWN;
+	switch (get_irn_opcode(pred)) {
+	case iro_Start:
+		if (pn == pn_Start_P_frame_base) {
+			/* the frame pointer points to all entities on the frame */
+			var = new_var(env);
+			ir_type *const frame = get_irg_frame_type(env->irg);
+			for (size_t i = 0, n = get_compound_n_members(frame); i < n; ++i) {
+				ir_entity *const member = get_compound_member(frame, i);
+				add_constraint(env, PTA_COPY, var, get_entity_var(env, member),
+				               NULL);
+			}
+		}
+		break;
+
+	case iro_Proj: {
+		ir_node *const pred_pred = get_Proj_pred(pred);
+		unsigned const pred_pn   = get_Proj_num(pred);
+		if (is_Start(pred_pred) && pred_pn == pn_Start_T_args) {
+			unsigned const *const params = env->graph->params;
+			if (pn < ARR_LEN(params))
+				var = params[pn];
+		} else if (is_Call(pred_pred) && pred_pn == pn_Call_T_result) {
+			var = generate_call_result(env, pred_pred, pn);
+		}
+		break;
+	}
+
+	case iro_Load:
+		if (pn == pn_Load_res) {
+			ir_node    *const ptr = get_Load_ptr(pred);
+			pta_value_t const val = get_value(env, ptr);
+			var = new_var(env);
+			add_constraint(env, PTA_LOAD, var, val.var,
+			               get_access_field(val.field));
+		}
+		break;
+
+	case iro_Alloc:
+		if (pn == pn_Alloc_res) {
+			var = new_var(env);
+			add_constraint(env, PTA_ADDR, var, new_object(env, NULL, pred),
+			               NULL);
+		}
+		break;
+
+	default:
+		break;
+	}
+	set_value(env, proj, var, NULL);
+}
+
+/** Returns the pointer operand of an address calculation. */
+static ir_node *get_pointer_operand(ir_node *const node)
+{
+	ir_node *const left = get_binop_left(node);
+	if (mode_is_reference(get_irn_mode(left)))
+		return left;
+	ir_node *const right = get_binop_right(node);
+	if (mode_is_reference(get_irn_mode(right)))
+		return right;
+	return NULL;
+}
+
+/** Handles nodes whose semantics are not modelled. */
+static void generate_unknown(pta_env_t *const env, ir_node *const node)
+{
+	bool has_pointer = false;
+	foreach_irn_in(node, i, op) {
+		if (!is_tracked_mode(get_irn_mode(op)))
+			continue;
+		unsigned const var = get_value_var(env, op);
+		if (var != VAR_NONE) {
+			escape(env, var);
+			has_pointer = true;
+		}
+	}
+	/* results of pointer arithmetic may point anywhere */
+	ir_mode *const mode = get_irn_mode(node);
+	if (is_tracked_mode(mode)
+	 && (has_pointer || mode_is_reference(mode)))
+		set_value(env, node, VAR_UNKNOWN, NULL);
+}
+
+static void generate_node(ir_node *const node, void *const data)
+{
+	pta_env_t   *const env   = (pta_env_t*)data;
+	pta_value_t *const value = &env->graph->values[get_irn_idx(node)];
+	if (value->done)
+		return;
+	value->done = true;
+
+	ir_mode *const mode = get_irn_mode(node);
+	switch (get_irn_opcode(node)) {
+	case iro_Address:
+		set_value(env, node, get_entity_var(env, get_Address_entity(node)),
+		          NULL);
+		return;
+
+	case iro_Member: {
+		ir_node   *const ptr    = get_Member_ptr(node);
+		ir_entity *const entity = get_Member_entity(node);
+		if (ptr == get_irg_frame(env->irg))
+			set_value(env, node, get_entity_var(env, entity), NULL);
+		else
+			set_value(env, node, get_value_var(env, ptr), entity);
+		return;
+	}
+
+	case iro_Sel:
+		set_value(env, node, get_value_var(env, get_Sel_ptr(node)),
+		          get_value(env, get_Sel_ptr(node)).field);
+		return;
+
+	case iro_Add:
+	case iro_Sub:
+		if (mode_is_reference(mode)) {
+			ir_node *const ptr = get_pointer_operand(node);
+			if (ptr != NULL) {
+				set_value(env, node, get_value_var(env, ptr), NULL);
+				return;
+			}
+		} else if (is_Sub(node)
+		        && mode_is_reference(get_irn_mode(get_Sub_left(node)))) {
+			/* pointer difference */
+			return;
+		}
+		break;
+
+	case iro_Confirm: {
+		pta_value_t const val = get_value(env, get_Confirm_value(node));
+		set_value(env, node, val.var, val.field);
+		return;
+	}
+
+	case iro_Id: {
+		pta_value_t const val = get_value(env, get_Id_pred(node));
+		set_value(env, node, val.var, val.field);
+		return;
+	}
+
+	case iro_Phi:
+		if (is_tracked_mode(mode)) {
+			/* set the variable first to break cycles */
+			unsigned const var = new_var(env);
+			set_value(env, node, var, NULL);
+			foreach_irn_in(node, i, op) {
+				add_constraint(env, PTA_COPY, var, get_value_var(env, op),
+				               NULL);
+			}
+		}
+		return;
+
+	case iro_Mux:
+		if (is_tracked_mode(mode)) {
+			pta_value_t const t   = get_value(env, get_Mux_true(node));
+			pta_value_t const f   = get_value(env, get_Mux_false(node));
+			unsigned    const var = new_var(env);
+			add_constraint(env, PTA_COPY, var, t.var, NULL);
+			add_constraint(env, PTA_COPY, var, f.var, NULL);
+			set_value(env, node, var, t.field == f.field ? t.field : NULL);
+		}
+		return;
+
+	case iro_Const:
+		if (mode_is_reference(mode) && !tarval_is_null(get_Const_tarval(node)))
+			set_value(env, node, VAR_UNKNOWN, NULL);
+		return;
+
+	case iro_Conv: {
+		ir_node *const op      = get_Conv_op(node);
+		ir_mode *const op_mode = get_irn_mode(op);
+		if (mode_is_reference(op_mode) != mode_is_reference(mode))
+			break;
+		pta_value_t const val = get_value(env, op);
+		set_value(env, node, val.var, val.field);
+		return;
+	}
+
+	case iro_Proj:
+		generate_proj(env, node);
+		return;
+
+	case iro_Load:
+		return;
+
+	case iro_Store: {
+		ir_node *const value = get_Store_value(node);
+		if (is_tracked_mode(get_irn_mode(value))) {
+			pta_value_t const ptr = get_value(env, get_Store_ptr(node));
+			add_constraint(env, PTA_STORE, ptr.var, get_value_var(env, value),
+			               get_access_field(ptr.field));
+		}
+		return;
+	}
+
+	case iro_CopyB:
+		add_constraint(env, PTA_COPYB,
+		               get_value_var(env, get_CopyB_dst(node)),
+		               get_value_var(env, get_CopyB_src(node)), NULL);
+		return;
+
+	case iro_Call:
+		generate_call(env, node);
+		return;
+
+	case iro_Return: {
+		unsigned const *const results = env->graph->results;
+		for (size_t i = 0, n = get_Return_n_ress(node); i < n; ++i) {
+			ir_node *const res = get_Return_res(node, i);
+			if (i < ARR_LEN(results) && is_tracked_mode(get_irn_mode(res))) {
+				add_constraint(env, PTA_COPY, results[i],
+				               get_value_var(env, res), NULL);
+			}
+		}
+		return;
+	}
+
+	case iro_Builtin:
+		switch (get_Builtin_kind(node)) {
+		case ir_bk_prefetch:
+		case ir_bk_may_alias:
+			return;
+		default:
+			break;
+		}
+		break;
+
+	case iro_Align:
+	case iro_Bad:
+	case iro_Block:
+	case iro_Cmp:
+	case iro_Cond:
+	case iro_Dummy:
+	case iro_End:
+	case iro_Free:
+	case iro_IJmp:
+	case iro_Jmp:
+	case iro_NoMem:
+	case iro_Offset:
+	case iro_Pin:
+	case iro_Size:
+	case iro_Start:
+	case iro_Switch:
+	case iro_Sync:
+	case iro_Unknown:
+		return;
+
+	default:
+		break;
+	}
+	generate_unknown(env, node);
+}
+
+static void generate_graph(pta_env_t *const env, ir_graph *const irg)
+{
+	assure_irg_properties(irg, IR_GRAPH_PROPERTY_NO_TUPLES);
+
+	pta_graph_t *const graph = get_graph(env, irg);
+	graph->n_values = get_irg_last_idx(irg);
+	graph->values   = XMALLOCNZ(pta_value_t, graph->n_values);
+	env->irg   = irg;
+	env->graph = graph;
+	irg_walk_graph(irg, NULL, generate_node, env);
+	env->irg   = NULL;
+	env->graph = NULL;
+}
+
+/** Collects the Address nodes in the constant expression @p value. */
+static void generate_initializer_value(pta_env_t *const env,
+                                       unsigned const var,
+                                       ir_entity *const field,
+                                       ir_node *const value, bool const stored)
+{
+	if (is_Address(value)) {
+		unsigned const target = get_entity_var(env, get_Address_entity(value));
+		if (stored)
+			add_constraint(env, PTA_STORE, var, target, get_access_field(field));
+		else
+			escape(env, target);
+		return;
+	}
+	foreach_irn_in(value, i, op) {
+		generate_initializer_value(env, var, field, op, stored);
+	}
+}
+
+static void generate_initializer(pta_env_t *const env, unsigned const var,
+                                 ir_entity *const field, ir_type *const type,
+                                 ir_initializer_t const *const initializer)
+{
+	switch (get_initializer_kind(initializer)) {
+	case IR_INITIALIZER_CONST: {
+		ir_node *const value = get_initializer_const_value(initializer);
+		generate_initializer_value(env, var, field, value,
+		                           mode_is_reference(get_irn_mode(value)));
+		return;
+	}
+	case IR_INITIALIZER_TARVAL:
+	case IR_INITIALIZER_NULL:
+		return;
+	case IR_INITIALIZER_COMPOUND:
+		for (size_t i = 0, n = get_initializer_compound_n_entries(initializer);
+		     i < n; ++i) {
+			ir_initializer_t const *const sub
+				= get_initializer_compound_value(initializer, i);
+			if (is_Array_type(type)) {
+				generate_initializer(env, var, field,
+				                     get_array_element_type(type), sub);
+			} else if (is_compound_type(type)
+			        && i < get_compound_n_members(type)) {
+				ir_entity *const member = get_compound_member(type, i);
+				generate_initializer(env, var, member, get_entity_type(member),
+				                     sub);
+			}
+		}
+		return;
+	}
+	panic("invalid initializer found");
+}
+
+static void generate_globals(pta_env_t *const env)
+{
+	for (ir_segment_t s = IR_SEGMENT_FIRST; s <= IR_SEGMENT_LAST; ++s) {
+		ir_type *const segment = get_segment_type(s);
+		for (size_t i = 0, n = get_compound_n_members(segment); i < n; ++i) {
+			ir_entity *const entity = get_compound_member(segment, i);
+			if (entity_is_externally_visible(entity))
+				escape(env, get_entity_var(env, entity));
+			if (get_entity_kind(entity) != IR_ENTITY_NORMAL)
+				continue;
+			ir_initializer_t const *const init
+				= get_entity_initializer(entity);
+			if (init != NULL) {
+				generate_initializer(env, get_entity_var(env, entity), NULL,
+				                     get_entity_type(entity), init);
+			}
+		}
+	}
+}
+
+static unsigned *new_vars(pta_env_t *const env, size_t const n)
+{
+	unsigned *const vars = NEW_ARR_D(unsigned, &env->obst, n);
+	for (size_t i = 0; i < n; ++i)
+		vars[i] = new_var(env);
+	return vars;
+}
+
+static void generate_constraints(pta_env_t *const env)
+{
+	/* the unknown object contains pointers to itself */
+	unsigned const unknown = new_var(env);
+	assert(unknown == VAR_UNKNOWN);
+	(void)unknown;
+	add_constraint(env, PTA_ADDR, VAR_UNKNOWN,
+	               new_object(env, NULL, NULL), NULL);
+	add_constraint(env, PTA_STORE, VAR_UNKNOWN, VAR_UNKNOWN, NULL);
+	add_constraint(env, PTA_LOAD, VAR_UNKNOWN, VAR_UNKNOWN, NULL);
+
+	foreach_irp_irg(i, irg) {
+		ir_type     *const mtp   = get_entity_type(get_irg_entity(irg));
+		pta_graph_t *const graph = OALLOCZ(&env->obst, pta_graph_t);
+		graph->params  = new_vars(env, get_method_n_params(mtp));
+		graph->results = new_vars(env, get_method_n_ress(mtp));
+		pmap_insert(env->graphs, irg, graph);
+	}
+
+	/* functions callable from unknown code get unknown arguments */
+	ir_entity **free_methods;
+	size_t const n_free_methods = cgana(&free_methods);
+	for (size_t i = 0; i < n_free_methods; ++i) {
+		ir_graph *const irg = get_entity_irg(free_methods[i]);
+		if (irg == NULL)
+			continue;
+		pta_graph_t const *const graph = get_graph(env, irg);
+		for (size_t p = 0, n = ARR_LEN(graph->params); p < n; ++p)
+			add_constraint(env, PTA_COPY, graph->params[p], VAR_UNKNOWN, NULL);
+		for (size_t r = 0, n = ARR_LEN(graph->results); r < n; ++r)
+			escape(env, graph->results[r]);
+	}
+	free(free_methods);
+
+	generate_globals(env);
+	foreach_irp_irg(i, irg) {
+		generate_graph(env, irg);
+	}
+}
+
+static void free_env(pta_env_t *const env)
+{
+	for (size_t i = 0, n = ARR_LEN(env->vars); i < n; ++i) {
+		pta_var_t *const var = &env->vars[i];
+		if (var->succs != NULL)
+			DEL_ARR_F(var->succs);
+		if (var->derefs != NULL)
+			DEL_ARR_F(var->derefs);
+	}
+	foreach_pmap(env->graphs, entry) {
+		pta_graph_t *const graph = (pta_graph_t*)entry->value;
+		free(graph->values);
+	}
+	DEL_ARR_F(env->constraints);
+	DEL_ARR_F(env->objects);
+	DEL_ARR_F(env->vars);
+	DEL_ARR_F(env->pending);
+	pmap_destroy(env->entity_vars);
+	pmap_destroy(env->graphs);
+	obstack_free(&env->obst, NULL);
+	free(env);
+}
+
+void compute_irp_points_to(ir_points_to_algorithm const algorithm)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.ana.pointsto");
+	free_irp_points_to();
+
+	stat_ev_tim_push();
+	ir_timer_t *const timer = ir_timer_new();
+	ir_timer_start(timer);
+
+	pta_env_t *const env = XMALLOCZ(pta_env_t);
+	obstack_init(&env->obst);
+	env->algorithm   = algorithm;
+	env->constraints = NEW_ARR_F(pta_constraint_t, 0);
+	env->objects     = NEW_ARR_F(pta_object_t, 0);
+	env->vars        = NEW_ARR_F(pta_var_t, 0);
+	env->pending     = NEW_ARR_F(unsigned, 0);
+	env->entity_vars = pmap_create();
+	env->graphs      = pmap_create();
+
+	/* VAR_NONE */
+	new_var(env);
+	generate_constraints(env);
+
+	size_t const n_vars = ARR_LEN(env->vars);
+	size_t const n_objs = ARR_LEN(env->objects);
+	if (env->algorithm == ir_points_to_andersen
+	 && 2 * n_vars * n_objs > ANDERSEN_MAX_BITS) {
+		DB((dbg, LEVEL_1, "too many objects for Andersen, using Steensgaard\n"));
+		env->algorithm = ir_points_to_steensgaard;
+	}
+	if (env->algorithm == ir_points_to_steensgaard) {
+		steens_solve(env);
+		steens_collect_globals(env);
+	} else {
+		andersen_solve(env);
+	}
+
+	foreach_irp_irg(i, irg) {
+		add_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_POINTS_TO);
+		clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_ALIAS_CACHE);
+	}
+	points_to = env;
+
+	ir_timer_stop(timer);
+	DB((dbg, LEVEL_1, "%s: %zu constraints, %zu variables, %zu objects, %lu usec\n",
+	    env->algorithm == ir_points_to_steensgaard ? "steensgaard" : "andersen",
+	    ARR_LEN(env->constraints), ARR_LEN(env->vars), n_objs,
+	    ir_timer_elapsed_usec(timer)));
+	ir_timer_free(timer);
+	stat_ev_tim_pop("pointsto_time");
+	stat_ev_ull("pointsto_vars", ARR_LEN(env->vars));
+	stat_ev_ull("pointsto_objects", n_objs);
+}
+
+void assure_irp_points_to(ir_points_to_algorithm const algorithm)
+{
+	if (points_to != NULL) {
+		bool consistent = true;
+		foreach_irp_irg(i, irg) {
+			consistent &= irg_has_properties(irg,
+				IR_GRAPH_PROPERTY_CONSISTENT_POINTS_TO);
+		}
+		if (consistent)
+			return;
+	}
+	compute_irp_points_to(algorithm);
+}
+
+void free_irp_points_to(void)
+{
+	pta_env_t *const env = points_to;
+	if (env == NULL)
+		return;
+
+	DB((dbg, LEVEL_1, "%lu alias queries, %lu disambiguated\n",
+	    env->n_queries, env->n_no_alias));
+	stat_ev_ull("pointsto_queries", env->n_queries);
+	stat_ev_ull("pointsto_no_alias", env->n_no_alias);
+
+	foreach_irp_irg(i, irg) {
+		clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_POINTS_TO
+		                        | IR_GRAPH_PROPERTY_CONSISTENT_ALIAS_CACHE);
+	}
+	points_to = NULL;
+	free_env(env);
+}
+
+static unsigned get_node_var(pta_env_t const *const env,
+                             ir_node const *const node)
+{
+	ir_graph *const irg = get_irn_irg(node);
+	if (!irg_has_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_POINTS_TO))
+		return VAR_NONE;
+	pta_graph_t const *const graph = get_graph(env, irg);
+	if (graph == NULL)
+		return VAR_NONE;
+	unsigned const idx = get_irn_idx(node);
+	return idx < graph->n_values ? graph->values[idx].var : VAR_NONE;
+}
+
+static bool vars_disjoint(pta_env_t const *const env, unsigned const var1,
+                          unsigned const var2)
+{
+	pta_var_t const *const v1 = &env->vars[var1];
+	pta_var_t const *const v2 = &env->vars[var2];
+	if (env->algorithm == ir_points_to_steensgaard) {
+		/* variables pointing nowhere are conservatively treated as unknown */
+		if (v1->pointee == NULL || v2->pointee == NULL)
+			return false;
+		steens_class_t const *const cls1 = steens_find(v1->pointee);
+		steens_class_t const *const cls2 = steens_find(v2->pointee);
+		return cls1 != cls2 && cls1->has_objects && cls2->has_objects;
+	} else {
+		size_t const n_objs = ARR_LEN(env->objects);
+		if (v1->pts == NULL || v2->pts == NULL
+		 || rbitset_is_empty(v1->pts, n_objs)
+		 || rbitset_is_empty(v2->pts, n_objs))
+			return false;
+		return !rbitsets_have_common(v1->pts, v2->pts, n_objs);
+	}
+}
+
+ir_alias_relation get_points_to_alias_relation(ir_node const *const addr1,
+                                               ir_node const *const addr2)
+{
+	pta_env_t *const env = points_to;
+	if (env == NULL)
+		return ir_may_alias;
+
+	unsigned const var1 = get_node_var(env, addr1);
+	unsigned const var2 = get_node_var(env, addr2);
+	if (var1 == VAR_NONE || var2 == VAR_NONE)
+		return ir_may_alias;
+
+	++env->n_queries;
+	if (!vars_disjoint(env, var1, var2))
+		return ir_may_alias;
+	++env->n_no_alias;
+	return ir_no_alias;
+}
+
+bool get_points_to_globals(ir_node const *const addr,
+                           ir_entity ***const entities)
+{
+	pta_env_t *const env = points_to;
+	if (env == NULL)
+		return false;
+	unsigned const var = get_node_var(env, addr);
+	if (var == VAR_NONE)
+		return false;
+
+	pta_var_t const *const v = &env->vars[var];
+	if (env->algorithm == ir_points_to_steensgaard) {
+		if (v->pointee == NULL)
+			return false;
+		steens_class_t const *const cls = steens_find(v->pointee);
+		if (!cls->has_objects || cls->has_others)
+			return false;
+		for (pta_global_t const *g = cls->globals; g != NULL; g = g->next) {
+			ARR_APP1(ir_entity*, *entities, g->entity);
+		}
+	} else {
+		size_t const n_objs = ARR_LEN(env->objects);
+		if (v->pts == NULL || rbitset_is_empty(v->pts, n_objs))
+			return false;
+		rbitset_foreach(v->pts, n_objs, obj) {
+			ir_entity const *const entity = env->objects[obj].entity;
+			if (entity == NULL || !is_global_var(entity))
+				return false;
+			ARR_APP1(ir_entity*, *entities, (ir_entity*)entity);
+		}
+	}
+	return true;
+}
@@ -0,0 +1,410 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2017 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Scalar evolution: induction variables and trip counts of loops.
+ */
+#include "scev.h"
+
+#include "debug.h"
+#include "irdom.h"
+#include "irgraph_t.h"
+#include "irgwalk.h"
+#include "irloop_t.h"
+#include "irnode_t.h"
+#include "obst.h"
+#include "pmap.h"
+#include "tv.h"
+#include "util.h"
+#include "xmalloc.h"
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg;)
+
+/** Control flow facts about a loop. */
+typedef struct scev_loop_t {
+	ir_node                 *header;      /**< the block with the backedges */
+	bool                     irreducible; /**< more than one header */
+	unsigned                 n_exits;     /**< number of edges leaving */
+	ir_node                 *exit;        /**< the leaving edge if unique */
+	bool                     analyzed;    /**< trip_count is computed */
+	scev_trip_count_t const *trip_count;
+} scev_loop_t;
+
+/**
+ * Memoized scalar evolution results of a graph, valid as long as the graph
+ * has IR_GRAPH_PROPERTY_CONSISTENT_SCEV.
+ */
+struct ir_scev_cache {
+	struct obstack obst;
+	pmap          *phis;  /**< maps Phis to their scev_t or NULL */
+	pmap          *loops; /**< maps loops to their scev_loop_t */
+};
+
+/** Checks whether @p inner is @p loop or one of its nested loops. */
+static bool loop_contains(const ir_loop *loop, const ir_loop *inner)
+{
+	if (inner == NULL)
+		return false;
+	unsigned const depth = get_loop_depth(loop);
+	while (get_loop_depth(inner) > depth)
+		inner = get_loop_outer_loop(inner);
+	return inner == loop;
+}
+
+/** Checks whether the value of @p node does not change inside @p loop. */
+static bool is_invariant(const ir_node *node, const ir_loop *loop)
+{
+	ir_node const *const block = get_block_const(node);
+	return !is_Bad(block) && !loop_contains(loop, get_irn_loop(block));
+}
+
+static scev_loop_t *get_loop_entry(ir_scev_cache *cache, ir_loop *loop)
+{
+	scev_loop_t *entry = pmap_get(scev_loop_t, cache->loops, loop);
+	if (entry == NULL) {
+		entry = OALLOCZ(&cache->obst, scev_loop_t);
+		pmap_insert(cache->loops, loop, entry);
+	}
+	return entry;
+}
+
+/** Records the headers and the exits of all loops the block is part of. */
+static void analyze_block(ir_node *block, void *data)
+{
+	ir_scev_cache *const cache = (ir_scev_cache*)data;
+	ir_loop       *const loop  = get_irn_loop(block);
+	for (int i = 0, n = get_Block_n_cfgpreds(block); i < n; ++i) {
+		ir_node *const pred = get_Block_cfgpred_block(block, i);
+		if (pred == NULL)
+			continue;
+
+		if (is_backedge(block, i) && loop != NULL) {
+			scev_loop_t *const entry = get_loop_entry(cache, loop);
+			if (entry->header != NULL && entry->header != block)
+				entry->irreducible = true;
+			entry->header = block;
+		}
+
+		/* the edge leaves all loops containing pred but not block */
+		for (ir_loop *l = get_irn_loop(pred); l != NULL
+		     && get_loop_outer_loop(l) != l && !loop_contains(l, loop);
+		     l = get_loop_outer_loop(l)) {
+			scev_loop_t *const entry = get_loop_entry(cache, l);
+			++entry->n_exits;
+			entry->exit = get_Block_cfgpred(block, i);
+		}
+	}
+}
+
+void free_irg_scev_cache(ir_graph *const irg)
+{
+	ir_scev_cache *const cache = irg->scev_cache;
+	if (cache == NULL)
+		return;
+	pmap_destroy(cache->loops);
+	pmap_destroy(cache->phis);
+	obstack_free(&cache->obst, NULL);
+	free(cache);
+	irg->scev_cache = NULL;
+}
+
+static ir_scev_cache *get_irg_scev_cache(ir_graph *const irg)
+{
+	if (!irg_has_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_SCEV)) {
+		FIRM_DBG_REGISTER(dbg, "firm.ana.scev");
+		free_irg_scev_cache(irg);
+		assure_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO
+		                         | IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE);
+		ir_scev_cache *const cache = XMALLOCZ(ir_scev_cache);
+		obstack_init(&cache->obst);
+		cache->phis  = pmap_create();
+		cache->loops = pmap_create();
+		irg_block_walk_graph(irg, analyze_block, NULL, cache);
+		irg->scev_cache = cache;
+		add_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_SCEV);
+	}
+	return irg->scev_cache;
+}
+
+static ir_tarval *get_const_value(const ir_node *node)
+{
+	return is_Const(node) ? get_Const_tarval(node) : tarval_unknown;
+}
+
+static scev_t *analyze_phi(ir_scev_cache *cache, ir_node *phi)
+{
+	ir_mode *const mode = get_irn_mode(phi);
+	if (!mode_is_int(mode) && !mode_is_reference(mode))
+		return NULL;
+
+	ir_node *const block = get_nodes_block(phi);
+	ir_loop *const loop  = get_irn_loop(block);
+	if (loop == NULL)
+		return NULL;
+	scev_loop_t const *const entry = pmap_get(scev_loop_t, cache->loops, loop);
+	if (entry == NULL || entry->header != block || entry->irreducible)
+		return NULL;
+
+	ir_node *start = NULL;
+	ir_node *next  = NULL;
+	foreach_irn_in(phi, i, pred) {
+		ir_node **const value = is_backedge(block, i) ? &next : &start;
+		if (is_Bad(pred) || (*value != NULL && *value != pred))
+			return NULL;
+		*value = pred;
+	}
+	if (start == NULL || next == NULL || !is_invariant(start, loop))
+		return NULL;
+
+	ir_node *step;
+	if (is_Add(next) && get_Add_left(next) == phi) {
+		step = get_Add_right(next);
+	} else if (is_Add(next) && get_Add_right(next) == phi) {
+		step = get_Add_left(next);
+	} else if (is_Sub(next) && get_Sub_left(next) == phi) {
+		step = get_Sub_right(next);
+	} else {
+		return NULL;
+	}
+	if (!is_invariant(step, loop))
+		return NULL;
+
+	scev_t *const iv = OALLOCZ(&cache->obst, scev_t);
+	iv->phi      = phi;
+	iv->loop     = loop;
+	iv->start    = start;
+	iv->next     = next;
+	iv->step     = step;
+	iv->negated  = is_Sub(next);
+	iv->start_tv = get_const_value(start);
+	iv->step_tv  = get_const_value(step);
+	if (iv->negated && iv->step_tv != tarval_unknown) {
+		int const old_wrap_on_overflow = tarval_get_wrap_on_overflow();
+		tarval_set_wrap_on_overflow(true);
+		iv->step_tv = tarval_neg(iv->step_tv);
+		tarval_set_wrap_on_overflow(old_wrap_on_overflow);
+	}
+	DB((dbg, LEVEL_2, "%+F is {%+F, %s, %+F} in loop %ld\n", phi, start,
+	    iv->negated ? "-" : "+", step, get_loop_loop_nr(loop)));
+	return iv;
+}
+
+scev_t const *scev_get_phi(ir_node *const phi)
+{
+	ir_scev_cache *const cache = get_irg_scev_cache(get_irn_irg(phi));
+	if (pmap_contains(cache->phis, phi))
+		return pmap_get(scev_t, cache->phis, phi);
+	scev_t *const iv = analyze_phi(cache, phi);
+	pmap_insert(cache->phis, phi, iv);
+	return iv;
+}
+
+/** Returns the induction variable of @p loop whose value @p value is. */
+static scev_t const *get_iv_of_value(ir_node *value, const ir_loop *loop,
+                                     bool *latest)
+{
+	if (is_Phi(value)) {
+		scev_t const *const iv = scev_get_phi(value);
+		*latest = false;
+		return iv != NULL && iv->loop == loop ? iv : NULL;
+	}
+	if (is_Add(value) || is_Sub(value)) {
+		ir_node *const left = get_binop_left(value);
+		ir_node *const phi  = is_Phi(left) ? left : get_binop_right(value);
+		if (!is_Phi(phi))
+			return NULL;
+		scev_t const *const iv = scev_get_phi(phi);
+		*latest = true;
+		return iv != NULL && iv->loop == loop && iv->next == value ? iv : NULL;
+	}
+	return NULL;
+}
+
+/**
+ * Computes the number of executions of the exit test, see
+ * scev_trip_count_t. All components have to be constants.
+ */
+static ir_tarval *compute_count(scev_trip_count_t const *tc)
+{
+	scev_t const *const iv    = tc->iv;
+	ir_tarval    *const step  = iv->step_tv;
+	ir_tarval    *const bound = get_const_value(tc->bound);
+	if (iv->start_tv == tarval_unknown || step == tarval_unknown
+	    || bound == tarval_unknown || tarval_is_null(step))
+		return tarval_unknown;
+	ir_mode *const mode = get_tarval_mode(bound);
+	if (!mode_is_int(mode) || get_tarval_mode(step) != mode
+	    || get_tarval_mode(iv->start_tv) != mode)
+		return tarval_unknown;
+
+	ir_tarval  *const start    = iv->start_tv;
+	ir_tarval  *const first    = tc->latest ? tarval_add(start, step) : start;
+	ir_relation const relation = tc->relation;
+	ir_mode    *const umode    = find_unsigned_mode(mode);
+	ir_tarval  *const one      = get_mode_one(umode);
+	/* the loop is left after the first test */
+	if (!(tarval_cmp(first, bound) & relation))
+		return one;
+
+	/* Count in the unsigned mode in the direction of the step: the distance
+	 * diff between the first value and the bound is covered in steps of
+	 * size mag. */
+	bool up;
+	switch (relation) {
+	case ir_relation_equal:
+		/* the second value differs */
+		return tarval_add(one, one);
+	case ir_relation_less:
+	case ir_relation_less_equal:
+		up = true;
+		break;
+	case ir_relation_greater:
+	case ir_relation_greater_equal:
+		up = false;
+		break;
+	case ir_relation_less_greater:
+		up = !tarval_is_negative(tarval_convert_to(step,
+		                                           find_signed_mode(mode)));
+		break;
+	default:
+		return tarval_unknown;
+	}
+	ir_tarval *const ufirst = tarval_convert_to(first, umode);
+	ir_tarval *const ubound = tarval_convert_to(bound, umode);
+	ir_tarval *const mag    = tarval_convert_to(up ? step : tarval_neg(step),
+	                                            umode);
+	ir_tarval *const diff   = up ? tarval_sub(ubound, ufirst)
+	                             : tarval_sub(ufirst, ubound);
+	ir_tarval *const rem    = tarval_mod(diff, mag);
+	ir_tarval       *k      = tarval_div(diff, mag);
+	switch (relation) {
+	case ir_relation_less:
+	case ir_relation_greater:
+		if (!tarval_is_null(rem))
+			k = tarval_add(k, one);
+		break;
+	case ir_relation_less_equal:
+	case ir_relation_greater_equal:
+		k = tarval_add(k, one);
+		break;
+	default:
+		/* the bound is never hit exactly: the value wraps around */
+		if (!tarval_is_null(rem))
+			return tarval_unknown;
+		break;
+	}
+
+	/* The values before the k-th one lie between first and bound. The k-th
+	 * value leaves the loop unless it wrapped around. */
+	ir_tarval *const distance = tarval_mul(k, mag);
+	ir_tarval *const last     = tarval_convert_to(
+		up ? tarval_add(ufirst, distance) : tarval_sub(ufirst, distance),
+		mode);
+	if (tarval_cmp(last, bound) & relation)
+		return tarval_unknown;
+
+	ir_tarval *const count = tarval_add(k, one);
+	return tarval_is_null(count) ? tarval_unknown : count;
+}
+
+static scev_trip_count_t *analyze_loop(ir_scev_cache *cache, ir_loop *loop)
+{
+	scev_loop_t const *const entry = pmap_get(scev_loop_t, cache->loops, loop);
+	if (entry == NULL || entry->header == NULL || entry->irreducible
+	    || entry->n_exits != 1)
+		return NULL;
+
+	/* the exit test has to be executed exactly once per iteration */
+	ir_node *const exit = entry->exit;
+	if (!is_Proj(exit) || !is_Cond(get_Proj_pred(exit)))
+		return NULL;
+	ir_node *const cond   = get_Proj_pred(exit);
+	ir_node *const block  = get_nodes_block(cond);
+	ir_node *const header = entry->header;
+	if (get_irn_loop(block) != loop)
+		return NULL;
+	for (int i = 0, n = get_Block_n_cfgpreds(header); i < n; ++i) {
+		if (!is_backedge(header, i))
+			continue;
+		ir_node *const pred = get_Block_cfgpred_block(header, i);
+		if (pred == NULL || !block_dominates(block, pred))
+			return NULL;
+	}
+
+	ir_node *const cmp = get_Cond_selector(cond);
+	if (!is_Cmp(cmp) || !mode_is_int(get_irn_mode(get_Cmp_left(cmp))))
+		return NULL;
+	ir_relation relation = get_Cmp_relation(cmp);
+	if (get_Proj_num(exit) == pn_Cond_true)
+		relation = get_negated_relation(relation);
+	relation &= ~ir_relation_unordered;
+
+	ir_node      *value = get_Cmp_left(cmp);
+	ir_node      *bound = get_Cmp_right(cmp);
+	bool          latest;
+	scev_t const *iv    = get_iv_of_value(value, loop, &latest);
+	if (iv == NULL || !is_invariant(bound, loop)) {
+		ir_node *const tmp = value;
+		value    = bound;
+		bound    = tmp;
+		relation = get_inversed_relation(relation);
+		iv       = get_iv_of_value(value, loop, &latest);
+		if (iv == NULL || !is_invariant(bound, loop))
+			return NULL;
+	}
+
+	scev_trip_count_t *const tc = OALLOCZ(&cache->obst, scev_trip_count_t);
+	tc->loop     = loop;
+	tc->iv       = iv;
+	tc->exit     = exit;
+	tc->cmp      = cmp;
+	tc->bound    = bound;
+	tc->relation = relation;
+	tc->latest   = latest;
+
+	int const old_wrap_on_overflow = tarval_get_wrap_on_overflow();
+	tarval_set_wrap_on_overflow(true);
+	tc->count = compute_count(tc);
+	tarval_set_wrap_on_overflow(old_wrap_on_overflow);
+
+	DB((dbg, LEVEL_1, "loop %ld: %+F %s %+F, count %T\n",
+	    get_loop_loop_nr(loop), latest ? iv->next : iv->phi,
+	    get_relation_string(relation), bound, tc->count));
+	return tc;
+}
+
+scev_trip_count_t const *scev_get_trip_count(ir_graph *const irg,
+                                             ir_loop *const loop)
+{
+	ir_scev_cache *const cache = get_irg_scev_cache(irg);
+	scev_loop_t   *const entry = get_loop_entry(cache, loop);
+	if (!entry->analyzed) {
+		entry->trip_count = analyze_loop(cache, loop);
+		entry->analyzed   = true;
+	}
+	return entry->trip_count;
+}
+
+ir_tarval *scev_get_exit_value(scev_trip_count_t const *const tc,
+                               scev_t const *const iv)
+{
+	if (tc->count == tarval_unknown || iv->loop != tc->loop
+	    || iv->start_tv == tarval_unknown || iv->step_tv == tarval_unknown)
+		return tarval_unknown;
+	ir_mode *const mode = get_irn_mode(iv->phi);
+	if (!mode_is_int(mode) || get_tarval_mode(iv->step_tv) != mode)
+		return tarval_unknown;
+
+	int const old_wrap_on_overflow = tarval_get_wrap_on_overflow();
+	tarval_set_wrap_on_overflow(true);
+	ir_tarval *const steps = tarval_convert_to(
+		tarval_sub(tc->count, get_mode_one(get_tarval_mode(tc->count))),
+		mode);
+	ir_tarval *const value = tarval_add(iv->start_tv,
+	                                    tarval_mul(steps, iv->step_tv));
+	tarval_set_wrap_on_overflow(old_wrap_on_overflow);
+	return value;
+}
@@ -0,0 +1,86 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2017 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Scalar evolution: induction variables and trip counts of loops.
+ *
+ * A Phi in the header of a loop is an add-recurrence {start, +, step} if it
+ * receives a loop invariant start value from outside the loop and the value
+ * Phi + step or Phi - step over all backedges, where step is loop invariant.
+ *
+ * The trip count of a loop is derived from its only exit if that exit is
+ * decided by comparing an add-recurrence of the loop (or its incremented
+ * value) with a loop invariant bound once per iteration. The components of
+ * the exit test are available for every such loop, the number of iterations
+ * additionally as a constant if start, step and bound are constants.
+ *
+ * Results are memoized per graph as long as the graph has
+ * IR_GRAPH_PROPERTY_CONSISTENT_SCEV. Changing node inputs clears it like the
+ * loop information, other code changing the loops has to clear it.
+ */
+#ifndef FIRM_ANA_SCEV_H
+#define FIRM_ANA_SCEV_H
+
+#include <stdbool.h>
+#include "firm_types.h"
+
+/** An add-recurrence {start, +, step} of a loop header Phi. */
+typedef struct scev_t {
+	ir_node   *phi;      /**< the loop header Phi */
+	ir_loop   *loop;     /**< the loop of the header */
+	ir_node   *start;    /**< value entering the loop, loop invariant */
+	ir_node   *next;     /**< the Add or Sub computing the next value */
+	ir_node   *step;     /**< the loop invariant operand of next */
+	bool       negated;  /**< next subtracts step */
+	ir_tarval *start_tv; /**< constant start value or tarval_unknown */
+	ir_tarval *step_tv;  /**< constant increment (negated step for a Sub)
+	                          or tarval_unknown */
+} scev_t;
+
+/** The exit test and iteration count of a loop. */
+typedef struct scev_trip_count_t {
+	ir_loop      *loop;
+	scev_t const *iv;       /**< the induction variable controlling the loop */
+	ir_node      *exit;     /**< the control flow Proj leaving the loop */
+	ir_node      *cmp;      /**< the Cmp deciding the exit */
+	ir_node      *bound;    /**< loop invariant operand of cmp */
+	/**
+	 * The loop is continued while (value relation bound) holds, where value
+	 * is the compared value of the induction variable.
+	 */
+	ir_relation   relation;
+	bool          latest;   /**< cmp uses the incremented value (iv->next) */
+	/**
+	 * Number of executions of the exit test, which is the number of
+	 * iterations of the loop header. Constant of the unsigned mode of the
+	 * induction variable or tarval_unknown.
+	 */
+	ir_tarval    *count;
+} scev_trip_count_t;
+
+/**
+ * Returns the add-recurrence of the Phi @p phi or NULL if it is not an
+ * induction variable of a loop.
+ */
+scev_t const *scev_get_phi(ir_node *phi);
+
+/**
+ * Returns the exit test of the loop @p loop or NULL if the loop has no
+ * single exit controlled by an induction variable.
+ */
+scev_trip_count_t const *scev_get_trip_count(ir_graph *irg, ir_loop *loop);
+
+/**
+ * Returns the constant value of the induction variable @p iv in the last
+ * iteration of the loop described by @p tc, i.e. the value of its Phi when
+ * leaving the loop. Returns tarval_unknown if it is not known.
+ */
+ir_tarval *scev_get_exit_value(scev_trip_count_t const *tc, scev_t const *iv);
+
+/** Frees the memoized scalar evolution results of @p irg. */
+void free_irg_scev_cache(ir_graph *irg);
+
+#endif
@@ -59,6 +59,17 @@ vrp_attr *vrp_get_info(const ir_node *node)
 	return ir_nodemap_get(vrp_attr, &irg->vrp.infos, node);
 }
 
+const vrp_attr *vrp_get_param_info(const ir_graph *irg, size_t pos)
+{
+	/* lowering may change the parameters of a method */
+	ir_type *mtp = get_entity_type(get_irg_entity(irg));
+	if (irg->vrp.params == NULL || irg->vrp.params_mtp != mtp)
+		return NULL;
+	assert(pos < get_method_n_params(mtp));
+	const vrp_attr *param = &irg->vrp.params[pos];
+	return param->range_type != VRP_UNDEFINED ? param : NULL;
+}
+
 static int vrp_update_node(ir_vrp_info *info, ir_node *node)
 {
 	ir_tarval       *new_bits_set      = get_tarval_bad();
@@ -308,6 +319,22 @@ static int vrp_update_node(ir_vrp_info *info, ir_node *node)
 		break;
 	}
 
+	case iro_Proj: {
+		/* arguments may be known from all call sites */
+		ir_graph *irg = get_irn_irg(node);
+		if (get_Proj_pred(node) != get_irg_args(irg))
+			break;
+		const vrp_attr *param = vrp_get_param_info(irg, get_Proj_num(node));
+		if (param == NULL)
+			break;
+		new_bits_set     = param->bits_set;
+		new_bits_not_set = param->bits_not_set;
+		new_range_type   = param->range_type;
+		new_range_bottom = param->range_bottom;
+		new_range_top    = param->range_top;
+		break;
+	}
+
 	case iro_Phi: {
 		/* combine all ranges*/
 		const ir_node *pred = get_Phi_pred(node,0);
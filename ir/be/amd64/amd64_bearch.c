@@ -435,6 +435,14 @@ static void amd64_select_instructions(ir_graph *irg)
 	be_dump(DUMP_BE, irg, "opt");
 }
 
+COMPILETIME_ASSERT((int)n_amd64_ret_mem   == (int)n_amd64_tail_call_mem &&
+                   (int)n_amd64_ret_stack == (int)n_amd64_tail_call_stack,
+                   tail_call_inputs)
+
+/**
+ * Restores the stack pointer and frame pointer before @p ret, which is a
+ * ret or a tail_call node.
+ */
 static void introduce_epilogue(ir_node *ret, bool omit_fp)
 {
 	ir_graph *irg      = get_irn_irg(ret);
@@ -514,7 +522,7 @@ static void introduce_prologue_epilogue(ir_graph *irg, bool omit_fp)
 {
 	/* introduce epilogue for every return node */
 	foreach_irn_in(get_irg_end_block(irg), i, ret) {
-		assert(is_amd64_ret(ret));
+		assert(is_amd64_ret(ret) || is_amd64_tail_call(ret));
 		introduce_epilogue(ret, omit_fp);
 	}
 
@@ -742,13 +750,14 @@ static void amd64_lower_for_target(void)
 		be_after_transform(irg, "lower-copyb");
 	}
 
-	ir_builtin_kind supported[6];
+	ir_builtin_kind supported[7];
 	size_t  s = 0;
 	supported[s++] = ir_bk_ffs;
 	supported[s++] = ir_bk_clz;
 	supported[s++] = ir_bk_ctz;
 	supported[s++] = ir_bk_compare_swap;
 	supported[s++] = ir_bk_saturating_increment;
+	supported[s++] = ir_bk_prefetch;
 	supported[s++] = ir_bk_va_start;
 
 	assert(s <= ARRAY_SIZE(supported));
@@ -785,6 +794,29 @@ static unsigned amd64_get_op_estimated_cost(const ir_node *node)
 	return 1;
 }
 
+static be_op_class_t amd64_get_op_class(ir_node const *const node)
+{
+	if (!is_amd64_irn(node))
+		return be_get_generic_op_class(node);
+
+	if (is_amd64_imul(node) || is_amd64_imul_1op(node) || is_amd64_mul(node))
+		return BE_OP_MUL;
+	if (is_amd64_div(node) || is_amd64_idiv(node))
+		return BE_OP_DIV;
+	if (is_amd64_adds(node) || is_amd64_subs(node))
+		return BE_OP_FP_ADD;
+	if (is_amd64_muls(node))
+		return BE_OP_FP_MUL;
+	if (is_amd64_divs(node))
+		return BE_OP_FP_DIV;
+	if (is_amd64_mov_store(node) || is_amd64_movs_store_xmm(node)
+	 || is_amd64_movdqu_store(node))
+		return BE_OP_STORE;
+	if (amd64_loads(node))
+		return BE_OP_LOAD;
+	return be_get_generic_op_class(node);
+}
+
 /** we don't have a concept of aliasing registers, so enumerate them
  * manually for the asm nodes. */
 static be_register_name_t const amd64_additional_reg_names[] = {
@@ -814,6 +846,7 @@ arch_isa_if_t const amd64_isa_if = {
 	.big_endian            = false,
 	.po2_biggest_alignment = 4,
 	.pic_supported         = true,
+	.far_branches          = true,
 	.n_registers           = N_AMD64_REGISTERS,
 	.registers             = amd64_registers,
 	.n_register_classes    = N_AMD64_CLASSES,
@@ -825,6 +858,8 @@ arch_isa_if_t const amd64_isa_if = {
 	.additional_reg_names  = amd64_additional_reg_names,
 	.handle_intrinsics     = amd64_handle_intrinsics,
 	.get_op_estimated_cost = amd64_get_op_estimated_cost,
+	.machine               = "x86-64",
+	.get_op_class          = amd64_get_op_class,
 };
 
 BE_REGISTER_MODULE_CONSTRUCTOR(be_init_arch_amd64)
@@ -301,6 +301,20 @@ my $x87store = {
 	attr      => "const amd64_binop_addr_attr_t *attr_init",
 };
 
+my $prefetchop = {
+	op_flags  => [ "uses_memory" ],
+	state     => "exc_pinned",
+	in_reqs   => "...",
+	out_reqs  => [ "mem" ],
+	outs      => [ "M" ],
+	attr_type => "amd64_addr_attr_t",
+	attr      => "x86_addr_t addr",
+	fixed     => "amd64_op_mode_t op_mode = AMD64_OP_ADDR;\n"
+	            ."x86_insn_size_t size = X86_SIZE_8;\n",
+	emit      => "{name} %A",
+	latency   => 0,
+};
+
 %nodes = (
 push_am => {
 	op_flags  => [ "uses_memory" ],
@@ -531,6 +545,14 @@ mov_store => {
 	emit      => "mov%M %AM",
 },
 
+prefetcht0 => { template => $prefetchop },
+
+prefetcht1 => { template => $prefetchop },
+
+prefetcht2 => { template => $prefetchop },
+
+prefetchnta => { template => $prefetchop },
+
 jmp_switch => {
 	op_flags  => [ "cfopcode", "forking" ],
 	state     => "pinned",
@@ -551,6 +573,18 @@ call => {
 	emit      => "call %*AM",
 },
 
+tail_call => {
+	state     => "pinned",
+	op_flags  => [ "cfopcode" ],
+	in_reqs   => "...",
+	out_reqs  => [ "exec" ],
+	ins       => [ "mem", "stack", "first_argument" ],
+	attr_type => "amd64_addr_attr_t",
+	attr      => "amd64_op_mode_t op_mode, x86_addr_t addr",
+	fixed     => "x86_insn_size_t size = X86_SIZE_64;\n",
+	emit      => "jmp %*AM",
+},
+
 ret => {
 	state    => "pinned",
 	op_flags => [ "cfopcode" ],
@@ -1661,8 +1661,14 @@ static ir_node *gen_Proj_Start(ir_node *const node)
 	panic("unexpected Start Proj: %u", pn);
 }
 
+static ir_node *gen_tail_call(ir_node *ret, ir_node *call);
+
 static ir_node *gen_Return(ir_node *const node)
 {
+	ir_node *const call = x86_get_tail_call(node);
+	if (call != NULL)
+		return gen_tail_call(node, call);
+
 	ir_graph          *const irg       = get_irn_irg(node);
 	ir_node           *const new_block = be_transform_nodes_block(node);
 	dbg_info          *const dbgi      = get_irn_dbg_info(node);
@@ -1761,6 +1767,143 @@ static ir_node *make_lea_base_frameoffset(dbg_info *dbgi, ir_node *block, ir_nod
 	return new_bd_amd64_lea(dbgi, block, ARRAY_SIZE(lea_in), lea_in, reg_reqs, X86_SIZE_64, lea_addr);
 }
 
+/**
+ * Transforms the Return @p ret of the results of the tail call @p call into
+ * a jump to the callee, which returns to our caller.
+ */
+static ir_node *gen_tail_call(ir_node *const ret, ir_node *const call)
+{
+	ir_graph          *const irg       = get_irn_irg(ret);
+	ir_node           *const new_block = be_transform_nodes_block(ret);
+	dbg_info          *const dbgi      = get_irn_dbg_info(call);
+	ir_node           *const callee    = get_Call_ptr(call);
+	ir_node           *const mem       = be_transform_node(get_Call_mem(call));
+	ir_type           *const type      = get_Call_type(call);
+	size_t             const n_params  = get_Call_n_params(call);
+	x86_cconv_t       *const cconv
+		= amd64_decide_calling_convention(type, NULL);
+	x86_cconv_t const *const own_cconv = current_cconv;
+
+	size_t const n_callee_saves
+		= rbitset_popcount(own_cconv->callee_saves, N_AMD64_REGISTERS);
+	/* mem + stackpointer + callee + rax + param-regs + callee saves */
+	unsigned const max_inputs = 4 + cconv->n_param_regs + n_callee_saves;
+	arch_register_req_t const **const reqs = be_allocate_in_reqs(irg, max_inputs);
+	ir_node                   **const in   = ALLOCAN(ir_node*, max_inputs);
+	ir_node                   **const sync_ins = ALLOCAN(ir_node*, 1 + n_params);
+	int                               sync_arity = 0;
+	int                               arity      = n_amd64_tail_call_first_argument;
+
+	in[n_amd64_tail_call_stack]   = get_initial_sp(irg);
+	reqs[n_amd64_tail_call_stack] = amd64_registers[REG_RSP].single_req;
+
+	/* match callee, address mode is not possible as the frame is already
+	 * gone when jumping */
+	x86_addr_t addr;
+	memset(&addr, 0, sizeof(addr));
+	amd64_op_mode_t op_mode;
+	if (match_immediate_32(&addr.immediate, callee, true)) {
+		op_mode = AMD64_OP_IMM32;
+	} else {
+		int const input = arity++;
+		addr.variant    = X86_ADDR_REG;
+		addr.base_input = input;
+		in[input]       = be_transform_node(callee);
+		reqs[input]     = &amd64_class_reg_req_gp;
+		op_mode         = AMD64_OP_REG;
+	}
+
+	/* vararg calls need the number of SSE registers used */
+	if (is_method_variadic(type)) {
+		in[arity]   = make_const(dbgi, new_block, cconv->n_xmm_regs);
+		reqs[arity] = amd64_registers[REG_RAX].single_req;
+		++arity;
+	}
+
+	/* parameters, stack arguments replace our own stack parameters */
+	ir_node *const frame = get_frame_base(irg);
+	for (size_t p = 0; p < n_params; ++p) {
+		ir_node                  *const value = get_Call_param(call, p);
+		reg_or_stackslot_t const *const param = &cconv->parameters[p];
+		if (param->reg != NULL) {
+			in[arity]   = be_transform_node(value);
+			reqs[arity] = param->reg->single_req;
+			++arity;
+			continue;
+		}
+
+		ir_mode        *const mode = get_type_mode(get_method_param_type(type, p));
+		x86_insn_size_t       size = x86_size_from_mode(mode);
+		if (size < X86_SIZE_32)
+			size = X86_SIZE_32;
+
+		amd64_binop_addr_attr_t attr = {
+			.base = {
+				.base = {
+					.size = size,
+				},
+				.addr = {
+					.immediate = {
+						.kind   = X86_IMM_FRAMEOFFSET,
+						.offset = AMD64_REGISTER_SIZE + param->offset,
+					},
+					.variant = X86_ADDR_BASE,
+				},
+			},
+		};
+
+		ir_node *store_in[3];
+		int      store_arity = make_store_value(&attr, mode, value, store_in);
+
+		attr.base.addr.base_input = store_arity;
+		store_in[store_arity++]   = frame;
+		store_in[store_arity++]   = mem;
+		sync_ins[sync_arity++]    = make_store_for_mode(mode, dbgi, new_block, store_arity, store_in, &attr, true);
+	}
+	if (sync_arity == 0)
+		sync_ins[sync_arity++] = mem;
+	in[n_amd64_tail_call_mem]   = be_make_Sync(new_block, sync_arity, sync_ins);
+	reqs[n_amd64_tail_call_mem] = arch_memory_req;
+	addr.mem_input              = n_amd64_tail_call_mem;
+
+	/* callee saves */
+	for (size_t i = 0; i < N_AMD64_REGISTERS; ++i) {
+		if (!rbitset_is_set(own_cconv->callee_saves, i))
+			continue;
+		arch_register_t const *const reg = &amd64_registers[i];
+		in[arity]   = be_get_Start_proj(irg, reg);
+		reqs[arity] = reg->single_req;
+		++arity;
+	}
+	assert(arity <= (int)max_inputs);
+
+	ir_node *const jmp = new_bd_amd64_tail_call(dbgi, new_block, arity, in, reqs, op_mode, addr);
+	be_stack_record_chain(&stack_env, jmp, n_amd64_tail_call_stack, NULL);
+	x86_free_calling_convention(cconv);
+	DB((dbg, LEVEL_2, "%+F is a tail call\n", call));
+	return jmp;
+}
+
+/**
+ * Decides which of the marked tail calls are executed as jumps.  The stack
+ * arguments of the callee must fit into the area of our stack parameters.
+ */
+static void prepare_tail_calls(ir_graph *const irg)
+{
+	foreach_irn_in(get_irg_end_block(irg), i, ret) {
+		ir_node *const call = x86_get_tail_call(ret);
+		if (call == NULL)
+			continue;
+		x86_cconv_t *const cconv
+			= amd64_decide_calling_convention(get_Call_type(call), NULL);
+		if (cconv->param_stacksize > current_cconv->param_stacksize)
+			set_Call_tail_call(call, false);
+		else if (cconv->param_stacksize > 0)
+			x86_order_parameter_loads(call);
+		x86_free_calling_convention(cconv);
+	}
+}
+
 static ir_node *gen_Call(ir_node *const node)
 {
 	ir_node           *const callee       = get_Call_ptr(node);
@@ -3081,6 +3224,45 @@ static ir_node *gen_saturating_increment(ir_node *const node)
 	return sbb;
 }
 
+static ir_node *gen_prefetch(ir_node *const node)
+{
+	dbg_info *const dbgi     = get_irn_dbg_info(node);
+	ir_node  *const block    = be_transform_nodes_block(node);
+	ir_node  *const ptr      = get_Builtin_param(node, 0);
+	ir_node  *const mem      = get_Builtin_mem(node);
+	size_t    const n_params = get_Builtin_n_params(node);
+	/* the rw parameter is ignored, prefetchw is not available everywhere */
+	long      const locality = n_params > 2
+		? get_Const_long(get_Builtin_param(node, 2)) : 3;
+
+	ir_node *in[3];
+	int arity = 0;
+	x86_addr_t addr;
+	memset(&addr, 0, sizeof(addr));
+	perform_address_matching(ptr, &arity, in, &addr);
+	arch_register_req_t const **const reqs = gp_am_reqs[arity];
+	in[arity++] = be_transform_node(mem);
+	assert((size_t)arity <= ARRAY_SIZE(in));
+
+	ir_node *new_node;
+	switch (locality) {
+	case 0:
+		new_node = new_bd_amd64_prefetchnta(dbgi, block, arity, in, reqs, addr);
+		break;
+	case 1:
+		new_node = new_bd_amd64_prefetcht2(dbgi, block, arity, in, reqs, addr);
+		break;
+	case 2:
+		new_node = new_bd_amd64_prefetcht1(dbgi, block, arity, in, reqs, addr);
+		break;
+	default:
+		new_node = new_bd_amd64_prefetcht0(dbgi, block, arity, in, reqs, addr);
+		break;
+	}
+	set_irn_pinned(new_node, get_irn_pinned(node));
+	return new_node;
+}
+
 static ir_node *gen_va_start(ir_node *const node)
 {
 	ir_graph *const irg   = get_irn_irg(node);
@@ -3107,6 +3289,8 @@ static ir_node *gen_Builtin(ir_node *const node)
 		return gen_compare_swap(node);
 	case ir_bk_saturating_increment:
 		return gen_saturating_increment(node);
+	case ir_bk_prefetch:
+		return gen_prefetch(node);
 	case ir_bk_va_start:
 		return gen_va_start(node);
 	default:
@@ -3137,6 +3321,7 @@ static ir_node *gen_Proj_Builtin(ir_node *const proj)
 		}
 	case ir_bk_saturating_increment:
 		return be_new_Proj(new_node, pn_amd64_sbb_res);
+	case ir_bk_prefetch:
 	case ir_bk_va_start:
 		assert(get_Proj_num(proj) == pn_Builtin_M);
 		return new_node;
@@ -3276,6 +3461,7 @@ void amd64_transform_graph(ir_graph *irg)
 	amd64_set_va_stack_args_param(current_cconv->va_start_addr);
 	be_add_parameter_entity_stores(irg);
 	x86_create_parameter_loads(irg, current_cconv);
+	prepare_tail_calls(irg);
 
 	heights = heights_new(irg);
 	x86_calculate_non_address_mode_nodes(irg);
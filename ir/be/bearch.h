@@ -19,6 +19,7 @@
 
 #include "be_types.h"
 #include "beinfo.h"
+#include "bemachine.h"
 #include "be.h"
 
 extern arch_register_req_t const arch_exec_requirement;
@@ -267,6 +268,9 @@ struct arch_isa_if_t {
 	                                         necessary/recommended for any data
 	                                         type on the target. */
 	bool        pic_supported;
+	bool        far_branches;           /**< branches reach code in other
+	                                         sections, so cold blocks may be
+	                                         moved out of the function */
 
 	unsigned                     n_registers;        /**< number of registers */
 	arch_register_t       const *registers;          /**< register array */
@@ -321,6 +325,18 @@ struct arch_isa_if_t {
 	 * number of cycles necessary to execute the instruction.
 	 */
 	unsigned (*get_op_estimated_cost)(const ir_node *irn);
+
+	/**
+	 * Name of the default machine model for latency aware scheduling.
+	 * NULL selects a simple in-order model.
+	 */
+	char const *machine;
+
+	/**
+	 * Classify node @p irn for the machine model.  May be NULL, then
+	 * be_get_generic_op_class() is used.
+	 */
+	be_op_class_t (*get_op_class)(const ir_node *irn);
 };
 
 static inline bool arch_irn_is_ignore(const ir_node *irn)
@@ -18,10 +18,17 @@
  * to change as many edges to fallthroughs as possible, this is done by setting
  * a next and prev pointers on blocks. The greedy algorithm sorts the edges by
  * execution frequencies and tries to transform them to fallthroughs in this order
+ *
+ * The ExtTSP algorithm maximizes the extended TSP score of the layout, which
+ * also rewards short jumps, by merging chains of blocks.
+ *
+ * With profile data, blocks which were never executed are moved to the end and
+ * emitted into a separate cold section.
  */
 #include "beblocksched.h"
 
 #include "bearch.h"
+#include "begnuas.h"
 #include "beirg.h"
 #include "bemodule.h"
 #include "besched.h"
@@ -31,11 +38,40 @@
 #include "irgmod.h"
 #include "irgwalk.h"
 #include "irnode_t.h"
+#include "irprofile.h"
+#include "irtools.h"
+#include "lc_opts.h"
+#include "lc_opts_enum.h"
 #include "pdeq.h"
+#include "target_t.h"
 #include "util.h"
 
 DEBUG_ONLY(static firm_dbg_module_t *dbg = NULL;)
 
+typedef enum blocksched_algo_t {
+	BLOCKSCHED_GREEDY,
+	BLOCKSCHED_EXTTSP,
+} blocksched_algo_t;
+
+static int  algo       = BLOCKSCHED_GREEDY;
+static bool split_cold = true;
+
+static const lc_opt_enum_int_items_t algo_items[] = {
+	{ "greedy", BLOCKSCHED_GREEDY },
+	{ "exttsp", BLOCKSCHED_EXTTSP },
+	{ NULL,     0 }
+};
+
+static lc_opt_enum_int_var_t algo_var = {
+	&algo, algo_items
+};
+
+static const lc_opt_table_entry_t blocksched_options[] = {
+	LC_OPT_ENT_ENUM_INT("algo",      "block scheduling algorithm",                                 &algo_var),
+	LC_OPT_ENT_BOOL    ("splitcold", "emit never executed blocks into a cold section (needs profile)", &split_cold),
+	LC_OPT_LAST
+};
+
 static bool blocks_removed;
 
 /**
@@ -532,6 +568,500 @@ static ir_node **create_blocksched_array(blocksched_env_t *const env)
 	return block_list;
 }
 
+/* Parameters of the extended TSP score, see Newell, Pupyrev: "Improved Basic
+ * Block Reordering" */
+#define EXTTSP_FALLTHROUGH_WEIGHT 1.0
+#define EXTTSP_FORWARD_WEIGHT     0.1
+#define EXTTSP_BACKWARD_WEIGHT    0.1
+#define EXTTSP_FORWARD_DISTANCE   1024
+#define EXTTSP_BACKWARD_DISTANCE  640
+/** estimated size of an instruction in bytes */
+#define EXTTSP_INSN_SIZE          4
+/** larger functions use the greedy algorithm */
+#define EXTTSP_MAX_BLOCKS         4096
+
+typedef struct exttsp_block_t     exttsp_block_t;
+typedef struct exttsp_chain_t     exttsp_chain_t;
+typedef struct exttsp_candidate_t exttsp_candidate_t;
+
+typedef struct exttsp_edge_t {
+	exttsp_block_t *src;
+	exttsp_block_t *dst;
+	double          freq;
+} exttsp_edge_t;
+
+struct exttsp_block_t {
+	ir_node         *block;
+	unsigned         size;   /**< estimated code size in bytes */
+	unsigned         offset; /**< offset in its chain */
+	exttsp_chain_t  *chain;
+	exttsp_edge_t  **succs;  /**< outgoing edges */
+};
+
+struct exttsp_chain_t {
+	exttsp_block_t **blocks;
+	double           freq;   /**< sum of the block frequencies */
+	unsigned         size;
+	exttsp_candidate_t **cands; /**< candidates merging this chain */
+	exttsp_candidate_t  *best;  /**< candidate with the highest gain or NULL */
+};
+
+/**
+ * A pair of chains connected by an edge, which may be merged. A candidate
+ * with a == b is no longer used.
+ */
+struct exttsp_candidate_t {
+	exttsp_chain_t  *a;
+	exttsp_chain_t  *b;
+	exttsp_edge_t  **edges; /**< edges between a and b */
+	double           gain;
+	bool            a_first; /**< append b to a, otherwise a to b */
+};
+
+typedef struct exttsp_env_t {
+	struct obstack   obst;
+	exttsp_block_t **blocks;
+	exttsp_chain_t  *entry;
+} exttsp_env_t;
+
+static exttsp_block_t *get_exttsp_block(ir_node const *const block)
+{
+	return (exttsp_block_t*)get_irn_link(block);
+}
+
+static void collect_exttsp_block(ir_node *const block, void *const data)
+{
+	exttsp_env_t *const env = (exttsp_env_t*)data;
+	if (block == get_irg_end_block(get_irn_irg(block)))
+		return;
+
+	unsigned n_insns = 1;
+	sched_foreach(block, node) {
+		++n_insns;
+	}
+
+	exttsp_block_t *const eblock = OALLOCZ(&env->obst, exttsp_block_t);
+	eblock->block = block;
+	eblock->size  = n_insns * EXTTSP_INSN_SIZE;
+	eblock->succs = NEW_ARR_F(exttsp_edge_t*, 0);
+	set_irn_link(block, eblock);
+	ARR_APP1(exttsp_block_t*, env->blocks, eblock);
+}
+
+static bool has_single_succ(ir_node const *const block)
+{
+	return get_block_succ_next(block, get_block_succ_first(block)) == NULL;
+}
+
+static void collect_exttsp_edges(exttsp_env_t *const env)
+{
+	for (size_t i = 0, n = ARR_LEN(env->blocks); i < n; ++i) {
+		exttsp_block_t *const eblock = env->blocks[i];
+		ir_node        *const block  = eblock->block;
+		int             const arity  = get_Block_n_cfgpreds(block);
+		for (int p = 0; p < arity; ++p) {
+			ir_node *const pred = get_Block_cfgpred(block, p);
+			if (is_Bad(pred))
+				continue;
+
+			/* the edge frequency is exact if the edge is the only one entering
+			 * or leaving a block */
+			ir_node *const pred_block = get_nodes_block(pred);
+			double   const freq       = get_block_execfreq(block);
+			double   const pred_freq  = get_block_execfreq(pred_block);
+			double         edge_freq;
+			if (arity == 1) {
+				edge_freq = freq;
+			} else if (has_single_succ(pred_block)) {
+				edge_freq = pred_freq;
+			} else {
+				edge_freq = MIN(freq, pred_freq);
+			}
+
+			exttsp_block_t *const src  = get_exttsp_block(pred_block);
+			exttsp_edge_t  *const edge = OALLOC(&env->obst, exttsp_edge_t);
+			edge->src  = src;
+			edge->dst  = eblock;
+			edge->freq = edge_freq;
+			ARR_APP1(exttsp_edge_t*, src->succs, edge);
+		}
+	}
+}
+
+static double exttsp_edge_score(exttsp_edge_t const *const edge,
+                                unsigned const src, unsigned const dst)
+{
+	unsigned const src_end = src + edge->src->size;
+	if (dst == src_end)
+		return edge->freq * EXTTSP_FALLTHROUGH_WEIGHT;
+	if (dst > src_end) {
+		unsigned const dist = dst - src_end;
+		if (dist < EXTTSP_FORWARD_DISTANCE) {
+			return edge->freq * EXTTSP_FORWARD_WEIGHT
+			     * (1.0 - (double)dist / EXTTSP_FORWARD_DISTANCE);
+		}
+	} else {
+		unsigned const dist = src_end - dst;
+		if (dist < EXTTSP_BACKWARD_DISTANCE) {
+			return edge->freq * EXTTSP_BACKWARD_WEIGHT
+			     * (1.0 - (double)dist / EXTTSP_BACKWARD_DISTANCE);
+		}
+	}
+	return 0.0;
+}
+
+static void place_chain(exttsp_chain_t const *const chain)
+{
+	unsigned offset = 0;
+	for (size_t i = 0, n = ARR_LEN(chain->blocks); i < n; ++i) {
+		exttsp_block_t *const eblock = chain->blocks[i];
+		eblock->offset = offset;
+		offset        += eblock->size;
+	}
+}
+
+/**
+ * Computes the score of the edges of @p cand in the layout placing
+ * @p second directly behind @p first. The edges inside the chains keep their
+ * score, because their distances do not change.
+ */
+static double score_layout(exttsp_candidate_t const *const cand,
+                           exttsp_chain_t const *const first,
+                           exttsp_chain_t const *const second)
+{
+	double score = 0.0;
+	for (size_t i = 0, n = ARR_LEN(cand->edges); i < n; ++i) {
+		exttsp_edge_t const *const edge = cand->edges[i];
+		unsigned src = edge->src->offset;
+		unsigned dst = edge->dst->offset;
+		if (edge->src->chain == second)
+			src += first->size;
+		else
+			dst += first->size;
+		score += exttsp_edge_score(edge, src, dst);
+	}
+	return score;
+}
+
+static void evaluate_candidate(exttsp_env_t const *const env,
+                               exttsp_candidate_t *const cand)
+{
+	exttsp_chain_t *const a = cand->a;
+	exttsp_chain_t *const b = cand->b;
+
+	/* the entry block must stay at the beginning */
+	cand->gain = -1.0;
+	if (b != env->entry) {
+		cand->gain    = score_layout(cand, a, b);
+		cand->a_first = true;
+	}
+	if (a != env->entry) {
+		double const gain = score_layout(cand, b, a);
+		if (gain > cand->gain) {
+			cand->gain    = gain;
+			cand->a_first = false;
+		}
+	}
+}
+
+/** Returns the candidate merging @p chain and @p other or NULL. */
+static exttsp_candidate_t *find_candidate(exttsp_chain_t const *const chain,
+                                          exttsp_chain_t const *const other)
+{
+	for (size_t i = 0, n = ARR_LEN(chain->cands); i < n; ++i) {
+		exttsp_candidate_t *const cand = chain->cands[i];
+		if (cand->a != cand->b && (cand->a == other || cand->b == other))
+			return cand;
+	}
+	return NULL;
+}
+
+static void add_candidate(exttsp_env_t *const env, exttsp_edge_t *const edge)
+{
+	exttsp_chain_t     *const a    = edge->src->chain;
+	exttsp_chain_t     *const b    = edge->dst->chain;
+	exttsp_candidate_t       *cand = find_candidate(a, b);
+	if (cand == NULL) {
+		cand        = OALLOCZ(&env->obst, exttsp_candidate_t);
+		cand->a     = a;
+		cand->b     = b;
+		cand->edges = NEW_ARR_F(exttsp_edge_t*, 0);
+		ARR_APP1(exttsp_candidate_t*, a->cands, cand);
+		ARR_APP1(exttsp_candidate_t*, b->cands, cand);
+	}
+	ARR_APP1(exttsp_edge_t*, cand->edges, edge);
+}
+
+static void remove_candidate(exttsp_candidate_t *const cand,
+                             exttsp_chain_t *const chain)
+{
+	DEL_ARR_F(cand->edges);
+	cand->edges = NULL;
+	cand->a     = chain;
+	cand->b     = chain;
+}
+
+static void update_best_candidate(exttsp_chain_t *const chain)
+{
+	exttsp_candidate_t *best = NULL;
+	for (size_t i = 0, n = ARR_LEN(chain->cands); i < n; ++i) {
+		exttsp_candidate_t *const cand = chain->cands[i];
+		if (cand->a != cand->b && cand->gain > 0.0
+		 && (best == NULL || cand->gain > best->gain))
+			best = cand;
+	}
+	chain->best = best;
+}
+
+static exttsp_chain_t *get_other_chain(exttsp_candidate_t const *const cand,
+                                       exttsp_chain_t const *const chain)
+{
+	return cand->a == chain ? cand->b : cand->a;
+}
+
+static void merge_chains(exttsp_env_t *const env,
+                         exttsp_candidate_t const *const cand)
+{
+	exttsp_chain_t *const keep = cand->a;
+	exttsp_chain_t *const dead = cand->b;
+	DB((dbg, LEVEL_1, "Merge chains %+F and %+F (gain %.3g)\n",
+	    keep->blocks[0]->block, dead->blocks[0]->block, cand->gain));
+
+	for (size_t i = 0, n = ARR_LEN(dead->blocks); i < n; ++i)
+		dead->blocks[i]->chain = keep;
+	if (cand->a_first) {
+		for (size_t i = 0, n = ARR_LEN(dead->blocks); i < n; ++i)
+			ARR_APP1(exttsp_block_t*, keep->blocks, dead->blocks[i]);
+		DEL_ARR_F(dead->blocks);
+	} else {
+		for (size_t i = 0, n = ARR_LEN(keep->blocks); i < n; ++i)
+			ARR_APP1(exttsp_block_t*, dead->blocks, keep->blocks[i]);
+		DEL_ARR_F(keep->blocks);
+		keep->blocks = dead->blocks;
+	}
+	dead->blocks = NULL;
+	keep->freq  += dead->freq;
+	keep->size  += dead->size;
+	place_chain(keep);
+	if (dead == env->entry)
+		env->entry = keep;
+
+	/* the candidates of the dead chain merge the kept chain now, unless the
+	 * kept chain already has a candidate for the same chain */
+	for (size_t i = 0, n = ARR_LEN(dead->cands); i < n; ++i) {
+		exttsp_candidate_t *const other = dead->cands[i];
+		if (other->a == other->b)
+			continue;
+		exttsp_chain_t *const other_chain = get_other_chain(other, dead);
+		if (other_chain == keep) {
+			remove_candidate(other, keep);
+			continue;
+		}
+		exttsp_candidate_t *const dup = find_candidate(keep, other_chain);
+		if (dup != NULL) {
+			for (size_t e = 0, n_edges = ARR_LEN(other->edges); e < n_edges; ++e)
+				ARR_APP1(exttsp_edge_t*, dup->edges, other->edges[e]);
+			remove_candidate(other, keep);
+			continue;
+		}
+		if (other->a == dead)
+			other->a = keep;
+		else
+			other->b = keep;
+		ARR_APP1(exttsp_candidate_t*, keep->cands, other);
+	}
+	DEL_ARR_F(dead->cands);
+	dead->cands = NULL;
+	dead->best  = NULL;
+
+	/* only the gains of the pairs involving the merged chain change */
+	for (size_t i = 0, n = ARR_LEN(keep->cands); i < n; ++i) {
+		exttsp_candidate_t *const other = keep->cands[i];
+		if (other->a != other->b)
+			evaluate_candidate(env, other);
+	}
+	update_best_candidate(keep);
+	for (size_t i = 0, n = ARR_LEN(keep->cands); i < n; ++i) {
+		exttsp_candidate_t *const other = keep->cands[i];
+		if (other->a != other->b)
+			update_best_candidate(get_other_chain(other, keep));
+	}
+}
+
+static void merge_all_chains(exttsp_env_t *const env,
+                             exttsp_chain_t *const *const chains,
+                             size_t const n_chains)
+{
+	for (;;) {
+		exttsp_candidate_t *best = NULL;
+		for (size_t i = 0; i < n_chains; ++i) {
+			exttsp_candidate_t *const cand = chains[i]->best;
+			if (cand != NULL && (best == NULL || cand->gain > best->gain))
+				best = cand;
+		}
+		if (best == NULL)
+			break;
+		merge_chains(env, best);
+	}
+}
+
+static double get_chain_density(exttsp_chain_t const *const chain)
+{
+	return chain->freq / chain->size;
+}
+
+static int cmp_chain_density(const void *const d1, const void *const d2)
+{
+	exttsp_chain_t const *const c1 = *(exttsp_chain_t const*const*)d1;
+	exttsp_chain_t const *const c2 = *(exttsp_chain_t const*const*)d2;
+	double const density1 = get_chain_density(c1);
+	double const density2 = get_chain_density(c2);
+	if (density1 != density2)
+		return density1 < density2 ? 1 : -1;
+	long const nr1 = get_irn_node_nr(c1->blocks[0]->block);
+	long const nr2 = get_irn_node_nr(c2->blocks[0]->block);
+	return (nr1 > nr2) - (nr1 < nr2);
+}
+
+/**
+ * Creates the block schedule with the ExtTSP algorithm. Returns NULL if the
+ * function is too large.
+ */
+static ir_node **create_exttsp_schedule(ir_graph *const irg)
+{
+	exttsp_env_t env;
+	obstack_init(&env.obst);
+	env.blocks = NEW_ARR_F(exttsp_block_t*, 0);
+	irg_block_walk_graph(irg, collect_exttsp_block, NULL, &env);
+
+	size_t    const n_blocks   = ARR_LEN(env.blocks);
+	ir_node **      block_list = NULL;
+	if (n_blocks > EXTTSP_MAX_BLOCKS)
+		goto end;
+
+	collect_exttsp_edges(&env);
+
+	/* start with a chain per block */
+	exttsp_chain_t **const chains = NEW_ARR_F(exttsp_chain_t*, n_blocks);
+	for (size_t i = 0; i < n_blocks; ++i) {
+		exttsp_block_t *const eblock = env.blocks[i];
+		exttsp_chain_t *const chain  = OALLOCZ(&env.obst, exttsp_chain_t);
+		chain->blocks = NEW_ARR_F(exttsp_block_t*, 1);
+		chain->blocks[0] = eblock;
+		chain->freq   = get_block_execfreq(eblock->block);
+		chain->size   = eblock->size;
+		chain->cands  = NEW_ARR_F(exttsp_candidate_t*, 0);
+		eblock->chain = chain;
+		chains[i]     = chain;
+	}
+	env.entry = get_exttsp_block(get_irg_start_block(irg))->chain;
+
+	for (size_t i = 0; i < n_blocks; ++i) {
+		exttsp_block_t *const eblock = env.blocks[i];
+		for (size_t s = 0, n = ARR_LEN(eblock->succs); s < n; ++s) {
+			exttsp_edge_t *const edge = eblock->succs[s];
+			if (edge->src != edge->dst)
+				add_candidate(&env, edge);
+		}
+	}
+	for (size_t i = 0; i < n_blocks; ++i) {
+		exttsp_chain_t *const chain = chains[i];
+		for (size_t c = 0, n = ARR_LEN(chain->cands); c < n; ++c) {
+			/* each candidate is in the lists of both chains */
+			exttsp_candidate_t *const cand = chain->cands[c];
+			if (cand->a == chain)
+				evaluate_candidate(&env, cand);
+		}
+	}
+	for (size_t i = 0; i < n_blocks; ++i)
+		update_best_candidate(chains[i]);
+
+	merge_all_chains(&env, chains, n_blocks);
+
+	/* entry chain first, then the other chains by decreasing density */
+	size_t n_chains = 0;
+	for (size_t i = 0; i < n_blocks; ++i) {
+		exttsp_chain_t *const chain = chains[i];
+		if (chain->blocks != NULL && chain != env.entry)
+			chains[n_chains++] = chain;
+	}
+	QSORT(chains, n_chains, cmp_chain_density);
+
+	struct obstack *const obst = be_get_be_obst(irg);
+	block_list = NEW_ARR_D(ir_node*, obst, n_blocks);
+	size_t i = 0;
+	for (size_t c = 0; c <= n_chains; ++c) {
+		exttsp_chain_t *const chain = c == 0 ? env.entry : chains[c - 1];
+		for (size_t b = 0, n = ARR_LEN(chain->blocks); b < n; ++b)
+			block_list[i++] = chain->blocks[b]->block;
+		for (size_t k = 0, n = ARR_LEN(chain->cands); k < n; ++k) {
+			/* each candidate is in the lists of both chains */
+			exttsp_candidate_t *const cand = chain->cands[k];
+			if (cand->a == chain && cand->b != chain)
+				DEL_ARR_F(cand->edges);
+		}
+		DEL_ARR_F(chain->blocks);
+		DEL_ARR_F(chain->cands);
+	}
+	assert(i == n_blocks);
+	DEL_ARR_F(chains);
+
+end:
+	for (size_t i = 0; i < n_blocks; ++i)
+		DEL_ARR_F(env.blocks[i]->succs);
+	DEL_ARR_F(env.blocks);
+	obstack_free(&env.obst, NULL);
+	return block_list;
+}
+
+/**
+ * Returns true if the profile says that @p block was never executed.
+ */
+static bool is_cold_block(ir_node const *const block)
+{
+	if (ir_profile_has_block_execcount(block))
+		return ir_profile_get_block_execcount(block) == 0;
+	/* the block was created after reading the profile */
+	if (get_Block_n_cfgpreds(block) != 1)
+		return false;
+	ir_node const *const pred = get_Block_cfgpred_block(block, 0);
+	return ir_profile_has_block_execcount(pred)
+	    && ir_profile_get_block_execcount(pred) == 0;
+}
+
+/**
+ * Moves blocks which were never executed to the end of the block schedule and
+ * marks the first of them as start of the cold part of the function.
+ */
+static void split_cold_blocks(ir_graph *const irg, ir_node **const block_list)
+{
+	ir_node *const start_block = get_irg_start_block(irg);
+	if (!split_cold || !ir_target.isa->far_branches
+	 || !ir_profile_has_block_execcount(start_block)
+	 || ir_profile_get_block_execcount(start_block) == 0
+	 || !be_gas_can_split_function(get_irg_entity(irg)))
+		return;
+
+	size_t    const n_blocks = ARR_LEN(block_list);
+	ir_node **const cold     = ALLOCAN(ir_node*, n_blocks);
+	size_t          n_hot    = 0;
+	size_t          n_cold   = 0;
+	for (size_t i = 0; i < n_blocks; ++i) {
+		ir_node *const block = block_list[i];
+		if (is_cold_block(block))
+			cold[n_cold++] = block;
+		else
+			block_list[n_hot++] = block;
+	}
+	if (n_cold == 0)
+		return;
+
+	MEMCPY(&block_list[n_hot], cold, n_cold);
+	be_birg_from_irg(irg)->first_cold_block = block_list[n_hot];
+	DB((dbg, LEVEL_1, "%+F: %zu cold blocks starting at %+F\n", irg, n_cold,
+	    block_list[n_hot]));
+}
+
 ir_node **be_create_block_schedule(ir_graph *irg)
 {
 	blocksched_env_t env = {
@@ -542,18 +1072,28 @@ ir_node **be_create_block_schedule(ir_graph *irg)
 	obstack_init(&env.obst);
 
 	assure_loopinfo(irg);
+	be_birg_from_irg(irg)->first_cold_block = NULL;
 
-	// collect edge execution frequencies
 	ir_reserve_resources(irg, IR_RESOURCE_IRN_LINK);
-	irg_block_walk_graph(irg, collect_egde_frequency, NULL, &env);
+	ir_node **block_list = NULL;
+	if (algo == BLOCKSCHED_EXTTSP) {
+		remove_empty_blocks(irg);
+		block_list = create_exttsp_schedule(irg);
+	}
+	if (block_list == NULL) {
+		// collect edge execution frequencies
+		irg_block_walk_graph(irg, collect_egde_frequency, NULL, &env);
 
-	remove_empty_blocks(irg);
+		remove_empty_blocks(irg);
 
-	coalesce_blocks(&env);
+		coalesce_blocks(&env);
 
-	ir_node **const block_list = create_blocksched_array(&env);
+		block_list = create_blocksched_array(&env);
+	}
 	ir_free_resources(irg, IR_RESOURCE_IRN_LINK);
 
+	split_cold_blocks(irg, block_list);
+
 	DEL_ARR_F(env.edges);
 	obstack_free(&env.obst, NULL);
 
@@ -563,5 +1103,9 @@ ir_node **be_create_block_schedule(ir_graph *irg)
 BE_REGISTER_MODULE_CONSTRUCTOR(be_init_blocksched)
 void be_init_blocksched(void)
 {
+	lc_opt_entry_t *be_grp         = lc_opt_get_grp(firm_opt_get_root(), "be");
+	lc_opt_entry_t *blocksched_grp = lc_opt_get_grp(be_grp, "blocksched");
+	lc_opt_add_table(blocksched_grp, blocksched_options);
+
 	FIRM_DBG_REGISTER(dbg, "firm.be.blocksched");
 }
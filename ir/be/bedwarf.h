@@ -11,6 +11,8 @@
 #ifndef FIRM_BE_BEDWARF_H
 #define FIRM_BE_BEDWARF_H
 
+#include <stdbool.h>
+
 #include "be_types.h"
 
 typedef struct parameter_dbg_info_t {
@@ -24,6 +26,9 @@ void be_dwarf_open(void);
 /** close a debug handler. */
 void be_dwarf_close(void);
 
+/** Returns true if any debug information is emitted. */
+bool be_dwarf_enabled(void);
+
 /** start a compilation unit */
 void be_dwarf_unit_begin(const char *filename);
 
@@ -15,6 +15,7 @@
 #include "bedwarf.h"
 #include "beemitter.h"
 #include "begnuas.h"
+#include "beirg.h"
 #include "benode.h"
 #include "dbginfo.h"
 #include "debug.h"
@@ -70,6 +71,11 @@ void be_emit_init_cf_links(ir_node **const block_schedule)
 	for (size_t i = 0, n = ARR_LEN(block_schedule); i < n; ++i) {
 		ir_node *const block = block_schedule[i];
 
+		/* the cold part is emitted into another section, so nothing may fall
+		 * through into it */
+		if (block == be_birg_from_irg(get_irn_irg(block))->first_cold_block)
+			prev = NULL;
+
 		/* Initialize cfop link */
 		for (unsigned n = get_Block_n_cfgpreds(block); n-- > 0; ) {
 			ir_node *pred = get_Block_cfgpred(block, n);
@@ -15,6 +15,7 @@
 #include "bearch.h"
 #include "beemithlp.h"
 #include "beemitter.h"
+#include "beirg.h"
 #include "bemodule.h"
 #include "betranshlp.h"
 #include "dbginfo.h"
@@ -36,6 +37,7 @@ bool                   be_gas_emit_types    = true;
 char                   be_gas_elf_type_char = '@';
 
 static be_gas_section_t current_section = (be_gas_section_t) -1;
+static bool             in_cold_part;
 static pmap            *block_numbers;
 static unsigned         next_block_nr;
 
@@ -124,6 +126,7 @@ typedef struct {
 
 static const elf_sectioninfo_t elf_sectioninfos[] = {
 	[GAS_SECTION_TEXT]           = { "text",              "progbits", "ax" },
+	[GAS_SECTION_TEXT_UNLIKELY]  = { "text.unlikely",     "progbits", "ax" },
 	[GAS_SECTION_DATA]           = { "data",              "progbits", "aw" },
 	[GAS_SECTION_RODATA]         = { "rodata",            "progbits", "a"  },
 	[GAS_SECTION_REL_RO_LOCAL]   = { "data.rel.ro.local", "progbits", "aw" },
@@ -644,10 +647,53 @@ void be_gas_emit_function_prolog(const ir_entity *entity, unsigned po2alignment,
 	be_dwarf_function_begin();
 }
 
+static void emit_cold_part_name(ir_entity const *const entity)
+{
+	be_gas_emit_entity(entity);
+	be_emit_cstring(".cold");
+}
+
+bool be_gas_can_split_function(ir_entity const *const entity)
+{
+	/* the cold part would need its own debug and callframe information */
+	return ir_platform.object_format == OBJECT_FORMAT_ELF
+	    && be_gas_elf_variant == ELF_VARIANT_NORMAL
+	    && !be_dwarf_enabled()
+	    && !(determine_section(NULL, entity) & GAS_SECTION_FLAG_COMDAT);
+}
+
+static void begin_cold_part(ir_entity const *const entity)
+{
+	assert(!in_cold_part);
+	in_cold_part = true;
+	emit_section(GAS_SECTION_TEXT_UNLIKELY, NULL);
+
+	be_emit_cstring("\t.type\t");
+	emit_cold_part_name(entity);
+	be_emit_irprintf(", %cfunction\n", be_gas_elf_type_char);
+	be_emit_write_line();
+	emit_cold_part_name(entity);
+	be_emit_cstring(":\n");
+	be_emit_write_line();
+}
+
 void be_gas_emit_function_epilog(ir_entity const *const entity)
 {
 	be_dwarf_function_end();
 
+	if (in_cold_part) {
+		be_emit_cstring("\t.size\t");
+		emit_cold_part_name(entity);
+		be_emit_cstring(", .-");
+		emit_cold_part_name(entity);
+		be_emit_char('\n');
+		be_emit_write_line();
+
+		/* the size of the function is measured in its own section */
+		emit_section(determine_section(NULL, entity), entity);
+		in_cold_part = false;
+	}
+
 	if (ir_platform.object_format == OBJECT_FORMAT_ELF) {
 		be_emit_cstring("\t.size\t");
 		be_gas_emit_entity(entity);
@@ -1353,6 +1399,10 @@ static bool block_needs_label(ir_node const *const block)
 
 void be_gas_begin_block(ir_node const *const block)
 {
+	ir_graph const *const irg = get_irn_irg(block);
+	if (block == be_birg_from_irg(irg)->first_cold_block)
+		begin_cold_part(get_irg_entity(irg));
+
 	if (block_needs_label(block)) {
 		be_gas_emit_block_name(block);
 		be_emit_char(':');
@@ -19,6 +19,7 @@
 
 typedef enum {
 	GAS_SECTION_TEXT,            /**< text section - program code */
+	GAS_SECTION_TEXT_UNLIKELY,   /**< rarely executed program code */
 	GAS_SECTION_DATA,            /**< data section - arbitrary data */
 	GAS_SECTION_RODATA,          /**< read only data no relocations */
 	GAS_SECTION_REL_RO,          /**< read only data containing relocations */
@@ -72,6 +73,12 @@ void be_gas_emit_function_prolog(const ir_entity *entity,
 
 void be_gas_emit_function_epilog(const ir_entity *entity);
 
+/**
+ * Returns true if rarely executed blocks of the function @p entity may be
+ * emitted into a separate cold section.
+ */
+bool be_gas_can_split_function(const ir_entity *entity);
+
 char const *be_gas_get_private_prefix(void);
 
 /**
@@ -90,6 +97,7 @@ void be_gas_emit_block_name(const ir_node *block);
  * Starts a basic block. Emits an assembler label "blockname:" if any control
  * flow predecessor does not fall through, otherwise a comment with the
  * blockname if verboseasm is enabled.
+ * Switches to the cold section at the first cold block of the function.
  */
 void be_gas_begin_block(ir_node const *block);
 
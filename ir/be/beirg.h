@@ -55,6 +55,9 @@ typedef struct be_irg_t {
 	/** Architecture specific per-graph data */
 	void             *isa_link;
 	bool              has_returns_twice_call;
+	/** first block of the block schedule which is emitted into the cold
+	 * section, NULL if the function is not split */
+	ir_node          *first_cold_block;
 } be_irg_t;
 
 static inline be_irg_t *be_birg_from_irg(const ir_graph *irg)
@@ -0,0 +1,120 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2017 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief       Machine models describing latency, throughput and execution
+ *              ports of instructions.
+ */
+#include "bemachine.h"
+
+#include "bearch.h"
+#include "bemodule.h"
+#include "benode.h"
+#include "irnode_t.h"
+#include "irtools.h"
+#include "lc_opts.h"
+#include "target_t.h"
+#include "util.h"
+
+#define PORT(n) (1u << (n))
+
+/** A simple single issue in-order pipeline with separate load/store unit. */
+static be_machine_t const machine_inorder = {
+	.name        = "inorder",
+	.issue_width = 1,
+	.n_ports     = 2,
+	.timing      = {
+		[BE_OP_SIMPLE] = {  1,  1, PORT(0) },
+		[BE_OP_COPY]   = {  1,  1, PORT(0) },
+		[BE_OP_MUL]    = {  3,  1, PORT(0) },
+		[BE_OP_DIV]    = { 20, 20, PORT(0) },
+		[BE_OP_LOAD]   = {  3,  1, PORT(1) },
+		[BE_OP_STORE]  = {  1,  1, PORT(1) },
+		[BE_OP_BRANCH] = {  1,  1, PORT(0) },
+		[BE_OP_FP_ADD] = {  4,  1, PORT(0) },
+		[BE_OP_FP_MUL] = {  5,  1, PORT(0) },
+		[BE_OP_FP_DIV] = { 20, 20, PORT(0) },
+	},
+};
+
+/**
+ * A modern out-of-order x86-64 core: 4 ALU ports (0, 1, 5, 6), 2 load ports
+ * (2, 3) and a store data port (4).
+ */
+static be_machine_t const machine_x86_64 = {
+	.name        = "x86-64",
+	.issue_width = 4,
+	.n_ports     = 7,
+	.timing      = {
+		[BE_OP_SIMPLE] = {  1, 1, PORT(0) | PORT(1) | PORT(5) | PORT(6) },
+		[BE_OP_COPY]   = {  1, 1, PORT(0) | PORT(1) | PORT(5) | PORT(6) },
+		[BE_OP_MUL]    = {  3, 1, PORT(1) },
+		[BE_OP_DIV]    = { 26, 6, PORT(0) },
+		[BE_OP_LOAD]   = {  5, 1, PORT(2) | PORT(3) },
+		[BE_OP_STORE]  = {  1, 1, PORT(4) },
+		[BE_OP_BRANCH] = {  1, 1, PORT(0) | PORT(6) },
+		[BE_OP_FP_ADD] = {  4, 1, PORT(0) | PORT(1) },
+		[BE_OP_FP_MUL] = {  4, 1, PORT(0) | PORT(1) },
+		[BE_OP_FP_DIV] = { 13, 4, PORT(0) },
+	},
+};
+
+static be_machine_t const *const all_machines[] = {
+	&machine_inorder,
+	&machine_x86_64,
+};
+
+static be_module_list_entry_t *machines;
+static be_machine_t const     *machine;
+
+be_machine_t const *be_get_machine(void)
+{
+	if (machine != NULL)
+		return machine;
+	char const *const name = ir_target.isa->machine;
+	if (name != NULL) {
+		for (size_t i = 0; i < ARRAY_SIZE(all_machines); ++i) {
+			if (streq(all_machines[i]->name, name))
+				return all_machines[i];
+		}
+	}
+	return &machine_inorder;
+}
+
+be_op_class_t be_get_generic_op_class(ir_node const *const node)
+{
+	if (is_cfop(node))
+		return BE_OP_BRANCH;
+	if (be_is_Copy(node) || be_is_CopyKeep(node) || be_is_Perm(node))
+		return BE_OP_COPY;
+	foreach_irn_in(node, i, pred) {
+		if (get_irn_mode(pred) == mode_M)
+			return get_irn_mode(node) == mode_M ? BE_OP_STORE : BE_OP_LOAD;
+	}
+	return BE_OP_SIMPLE;
+}
+
+be_op_class_t be_get_op_class(ir_node const *const node)
+{
+	be_op_class_t (*const get_op_class)(ir_node const*)
+		= ir_target.isa->get_op_class;
+	return get_op_class != NULL ? get_op_class(node)
+	                            : be_get_generic_op_class(node);
+}
+
+BE_REGISTER_MODULE_CONSTRUCTOR(be_init_machine)
+void be_init_machine(void)
+{
+	for (size_t i = 0; i < ARRAY_SIZE(all_machines); ++i) {
+		be_add_module_to_list(&machines, all_machines[i]->name,
+		                      (void*)all_machines[i]);
+	}
+
+	lc_opt_entry_t *be_grp = lc_opt_get_grp(firm_opt_get_root(), "be");
+	be_add_module_list_opt(be_grp, "machine",
+	                       "machine model for latency aware scheduling",
+	                       &machines, (void**)&machine);
+}
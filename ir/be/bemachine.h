@@ -0,0 +1,61 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2017 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief       Machine models describing latency, throughput and execution
+ *              ports of instructions.
+ */
+#ifndef FIRM_BE_BEMACHINE_H
+#define FIRM_BE_BEMACHINE_H
+
+#include "firm_types.h"
+
+/** Classes of instructions with similar timing. */
+typedef enum be_op_class_t {
+	BE_OP_SIMPLE,  /**< simple integer operation */
+	BE_OP_COPY,    /**< register copy */
+	BE_OP_MUL,     /**< integer multiplication */
+	BE_OP_DIV,     /**< integer division */
+	BE_OP_LOAD,    /**< memory read, possibly combined with an operation */
+	BE_OP_STORE,   /**< memory write */
+	BE_OP_BRANCH,  /**< control flow */
+	BE_OP_FP_ADD,  /**< floating point addition */
+	BE_OP_FP_MUL,  /**< floating point multiplication */
+	BE_OP_FP_DIV,  /**< floating point division */
+	BE_OP_CLASS_COUNT
+} be_op_class_t;
+
+/** Timing of an instruction class. */
+typedef struct be_op_timing_t {
+	unsigned char latency;    /**< cycles until the result is available */
+	unsigned char throughput; /**< cycles an execution port stays busy */
+	unsigned char ports;      /**< bitset of the possible execution ports */
+} be_op_timing_t;
+
+/** A machine model. */
+typedef struct be_machine_t {
+	char const     *name;
+	unsigned        issue_width; /**< instructions issued per cycle */
+	unsigned        n_ports;     /**< number of execution ports */
+	be_op_timing_t  timing[BE_OP_CLASS_COUNT];
+} be_machine_t;
+
+/**
+ * Returns the machine model selected with the be.machine option or the
+ * default model of the current target.
+ */
+be_machine_t const *be_get_machine(void);
+
+/**
+ * Classifies @p node by looking at its control flow and memory behaviour.
+ * Backends use this as fallback for nodes they do not classify themselves.
+ */
+be_op_class_t be_get_generic_op_class(ir_node const *node);
+
+/** Returns the instruction class of @p node for the current target. */
+be_op_class_t be_get_op_class(ir_node const *node);
+
+#endif
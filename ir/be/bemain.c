@@ -293,8 +293,9 @@ static ir_graph *be_prepare_profile(const char *const cup_name)
 		if (!res) {
 			be_warningf(NULL, "could not read profile data '%s'", prof_filename);
 		} else {
+			/* the profile is kept until be_finish() for the block
+			 * scheduler */
 			ir_create_execfreqs_from_profile();
-			ir_profile_free();
 			have_profile = true;
 		}
 	}
@@ -552,6 +553,7 @@ void be_step_last(ir_graph *irg)
 void be_finish(void)
 {
 	be_gas_end_compilation_unit(&env);
+	ir_profile_free();
 
 	if (be_options.timing) {
 		ir_timer_stop(bemain_timer);
@@ -42,12 +42,14 @@ void be_init_dwarf(void);
 void be_init_listsched(void);
 void be_init_live(void);
 void be_init_loopana(void);
+void be_init_machine(void);
 void be_init_pbqp(void);
 void be_init_pbqp_coloring(void);
 void be_init_peephole(void);
 void be_init_pref_alloc(void);
 void be_init_ra(void);
 void be_init_sched(void);
+void be_init_sched_latency(void);
 void be_init_sched_normal(void);
 void be_init_sched_rand(void);
 void be_init_sched_trivial(void);
@@ -79,6 +81,7 @@ void be_init_modules(void)
 	be_init_dwarf();
 	be_init_live();
 	be_init_loopana();
+	be_init_machine();
 	be_init_peephole();
 	be_init_ra();
 	be_init_sched();
@@ -98,6 +101,7 @@ void be_init_modules(void)
 
 	be_init_listsched();
 	be_init_sched_normal();
+	be_init_sched_latency();
 	be_init_sched_rand();
 	be_init_sched_trivial();
 
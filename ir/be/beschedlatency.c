@@ -0,0 +1,591 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2017 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief       Latency and execution port aware list scheduler.
+ *
+ * Critical path list scheduling driven by the machine model: the scheduler
+ * simulates issue cycles and port occupation and picks the ready node which
+ * can start earliest, preferring nodes on the longest latency path.  If the
+ * number of values live in a register class reaches the limit, nodes which
+ * reduce the register pressure are preferred.
+ *
+ * Ready nodes are kept in priority queues per set of execution ports, as
+ * all nodes of such a queue, whose operands are available, can start in the
+ * same cycle. Nodes reducing the register pressure are tracked separately,
+ * so selecting a node takes logarithmic time.
+ */
+#include "bearch.h"
+#include "belistsched.h"
+#include "bemachine.h"
+#include "bemodule.h"
+#include "besched.h"
+#include "debug.h"
+#include "iredges_t.h"
+#include "irgwalk.h"
+#include "irnode_t.h"
+#include "irtools.h"
+#include "lc_opts.h"
+#include "pqueue.h"
+#include "target_t.h"
+#include "util.h"
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg = NULL;)
+
+/** Percentage of the registers of a class the scheduler tries to keep live. */
+static int pressure_percent = 75;
+
+typedef struct node_info_t {
+	unsigned height;      /**< length of the latency path to the block end */
+	unsigned ready;       /**< cycle when all operands are available */
+	unsigned n_users;     /**< unscheduled uses in the block */
+	bool     live_out;    /**< value is used outside the block */
+	bool     visited;
+	bool     queued;      /**< node is in a port queue */
+} node_info_t;
+
+/** Ready nodes, which can be issued on the same execution ports. */
+typedef struct port_queue_t {
+	unsigned  ports;     /**< bitset of the execution ports */
+	pqueue_t *waiting;   /**< nodes waiting for operands, earliest first */
+	pqueue_t *available; /**< nodes with available operands, highest first */
+} port_queue_t;
+
+typedef struct sched_env_t {
+	be_machine_t const *machine;
+	node_info_t        *infos;     /**< indexed by node index */
+	unsigned           *live;      /**< live values per register class */
+	unsigned           *limit;     /**< pressure limit per register class */
+	unsigned           *port_free; /**< first free cycle of each port */
+	unsigned            cycle;     /**< current issue cycle */
+	unsigned            n_issued;  /**< nodes issued in the current cycle */
+	ir_nodeset_t       *ready_set; /**< ready nodes of the list scheduler */
+	port_queue_t       *queues;    /**< ready nodes per execution ports */
+	ir_nodeset_t        killers;   /**< ready last users of operands */
+} sched_env_t;
+
+static node_info_t *get_info(sched_env_t const *const env,
+                             ir_node const *const node)
+{
+	return &env->infos[get_irn_idx(node)];
+}
+
+static be_op_timing_t const *get_timing(sched_env_t const *const env,
+                                        ir_node const *const node)
+{
+	return &env->machine->timing[be_get_op_class(node)];
+}
+
+/** Returns the register class of value @p node or NULL. */
+static arch_register_class_t const *get_value_class(ir_node const *const node)
+{
+	ir_mode *const mode = get_irn_mode(node);
+	if (mode == mode_T || mode == mode_M || mode == mode_X)
+		return NULL;
+	arch_register_req_t const *const req = arch_get_irn_register_req(node);
+	if (req->ignore || req->cls == NULL || req->cls->manual_ra)
+		return NULL;
+	return req->cls;
+}
+
+static bool is_block_user(ir_node const *const user, ir_node const *const block)
+{
+	return !is_Block(user) && !is_Phi(user) && get_nodes_block(user) == block;
+}
+
+/**
+ * Computes the latency weighted height of @p node in its block.  Projs and
+ * nodes which are not scheduled only pass on the height of their users.
+ */
+static unsigned compute_height(sched_env_t *const env, ir_node *const node)
+{
+	node_info_t *const info = get_info(env, node);
+	if (info->visited)
+		return info->height;
+	info->visited = true;
+
+	ir_node *const block  = get_nodes_block(node);
+	unsigned       height = 0;
+	foreach_out_edge(node, edge) {
+		ir_node *const user = get_edge_src_irn(edge);
+		if (is_block_user(user, block))
+			height = MAX(height, compute_height(env, user));
+	}
+	if (!is_Proj(node) && !arch_is_irn_not_scheduled(node))
+		height += get_timing(env, node)->latency;
+	info->height = height;
+	return height;
+}
+
+/** Counts the uses of the value @p node inside its block. */
+static void init_value(sched_env_t *const env, ir_node *const node)
+{
+	node_info_t *const info  = get_info(env, node);
+	ir_node     *const block = get_nodes_block(node);
+	foreach_out_edge(node, edge) {
+		ir_node *const user = get_edge_src_irn(edge);
+		if (is_block_user(user, block))
+			++info->n_users;
+		else if (!is_Block(user))
+			info->live_out = true;
+	}
+}
+
+static void init_block(sched_env_t *const env, ir_node *const block)
+{
+	foreach_out_edge(block, edge) {
+		ir_node *const node = get_edge_src_irn(edge);
+		node_info_t *const info = get_info(env, node);
+		memset(info, 0, sizeof(*info));
+	}
+	foreach_out_edge(block, edge) {
+		ir_node *const node = get_edge_src_irn(edge);
+		compute_height(env, node);
+		init_value(env, node);
+	}
+
+	unsigned const n_classes = ir_target.isa->n_register_classes;
+	memset(env->live, 0, n_classes * sizeof(*env->live));
+	memset(env->port_free, 0, env->machine->n_ports * sizeof(*env->port_free));
+	env->cycle    = 0;
+	env->n_issued = 0;
+}
+
+/** Checks whether the value @p value of class @p cls becomes live. */
+static bool is_new_live(sched_env_t const *const env, ir_node const *const value,
+                        arch_register_class_t const *const cls)
+{
+	node_info_t const *const info = get_info(env, value);
+	return get_value_class(value) == cls
+	    && (info->n_users > 0 || info->live_out);
+}
+
+/** Checks whether @p node is the last unscheduled user of @p op. */
+static bool is_last_user(sched_env_t const *const env,
+                         ir_node const *const node, ir_node const *const op)
+{
+	node_info_t const *const info = get_info(env, op);
+	if (info->live_out)
+		return false;
+	unsigned n_uses = 0;
+	foreach_irn_in(node, i, other) {
+		if (other == op)
+			++n_uses;
+	}
+	return info->n_users == n_uses;
+}
+
+/** Checks whether scheduling @p node may end the lifetime of an operand. */
+static bool may_reduce_pressure(sched_env_t const *const env,
+                                ir_node const *const node)
+{
+	if (is_Phi(node))
+		return false;
+	foreach_irn_in(node, i, op) {
+		if (get_value_class(op) != NULL
+		 && get_nodes_block(op) == get_nodes_block(node)
+		 && is_last_user(env, node, op))
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Returns the change of the number of live values in class @p cls when
+ * scheduling @p node.
+ */
+static int get_pressure_delta(sched_env_t const *const env,
+                              ir_node const *const node,
+                              arch_register_class_t const *const cls)
+{
+	int delta = 0;
+	if (get_irn_mode(node) == mode_T) {
+		foreach_out_edge(node, edge) {
+			if (is_new_live(env, get_edge_src_irn(edge), cls))
+				++delta;
+		}
+	} else if (is_new_live(env, node, cls)) {
+		++delta;
+	}
+	foreach_irn_in(node, i, op) {
+		if (is_Phi(node) || get_value_class(op) != cls
+		 || get_nodes_block(op) != get_nodes_block(node))
+			continue;
+		/* count each operand once */
+		bool seen = false;
+		for (int j = 0; j < i; ++j) {
+			if (get_irn_n(node, j) == op)
+				seen = true;
+		}
+		if (!seen && is_last_user(env, node, op))
+			--delta;
+	}
+	return delta;
+}
+
+/**
+ * Returns the first cycle a node using the execution ports @p ports can be
+ * issued, if its operands are available in cycle @p ready.
+ */
+static unsigned get_port_start(sched_env_t const *const env,
+                               unsigned const ready, unsigned const ports,
+                               unsigned *const port)
+{
+	unsigned start = MAX(env->cycle, ready);
+	if (env->n_issued >= env->machine->issue_width)
+		start = MAX(start, env->cycle + 1);
+
+	unsigned best_port = 0;
+	unsigned best_free = ~0u;
+	for (unsigned p = 0; p < env->machine->n_ports; ++p) {
+		if ((ports & (1u << p)) && env->port_free[p] < best_free) {
+			best_port = p;
+			best_free = env->port_free[p];
+		}
+	}
+	if (best_free != ~0u)
+		start = MAX(start, best_free);
+	*port = best_port;
+	return start;
+}
+
+/** Returns the first cycle @p node can be issued. */
+static unsigned get_start(sched_env_t const *const env,
+                          ir_node const *const node, unsigned *const port)
+{
+	return get_port_start(env, get_info(env, node)->ready,
+	                      get_timing(env, node)->ports, port);
+}
+
+/** Returns a register class exceeding its pressure limit or NULL. */
+static arch_register_class_t const *get_pressured_class(sched_env_t const *env)
+{
+	for (unsigned c = 0, n = ir_target.isa->n_register_classes; c < n; ++c) {
+		if (env->limit[c] != 0 && env->live[c] >= env->limit[c])
+			return &ir_target.isa->register_classes[c];
+	}
+	return NULL;
+}
+
+/** Checks whether @p node is better than @p best with the given values. */
+static bool is_better(ir_node const *const node, int const delta,
+                      unsigned const start, unsigned const height,
+                      ir_node const *const best, int const best_delta,
+                      unsigned const best_start, unsigned const best_height)
+{
+	if (best == NULL)
+		return true;
+	if (delta != best_delta)
+		return delta < best_delta;
+	if (start != best_start)
+		return start < best_start;
+	if (height != best_height)
+		return height > best_height;
+	return get_irn_idx(node) < get_irn_idx(best);
+}
+
+static port_queue_t *get_port_queue(sched_env_t *const env,
+                                    unsigned const ports)
+{
+	for (size_t i = 0, n = ARR_LEN(env->queues); i < n; ++i) {
+		if (env->queues[i].ports == ports)
+			return &env->queues[i];
+	}
+	port_queue_t const queue = {
+		.ports     = ports,
+		.waiting   = new_pqueue(),
+		.available = new_pqueue(),
+	};
+	ARR_APP1(port_queue_t, env->queues, queue);
+	return &env->queues[ARR_LEN(env->queues) - 1];
+}
+
+static void queue_ready(sched_env_t *const env, ir_node *const node)
+{
+	node_info_t *const info = get_info(env, node);
+	if (info->queued)
+		return;
+	info->queued = true;
+	port_queue_t *const queue = get_port_queue(env, get_timing(env, node)->ports);
+	pqueue_put(queue->waiting, node, -(int)info->ready);
+	if (may_reduce_pressure(env, node))
+		ir_nodeset_insert(&env->killers, node);
+}
+
+/**
+ * Queues the users of @p node which became ready when scheduling it. Looks
+ * through nodes which are not scheduled or were scheduled immediately, as they
+ * make their users ready, too.
+ */
+static void queue_ready_users(sched_env_t *const env, ir_node *const node)
+{
+	ir_node *const block = get_nodes_block(node);
+	foreach_out_edge(node, edge) {
+		ir_node *const user = get_edge_src_irn(edge);
+		if (!is_block_user(user, block))
+			continue;
+		if (ir_nodeset_contains(env->ready_set, user)) {
+			queue_ready(env, user);
+		} else if (arch_is_irn_not_scheduled(user)
+		        || (arch_irn_is(user, schedule_first)
+		            && sched_is_scheduled(user))) {
+			queue_ready_users(env, user);
+		}
+	}
+}
+
+/**
+ * Pops nodes from @p queue until it finds one which is still ready. Nodes
+ * scheduled by a different queue are left in the queue until then.
+ */
+static ir_node *pop_ready(sched_env_t const *const env, pqueue_t *const queue)
+{
+	while (!pqueue_empty(queue)) {
+		ir_node *const node = (ir_node*)pqueue_pop_front(queue);
+		if (ir_nodeset_contains(env->ready_set, node))
+			return node;
+	}
+	return NULL;
+}
+
+/**
+ * Returns the highest node of @p queue, which can start earliest. The node
+ * stays in the queue.
+ */
+static ir_node *get_queue_best(sched_env_t const *const env,
+                               port_queue_t *const queue)
+{
+	ir_node *best = pop_ready(env, queue->available);
+	unsigned port;
+	unsigned limit = get_port_start(env, 0, queue->ports, &port);
+	for (ir_node *node; (node = pop_ready(env, queue->waiting)) != NULL;) {
+		unsigned const ready = get_info(env, node)->ready;
+		if (ready > limit) {
+			if (best != NULL) {
+				pqueue_put(queue->waiting, node, -(int)ready);
+				break;
+			}
+			/* nothing can start before the first operands are available */
+			limit = ready;
+		}
+		unsigned const height = get_info(env, node)->height;
+		if (best != NULL && get_info(env, best)->height >= height) {
+			pqueue_put(queue->available, node, (int)height);
+		} else {
+			if (best != NULL)
+				pqueue_put(queue->available, best, (int)get_info(env, best)->height);
+			best = node;
+		}
+	}
+	if (best != NULL)
+		pqueue_put(queue->available, best, (int)get_info(env, best)->height);
+	return best;
+}
+
+/** Selects the node which reduces the pressure of class @p cls most. */
+static ir_node *select_killer(sched_env_t const *const env,
+                              arch_register_class_t const *const cls)
+{
+	ir_node *best        = NULL;
+	int      best_delta  = 0;
+	unsigned best_start  = 0;
+	unsigned best_height = 0;
+	foreach_ir_nodeset(&env->killers, node, iter) {
+		int const delta = get_pressure_delta(env, node, cls);
+		if (delta >= 0)
+			continue;
+		unsigned       port;
+		unsigned const start  = get_start(env, node, &port);
+		unsigned const height = get_info(env, node)->height;
+		if (is_better(node, delta, start, height,
+		              best, best_delta, best_start, best_height)) {
+			best        = node;
+			best_delta  = delta;
+			best_start  = start;
+			best_height = height;
+		}
+	}
+	return best;
+}
+
+static ir_node *latency_select(sched_env_t *const env)
+{
+	arch_register_class_t const *const cls = get_pressured_class(env);
+	if (cls != NULL) {
+		ir_node *const killer = select_killer(env, cls);
+		if (killer != NULL)
+			return killer;
+	}
+
+	ir_node *best        = NULL;
+	unsigned best_start  = 0;
+	unsigned best_height = 0;
+	for (size_t i = 0, n = ARR_LEN(env->queues); i < n; ++i) {
+		ir_node *const node = get_queue_best(env, &env->queues[i]);
+		if (node == NULL)
+			continue;
+		unsigned       port;
+		unsigned const start  = get_start(env, node, &port);
+		unsigned const height = get_info(env, node)->height;
+		if (is_better(node, 0, start, height,
+		              best, 0, best_start, best_height)) {
+			best        = node;
+			best_start  = start;
+			best_height = height;
+		}
+	}
+	/* the control flow node becomes ready after all other nodes */
+	return best != NULL ? best : ir_nodeset_first(env->ready_set);
+}
+
+/** Marks value @p value as live and available in cycle @p available. */
+static void define_value(sched_env_t *const env, ir_node *const value,
+                         unsigned const available)
+{
+	node_info_t                 *const info = get_info(env, value);
+	arch_register_class_t const *const cls  = get_value_class(value);
+	if (cls != NULL && (info->n_users > 0 || info->live_out))
+		++env->live[cls->index];
+
+	ir_node *const block = get_nodes_block(value);
+	foreach_out_edge(value, edge) {
+		ir_node *const user = get_edge_src_irn(edge);
+		if (is_block_user(user, block)) {
+			node_info_t *const user_info = get_info(env, user);
+			user_info->ready = MAX(user_info->ready, available);
+		}
+	}
+}
+
+/** Updates the simulated machine state after scheduling @p node. */
+static void issue(sched_env_t *const env, ir_node *const node)
+{
+	unsigned              port;
+	unsigned const        start  = get_start(env, node, &port);
+	be_op_timing_t const *timing = get_timing(env, node);
+	if (start != env->cycle) {
+		env->cycle    = start;
+		env->n_issued = 0;
+	}
+	++env->n_issued;
+	if (timing->ports != 0)
+		env->port_free[port] = start + timing->throughput;
+	DB((dbg, LEVEL_2, "\tcycle %u: %+F (port %u)\n", start, node, port));
+
+	/* operands die, the operands of Phis are used at the end of the
+	 * predecessor blocks */
+	ir_node *const block = get_nodes_block(node);
+	foreach_irn_in(node, i, op) {
+		if (is_Phi(node) || get_nodes_block(op) != block)
+			continue;
+		node_info_t *const info = get_info(env, op);
+		assert(info->n_users > 0);
+		--info->n_users;
+		arch_register_class_t const *const cls = get_value_class(op);
+		if (info->live_out || cls == NULL)
+			continue;
+		if (info->n_users == 0) {
+			--env->live[cls->index];
+		} else if (info->n_users == 1) {
+			/* the remaining user ends the lifetime of op */
+			foreach_out_edge(op, edge) {
+				ir_node *const user = get_edge_src_irn(edge);
+				if (user != node
+				 && ir_nodeset_contains(env->ready_set, user))
+					ir_nodeset_insert(&env->killers, user);
+			}
+		}
+	}
+
+	/* results become live and available after the latency */
+	unsigned const available = start + timing->latency;
+	if (get_irn_mode(node) == mode_T) {
+		foreach_out_edge(node, edge) {
+			define_value(env, get_edge_src_irn(edge), available);
+		}
+	} else {
+		define_value(env, node, available);
+	}
+}
+
+static void sched_block(ir_node *block, void *data)
+{
+	sched_env_t *const env = (sched_env_t*)data;
+	init_block(env, block);
+
+	env->ready_set = be_list_sched_begin_block(block);
+	foreach_ir_nodeset(env->ready_set, node, iter) {
+		queue_ready(env, node);
+	}
+	while (ir_nodeset_size(env->ready_set) > 0) {
+		ir_node *const node = latency_select(env);
+		issue(env, node);
+		ir_nodeset_remove(&env->killers, node);
+		be_list_sched_schedule(node);
+		queue_ready_users(env, node);
+	}
+	be_list_sched_end_block();
+
+	/* drop the nodes scheduled from other queues */
+	for (size_t i = 0, n = ARR_LEN(env->queues); i < n; ++i) {
+		port_queue_t *const queue = &env->queues[i];
+		while (!pqueue_empty(queue->waiting))
+			pqueue_pop_front(queue->waiting);
+		while (!pqueue_empty(queue->available))
+			pqueue_pop_front(queue->available);
+	}
+	assert(ir_nodeset_size(&env->killers) == 0);
+}
+
+static void sched_latency(ir_graph *irg)
+{
+	unsigned const n_classes = ir_target.isa->n_register_classes;
+	sched_env_t    env;
+	env.machine   = be_get_machine();
+	env.live      = XMALLOCN(unsigned, n_classes);
+	env.limit     = XMALLOCN(unsigned, n_classes);
+	env.port_free = XMALLOCN(unsigned, env.machine->n_ports);
+	for (unsigned c = 0; c < n_classes; ++c) {
+		arch_register_class_t const *const cls = &ir_target.isa->register_classes[c];
+		env.limit[c] = cls->manual_ra ? 0 : MAX(cls->n_regs * (unsigned)pressure_percent / 100, 1u);
+	}
+
+	be_list_sched_begin(irg);
+	env.infos  = XMALLOCNZ(node_info_t, get_irg_last_idx(irg));
+	env.queues = NEW_ARR_F(port_queue_t, 0);
+	ir_nodeset_init(&env.killers);
+	DB((dbg, LEVEL_1, "scheduling %+F for machine %s\n", irg,
+	    env.machine->name));
+	irg_block_walk_graph(irg, sched_block, NULL, &env);
+	be_list_sched_finish();
+
+	ir_nodeset_destroy(&env.killers);
+	for (size_t i = 0, n = ARR_LEN(env.queues); i < n; ++i) {
+		del_pqueue(env.queues[i].waiting);
+		del_pqueue(env.queues[i].available);
+	}
+	DEL_ARR_F(env.queues);
+	free(env.infos);
+	free(env.port_free);
+	free(env.limit);
+	free(env.live);
+}
+
+static const lc_opt_table_entry_t latency_options[] = {
+	LC_OPT_ENT_INT("pressure", "percentage of registers the latency scheduler may keep live", &pressure_percent),
+	LC_OPT_LAST
+};
+
+BE_REGISTER_MODULE_CONSTRUCTOR(be_init_sched_latency)
+void be_init_sched_latency(void)
+{
+	lc_opt_entry_t *be_grp    = lc_opt_get_grp(firm_opt_get_root(), "be");
+	lc_opt_entry_t *sched_grp = lc_opt_get_grp(be_grp, "latencysched");
+	lc_opt_add_table(sched_grp, latency_options);
+
+	be_register_scheduler("latency", sched_latency);
+	FIRM_DBG_REGISTER(dbg, "firm.be.sched.latency");
+}
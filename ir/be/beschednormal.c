@@ -16,16 +16,29 @@
 #include "besched.h"
 #include "debug.h"
 #include "heights.h"
+#include "iredges_t.h"
 #include "irgwalk.h"
 #include "irprintf.h"
 #include "irtools.h"
+#include "lc_opts.h"
+#include "panic.h"
+#include "pqueue.h"
 #include "util.h"
 #include <stdlib.h>
 
 DEBUG_ONLY(static firm_dbg_module_t *dbg = NULL;)
 
 static struct obstack obst;
-static ir_node       *curr_list;
+/** Position of each node in the precomputed order of its block plus one, 0 if
+ * the node is not in the order or already queued. Indexed by node index. */
+static unsigned      *order;
+/** Ready nodes of the current block sorted by their position in the order. */
+static pqueue_t      *ready_queue;
+/** Compare each selection with a linear scan of the order, which is slow. */
+static bool           check_selection;
+/** Not yet selected nodes of the order of the current block, used for
+ * check_selection. */
+static ir_node      **remaining;
 
 typedef struct irn_cost_pair {
 	ir_node *irn;
@@ -47,17 +60,61 @@ static void set_irn_flag_and_cost(ir_node *node, flag_and_cost *fc)
 	set_irn_link(node, fc);
 }
 
+static void queue_ready(ir_node *const node)
+{
+	unsigned *const pos = &order[get_irn_idx(node)];
+	if (*pos != 0) {
+		pqueue_put(ready_queue, node, -(int)*pos);
+		*pos = 0;
+	}
+}
+
+/**
+ * Queues the users of @p node which became ready when scheduling it. Looks
+ * through nodes which are not scheduled or were scheduled immediately, as they
+ * make their users ready, too.
+ */
+static void queue_ready_users(ir_nodeset_t *const ready_set,
+                              ir_node *const node)
+{
+	ir_node *const block = get_nodes_block(node);
+	foreach_out_edge(node, edge) {
+		ir_node *const user = get_edge_src_irn(edge);
+		if (is_Block(user) || is_Phi(user) || get_nodes_block(user) != block)
+			continue;
+		if (ir_nodeset_contains(ready_set, user)) {
+			queue_ready(user);
+		} else if (arch_is_irn_not_scheduled(user)
+		        || (arch_irn_is(user, schedule_first)
+		            && sched_is_scheduled(user))) {
+			queue_ready_users(ready_set, user);
+		}
+	}
+}
+
 static ir_node *normal_select(ir_nodeset_t *ready_set)
 {
-	for (ir_node *irn = curr_list, *last = NULL, *next; irn != NULL;
-	     last = irn, irn = next) {
-		next = (ir_node*)get_irn_link(irn);
+	while (!pqueue_empty(ready_queue)) {
+		ir_node *const irn = (ir_node*)pqueue_pop_front(ready_queue);
 		if (ir_nodeset_contains(ready_set, irn)) {
 			DB((dbg, LEVEL_1, "Scheduling %+F\n", irn));
-			if (last == NULL)
-				curr_list = next;
-			else
-				set_irn_link(last, next);
+			return irn;
+		}
+	}
+
+	return ir_nodeset_first(ready_set);
+}
+
+/**
+ * Selects the first ready node of the precomputed order by scanning it.  This
+ * is the original selection, which is quadratic in the size of the block.
+ */
+static ir_node *linear_select(ir_nodeset_t *const ready_set)
+{
+	for (size_t i = 0, n = ARR_LEN(remaining); i < n; ++i) {
+		ir_node *const irn = remaining[i];
+		if (irn != NULL && ir_nodeset_contains(ready_set, irn)) {
+			remaining[i] = NULL;
 			return irn;
 		}
 	}
@@ -282,27 +339,33 @@ static void real_sched_block(ir_node *block, void *data)
 {
 	(void)data;
 	ir_node **sched = (ir_node**)get_irn_link(block);
-	ir_node  *first = NULL;
-
-	/* turn into a list, so we can easily remove nodes. The link field is used
-	 * anyway. */
-	for (int i = ARR_LEN(sched); i-- > 0; ) {
-		ir_node *irn = sched[i];
-		set_irn_link(irn, first);
-		first = irn;
-	}
+
+	for (size_t i = 0, n = ARR_LEN(sched); i < n; ++i)
+		order[get_irn_idx(sched[i])] = i + 1;
 	/* note: we can free sched here, there should be no attempt to schedule
-	 * a block twice */
-	DEL_ARR_F(sched);
-	set_irn_link(block, sched);
-	curr_list = first;
+	 * a block twice; the check still needs it as list of remaining nodes */
+	if (check_selection)
+		remaining = sched;
+	else
+		DEL_ARR_F(sched);
+	set_irn_link(block, NULL);
 
 	ir_nodeset_t *cands = be_list_sched_begin_block(block);
+	foreach_ir_nodeset(cands, irn, iter) {
+		queue_ready(irn);
+	}
 	while (ir_nodeset_size(cands) > 0) {
 		ir_node *node = normal_select(cands);
+		if (check_selection && linear_select(cands) != node)
+			panic("%+F selected out of order in %+F", node, block);
 		be_list_sched_schedule(node);
+		queue_ready_users(cands, node);
 	}
 	be_list_sched_end_block();
+	assert(pqueue_empty(ready_queue));
+
+	if (check_selection)
+		DEL_ARR_F(remaining);
 }
 
 static void sched_normal(ir_graph *irg)
@@ -323,16 +386,29 @@ static void sched_normal(ir_graph *irg)
 	heights_free(heights);
 
 	be_list_sched_begin(irg);
+	order       = XMALLOCNZ(unsigned, get_irg_last_idx(irg));
+	ready_queue = new_pqueue();
 	irg_block_walk_graph(irg, real_sched_block, NULL, NULL);
+	del_pqueue(ready_queue);
+	free(order);
 	be_list_sched_finish();
 
 	ir_free_resources(irg, IR_RESOURCE_IRN_LINK);
 	obstack_free(&obst, NULL);
 }
 
+static const lc_opt_table_entry_t normal_options[] = {
+	LC_OPT_ENT_BOOL("check", "compare the selection with a linear scan of the order", &check_selection),
+	LC_OPT_LAST
+};
+
 BE_REGISTER_MODULE_CONSTRUCTOR(be_init_sched_normal)
 void be_init_sched_normal(void)
 {
+	lc_opt_entry_t *be_grp    = lc_opt_get_grp(firm_opt_get_root(), "be");
+	lc_opt_entry_t *sched_grp = lc_opt_get_grp(be_grp, "normalsched");
+	lc_opt_add_table(sched_grp, normal_options);
+
 	be_register_scheduler("normal", sched_normal);
 	FIRM_DBG_REGISTER(dbg, "firm.be.sched.normal");
 }
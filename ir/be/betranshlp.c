@@ -325,6 +325,9 @@ void be_transform_graph(ir_graph *irg, arch_pretrans_nodes *func)
 	irg->last_node_idx = 0;
 
 	free_vrp_data(irg);
+	clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_POINTS_TO
+	                        | IR_GRAPH_PROPERTY_CONSISTENT_ALIAS_CACHE
+	                        | IR_GRAPH_PROPERTY_CONSISTENT_SCEV);
 
 	/* create new value table for CSE */
 	new_identities(irg);
@@ -260,6 +260,32 @@ static unsigned ia32_get_op_estimated_cost(ir_node const *const irn)
 	return cost;
 }
 
+static be_op_class_t ia32_get_op_class(ir_node const *const irn)
+{
+	if (!is_ia32_irn(irn))
+		return be_get_generic_op_class(irn);
+
+	if (is_ia32_IMul(irn) || is_ia32_IMulImm(irn) || is_ia32_IMul1OP(irn)
+	 || is_ia32_Mul(irn))
+		return BE_OP_MUL;
+	if (is_ia32_Div(irn) || is_ia32_IDiv(irn))
+		return BE_OP_DIV;
+	if (is_ia32_Adds(irn) || is_ia32_Subs(irn) || is_ia32_fadd(irn)
+	 || is_ia32_fsub(irn))
+		return BE_OP_FP_ADD;
+	if (is_ia32_Muls(irn) || is_ia32_fmul(irn))
+		return BE_OP_FP_MUL;
+	if (is_ia32_Divs(irn) || is_ia32_fdiv(irn))
+		return BE_OP_FP_DIV;
+
+	switch (get_ia32_op_type(irn)) {
+	case ia32_AddrModeS: return BE_OP_LOAD;
+	case ia32_AddrModeD: return BE_OP_STORE;
+	case ia32_Normal:    break;
+	}
+	return be_get_generic_op_class(irn);
+}
+
 /**
  * Check if irn can load its operand at position i from memory (source addressmode).
  * @param irn    The irn to be checked
@@ -953,10 +979,18 @@ static int determine_ebp_input(ir_node *ret)
 	panic("no ebp input found at %+F", ret);
 }
 
+/**
+ * Restores the stack pointer and frame pointer before @p ret, which is a Ret
+ * or a TailCall.
+ */
 static void introduce_epilogue(ir_node *const ret, bool const omit_fp)
 {
+	int const n_mem   = is_ia32_Ret(ret) ? n_ia32_Ret_mem : n_ia32_TailCall_mem;
+	int const n_stack
+		= is_ia32_Ret(ret) ? n_ia32_Ret_stack : n_ia32_TailCall_stack;
+
 	ir_node        *curr_sp;
-	ir_node  *const first_sp = get_irn_n(ret, n_ia32_Ret_stack);
+	ir_node  *const first_sp = get_irn_n(ret, n_stack);
 	ir_node  *const block    = get_nodes_block(ret);
 	ir_graph *const irg      = get_irn_irg(ret);
 	if (!omit_fp) {
@@ -966,7 +1000,7 @@ static void introduce_epilogue(ir_node *const ret, bool const omit_fp)
 		ir_node  *restore;
 		int const n_ebp    = determine_ebp_input(ret);
 		ir_node  *curr_bp  = get_irn_n(ret, n_ebp);
-		ir_node  *curr_mem = get_irn_n(ret, n_ia32_Ret_mem);
+		ir_node  *curr_mem = get_irn_n(ret, n_mem);
 		if (ia32_cg_config.use_leave) {
 			restore  = new_bd_ia32_Leave(NULL, block, curr_mem, curr_bp);
 			curr_bp  = be_new_Proj_reg(restore, pn_ia32_Leave_frame, bp);
@@ -986,15 +1020,15 @@ static void introduce_epilogue(ir_node *const ret, bool const omit_fp)
 			curr_mem = be_new_Proj(restore, pn_ia32_Pop_M);
 		}
 		sched_add_before(ret, restore);
-		set_irn_n(ret, n_ia32_Ret_mem, curr_mem);
-		set_irn_n(ret, n_ebp,          curr_bp);
+		set_irn_n(ret, n_mem, curr_mem);
+		set_irn_n(ret, n_ebp, curr_bp);
 	} else {
 		ir_type *const frame_type = get_irg_frame_type(irg);
 		unsigned const frame_size = get_type_size(frame_type);
 		curr_sp = ia32_new_IncSP(block, first_sp, -(int)frame_size, true);
 		sched_add_before(ret, curr_sp);
 	}
-	set_irn_n(ret, n_ia32_Ret_stack, curr_sp);
+	set_irn_n(ret, n_stack, curr_sp);
 
 	/* Keep verifier happy. */
 	if (get_irn_n_edges(first_sp) == 0 && is_Proj(first_sp))
@@ -1049,7 +1083,7 @@ static void introduce_prologue_epilogue(ir_graph *const irg, bool omit_fp)
 {
 	/* introduce epilogue for every return node */
 	foreach_irn_in(get_irg_end_block(irg), i, ret) {
-		assert(is_ia32_Ret(ret));
+		assert(is_ia32_Ret(ret) || is_ia32_TailCall(ret));
 		introduce_epilogue(ret, omit_fp);
 	}
 
@@ -1668,6 +1702,7 @@ arch_isa_if_t const ia32_isa_if = {
 	.big_endian            = false,
 	.po2_biggest_alignment = 4,
 	.pic_supported         = true,
+	.far_branches          = true,
 	.n_registers           = N_IA32_REGISTERS,
 	.registers             = ia32_registers,
 	.n_register_classes    = N_IA32_CLASSES,
@@ -1680,6 +1715,8 @@ arch_isa_if_t const ia32_isa_if = {
 	.lower_for_target      = ia32_lower_for_target,
 	.additional_reg_names  = ia32_additional_reg_names,
 	.get_op_estimated_cost = ia32_get_op_estimated_cost,
+	.machine               = "x86-64",
+	.get_op_class          = ia32_get_op_class,
 };
 
 BE_REGISTER_MODULE_CONSTRUCTOR(be_init_arch_ia32)
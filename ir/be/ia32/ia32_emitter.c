@@ -1424,6 +1424,16 @@ static unsigned emit_jit_entity_relocation_asm(char *const buffer,
 		return 4;
 	}
 
+	if (be_kind == IA32_RELOCATION_TAILJUMP) {
+		/* The assembler might shorten a jmp instruction, so the opcode and a
+		 * PC relative displacement are emitted explicitly. */
+		be_emit_cstring("\t.byte 0xE9\n\t.long ");
+		x86_emit_relocation_no_offset(X86_IMM_PCREL, entity);
+		be_emit_irprintf("%+"PRId32"-.\n", offset - 4);
+		be_emit_write_line();
+		return 5;
+	}
+
 	unsigned res = 4;
 	if (be_kind == X86_IMM_PCREL) {
 		/* cheat... */
@@ -1016,6 +1016,32 @@ static void enc_return(const ir_node *node)
 	}
 }
 
+static void enc_tailcall(ir_node const *const node)
+{
+	ir_node *const callee = get_irn_n(node, n_ia32_TailCall_callee);
+	if (is_ia32_Immediate(callee)) {
+		x86_imm32_t const *const imm
+			= &get_ia32_immediate_attr_const(callee)->imm;
+		assert(imm->kind == X86_IMM_PCREL);
+
+		if (ia32_cg_config.emit_machcode) {
+			/* Cheat like enc_call(), see emit_jit_entity_relocation_asm(). */
+			be_emit_reloc_entity(5, IA32_RELOCATION_TAILJUMP, imm->entity,
+			                     imm->offset);
+		} else {
+			be_emit8(0xE9);
+			x86_imm32_t const jmp_imm = {
+				.kind   = X86_IMM_PCREL,
+				.entity = imm->entity,
+				.offset = imm->offset - 4,
+			};
+			enc_relocation(&jmp_imm);
+		}
+	} else {
+		ia32_enc_unop(node, 0xFF, 4, n_ia32_TailCall_callee);
+	}
+}
+
 static void enc_subsp(const ir_node *node)
 {
 	/* sub %in, %esp */
@@ -1314,6 +1340,7 @@ static void ia32_register_binary_emitters(void)
 	be_set_emitter(op_ia32_Store,         enc_store);
 	be_set_emitter(op_ia32_SubSP,         enc_subsp);
 	be_set_emitter(op_ia32_SwitchJmp,     enc_switchjmp);
+	be_set_emitter(op_ia32_TailCall,      enc_tailcall);
 	be_set_emitter(op_ia32_Test,          enc_test);
 	be_set_emitter(op_ia32_Xor0,          enc_xor0);
 	be_set_emitter(op_ia32_fild,          enc_fild);
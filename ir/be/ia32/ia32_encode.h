@@ -17,6 +17,7 @@
 
 enum {
 	IA32_RELOCATION_RELJUMP = 128,
+	IA32_RELOCATION_TAILJUMP,
 };
 
 ir_jit_function_t *ia32_emit_jit(ir_jit_segment_t *segment, ir_graph *irg);
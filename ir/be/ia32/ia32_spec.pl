@@ -1269,6 +1269,17 @@ Ret => {
 	fixed     => "x86_insn_size_t const size = X86_SIZE_32;",
 },
 
+TailCall => {
+	state     => "pinned",
+	op_flags  => [ "cfopcode" ],
+	in_reqs   => "...",
+	out_reqs  => [ "exec" ],
+	ins       => [ "base", "index", "mem", "callee", "stack", "first_argument" ],
+	fixed     => "x86_insn_size_t const size = X86_SIZE_32;",
+	emit      => "jmp %*S3",
+	latency   => 1,
+},
+
 Call => {
 	op_flags  => [ "uses_memory" ],
 	irn_flags => [ "modify_flags" ],
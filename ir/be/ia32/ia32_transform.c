@@ -4073,8 +4073,14 @@ static ir_node *gen_Proj_Proj_Start(ir_node *node)
 	return be_get_Start_proj(irg, param->reg);
 }
 
+static ir_node *gen_tail_call(ir_node *ret, ir_node *call);
+
 static ir_node *gen_Return(ir_node *node)
 {
+	ir_node *const call = x86_get_tail_call(node);
+	if (call != NULL)
+		return gen_tail_call(node, call);
+
 	ir_graph *irg       = get_irn_irg(node);
 	ir_node  *new_block = be_transform_nodes_block(node);
 	dbg_info *dbgi      = get_irn_dbg_info(node);
@@ -4684,6 +4690,132 @@ static bool callee_is_plt(ir_node *callee)
 	    && be_get_Relocation_kind(callee) == X86_IMM_PLT;
 }
 
+/**
+ * Transforms the Return @p ret of the results of the tail call @p call into
+ * a jump to the callee, which returns to our caller.
+ */
+static ir_node *gen_tail_call(ir_node *const ret, ir_node *const call)
+{
+	ir_graph          *const irg       = get_irn_irg(ret);
+	ir_node           *const new_block = be_transform_nodes_block(ret);
+	dbg_info          *const dbgi      = get_irn_dbg_info(call);
+	ir_node           *const callee    = get_Call_ptr(call);
+	ir_node           *const mem       = be_transform_node(get_Call_mem(call));
+	ir_type           *const type      = get_Call_type(call);
+	unsigned           const n_params  = get_Call_n_params(call);
+	x86_cconv_t       *const cconv     = ia32_decide_calling_convention(type, NULL);
+	x86_cconv_t const *const own_cconv = current_cconv;
+
+	unsigned const n_callee_saves
+		= rbitset_popcount(own_cconv->callee_saves, N_IA32_REGISTERS);
+	unsigned const n_ins
+		= n_ia32_TailCall_first_argument + cconv->n_param_regs + n_callee_saves;
+	arch_register_req_t const **const in_req   = be_allocate_in_reqs(irg, n_ins);
+	ir_node                   **const in       = ALLOCAN(ir_node*, n_ins);
+	ir_node                   **const sync_ins = ALLOCAN(ir_node*, n_params + 1);
+	unsigned                          sync_arity = 0;
+	unsigned                          in_arity   = n_ia32_TailCall_first_argument;
+
+	/* Address mode is not possible for the callee, as the frame is already
+	 * gone when jumping. */
+	ir_node *new_callee = try_create_Immediate(callee, 'i');
+	if (new_callee == NULL)
+		new_callee = be_transform_node(callee);
+	adjust_pc_relative_relocation(new_callee);
+
+	in[n_ia32_TailCall_base]       = noreg_GP;
+	in_req[n_ia32_TailCall_base]   = &ia32_class_reg_req_gp;
+	in[n_ia32_TailCall_index]      = noreg_GP;
+	in_req[n_ia32_TailCall_index]  = &ia32_class_reg_req_gp;
+	in[n_ia32_TailCall_callee]     = new_callee;
+	in_req[n_ia32_TailCall_callee] = &ia32_class_reg_req_gp;
+	in[n_ia32_TailCall_stack]      = get_initial_sp(irg);
+	in_req[n_ia32_TailCall_stack]  = ia32_registers[REG_ESP].single_req;
+
+	/* Stack arguments replace our own stack parameters. */
+	ir_node *const frame = own_cconv->omit_fp ? get_initial_sp(irg)
+	                                          : get_initial_fp(irg);
+	for (unsigned p = 0; p < n_params; ++p) {
+		ir_node                  *const value = get_Call_param(call, p);
+		reg_or_stackslot_t const *const param = &cconv->parameters[p];
+		if (param->reg) {
+			unsigned const parami = in_arity++;
+			in[parami]     = be_transform_node(value);
+			in_req[parami] = param->reg->single_req;
+		} else {
+			x86_address_t const store_addr = {
+				.variant = X86_ADDR_BASE,
+				.base    = frame,
+				.index   = noreg_GP,
+				.mem     = mem,
+				.imm     = {
+					.kind   = X86_IMM_FRAMEOFFSET,
+					.offset = IA32_REGISTER_SIZE + param->offset,
+				},
+			};
+			ir_node *const store = create_store(dbgi, new_block, value, &store_addr);
+			set_irn_pinned(store, true);
+			sync_ins[sync_arity++] = create_proj_for_store(store, pn_Store_M);
+		}
+	}
+	if (sync_arity == 0)
+		sync_ins[sync_arity++] = mem;
+	in[n_ia32_TailCall_mem]     = be_make_Sync(new_block, sync_arity, sync_ins);
+	in_req[n_ia32_TailCall_mem] = arch_memory_req;
+
+	/* Callee saves. */
+	for (unsigned i = 0; i < N_IA32_REGISTERS; ++i) {
+		if (!rbitset_is_set(own_cconv->callee_saves, i))
+			continue;
+		arch_register_t const *const reg = &ia32_registers[i];
+		unsigned               const regi = in_arity++;
+		in[regi]     = be_get_Start_proj(irg, reg);
+		in_req[regi] = reg->single_req;
+	}
+	assert(in_arity <= n_ins);
+
+	ir_node *const jmp = new_bd_ia32_TailCall(dbgi, new_block, in_arity, in, in_req);
+	be_stack_record_chain(&stack_env, jmp, n_ia32_TailCall_stack, NULL);
+	x86_free_calling_convention(cconv);
+	DB((dbg, LEVEL_2, "%+F is a tail call\n", call));
+	return jmp;
+}
+
+/**
+ * Decides which of the marked tail calls are executed as jumps.  The stack
+ * arguments of the callee must fit into the area of our stack parameters and
+ * neither function may pop its arguments.
+ */
+static void prepare_tail_calls(ir_graph *const irg)
+{
+	foreach_irn_in(get_irg_end_block(irg), i, ret) {
+		ir_node *const call = x86_get_tail_call(ret);
+		if (call == NULL)
+			continue;
+		ir_node     *const callee = get_Call_ptr(call);
+		x86_cconv_t *const cconv
+			= ia32_decide_calling_convention(get_Call_type(call), NULL);
+		unsigned n_gp_regs = 0;
+		for (unsigned p = 0; p < cconv->n_parameters; ++p) {
+			arch_register_t const *const reg = cconv->parameters[p].reg;
+			if (reg != NULL && reg->cls == &ia32_reg_classes[CLASS_ia32_gp])
+				++n_gp_regs;
+		}
+		bool const direct = is_Address(callee) || be_is_Relocation(callee);
+		/* PLT calls need the GOT address in ebx, which is callee save. An
+		 * indirect callee needs a register besides the parameters. */
+		if (callee_is_plt(callee)
+		 || (!direct && n_gp_regs >= 3)
+		 || cconv->sp_delta != 0 || current_cconv->sp_delta != 0
+		 || cconv->param_stacksize > current_cconv->param_stacksize) {
+			set_Call_tail_call(call, false);
+		} else if (cconv->param_stacksize > 0) {
+			x86_order_parameter_loads(call);
+		}
+		x86_free_calling_convention(cconv);
+	}
+}
+
 static ir_node *gen_Call(ir_node *node)
 {
 	arch_register_req_t const *const req_gp = &ia32_class_reg_req_gp;
@@ -5560,6 +5692,7 @@ void ia32_transform_graph(ir_graph *irg)
 	x86_layout_param_entities(irg, current_cconv, IA32_REGISTER_SIZE);
 	be_add_parameter_entity_stores(irg);
 	x86_create_parameter_loads(irg, current_cconv);
+	prepare_tail_calls(irg);
 
 	be_timer_push(T_HEIGHTS);
 	heights = heights_new(irg);
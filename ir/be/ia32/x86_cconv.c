@@ -10,8 +10,10 @@
  */
 #include "x86_cconv.h"
 
+#include "array.h"
 #include "betranshlp.h"
 #include "bevarargs.h"
+#include "ircons.h"
 #include "iredges_t.h"
 #include "irgmod.h"
 #include "irnode_t.h"
@@ -83,3 +85,86 @@ void x86_layout_param_entities(ir_graph *const irg, x86_cconv_t *const cconv,
 		cconv->va_start_addr = be_make_va_start_entity(frame_type, offset);
 	}
 }
+
+/** Checks whether all users of @p node are @p ret. */
+static bool only_used_by(ir_node const *const node, ir_node const *const ret)
+{
+	foreach_out_edge(node, edge) {
+		if (get_edge_src_irn(edge) != ret)
+			return false;
+	}
+	return true;
+}
+
+ir_node *x86_get_tail_call(ir_node *const ret)
+{
+	if (!is_Return(ret))
+		return NULL;
+	ir_node *const mem = get_Return_mem(ret);
+	if (!is_Proj(mem))
+		return NULL;
+	ir_node *const call = get_Proj_pred(mem);
+	if (!is_Call(call) || !get_Call_tail_call(call)
+	 || get_nodes_block(call) != get_nodes_block(ret))
+		return NULL;
+
+	/* The Call must not be reachable other than through the Return, as it
+	 * is replaced by the Return. */
+	size_t const n_ress = get_Return_n_ress(ret);
+	if (n_ress != get_method_n_ress(get_Call_type(call)))
+		return NULL;
+	foreach_out_edge(call, edge) {
+		ir_node *const proj = get_edge_src_irn(edge);
+		if (proj == mem) {
+			if (!only_used_by(proj, ret))
+				return NULL;
+			continue;
+		}
+		if (!is_Proj(proj) || get_Proj_num(proj) != pn_Call_T_result)
+			return NULL;
+		foreach_out_edge(proj, res_edge) {
+			ir_node *const res = get_edge_src_irn(res_edge);
+			unsigned const pn  = get_Proj_num(res);
+			if (pn >= n_ress || get_Return_res(ret, pn) != res
+			 || !only_used_by(res, ret))
+				return NULL;
+		}
+	}
+	for (size_t i = 0; i < n_ress; ++i) {
+		ir_node *const res = get_Return_res(ret, i);
+		if (!is_Proj(res) || get_Proj_num(res) != i
+		 || get_Proj_pred(res) != get_Proj_for_pn(call, pn_Call_T_result))
+			return NULL;
+	}
+	return call;
+}
+
+void x86_order_parameter_loads(ir_node *const call)
+{
+	ir_graph *const irg = get_irn_irg(call);
+	ir_node       **in  = NEW_ARR_F(ir_node*, 0);
+	ARR_APP1(ir_node*, in, get_Call_mem(call));
+	foreach_out_edge(get_irg_frame(irg), edge) {
+		ir_node *const member = get_edge_src_irn(edge);
+		if (!is_Member(member)
+		 || !is_parameter_entity(get_Member_entity(member)))
+			continue;
+		foreach_out_edge(member, member_edge) {
+			ir_node *const load = get_edge_src_irn(member_edge);
+			if (!is_Load(load))
+				continue;
+			/* Pinned loads are not rematerialized after the stores. */
+			set_irn_pinned(load, true);
+			ir_node *proj = get_Proj_for_pn(load, pn_Load_M);
+			if (proj == NULL)
+				proj = new_r_Proj(load, mode_M, pn_Load_M);
+			ARR_APP1(ir_node*, in, proj);
+		}
+	}
+	size_t const n = ARR_LEN(in);
+	if (n > 1) {
+		ir_node *const block = get_nodes_block(call);
+		set_Call_mem(call, new_r_Sync(block, n, in));
+	}
+	DEL_ARR_F(in);
+}
@@ -56,4 +56,18 @@ void x86_create_parameter_loads(ir_graph *irg, const x86_cconv_t *cconv);
 void x86_layout_param_entities(ir_graph *irg, x86_cconv_t *cconv,
                                int params_offset);
 
+/**
+ * Returns the Call marked as tail call whose results are returned by @p ret
+ * or NULL if @p ret is no such Return.  The Call must be used by @p ret only,
+ * so it can be replaced by a jump to the callee.
+ */
+ir_node *x86_get_tail_call(ir_node *ret);
+
+/**
+ * Makes the tail call @p call depend on all loads of stack parameters, as it
+ * overwrites them with its own stack arguments.  The loads get pinned, so
+ * they are not rematerialized afterwards.
+ */
+void x86_order_parameter_loads(ir_node *call);
+
 #endif
@@ -91,6 +91,8 @@ void ir_finish(void)
 	exit_execfreq();
 	firm_be_finish();
 
+	free_irp_points_to();
+	free_irp_mod_ref();
 	free_ir_prog();
 	firm_finish_op();
 	finish_tarval();
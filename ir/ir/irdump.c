@@ -651,6 +651,12 @@ void dump_node_opcode(FILE *F, const ir_node *n)
 		fprintf(F, "%s[%s]", name, get_builtin_kind_name(get_Builtin_kind(n)));
 		break;
 
+	case iro_Call:
+		fprintf(F, "%s", name);
+		if (get_Call_tail_call(n))
+			fprintf(F, "[tail]");
+		break;
+
 	case iro_Const:
 		ir_fprintf(F, "%s %T", name, get_Const_tarval(n));
 		break;
@@ -1328,6 +1334,12 @@ static void dump_graph_info(FILE *F, ir_graph *irg)
 		fprintf(F, " consistent_entity_usage");
 	if (irg_has_properties(irg, IR_GRAPH_PROPERTY_MANY_RETURNS))
 		fprintf(F, " many_returns");
+	if (irg_has_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_POINTS_TO))
+		fprintf(F, " consistent_points_to");
+	if (irg_has_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_ALIAS_CACHE))
+		fprintf(F, " consistent_alias_cache");
+	if (irg_has_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_SCEV))
+		fprintf(F, " consistent_scev");
 	fprintf(F, "\"\n");
 }
 
@@ -12,11 +12,13 @@
 
 #include "array.h"
 #include "ircons.h"
+#include "irdom_t.h"
 #include "iredges_t.h"
 #include "irflag_t.h"
 #include "irgraph_t.h"
 #include "irgwalk.h"
 #include "irhooks.h"
+#include "irloop_t.h"
 #include "irnode_t.h"
 #include "irtools.h"
 #include "panic.h"
@@ -85,7 +87,9 @@ void exchange(ir_node *old, ir_node *nw)
 
 	/* update irg flags */
 	clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUTS
-	                        | IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO);
+	                        | IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO
+	                        | IR_GRAPH_PROPERTY_CONSISTENT_ALIAS_CACHE
+	                        | IR_GRAPH_PROPERTY_CONSISTENT_SCEV);
 }
 
 static void collect_new_start_block_node_(ir_node *node)
@@ -313,6 +317,99 @@ void kill_node(ir_node *node)
 	set_irn_op(node, op_Deleted);
 }
 
+/**
+ * Returns the innermost loop containing both @p block0 and @p block1.
+ */
+static ir_loop *get_common_loop(const ir_node *block0, const ir_node *block1)
+{
+	ir_loop *loop0 = get_irn_loop(block0);
+	ir_loop *loop1 = get_irn_loop(block1);
+	if (loop0 == NULL || loop1 == NULL)
+		return NULL;
+
+	while (get_loop_depth(loop0) > get_loop_depth(loop1))
+		loop0 = get_loop_outer_loop(loop0);
+	while (get_loop_depth(loop1) > get_loop_depth(loop0))
+		loop1 = get_loop_outer_loop(loop1);
+	while (loop0 != loop1) {
+		loop0 = get_loop_outer_loop(loop0);
+		loop1 = get_loop_outer_loop(loop1);
+	}
+	return loop0;
+}
+
+ir_node *split_cf_edge(ir_node *block, int pos)
+{
+	ir_graph *irg  = get_irn_irg(block);
+	ir_node  *pred = get_Block_cfgpred(block, pos);
+	assert(!is_Bad(pred));
+
+	ir_node *from  = get_nodes_block(pred);
+	ir_node *split = new_r_Block(irg, 1, &pred);
+	ir_node *jmp   = new_r_Jmp(split);
+
+	/* The new block belongs to the innermost loop containing the edge. The
+	 * back edge flag stays with the edge entering block. Changing the
+	 * predecessor clears the loop information, so it is updated before. */
+	bool keep_loopinfo = false;
+	if (irg_has_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO)) {
+		ir_loop *loop = get_common_loop(from, block);
+		if (loop != NULL) {
+			add_mature_loop_node(loop, split, get_irg_obstack(irg));
+			set_irn_loop(split, loop);
+			keep_loopinfo = true;
+		}
+	}
+
+	set_Block_cfgpred(block, pos, jmp);
+	if (keep_loopinfo)
+		add_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO);
+
+	dom_split_cf_edge(from, split, block);
+	pdom_split_cf_edge(from, split, block);
+
+	/* The split block changes the exits of the loops. */
+	clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUTS
+	                   | IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE_FRONTIERS
+	                   | IR_GRAPH_PROPERTY_CONSISTENT_SCEV);
+	return split;
+}
+
+void replace_cf_edge(ir_node *block, int pos, ir_node *pred)
+{
+	ir_graph *irg       = get_irn_irg(block);
+	ir_node  *old_block = get_Block_cfgpred_block(block, pos);
+	ir_node  *new_block = is_Bad(pred) ? NULL : get_nodes_block(pred);
+	if (new_block != NULL && is_Bad(new_block))
+		new_block = NULL;
+
+	if (old_block == new_block) {
+		set_Block_cfgpred(block, pos, pred);
+		clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUTS);
+		return;
+	}
+
+	/* Update dominance for the removal and the insertion separately. */
+	if (old_block != NULL) {
+		set_Block_cfgpred(block, pos, new_r_Bad(irg, mode_X));
+		dom_delete_cf_edge(old_block, block);
+	}
+	set_Block_cfgpred(block, pos, pred);
+	if (new_block != NULL)
+		dom_insert_cf_edge(new_block, block);
+
+	ir_graph_properties_t props
+		= IR_GRAPH_PROPERTY_CONSISTENT_OUTS
+		| IR_GRAPH_PROPERTY_CONSISTENT_POSTDOMINANCE
+		| IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE_FRONTIERS
+		| IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO
+		| IR_GRAPH_PROPERTY_NO_CRITICAL_EDGES
+		| IR_GRAPH_PROPERTY_NO_UNREACHABLE_CODE;
+	if (is_Bad(pred))
+		props |= IR_GRAPH_PROPERTY_NO_BADS;
+	clear_irg_properties(irg, props);
+}
+
 ir_node *duplicate_subgraph(dbg_info *dbg, ir_node *n, ir_node *block)
 {
 	ir_graph *irg  = get_irn_irg(block);
@@ -19,13 +19,14 @@
 #include "irgopt.h"
 #include "irgwalk.h"
 #include "irhooks.h"
-#include "irmemory.h"
+#include "irmemory_t.h"
 #include "irnode_t.h"
 #include "iropt_t.h"
 #include "iroptimize.h"
 #include "irouts.h"
 #include "irprog_t.h"
 #include "irtools.h"
+#include "scev.h"
 #include "type_t.h"
 #include "util.h"
 #include "xmalloc.h"
@@ -235,7 +236,13 @@ ir_graph *create_irg_copy(ir_graph *irg)
 {
 	ir_graph *res = alloc_graph();
 
-	res->irg_pinned_state = irg->irg_pinned_state;
+	res->irg_pinned_state  = irg->irg_pinned_state;
+	res->callee_info_state = irg_callee_info_none;
+	res->mem_disambig_opt  = irg->mem_disambig_opt;
+	res->index             = get_irp_new_irg_idx();
+#ifdef DEBUG_libfirm
+	res->graph_nr          = get_irp_new_node_nr();
+#endif
 
 	/* clone the frame type here for safety */
 	irp_reserve_resources(irp, IRP_RESOURCE_ENTITY_LINK);
@@ -616,4 +623,8 @@ void confirm_irg_properties(ir_graph *irg, ir_graph_properties_t props)
 		set_irp_globals_entity_usage_state(ir_entity_usage_not_computed);
 	if (!(props & IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE_FRONTIERS))
 		ir_free_dominance_frontiers(irg);
+	if (!(props & IR_GRAPH_PROPERTY_CONSISTENT_ALIAS_CACHE))
+		free_irg_alias_cache(irg);
+	if (!(props & IR_GRAPH_PROPERTY_CONSISTENT_SCEV))
+		free_irg_scev_cache(irg);
 }
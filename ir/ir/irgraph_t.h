@@ -24,6 +24,7 @@
 #include "obst.h"
 #include "pset.h"
 #include "type_t.h"
+#include "vrp.h"
 
 #define get_irg_start_block(irg)              get_irg_start_block_(irg)
 #define set_irg_start_block(irg, node)        set_irg_start_block_(irg, node)
@@ -94,9 +95,15 @@ typedef struct ir_bitinfo {
 	struct obstack    obst;
 } ir_bitinfo;
 
+typedef struct ir_alias_cache ir_alias_cache;
+typedef struct ir_scev_cache  ir_scev_cache;
+
 typedef struct ir_vrp_info {
 	struct ir_nodemap infos;
 	struct obstack    obst;
+	vrp_attr         *params;     /**< facts about the parameters which hold
+	                                   at all call sites, see ipcp() */
+	ir_type          *params_mtp; /**< method type the facts belong to */
 } ir_vrp_info;
 
 /**
@@ -131,6 +138,8 @@ struct ir_graph {
 	unsigned short   dump_nr;       /**< number of graph dumps */
 
 	unsigned char    mem_disambig_opt;
+	ir_alias_cache  *alias_cache;   /**< memoized alias queries */
+	ir_scev_cache   *scev_cache;    /**< memoized scalar evolution */
 
 	/** Number of local variables in this function during construction. */
 	int      n_loc;
@@ -145,6 +154,11 @@ struct ir_graph {
 	ir_vrp_info         vrp;         /**< vrp info */
 	ir_loop            *loop;        /**< The outermost loop for this graph. */
 	ir_dom_front_info_t domfront;    /**< dominance frontier analysis data */
+	bool                dom_numbers_outdated;  /**< dominator tree pre-order
+	                                                numbers must be recomputed
+	                                                after incremental updates */
+	bool                pdom_numbers_outdated; /**< same for the post
+	                                                dominator tree */
 	irg_edges_info_t    edge_info;   /**< edge info for automatic outs */
 	ir_graph          **callers;     /**< Callgraph: list of callers. */
 	unsigned           *caller_isbe; /**< Callgraph: bitset if backedge info is
@@ -185,7 +199,8 @@ ir_graph *new_const_code_irg(void);
 
 /**
  * Create a new graph that is a copy of a given one.
- * Uses the link fields of the original graphs.
+ * Uses the link fields of the original graphs. The copy has no entity and is
+ * not added to the program.
  *
  * @param irg  The graph that must be copied.
  */
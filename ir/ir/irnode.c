@@ -172,7 +172,10 @@ void set_irn_in(ir_node *const node, int const arity, ir_node *const *const in)
 	MEMCPY(*pOld_in + 1, in, arity);
 
 	/* update irg flags */
-	clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUTS | IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO);
+	clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUTS
+	                        | IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO
+	                        | IR_GRAPH_PROPERTY_CONSISTENT_ALIAS_CACHE
+	                        | IR_GRAPH_PROPERTY_CONSISTENT_SCEV);
 }
 
 ir_node *(get_irn_n)(const ir_node *node, int n)
@@ -195,7 +198,10 @@ void set_irn_n(ir_node *node, int n, ir_node *in)
 	node->in[n + 1] = in;
 
 	/* update irg flags */
-	clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUTS | IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO);
+	clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUTS
+	                        | IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO
+	                        | IR_GRAPH_PROPERTY_CONSISTENT_ALIAS_CACHE
+	                        | IR_GRAPH_PROPERTY_CONSISTENT_SCEV);
 }
 
 int add_irn_n(ir_node *node, ir_node *in)
@@ -142,6 +142,7 @@ typedef struct call_attr {
 	except_attr exc;          /**< Exception attribute. MUST be first. */
 	ir_type     *type;        /**< type of called procedure */
 	ir_entity   **callee_arr; /**< result of callee analysis */
+	unsigned    tail_call:1;  /**< Set if the Call may be a tail call. */
 } call_attr;
 
 /** Attributes for Builtin nodes. */
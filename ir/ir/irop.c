@@ -443,6 +443,9 @@ static void call_copy_attr(ir_graph *irg, const ir_node *old_node,
 {
 	default_copy_attr(irg, old_node, new_node);
 	cg_remove_call_callee_arr(new_node);
+	/* a tail call of the inlined graph is no tail call of the caller */
+	if (irg != get_irn_irg(old_node))
+		new_node->attr.call.tail_call = false;
 }
 
 /**
@@ -84,6 +84,14 @@ uint32_t ir_profile_get_block_execcount(const ir_node *block)
 	}
 }
 
+bool ir_profile_has_block_execcount(const ir_node *block)
+{
+	if (profile == NULL)
+		return false;
+	execcount_t const query = { .block = get_irn_node_nr(block), .count = 0 };
+	return set_find(execcount_t, profile, &query, sizeof(query), query.block) != NULL;
+}
+
 /**
  * Block walker, count number of blocks.
  */
@@ -491,7 +499,7 @@ void ir_profile_free(void)
 	}
 }
 
-bool ir_profile_read(const char *filename)
+int ir_profile_read(const char *filename)
 {
 	FIRM_DBG_REGISTER(dbg, "firm.ir.profile");
 
@@ -15,32 +15,18 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#include "execfreq.h"
 #include "firm_types.h"
 
 /**
- * Instruments all irgs in the program with profile code.
- * The final code will have a counter for each basic block which is
- * incremented in that block. After the program has run the info is written
- * to @p filename.
- */
-ir_graph *ir_profile_instrument(const char *filename);
-
-/**
- * Reads the corresponding profile info file if it exists and returns a
- * profile info struct
- * @param filename The name of the file containing profile information
- */
-bool ir_profile_read(const char *filename);
-
-/**
- * Frees the profile info
+ * Get block execution count as determined be profiling
  */
-void ir_profile_free(void);
+uint32_t ir_profile_get_block_execcount(const ir_node *block);
 
 /**
- * Get block execution count as determined be profiling
+ * Returns true if the profile contains an execution count for @p block.
  */
-uint32_t ir_profile_get_block_execcount(const ir_node *block);
+bool ir_profile_has_block_execcount(const ir_node *block);
 
 /**
  * Initializes exec_freq structure for an irg based on profile data
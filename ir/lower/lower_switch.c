@@ -7,6 +7,12 @@
  * @file
  * @brief   Lowering of Switches if necessary or advantageous.
  * @author  Moritz Kroll
+ *
+ * Switches with too many unused table entries are split into clusters of
+ * consecutive cases: dense clusters become jump tables, small sets of cases
+ * with few targets become bit tests and single cases become compares.  A
+ * binary search, weighted by profile counts if available, dispatches between
+ * the clusters.
  */
 #include "array.h"
 #include "ircons.h"
@@ -15,11 +21,20 @@
 #include "irnode_t.h"
 #include "irnodeset.h"
 #include "irouts_t.h"
+#include "irprofile.h"
 #include "lowering.h"
 #include "panic.h"
 #include "util.h"
+#include <limits.h>
+#include <math.h>
 #include <stdbool.h>
 
+/** At least one in TABLE_DENSITY entries of the jump table of a cluster must
+ * be used. */
+#define TABLE_DENSITY        4
+/** Maximum number of different targets of a bit test cluster. */
+#define MAX_BIT_TEST_TARGETS 3
+
 typedef struct walk_env_t {
 	ir_nodeset_t  processed;
 	ir_mode      *selector_mode;
@@ -29,21 +44,46 @@ typedef struct walk_env_t {
 } walk_env_t;
 
 typedef struct target_t {
-	ir_node *block;     /**< block that is targetted */
-	uint16_t n_entries; /**< number of table entries targetting this block */
-	uint16_t i;
+	ir_node  *block;     /**< block that is targetted */
+	ir_node **preds;     /**< new control flow predecessors of the block */
+	unsigned  n_entries; /**< number of table entries targetting this block */
+	double    weight;    /**< weight of each entry targetting this block */
 } target_t;
 
 typedef struct switch_info_t {
-	ir_node     *switchn;
-	ir_tarval   *switch_min;
-	ir_tarval   *switch_max;
-	ir_node     *default_block;
-	unsigned     num_cases;
-	target_t    *targets;
-	ir_node    **defusers;    /**< the Projs pointing to the default case */
+	ir_node       *switchn;
+	ir_tarval     *switch_min;
+	ir_tarval     *switch_max;
+	ir_node       *default_block;
+	unsigned       num_cases;
+	unsigned       n_targets;
+	target_t      *targets;
+	ir_node      **defusers;   /**< the Projs pointing to the default case */
+	ir_mode       *table_mode; /**< selector mode of jump tables */
+	ir_nodeset_t  *processed;  /**< Switches which need no more lowering */
 } switch_info_t;
 
+typedef enum cluster_kind_t {
+	cluster_case,     /**< a single entry, tested by a compare */
+	cluster_table,    /**< dense entries, dispatched by a jump table */
+	cluster_bit_test, /**< entries with few targets, tested with bit masks */
+} cluster_kind_t;
+
+/** A cluster of consecutive switch table entries. */
+typedef struct case_cluster_t {
+	cluster_kind_t         kind;
+	ir_switch_table_entry *entries;   /**< the first entry of the cluster */
+	unsigned               n_entries;
+	double                 weight;    /**< sum of the weights of the entries */
+} case_cluster_t;
+
+/** A bit mask selecting the cases of a target in a bit test cluster. */
+typedef struct bit_test_t {
+	unsigned   pn;
+	ir_tarval *mask;
+	double     weight;
+} bit_test_t;
+
 /**
  * analyze enough to decide if we should lower the switch
  */
@@ -105,7 +145,26 @@ static void analyse_switch1(switch_info_t *info)
 		++target->n_entries;
 	}
 
+	/* weight the entries by the profiled execution counts of their targets,
+	 * all entries are equally likely without profile */
+	bool use_profile = true;
+	for (unsigned pn = 0; pn < n_outs; ++pn) {
+		if (targets[pn].n_entries > 0
+		 && !ir_profile_has_block_execcount(targets[pn].block))
+			use_profile = false;
+	}
+	for (unsigned pn = 0; pn < n_outs; ++pn) {
+		target_t *target = &targets[pn];
+		if (target->n_entries == 0)
+			continue;
+		target->weight = use_profile
+			? (double)ir_profile_get_block_execcount(target->block)
+			  / target->n_entries
+			: 1.0;
+	}
+
 	info->default_block = targets[pn_Switch_default].block;
+	info->n_targets     = n_outs;
 	info->targets       = targets;
 }
 
@@ -269,6 +328,28 @@ static bool normalize_switch(switch_info_t *info, ir_mode *selector_mode)
 	return true;
 }
 
+/**
+ * Create an if (min <= selector && selector <= max) Cond node.  The test is
+ * done as unsigned compare of selector - min, which is returned in @p offset.
+ */
+static ir_node *create_range_cond(dbg_info *dbgi, ir_node *block,
+                                  ir_node *selector, ir_tarval *min,
+                                  ir_tarval *max, ir_node **offset)
+{
+	ir_graph  *irg          = get_irn_irg(block);
+	ir_mode   *mode         = find_unsigned_mode(get_irn_mode(selector));
+	ir_tarval *umin         = tarval_convert_to(min, mode);
+	ir_tarval *adjusted_max = tarval_sub(tarval_convert_to(max, mode), umin);
+	ir_node   *conv         = new_rd_Conv(dbgi, block, selector, mode);
+	ir_node   *minconst     = new_r_Const(irg, umin);
+	ir_node   *sub          = new_rd_Sub(dbgi, block, conv, minconst);
+	ir_node   *maxconst     = new_r_Const(irg, adjusted_max);
+	ir_node   *cmp          = new_rd_Cmp(dbgi, block, sub, maxconst,
+	                                     ir_relation_less_equal);
+	*offset = sub;
+	return new_rd_Cond(dbgi, block, cmp);
+}
+
 /**
  * Create an if (selector == caseval) Cond node (and handle the special case
  * of ranged cases)
@@ -277,67 +358,416 @@ static ir_node *create_case_cond(const ir_switch_table_entry *entry,
                                  dbg_info *dbgi, ir_node *block,
                                  ir_node *selector)
 {
+	if (entry->min != entry->max) {
+		ir_node *offset;
+		return create_range_cond(dbgi, block, selector, entry->min,
+		                         entry->max, &offset);
+	}
+
 	ir_graph *irg      = get_irn_irg(block);
 	ir_node  *minconst = new_r_Const(irg, entry->min);
-
-	ir_node  *cmp;
-	if (entry->min == entry->max) {
-		cmp = new_rd_Cmp(dbgi, block, selector, minconst, ir_relation_equal);
-	} else {
-		ir_tarval *adjusted_max = tarval_sub(entry->max, entry->min);
-		ir_node   *sub          = new_rd_Sub(dbgi, block, selector, minconst);
-		ir_node   *maxconst     = new_r_Const(irg, adjusted_max);
-		cmp = new_rd_Cmp(dbgi, block, sub, maxconst, ir_relation_less_equal);
-	}
+	ir_node  *cmp      = new_rd_Cmp(dbgi, block, selector, minconst,
+	                                ir_relation_equal);
 	return new_rd_Cond(dbgi, block, cmp);
 }
 
 static void connect_to_target(target_t *target, ir_node *cf)
 {
-	ir_node *block     = target->block;
-	unsigned n_entries = target->n_entries;
-	if (get_Block_n_cfgpreds(block) != (int)n_entries) {
-		ir_node **new_in = ALLOCAN(ir_node*, n_entries);
-		ir_graph *irg    = get_irn_irg(block);
-		ir_node  *dummy  = new_r_Dummy(irg, mode_X);
-		for (unsigned i = 0; i < n_entries; ++i) {
-			new_in[i] = dummy;
+	if (target->preds == NULL)
+		target->preds = NEW_ARR_F(ir_node*, 0);
+	ARR_APP1(ir_node*, target->preds, cf);
+}
+
+/**
+ * Sets the new control flow predecessors of all targets.
+ */
+static void connect_targets(switch_info_t *info)
+{
+	for (unsigned pn = 0; pn < info->n_targets; ++pn) {
+		target_t *target = &info->targets[pn];
+		if (target->preds == NULL)
+			continue;
+		set_irn_in(target->block, ARR_LEN(target->preds), target->preds);
+		DEL_ARR_F(target->preds);
+	}
+}
+
+/**
+ * Returns the distance of @p tv from @p base in the unsigned mode @p mode,
+ * or ULONG_MAX if it is too large.
+ */
+static unsigned long get_distance(ir_tarval *base, ir_tarval *tv,
+                                  ir_mode *mode)
+{
+	ir_tarval *distance = tarval_sub(tarval_convert_to(tv, mode),
+	                                 tarval_convert_to(base, mode));
+	return tarval_is_long(distance) ? (unsigned long)get_tarval_long(distance)
+	                                : ULONG_MAX;
+}
+
+/**
+ * Returns whether the @p n_entries entries have at most MAX_BIT_TEST_TARGETS
+ * different targets.
+ */
+static bool has_few_targets(ir_switch_table_entry const *entries,
+                            unsigned n_entries)
+{
+	unsigned pns[MAX_BIT_TEST_TARGETS];
+	unsigned n_pns = 0;
+	for (unsigned e = 0; e < n_entries; ++e) {
+		unsigned p = 0;
+		while (p < n_pns && pns[p] != entries[e].pn)
+			++p;
+		if (p == n_pns) {
+			if (n_pns == MAX_BIT_TEST_TARGETS)
+				return false;
+			pns[n_pns++] = entries[e].pn;
 		}
-		set_irn_in(block, n_entries, new_in);
-		assert(target->i == 0);
 	}
-	assert(target->i < n_entries);
-	set_Block_cfgpred(target->block, target->i++, cf);
+	return true;
+}
+
+static void add_cluster(case_cluster_t **clusters, switch_info_t const *info,
+                        cluster_kind_t kind, ir_switch_table_entry *entries,
+                        unsigned n_entries)
+{
+	double weight = 0.0;
+	for (unsigned e = 0; e < n_entries; ++e) {
+		weight += info->targets[entries[e].pn].weight;
+	}
+	case_cluster_t const cluster = {
+		.kind      = kind,
+		.entries   = entries,
+		.n_entries = n_entries,
+		.weight    = weight,
+	};
+	ARR_APP1(case_cluster_t, *clusters, cluster);
 }
 
 /**
- * Creates an if cascade realizing binary search.
+ * Partitions the sorted switch table into clusters.  Dense runs of entries
+ * become jump tables, using as few clusters as possible.  The remaining
+ * entries are combined to bit tests, if they lie within the width of a
+ * machine word and have few targets.
  */
-static void create_if_cascade(switch_info_t *info, ir_node *block,
-                              ir_switch_table_entry *curcases,
-                              unsigned numcases)
+static case_cluster_t *find_clusters(switch_info_t const *info,
+                                     walk_env_t const *env)
 {
-	ir_graph      *irg      = get_irn_irg(block);
-	const ir_node *switchn  = info->switchn;
-	dbg_info      *dbgi     = get_irn_dbg_info(switchn);
-	ir_node       *selector = get_Switch_selector(switchn);
+	ir_switch_table       *table     = get_Switch_table(info->switchn);
+	ir_switch_table_entry *entries   = table->entries;
+	unsigned               n_entries = (unsigned)table->n_entries;
+	ir_mode               *mode
+		= find_unsigned_mode(get_irn_mode(get_Switch_selector(info->switchn)));
+
+	/* positions of the entries relative to the smallest case value */
+	unsigned long *first = XMALLOCN(unsigned long, n_entries);
+	unsigned long *last  = XMALLOCN(unsigned long, n_entries);
+	for (unsigned e = 0; e < n_entries; ++e) {
+		first[e] = get_distance(entries[0].min, entries[e].min, mode);
+		last[e]  = get_distance(entries[0].min, entries[e].max, mode);
+	}
 
-	if (numcases == 0) {
-		/* zero cases: "goto default;" */
-		ARR_APP1(ir_node*, info->defusers, new_r_Jmp(block));
-	} else if (numcases == 1) {
+	/* n_parts[i] is the minimal number of clusters for the entries from i on,
+	 * next[i] the first entry after the cluster starting at i */
+	unsigned *n_parts = XMALLOCN(unsigned, n_entries + 1);
+	unsigned *next    = XMALLOCN(unsigned, n_entries);
+	n_parts[n_entries] = 0;
+	for (unsigned i = n_entries; i-- > 0;) {
+		n_parts[i] = n_parts[i + 1] + 1;
+		next[i]    = i + 1;
+
+		unsigned long n_values = 0;
+		for (unsigned j = i; j < n_entries && last[j] != ULONG_MAX; ++j) {
+			n_values += last[j] - first[j] + 1;
+			unsigned long span = last[j] - first[i];
+			/* the spare size only grows with more entries */
+			if (span - (j - i) >= env->spare_size)
+				break;
+			if (j - i + 1 > env->small_switch
+			 && n_values * TABLE_DENSITY > span
+			 && n_parts[j + 1] + 1 < n_parts[i]) {
+				n_parts[i] = n_parts[j + 1] + 1;
+				next[i]    = j + 1;
+			}
+		}
+	}
+
+	unsigned        bits     = get_mode_size_bits(info->table_mode);
+	case_cluster_t *clusters = NEW_ARR_F(case_cluster_t, 0);
+	for (unsigned i = 0; i < n_entries;) {
+		if (next[i] > i + 1) {
+			/* bit tests need no table, if the values fit into a word */
+			unsigned       n    = next[i] - i;
+			cluster_kind_t kind = last[next[i] - 1] - first[i] < bits
+			                   && has_few_targets(&entries[i], n)
+				? cluster_bit_test : cluster_table;
+			add_cluster(&clusters, info, kind, &entries[i], n);
+			i = next[i];
+			continue;
+		}
+
+		/* A bit test pays off if it replaces more compares than it needs
+		 * tests besides the range check. */
+		unsigned pns[MAX_BIT_TEST_TARGETS];
+		unsigned n_pns = 0;
+		unsigned end   = i + 1;
+		for (unsigned j = i; j < n_entries && next[j] == j + 1
+		     && last[j] != ULONG_MAX && last[j] - first[i] < bits; ++j) {
+			unsigned pn = entries[j].pn;
+			unsigned p  = 0;
+			while (p < n_pns && pns[p] != pn)
+				++p;
+			if (p == n_pns) {
+				if (n_pns == MAX_BIT_TEST_TARGETS)
+					break;
+				pns[n_pns++] = pn;
+			}
+			if (j - i + 1 > n_pns + 1)
+				end = j + 1;
+		}
+		if (end > i + 1) {
+			add_cluster(&clusters, info, cluster_bit_test, &entries[i],
+			            end - i);
+		} else {
+			add_cluster(&clusters, info, cluster_case, &entries[i], 1);
+		}
+		i = end;
+	}
+
+	free(next);
+	free(n_parts);
+	free(last);
+	free(first);
+	return clusters;
+}
+
+/**
+ * Creates a range check and a jump table for the entries of @p cluster.
+ */
+static void create_jump_table(switch_info_t *info, ir_node *block,
+                              case_cluster_t const *cluster)
+{
+	ir_graph              *irg       = get_irn_irg(block);
+	ir_node               *switchn   = info->switchn;
+	dbg_info              *dbgi      = get_irn_dbg_info(switchn);
+	ir_node               *selector  = get_Switch_selector(switchn);
+	ir_switch_table_entry *entries   = cluster->entries;
+	unsigned               n_entries = cluster->n_entries;
+
+	ir_node *offset;
+	ir_node *cond = create_range_cond(dbgi, block, selector, entries[0].min,
+	                                  entries[n_entries - 1].max, &offset);
+	ir_node *in[]        = { new_r_Proj(cond, mode_X, pn_Cond_true) };
+	ir_node *table_block = new_r_Block(irg, ARRAY_SIZE(in), in);
+	ARR_APP1(ir_node*, info->defusers, new_r_Proj(cond, mode_X, pn_Cond_false));
+
+	/* build a table normalized to 0 with new Proj numbers for the targets */
+	ir_mode         *offset_mode = get_irn_mode(offset);
+	ir_mode         *mode        = info->table_mode;
+	ir_tarval       *base        = tarval_convert_to(entries[0].min, offset_mode);
+	ir_switch_table *table       = ir_new_switch_table(irg, n_entries);
+	unsigned        *new_pns     = XMALLOCNZ(unsigned, info->n_targets);
+	unsigned         n_outs      = pn_Switch_max + 1;
+	for (unsigned e = 0; e < n_entries; ++e) {
+		ir_switch_table_entry const *entry = &entries[e];
+		if (new_pns[entry->pn] == 0)
+			new_pns[entry->pn] = n_outs++;
+
+		ir_tarval *min = tarval_convert_to(entry->min, offset_mode);
+		ir_tarval *max = tarval_convert_to(entry->max, offset_mode);
+		min = tarval_convert_to(tarval_sub(min, base), mode);
+		max = tarval_convert_to(tarval_sub(max, base), mode);
+		ir_switch_table_set(table, e, min, max, new_pns[entry->pn]);
+	}
+
+	ir_node *table_selector = new_rd_Conv(dbgi, table_block, offset, mode);
+	ir_node *new_switch     = new_rd_Switch(dbgi, table_block, table_selector,
+	                                        n_outs, table);
+	ir_nodeset_insert(info->processed, new_switch);
+
+	for (unsigned pn = 0; pn < info->n_targets; ++pn) {
+		if (new_pns[pn] == 0)
+			continue;
+		ir_node *proj = new_r_Proj(new_switch, mode_X, new_pns[pn]);
+		connect_to_target(&info->targets[pn], proj);
+	}
+	ir_node *default_proj = new_r_Proj(new_switch, mode_X, pn_Switch_default);
+	ARR_APP1(ir_node*, info->defusers, default_proj);
+	free(new_pns);
+}
+
+static int compare_bit_tests(const void *a, const void *b)
+{
+	const bit_test_t *test0 = (const bit_test_t*)a;
+	const bit_test_t *test1 = (const bit_test_t*)b;
+	if (test0->weight != test1->weight)
+		return test0->weight < test1->weight ? 1 : -1;
+	return QSORT_CMP(test0->pn, test1->pn);
+}
+
+/**
+ * Creates a range check and tests of the bit selected by the selector against
+ * a mask per target for the entries of @p cluster.
+ */
+static void create_bit_tests(switch_info_t *info, ir_node *block,
+                             case_cluster_t const *cluster)
+{
+	ir_graph              *irg       = get_irn_irg(block);
+	ir_node               *switchn   = info->switchn;
+	dbg_info              *dbgi      = get_irn_dbg_info(switchn);
+	ir_node               *selector  = get_Switch_selector(switchn);
+	ir_switch_table_entry *entries   = cluster->entries;
+	unsigned               n_entries = cluster->n_entries;
+
+	ir_node *offset;
+	ir_node *cond = create_range_cond(dbgi, block, selector, entries[0].min,
+	                                  entries[n_entries - 1].max, &offset);
+	ir_node *in[] = { new_r_Proj(cond, mode_X, pn_Cond_true) };
+	ARR_APP1(ir_node*, info->defusers, new_r_Proj(cond, mode_X, pn_Cond_false));
+
+	/* collect the masks of the targets */
+	ir_mode    *offset_mode = get_irn_mode(offset);
+	ir_mode    *mode        = info->table_mode;
+	ir_tarval  *one         = get_mode_one(mode);
+	bit_test_t  tests[MAX_BIT_TEST_TARGETS];
+	unsigned    n_tests     = 0;
+	for (unsigned e = 0; e < n_entries; ++e) {
+		ir_switch_table_entry const *entry = &entries[e];
+		unsigned t = 0;
+		while (t < n_tests && tests[t].pn != entry->pn)
+			++t;
+		if (t == n_tests) {
+			assert(n_tests < MAX_BIT_TEST_TARGETS);
+			tests[n_tests++] = (bit_test_t) {
+				.pn     = entry->pn,
+				.mask   = get_mode_null(mode),
+				.weight = 0.0,
+			};
+		}
+
+		unsigned long first = get_distance(entries[0].min, entry->min, offset_mode);
+		unsigned long last  = get_distance(entries[0].min, entry->max, offset_mode);
+		for (unsigned long bit = first; bit <= last; ++bit) {
+			ir_tarval *value = tarval_shl_unsigned(one, (unsigned)bit);
+			tests[t].mask = tarval_or(tests[t].mask, value);
+		}
+		tests[t].weight += info->targets[entry->pn].weight;
+	}
+	/* test the most likely target first */
+	QSORT(tests, n_tests, compare_bit_tests);
+
+	ir_node *test_block = new_r_Block(irg, ARRAY_SIZE(in), in);
+	ir_node *bit        = new_rd_Shl(dbgi, test_block, new_r_Const(irg, one),
+	                                 offset);
+	ir_node *zero       = new_r_Const(irg, get_mode_null(mode));
+	for (unsigned t = 0; t < n_tests; ++t) {
+		ir_node *mask  = new_r_Const(irg, tests[t].mask);
+		ir_node *and   = new_rd_And(dbgi, test_block, bit, mask);
+		ir_node *cmp   = new_rd_Cmp(dbgi, test_block, and, zero,
+		                             ir_relation_less_greater);
+		ir_node *tcond = new_rd_Cond(dbgi, test_block, cmp);
+		ir_node *tproj = new_r_Proj(tcond, mode_X, pn_Cond_true);
+		ir_node *fproj = new_r_Proj(tcond, mode_X, pn_Cond_false);
+		connect_to_target(&info->targets[tests[t].pn], tproj);
+
+		if (t == n_tests - 1) {
+			ARR_APP1(ir_node*, info->defusers, fproj);
+		} else {
+			ir_node *fin[] = { fproj };
+			test_block = new_r_Block(irg, ARRAY_SIZE(fin), fin);
+		}
+	}
+}
+
+/**
+ * Creates the code for a single cluster, unmatched values go to the default
+ * case.
+ */
+static void create_cluster(switch_info_t *info, ir_node *block,
+                           case_cluster_t const *cluster)
+{
+	switch (cluster->kind) {
+	case cluster_case: {
 		/*only one case: "if (sel == val) goto target else goto default;"*/
-		const ir_switch_table_entry *entry = &curcases[0];
+		const ir_node               *switchn  = info->switchn;
+		dbg_info                    *dbgi     = get_irn_dbg_info(switchn);
+		ir_node                     *selector = get_Switch_selector(switchn);
+		const ir_switch_table_entry *entry    = &cluster->entries[0];
 		ir_node *cond      = create_case_cond(entry, dbgi, block, selector);
 		ir_node *trueproj  = new_r_Proj(cond, mode_X, pn_Cond_true);
 		ir_node *falseproj = new_r_Proj(cond, mode_X, pn_Cond_false);
 
 		connect_to_target(&info->targets[entry->pn], trueproj);
 		ARR_APP1(ir_node*, info->defusers, falseproj);
-	} else if (numcases == 2) {
+		return;
+	}
+	case cluster_table:
+		create_jump_table(info, block, cluster);
+		return;
+	case cluster_bit_test:
+		create_bit_tests(info, block, cluster);
+		return;
+	}
+	panic("invalid cluster kind");
+}
+
+/**
+ * Returns the index of the first cluster of the upper half, so both halves
+ * have about the same weight.
+ */
+static unsigned split_clusters(case_cluster_t const *clusters,
+                               unsigned n_clusters)
+{
+	double total = 0.0;
+	for (unsigned c = 0; c < n_clusters; ++c) {
+		total += clusters[c].weight;
+	}
+
+	/* without weights (e.g. a profile without executions) split in the
+	 * middle, which gives a balanced tree */
+	unsigned const middle = n_clusters / 2;
+	if (total == 0.0)
+		return middle;
+
+	unsigned best      = middle;
+	unsigned best_dist = UINT_MAX;
+	double   best_diff = INFINITY;
+	double   lower     = 0.0;
+	for (unsigned c = 1; c < n_clusters; ++c) {
+		lower += clusters[c - 1].weight;
+		double   const diff = fabs(total - 2 * lower);
+		unsigned const dist = c < middle ? middle - c : c - middle;
+		/* break ties towards the middle */
+		if (diff < best_diff || (diff == best_diff && dist < best_dist)) {
+			best      = c;
+			best_dist = dist;
+			best_diff = diff;
+		}
+	}
+	return best;
+}
+
+/**
+ * Creates an if cascade realizing binary search over the clusters.
+ */
+static void create_if_cascade(switch_info_t *info, ir_node *block,
+                              case_cluster_t *clusters, unsigned n_clusters)
+{
+	ir_graph      *irg      = get_irn_irg(block);
+	const ir_node *switchn  = info->switchn;
+	dbg_info      *dbgi     = get_irn_dbg_info(switchn);
+	ir_node       *selector = get_Switch_selector(switchn);
+
+	if (n_clusters == 0) {
+		/* zero cases: "goto default;" */
+		ARR_APP1(ir_node*, info->defusers, new_r_Jmp(block));
+	} else if (n_clusters == 1) {
+		create_cluster(info, block, &clusters[0]);
+	} else if (n_clusters == 2 && clusters[0].kind == cluster_case
+	           && clusters[1].kind == cluster_case) {
 		/* only two cases: "if (sel == val[0]) goto target[0];" */
-		const ir_switch_table_entry *entry0 = &curcases[0];
-		const ir_switch_table_entry *entry1 = &curcases[1];
+		const ir_switch_table_entry *entry0 = &clusters[0].entries[0];
+		const ir_switch_table_entry *entry1 = &clusters[1].entries[0];
 		ir_node *cond      = create_case_cond(entry0, dbgi, block, selector);
 		ir_node *trueproj  = new_r_Proj(cond, mode_X, pn_Cond_true);
 		ir_node *falseproj = new_r_Proj(cond, mode_X, pn_Cond_false);
@@ -353,9 +783,9 @@ static void create_if_cascade(switch_info_t *info, ir_node *block,
 		connect_to_target(&info->targets[entry1->pn], trueproj1);
 		ARR_APP1(ir_node*, info->defusers, falseproj1);
 	} else {
-		/* recursive case: split cases in the middle */
-		unsigned midcase = numcases / 2;
-		const ir_switch_table_entry *entry = &curcases[midcase];
+		/* recursive case: split clusters, so both halves are equally likely */
+		unsigned mid = split_clusters(clusters, n_clusters);
+		const ir_switch_table_entry *entry = &clusters[mid].entries[0];
 		ir_node *val = new_r_Const(irg, entry->min);
 		ir_node *cmp = new_rd_Cmp(dbgi, block, selector, val, ir_relation_less);
 		ir_node *cond = new_rd_Cond(dbgi, block, cmp);
@@ -366,8 +796,8 @@ static void create_if_cascade(switch_info_t *info, ir_node *block,
 		ir_node *gein[]  = { new_r_Proj(cond, mode_X, pn_Cond_false) };
 		ir_node *geblock = new_r_Block(irg, ARRAY_SIZE(gein), gein);
 
-		create_if_cascade(info, ltblock, curcases, midcase);
-		create_if_cascade(info, geblock, curcases + midcase, numcases - midcase);
+		create_if_cascade(info, ltblock, clusters, mid);
+		create_if_cascade(info, geblock, clusters + mid, n_clusters - mid);
 	}
 }
 
@@ -423,14 +853,18 @@ static void find_switch_nodes(ir_node *block, void *ctx)
 	analyse_switch1(&info);
 
 	/* Now create the if cascade */
-	env->changed  = true;
-	info.defusers = NEW_ARR_F(ir_node*, 0);
-	block         = get_nodes_block(switchn);
-	ir_switch_table *table = get_Switch_table(switchn);
-	create_if_cascade(&info, block, table->entries, table->n_entries);
-
-	/* Connect new default case users */
+	env->changed    = true;
+	info.defusers   = NEW_ARR_F(ir_node*, 0);
+	info.table_mode = env->selector_mode != NULL ? env->selector_mode : mode;
+	info.processed  = &env->processed;
+	block           = get_nodes_block(switchn);
+	case_cluster_t *clusters = find_clusters(&info, env);
+	create_if_cascade(&info, block, clusters, ARR_LEN(clusters));
+	DEL_ARR_F(clusters);
+
+	/* Connect new default case users and targets */
 	set_irn_in(info.default_block, ARR_LEN(info.defusers), info.defusers);
+	connect_targets(&info);
 
 	DEL_ARR_F(info.defusers);
 	free(info.targets);
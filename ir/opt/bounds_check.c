@@ -0,0 +1,808 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2017 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Elimination and hoisting of range checks in loops.
+ *
+ * A range check compares an induction variable plus a constant with a
+ * value. The induction variable counts by one and is tested against a bound
+ * before every increment, so it does not wrap and ranges from its start
+ * value to the bound in every iteration. A check is removed if the range of
+ * the compared value and the facts known from dominating Conds, Confirms and
+ * value range propagation prove its outcome.
+ *
+ * A check which cannot be proven but only involves values defined outside
+ * the loop, and whose failing successor leaves the loop, is hoisted: the
+ * loop is versioned on the conjunction of the conditions which prove all
+ * such checks. The original loop is entered if they hold and does not
+ * contain the checks anymore, the copy with the checks is the fallback.
+ */
+#include "array.h"
+#include "debug.h"
+#include "ircons.h"
+#include "irdom.h"
+#include "iredges_t.h"
+#include "irgmod.h"
+#include "irgraph_t.h"
+#include "irgwalk.h"
+#include "irloop_t.h"
+#include "irnode_t.h"
+#include "irnodemap.h"
+#include "irnodeset.h"
+#include "iroptimize.h"
+#include "loop_unswitch.h"
+#include "scev.h"
+#include "tv.h"
+#include "util.h"
+#include "vrp.h"
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg;)
+
+/** Maximum absolute constant added to an induction variable. */
+#define MAX_OFFSET        (1L << 16)
+/** Maximum number of dominating blocks searched for facts. */
+#define MAX_DOM_DEPTH     64
+/** Maximum number of conditions checked before a versioned loop. */
+#define MAX_CONDITIONS    8
+/** Maximum number of nodes in a versioned loop. */
+#define MAX_LOOP_NODES    256
+/** Maximum growth of a graph in percent of its initial size. */
+#define MAX_GROWTH        100
+/** Maximum number of loops versioned in a graph. */
+#define MAX_VERSIONS      8
+/** Maximum number of conditions needed to prove a single check. */
+#define MAX_GOALS         3
+
+/**
+ * The value atom + k, where atom is a node of the mode of the induction
+ * variable or NULL for the constant k. Terms are mathematical integers, not
+ * subject to wrap around.
+ */
+typedef struct term_t {
+	ir_node *atom;
+	long     k;
+} term_t;
+
+/** A fact left relation right, the relation is <, <= or ==. */
+typedef struct fact_t {
+	term_t       left;
+	ir_relation  relation;
+	term_t       right;
+	ir_node     *block; /**< the block where the fact holds or NULL */
+} fact_t;
+
+/** A condition left relation right, the relation is < or <=. */
+typedef struct goal_t {
+	term_t      left;
+	ir_relation relation;
+	term_t      right;
+} goal_t;
+
+/** A check which holds if a loop invariant condition holds. */
+typedef struct candidate_t {
+	ir_node  *cond;
+	ir_loop  *loop;    /**< the loop to version */
+	ir_mode  *mode;    /**< the mode of the terms of the goals */
+	unsigned  ok;      /**< the successor of cond staying in the loop */
+	unsigned  n_goals;
+	goal_t    goals[MAX_GOALS];
+} candidate_t;
+
+typedef struct bce_env_t {
+	ir_mode      *mode;       /**< mode of the current induction variable */
+	long          min;        /**< lower bound of mode */
+	long          max;        /**< upper bound of mode, clamped to long */
+	fact_t       *facts;      /**< facts known at the current check */
+	candidate_t  *candidates; /**< the checks which may be hoisted */
+	ir_nodeset_t  versioned;  /**< checks of fallback loops */
+	unsigned      n_folded;
+} bce_env_t;
+
+static bool loop_contains(const ir_loop *loop, const ir_loop *inner)
+{
+	if (inner == NULL)
+		return false;
+	unsigned const depth = get_loop_depth(loop);
+	while (get_loop_depth(inner) > depth)
+		inner = get_loop_outer_loop(inner);
+	return inner == loop;
+}
+
+static bool is_in_loop(const ir_node *node, const ir_loop *loop)
+{
+	return loop_contains(loop, get_irn_loop(get_block_const(node)));
+}
+
+/** Computes *result = a + b, returns false on overflow. */
+static bool add_long(long a, long b, long *result)
+{
+	if ((b > 0 && a > LONG_MAX - b) || (b < 0 && a < LONG_MIN - b))
+		return false;
+	*result = a + b;
+	return true;
+}
+
+/** Returns the value of @p tv converted to @p mode in @p value. */
+static bool get_long_value(ir_tarval *tv, ir_mode *mode, long *value)
+{
+	tv = tarval_convert_to(tv, mode);
+	if (tv == tarval_bad || !tarval_is_long(tv))
+		return false;
+	long const result = get_tarval_long(tv);
+	/* unsigned values beyond LONG_MAX */
+	if (!mode_is_signed(mode) && result < 0)
+		return false;
+	*value = result;
+	return true;
+}
+
+static bool is_same_size_int(const ir_node *node, const ir_mode *mode)
+{
+	ir_mode *const node_mode = get_irn_mode(node);
+	return mode_is_int(node_mode)
+	    && get_mode_size_bits(node_mode) == get_mode_size_bits(mode);
+}
+
+/** Sets the mode of the terms and its bounds. */
+static void set_mode(bce_env_t *env, ir_mode *mode)
+{
+	env->mode = mode;
+	env->min  = mode_is_signed(mode) ? get_tarval_long(get_mode_min(mode)) : 0;
+	if (!get_long_value(get_mode_max(mode), mode, &env->max))
+		env->max = LONG_MAX;
+	ARR_SHRINKLEN(env->facts, 0);
+}
+
+static void add_fact(bce_env_t *env, term_t left, ir_relation relation,
+                     term_t right, ir_node *block);
+
+/**
+ * Strips Confirms and Convs not changing the bits of @p node and records the
+ * facts of the Confirms.
+ */
+static ir_node *skip_value(bce_env_t *env, ir_node *node, unsigned depth);
+
+static bool get_term(bce_env_t *env, ir_node *node, unsigned depth,
+                     term_t *term)
+{
+	node = skip_value(env, node, depth);
+	if (is_Const(node)) {
+		term->atom = NULL;
+		return get_long_value(get_Const_tarval(node), env->mode, &term->k);
+	}
+	if (get_irn_mode(node) != env->mode)
+		return false;
+	term->atom = node;
+	term->k    = 0;
+	return true;
+}
+
+static ir_node *skip_value(bce_env_t *env, ir_node *node, unsigned depth)
+{
+	for (;;) {
+		if (is_Confirm(node)) {
+			ir_node *const value = get_Confirm_value(node);
+			term_t         left;
+			term_t         right;
+			if (depth < 2 && get_irn_mode(node) == env->mode
+			    && get_term(env, value, depth + 1, &left)
+			    && get_term(env, get_Confirm_bound(node), depth + 1, &right))
+				add_fact(env, left, get_Confirm_relation(node), right, NULL);
+			node = value;
+		} else if (is_Conv(node) && is_same_size_int(node, env->mode)
+		           && is_same_size_int(get_Conv_op(node), env->mode)) {
+			node = get_Conv_op(node);
+		} else {
+			return node;
+		}
+	}
+}
+
+static void add_fact(bce_env_t *env, term_t left, ir_relation relation,
+                     term_t right, ir_node *block)
+{
+	relation &= ~ir_relation_unordered;
+	if (relation == ir_relation_greater
+	    || relation == ir_relation_greater_equal) {
+		term_t const tmp = left;
+		left     = right;
+		right    = tmp;
+		relation = get_inversed_relation(relation);
+	} else if (relation != ir_relation_less
+	           && relation != ir_relation_less_equal
+	           && relation != ir_relation_equal) {
+		return;
+	}
+	fact_t const fact = { left, relation, right, block };
+	ARR_APP1(fact_t, env->facts, fact);
+	if (relation == ir_relation_equal) {
+		fact_t const reversed = { right, relation, left, block };
+		ARR_APP1(fact_t, env->facts, reversed);
+	}
+}
+
+/** Records the facts of the Conds deciding whether @p block is reached. */
+static void collect_facts(bce_env_t *env, ir_node *block)
+{
+	unsigned depth = 0;
+	for (; block != NULL && depth < MAX_DOM_DEPTH;
+	     block = get_Block_idom(block), ++depth) {
+		if (get_Block_n_cfgpreds(block) != 1)
+			continue;
+		ir_node *const pred = get_Block_cfgpred(block, 0);
+		if (!is_Proj(pred) || !is_Cond(get_Proj_pred(pred)))
+			continue;
+		ir_node *const cond = get_Proj_pred(pred);
+		ir_node *const cmp  = get_Cond_selector(cond);
+		if (!is_Cmp(cmp) || get_irn_mode(get_Cmp_left(cmp)) != env->mode)
+			continue;
+		ir_relation relation = get_Cmp_relation(cmp);
+		if (get_Proj_num(pred) == pn_Cond_false)
+			relation = get_negated_relation(relation);
+		term_t left;
+		term_t right;
+		if (get_term(env, get_Cmp_left(cmp), 0, &left)
+		    && get_term(env, get_Cmp_right(cmp), 0, &right))
+			add_fact(env, left, relation, right, block);
+	}
+}
+
+/** Computes the range of values of @p atom known from the facts. */
+static void get_range(bce_env_t const *env, ir_node *atom, long *min,
+                      long *max)
+{
+	if (atom == NULL) {
+		*min = 0;
+		*max = 0;
+		return;
+	}
+	*min = env->min;
+	*max = env->max;
+	vrp_attr const *const vrp = vrp_get_info(atom);
+	long                  value;
+	if (vrp != NULL && vrp->range_type == VRP_RANGE) {
+		if (get_long_value(vrp->range_bottom, env->mode, &value))
+			*min = MAX(*min, value);
+		if (get_long_value(vrp->range_top, env->mode, &value))
+			*max = MIN(*max, value);
+	}
+	for (size_t i = 0, n = ARR_LEN(env->facts); i < n; ++i) {
+		fact_t const *const fact = &env->facts[i];
+		if (fact->left.atom == atom && fact->right.atom == NULL) {
+			/* atom + l relation r */
+			if (!add_long(fact->right.k, -fact->left.k, &value)
+			    || (fact->relation == ir_relation_less
+			        && !add_long(value, -1, &value)))
+				continue;
+			*max = MIN(*max, value);
+			if (fact->relation == ir_relation_equal)
+				*min = MAX(*min, value);
+		} else if (fact->left.atom == NULL && fact->right.atom == atom
+		           && fact->relation != ir_relation_equal) {
+			/* l relation atom + r */
+			if (!add_long(fact->left.k, -fact->right.k, &value)
+			    || (fact->relation == ir_relation_less
+			        && !add_long(value, 1, &value)))
+				continue;
+			*min = MAX(*min, value);
+		}
+	}
+}
+
+/** Checks whether a relation b holds for the constants a and b. */
+static bool holds(long a, ir_relation relation, long b)
+{
+	return relation == ir_relation_less ? a < b : a <= b;
+}
+
+/** Checks whether the goal follows from the known facts. */
+static bool prove(bce_env_t const *env, goal_t const *goal)
+{
+	term_t      const a        = goal->left;
+	term_t      const b        = goal->right;
+	ir_relation const relation = goal->relation;
+	if (a.atom == b.atom)
+		return holds(a.k, relation, b.k);
+
+	long a_min, a_max, b_min, b_max;
+	long left, right;
+	get_range(env, a.atom, &a_min, &a_max);
+	get_range(env, b.atom, &b_min, &b_max);
+	if (add_long(a_max, a.k, &left) && add_long(b_min, b.k, &right)
+	    && holds(left, relation, right))
+		return true;
+
+	for (size_t i = 0, n = ARR_LEN(env->facts); i < n; ++i) {
+		fact_t const *const fact = &env->facts[i];
+		if (fact->left.atom != a.atom || fact->right.atom != b.atom)
+			continue;
+		/* the fact is a + a.k relation b + m */
+		long m;
+		if (!add_long(fact->right.k, -fact->left.k, &m)
+		    || !add_long(m, a.k, &m))
+			continue;
+		if (fact->relation == ir_relation_less ? m <= b.k
+		                                       : holds(m, relation, b.k))
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Returns the node to which @p node adds constants, skipping Confirms and
+ * Convs between modes of the size of @p mode.
+ */
+static ir_node *get_iv_base(ir_node *node, ir_mode *mode)
+{
+	for (;;) {
+		if (is_Confirm(node)) {
+			node = get_Confirm_value(node);
+		} else if ((is_Conv(node) && is_same_size_int(get_Conv_op(node), mode))
+		           || ((is_Add(node) || is_Sub(node))
+		               && is_Const(get_binop_right(node)))) {
+			node = get_irn_n(node, 0);
+		} else {
+			return node;
+		}
+	}
+}
+
+/**
+ * Returns the induction variable of which @p node is the value plus a
+ * constant @p offset or NULL.
+ */
+static scev_t const *get_iv_offset(bce_env_t *env, ir_node *node,
+                                   long *offset)
+{
+	*offset = 0;
+	for (;;) {
+		node = skip_value(env, node, 0);
+		if (!is_Add(node) && !is_Sub(node))
+			break;
+		ir_node *const right = get_binop_right(node);
+		long           value;
+		if (!is_Const(right)
+		    || !get_long_value(get_Const_tarval(right), env->mode, &value)
+		    || labs(value) > MAX_OFFSET)
+			return NULL;
+		*offset += is_Add(node) ? value : -value;
+		if (labs(*offset) > MAX_OFFSET)
+			return NULL;
+		node = get_binop_left(node);
+	}
+	if (!is_Phi(node) || get_irn_mode(node) != env->mode)
+		return NULL;
+	return scev_get_phi(node);
+}
+
+/** Checks whether @p block dominates all backedges of @p loop. */
+static bool dominates_backedges(ir_node *block, ir_node *header,
+                                const ir_loop *loop)
+{
+	for (int i = 0, n = get_Block_n_cfgpreds(header); i < n; ++i) {
+		ir_node *const pred = get_Block_cfgpred_block(header, i);
+		if (pred != NULL && is_in_loop(pred, loop)
+		    && !block_dominates(block, pred))
+			return false;
+	}
+	return true;
+}
+
+/**
+ * Computes the range [@p lo, @p hi] of the value of the induction variable
+ * @p iv in the current iteration from a test of the loop against a bound.
+ */
+static bool get_iv_range(bce_env_t *env, scev_t const *iv, term_t *lo,
+                         term_t *hi)
+{
+	long step;
+	if (iv->step_tv == tarval_unknown
+	    || !get_long_value(iv->step_tv, env->mode, &step)
+	    || (step != 1 && (!mode_is_signed(env->mode) || step != -1)))
+		return false;
+	term_t start;
+	if (!get_term(env, iv->start, 0, &start))
+		return false;
+
+	ir_node *const header = get_nodes_block(iv->phi);
+	for (size_t i = 0, n = ARR_LEN(env->facts); i < n; ++i) {
+		fact_t const *const fact = &env->facts[i];
+		/* the test has to pass before every increment */
+		if (fact->block == NULL || !is_in_loop(fact->block, iv->loop)
+		    || !dominates_backedges(fact->block, header, iv->loop))
+			continue;
+		term_t const max = { NULL, env->max };
+		term_t const min = { NULL, env->min };
+		term_t       bound;
+		if (step > 0 && fact->left.atom == iv->phi && fact->left.k == 0) {
+			bound = fact->right;
+			if (fact->relation == ir_relation_less) {
+				if (!add_long(bound.k, -1, &bound.k))
+					continue;
+			} else {
+				/* the increment of the bound must not wrap */
+				goal_t const goal = { bound, ir_relation_less, max };
+				if (fact->relation != ir_relation_less_equal
+				    || !prove(env, &goal))
+					continue;
+			}
+			*lo = start;
+			*hi = bound;
+			return true;
+		} else if (step < 0 && fact->right.atom == iv->phi
+		           && fact->right.k == 0) {
+			bound = fact->left;
+			if (fact->relation == ir_relation_less) {
+				if (!add_long(bound.k, 1, &bound.k))
+					continue;
+			} else {
+				goal_t const goal = { min, ir_relation_less, bound };
+				if (fact->relation != ir_relation_less_equal
+				    || !prove(env, &goal))
+					continue;
+			}
+			*lo = bound;
+			*hi = start;
+			return true;
+		}
+	}
+	return false;
+}
+
+/** Returns @p term plus @p offset. */
+static bool add_offset(term_t term, long offset, term_t *result)
+{
+	result->atom = term.atom;
+	return add_long(term.k, offset, &result->k);
+}
+
+/**
+ * Computes the conditions under which the value in [@p lo, @p hi] is always
+ * in relation @p relation to @p other. Returns their number or 0 if the
+ * relation is not supported.
+ */
+static unsigned get_goals(bce_env_t const *env, ir_relation relation,
+                          bool is_unsigned, term_t lo, term_t hi,
+                          term_t other, goal_t *goals)
+{
+	term_t const zero = { NULL, 0 };
+	term_t const min  = { NULL, env->min };
+	term_t const max  = { NULL, env->max };
+	unsigned     n    = 0;
+	relation &= ~ir_relation_unordered;
+	switch (relation) {
+	case ir_relation_less:
+	case ir_relation_less_equal:
+		if (is_unsigned) {
+			/* a non-negative signed value is the same unsigned */
+			goals[n++] = (goal_t){ zero, ir_relation_less_equal, lo };
+		} else {
+			goals[n++] = (goal_t){ min, ir_relation_less_equal, lo };
+		}
+		goals[n++] = (goal_t){ hi, relation, other };
+		return n;
+	case ir_relation_greater:
+	case ir_relation_greater_equal:
+		if (is_unsigned)
+			goals[n++] = (goal_t){ zero, ir_relation_less_equal, other };
+		goals[n++] = (goal_t){ other, get_inversed_relation(relation), lo };
+		goals[n++] = (goal_t){ hi, ir_relation_less_equal, max };
+		return n;
+	default:
+		return 0;
+	}
+}
+
+/** Returns the successor of @p cond with number @p pn. */
+static ir_node *get_cond_succ(ir_node *cond, unsigned pn)
+{
+	foreach_out_edge(cond, edge) {
+		ir_node *const proj = get_edge_src_irn(edge);
+		if (get_Proj_num(proj) != pn)
+			continue;
+		foreach_out_edge(proj, succ_edge) {
+			return get_edge_src_irn(succ_edge);
+		}
+	}
+	return NULL;
+}
+
+/** Replaces @p cond by a jump to its successor @p pn. */
+static void fold_cond(ir_node *cond, unsigned pn)
+{
+	ir_node  *const block = get_nodes_block(cond);
+	ir_graph *const irg   = get_irn_irg(cond);
+	foreach_out_edge_safe(cond, edge) {
+		ir_node *const proj = get_edge_src_irn(edge);
+		if (get_Proj_num(proj) == pn)
+			exchange(proj, new_r_Jmp(block));
+		else
+			exchange(proj, new_r_Bad(irg, mode_X));
+	}
+}
+
+/** Checks whether the atoms of @p goal are defined outside of @p loop. */
+static bool is_invariant_goal(goal_t const *goal, const ir_loop *loop)
+{
+	return (goal->left.atom == NULL || !is_in_loop(goal->left.atom, loop))
+	    && (goal->right.atom == NULL || !is_in_loop(goal->right.atom, loop));
+}
+
+/**
+ * Tries to prove the check @p cond comparing @p iv plus @p offset with
+ * @p other. Folds the check or records it as candidate for hoisting.
+ */
+static void analyze_check(bce_env_t *env, ir_node *cond, scev_t const *iv,
+                          long offset, ir_relation relation, ir_node *other,
+                          bool is_unsigned)
+{
+	term_t lo;
+	term_t hi;
+	term_t value;
+	if (!get_term(env, other, 0, &value)
+	    || !get_iv_range(env, iv, &lo, &hi)
+	    || !add_offset(lo, offset, &lo) || !add_offset(hi, offset, &hi))
+		return;
+
+	for (unsigned pn = pn_Cond_false; pn <= pn_Cond_true; ++pn) {
+		ir_relation const rel = pn == pn_Cond_true ? relation
+			: get_negated_relation(relation);
+		goal_t         goals[MAX_GOALS];
+		unsigned const n_goals = get_goals(env, rel, is_unsigned, lo, hi,
+		                                   value, goals);
+		if (n_goals == 0)
+			continue;
+
+		candidate_t candidate = {
+			.cond    = cond,
+			.loop    = iv->loop,
+			.mode    = env->mode,
+			.ok      = pn,
+			.n_goals = 0,
+		};
+		bool invariant = true;
+		for (unsigned i = 0; i < n_goals; ++i) {
+			if (prove(env, &goals[i]))
+				continue;
+			candidate.goals[candidate.n_goals++] = goals[i];
+			invariant &= is_invariant_goal(&goals[i], iv->loop);
+		}
+		if (candidate.n_goals == 0) {
+			DB((dbg, LEVEL_2, "  %+F always takes %s\n", cond,
+			    pn == pn_Cond_true ? "true" : "false"));
+			fold_cond(cond, pn);
+			++env->n_folded;
+			return;
+		}
+
+		/* only hoist checks whose failing successor leaves the loop */
+		ir_node *const ok   = get_cond_succ(cond, pn);
+		ir_node *const fail = get_cond_succ(cond, pn ^ 1);
+		if (invariant && ok != NULL && fail != NULL
+		    && is_in_loop(ok, iv->loop) && !is_in_loop(fail, iv->loop)
+		    && !ir_nodeset_contains(&env->versioned, cond))
+			ARR_APP1(candidate_t, env->candidates, candidate);
+	}
+}
+
+static void collect_check(ir_node *node, void *data)
+{
+	bce_env_t *const env = (bce_env_t*)data;
+	if (!is_Cond(node))
+		return;
+	ir_node *const cmp = get_Cond_selector(node);
+	if (!is_Cmp(cmp))
+		return;
+	ir_node *const block = get_nodes_block(node);
+	ir_loop *const loop  = get_irn_loop(block);
+	if (loop == NULL || get_loop_depth(loop) == 0)
+		return;
+
+	ir_node     *left     = get_Cmp_left(cmp);
+	ir_node     *right    = get_Cmp_right(cmp);
+	ir_relation  relation = get_Cmp_relation(cmp);
+	ir_mode     *cmp_mode = get_irn_mode(left);
+	if (!mode_is_int(cmp_mode))
+		return;
+	for (unsigned i = 0; i < 2; ++i) {
+		if (i > 0) {
+			ir_node *const tmp = left;
+			left     = right;
+			right    = tmp;
+			relation = get_inversed_relation(relation);
+		}
+		/* the induction variable may have another signedness */
+		ir_node *const base = get_iv_base(left, cmp_mode);
+		if (!is_Phi(base) || !is_same_size_int(base, cmp_mode))
+			continue;
+		set_mode(env, get_irn_mode(base));
+		long                offset;
+		scev_t const *const iv = get_iv_offset(env, left, &offset);
+		if (iv == NULL || !loop_contains(iv->loop, loop))
+			continue;
+
+		/* an unsigned comparison of a signed value is a range check */
+		ir_mode *const mode        = env->mode;
+		bool     const is_unsigned = mode != cmp_mode;
+		if (is_unsigned
+		    && (!mode_is_signed(mode) || mode_is_signed(cmp_mode)))
+			continue;
+
+		collect_facts(env, block);
+		analyze_check(env, node, iv, offset, relation, right, is_unsigned);
+		return;
+	}
+}
+
+/** Creates a node computing the value of @p goal in @p block. */
+static ir_node *create_goal(bce_env_t const *env, ir_node *block,
+                            goal_t const *goal)
+{
+	ir_graph   *const irg      = get_irn_irg(block);
+	ir_mode    *const mode     = env->mode;
+	ir_relation const relation = goal->relation;
+	ir_node    *const a        = goal->left.atom;
+	ir_node    *const b        = goal->right.atom;
+	long              delta;
+	if ((a == NULL && b == NULL)
+	    || !add_long(goal->right.k, -goal->left.k, &delta))
+		return NULL;
+	if (a == NULL || b == NULL) {
+		/* compare the atom with a constant of its mode */
+		if (a == NULL && (delta == LONG_MIN || !add_long(0, -delta, &delta)))
+			return NULL;
+		if (delta < env->min || delta > env->max)
+			return NULL;
+		ir_node *const c = new_r_Const_long(irg, mode, delta);
+		return a != NULL ? new_r_Cmp(block, a, c, relation)
+		                 : new_r_Cmp(block, b, c,
+		                             get_inversed_relation(relation));
+	}
+	if (relation == ir_relation_less && delta == 1)
+		return new_r_Cmp(block, a, b, ir_relation_less_equal);
+	if (delta == 0)
+		return new_r_Cmp(block, a, b, relation);
+	if (delta == LONG_MIN || labs(delta) > MAX_OFFSET)
+		return NULL;
+
+	/* compute b + delta, which must not wrap */
+	ir_node *guard;
+	ir_node *sum;
+	ir_node *const c = new_r_Const_long(irg, mode, labs(delta));
+	if (delta > 0) {
+		ir_node *const limit = new_r_Const_long(irg, mode, env->max - delta);
+		guard = new_r_Cmp(block, b, limit, ir_relation_less_equal);
+		sum   = new_r_Add(block, b, c);
+	} else {
+		ir_node *const limit = new_r_Const_long(irg, mode, env->min - delta);
+		guard = new_r_Cmp(block, b, limit, ir_relation_greater_equal);
+		sum   = new_r_Sub(block, b, c);
+	}
+	return new_r_And(block, guard, new_r_Cmp(block, a, sum, relation));
+}
+
+/**
+ * Versions @p loop on the conditions of its candidates. Returns the number
+ * of copied nodes or 0.
+ */
+static unsigned hoist_checks(bce_env_t *env, ir_loop *loop, unsigned budget)
+{
+	candidate_t *const candidates = env->candidates;
+	ir_node           *block      = NULL;
+	ir_node           *selector   = NULL;
+	unsigned           n_goals    = 0;
+	bool              *hoisted    = ALLOCANZ(bool, ARR_LEN(candidates));
+	for (size_t i = 0, n = ARR_LEN(candidates); i < n; ++i) {
+		candidate_t const *const candidate = &candidates[i];
+		if (candidate->loop != loop
+		    || n_goals + candidate->n_goals > MAX_CONDITIONS)
+			continue;
+		if (block == NULL)
+			block = get_nodes_block(candidate->cond);
+		set_mode(env, candidate->mode);
+
+		ir_node *conds = NULL;
+		for (unsigned j = 0; j < candidate->n_goals; ++j) {
+			ir_node *const goal = create_goal(env, block,
+			                                  &candidate->goals[j]);
+			if (goal == NULL) {
+				conds = NULL;
+				break;
+			}
+			conds = conds == NULL ? goal : new_r_And(block, conds, goal);
+		}
+		if (conds == NULL)
+			continue;
+		selector = selector == NULL ? conds
+		                            : new_r_And(block, selector, conds);
+		n_goals   += candidate->n_goals;
+		hoisted[i] = true;
+	}
+	if (selector == NULL)
+		return 0;
+
+	ir_nodemap map;
+	ir_nodemap_init(&map, get_irn_irg(block));
+	unsigned const size = version_loop(loop, selector,
+	                                   MIN(budget, MAX_LOOP_NODES), &map);
+	if (size > 0) {
+		/* the original loop is entered if all checks succeed */
+		for (size_t i = 0, n = ARR_LEN(candidates); i < n; ++i) {
+			if (!hoisted[i])
+				continue;
+			ir_node *const cond = candidates[i].cond;
+			DB((dbg, LEVEL_2, "  hoisted %+F from loop %ld\n", cond,
+			    get_loop_loop_nr(loop)));
+			ir_nodeset_insert(&env->versioned,
+			                  ir_nodemap_get(ir_node, &map, cond));
+			fold_cond(cond, candidates[i].ok);
+		}
+	}
+	ir_nodemap_destroy(&map);
+	return size;
+}
+
+/** Versions one loop with candidates. Returns the number of copied nodes. */
+static unsigned hoist_any_checks(bce_env_t *env, unsigned budget)
+{
+	candidate_t *const candidates = env->candidates;
+	for (size_t i = 0, n = ARR_LEN(candidates); i < n; ++i) {
+		ir_loop *const loop = candidates[i].loop;
+		bool           tried = false;
+		for (size_t j = 0; j < i; ++j)
+			tried |= candidates[j].loop == loop;
+		if (tried)
+			continue;
+		unsigned const size = hoist_checks(env, loop, budget);
+		if (size > 0)
+			return size;
+	}
+	return 0;
+}
+
+void opt_bounds_checks(ir_graph *irg)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.opt.bounds_check");
+	DB((dbg, LEVEL_1, "bounds check elimination on %+F\n", irg));
+
+	bce_env_t env = {
+		.facts = NEW_ARR_F(fact_t, 0),
+	};
+	ir_nodeset_init(&env.versioned);
+	unsigned budget     = get_irg_last_idx(irg) * MAX_GROWTH / 100;
+	unsigned n_versions = 0;
+	bool     changed    = false;
+	for (;;) {
+		assure_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES
+			| IR_GRAPH_PROPERTY_NO_BADS
+			| IR_GRAPH_PROPERTY_NO_UNREACHABLE_CODE
+			| IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE
+			| IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO);
+
+		env.candidates = NEW_ARR_F(candidate_t, 0);
+		env.n_folded   = 0;
+		irg_walk_graph(irg, NULL, collect_check, &env);
+
+		/* folding invalidates the analyses, retry before hoisting */
+		unsigned size = 0;
+		if (env.n_folded == 0 && ARR_LEN(env.candidates) > 0
+		    && n_versions < MAX_VERSIONS)
+			size = hoist_any_checks(&env, budget);
+		DEL_ARR_F(env.candidates);
+
+		if (env.n_folded == 0 && size == 0)
+			break;
+		budget    -= size;
+		n_versions += size > 0;
+		changed    = true;
+		confirm_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES);
+	}
+	ir_nodeset_destroy(&env.versioned);
+	DEL_ARR_F(env.facts);
+
+	confirm_irg_properties(irg, changed ? IR_GRAPH_PROPERTIES_NONE
+	                                    : IR_GRAPH_PROPERTIES_ALL);
+}
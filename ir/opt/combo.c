@@ -43,6 +43,7 @@
 #include "pmap.h"
 #include "set.h"
 #include "tv_t.h"
+#include "vrp.h"
 #include <assert.h>
 
 /* define this to check that all type translations are monotone */
@@ -2233,6 +2234,16 @@ static void compute_Proj(node_t *node)
 		}
 	}
 
+	ir_graph *irg = get_irn_irg(proj);
+	if (pred == get_irg_args(irg)) {
+		/* arguments may be constant at all call sites */
+		const vrp_attr *param = vrp_get_param_info(irg, get_Proj_num(proj));
+		if (param != NULL && param->bits_set == param->bits_not_set) {
+			node->type.tv = param->bits_set;
+			return;
+		}
+	}
+
 	node_t *pred_node = get_irn_node(pred);
 	if (pred_node->type.tv == tarval_bottom) {
 		/* if the predecessor is Bottom, its Proj follow */
@@ -10,6 +10,7 @@
  *           Michael Beck
  */
 #include "ircons.h"
+#include "irgmod.h"
 #include "irgopt.h"
 #include "irgwalk.h"
 #include "irnode_t.h"
@@ -64,12 +65,8 @@ static void walk_critical_cf_edges(ir_node *block, void *env)
 			/* Predecessor has multiple successors. Insert new control flow
 			 * edge edges. */
 insert:;
-			/* set predecessor of new block */
-			ir_node *new_block = new_r_Block(irg, 1, &pre);
-			/* insert new jmp node to new block */
-			ir_node *jmp = new_r_Jmp(new_block);
-			/* set successor of new block */
-			set_irn_n(block, i, jmp);
+			/* insert a new block containing only a jump */
+			split_cf_edge(block, i);
 			cenv->changed = true;
 		}
 	}
@@ -83,10 +80,14 @@ void remove_critical_cf_edges_ex(ir_graph *irg, int ignore_exception_edges)
 
 	irg_block_walk_graph(irg, NULL, walk_critical_cf_edges, &env);
 	if (env.changed) {
-		/* control flow changed */
+		/* control flow changed, split_cf_edge() keeps the (post)dominance
+		 * and loop information consistent */
 		clear_irg_properties(irg, IR_GRAPH_PROPERTIES_ALL
 			& ~(IR_GRAPH_PROPERTY_ONE_RETURN
-				| IR_GRAPH_PROPERTY_MANY_RETURNS));
+				| IR_GRAPH_PROPERTY_MANY_RETURNS
+				| IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE
+				| IR_GRAPH_PROPERTY_CONSISTENT_POSTDOMINANCE
+				| IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO));
 	}
 	add_irg_properties(irg, IR_GRAPH_PROPERTY_NO_CRITICAL_EDGES);
 }
@@ -81,7 +81,12 @@ void dead_node_elimination(ir_graph *irg)
 	free_irg_outs(irg);
 	free_loop_information(irg);
 	free_vrp_data(irg);
-	clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE);
+	/* points-to information and the alias cache are indexed by node index,
+	 * scalar evolution refers to the old nodes */
+	clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE
+	                        | IR_GRAPH_PROPERTY_CONSISTENT_POINTS_TO
+	                        | IR_GRAPH_PROPERTY_CONSISTENT_ALIAS_CACHE
+	                        | IR_GRAPH_PROPERTY_CONSISTENT_SCEV);
 
 	/* A quiet place, where the old obstack can rest in peace,
 	   until it will be cremated. */
@@ -0,0 +1,324 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2017 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Escape analysis and heap to stack conversion.
+ *
+ * An object allocated by an Alloc or a call of malloc with constant size
+ * does not escape if its address is only used to access memory, compared,
+ * freed or passed to callees in which it does not escape either. Such an
+ * object cannot outlive the current invocation: its address neither reaches
+ * memory, a Phi nor a Return. It is replaced by a frame entity, the
+ * corresponding free calls are removed and scalar replacement is run on the
+ * new entities afterwards.
+ *
+ * An allocation inside a loop reuses the frame entity in every iteration,
+ * which is fine since the object of an earlier iteration cannot be
+ * referenced anymore.
+ */
+#include "array.h"
+#include "debug.h"
+#include "entity_t.h"
+#include "ircons.h"
+#include "irgmod.h"
+#include "irgraph_t.h"
+#include "irgwalk.h"
+#include "irnode_t.h"
+#include "iroptimize.h"
+#include "irouts_t.h"
+#include "tv.h"
+#include "type_t.h"
+#include "util.h"
+
+/** Maximum size of an object moved to the frame. */
+#define MAX_OBJECT_SIZE     256
+/** Maximum depth of callees analyzed for escaping parameters. */
+#define MAX_CALLEE_DEPTH    2
+/** Alignment of objects returned by malloc. */
+#define MALLOC_ALIGNMENT    16
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg;)
+
+/** An allocation which may be moved to the frame. */
+typedef struct allocation_t {
+	ir_node  *node;  /**< the Alloc or Call */
+	ir_node  *res;   /**< the address of the object */
+	unsigned  size;
+	unsigned  align;
+	ir_node **frees; /**< calls of free for the object */
+} allocation_t;
+
+typedef struct h2s_env_t {
+	ident         *malloc_id;
+	ident         *free_id;
+	allocation_t **allocations;
+} h2s_env_t;
+
+/** Returns the tuple Proj @p num of @p node or NULL. */
+static ir_node *find_proj(const ir_node *node, unsigned num)
+{
+	foreach_irn_out_r(node, i, succ) {
+		if (is_Proj(succ) && get_Proj_num(succ) == num)
+			return succ;
+	}
+	return NULL;
+}
+
+/** Checks whether @p call calls the function named @p id. */
+static bool calls(const ir_node *call, ident *id)
+{
+	ir_entity const *const callee = get_Call_callee(call);
+	return callee != NULL && get_entity_ident(callee) == id;
+}
+
+static bool is_escaping(h2s_env_t *env, ir_node *ptr, allocation_t *alloc,
+                        unsigned depth);
+
+/**
+ * Checks whether the address passed as parameter @p pos to @p call
+ * escapes in the callee.
+ */
+static bool escapes_in_callee(h2s_env_t *env, const ir_node *call,
+                              size_t pos, unsigned depth)
+{
+	ir_entity *const callee = get_Call_callee(call);
+	if (callee == NULL || depth >= MAX_CALLEE_DEPTH)
+		return true;
+	ir_graph *const irg = get_entity_linktime_irg(callee);
+	ir_type  *const tp  = get_entity_type(callee);
+	if (irg == NULL || pos >= get_method_n_params(tp)
+	    || is_method_variadic(tp))
+		return true;
+
+	assure_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUTS);
+	ir_node *const param = find_proj(get_irg_args(irg), pos);
+	/* an unused parameter does not escape */
+	return param != NULL && is_escaping(env, param, NULL, depth + 1);
+}
+
+/**
+ * Checks whether the object addressed by @p ptr escapes. Calls of free for
+ * the object are collected in @p alloc, inside callees (@p alloc is NULL)
+ * they let the object escape.
+ */
+static bool is_escaping(h2s_env_t *env, ir_node *ptr, allocation_t *alloc,
+                        unsigned depth)
+{
+	foreach_irn_out_r(ptr, i, succ) {
+		switch (get_irn_opcode(succ)) {
+		case iro_Load:
+		case iro_CopyB:
+		case iro_Cmp:
+			continue;
+		case iro_Store:
+			if (get_Store_value(succ) == ptr)
+				return true;
+			continue;
+		case iro_Member:
+		case iro_Sel:
+			if (is_escaping(env, succ, alloc, depth))
+				return true;
+			continue;
+		case iro_Add:
+		case iro_Sub:
+			if (!mode_is_reference(get_irn_mode(succ)))
+				return true;
+			if (is_escaping(env, succ, alloc, depth))
+				return true;
+			continue;
+		case iro_Call: {
+			if (get_Call_ptr(succ) == ptr)
+				return true;
+			/* free needs the start address of the object */
+			if (alloc != NULL && calls(succ, env->free_id)
+			    && get_Call_n_params(succ) == 1 && ptr == alloc->res) {
+				ARR_APP1(ir_node*, alloc->frees, succ);
+				continue;
+			}
+			for (int p = 0, n = get_Call_n_params(succ); p < n; ++p) {
+				if (get_Call_param(succ, p) == ptr
+				    && escapes_in_callee(env, succ, p, depth))
+					return true;
+			}
+			continue;
+		}
+		default:
+			DB((dbg, LEVEL_3, "  %+F escapes at %+F\n", ptr, succ));
+			return true;
+		}
+	}
+	return false;
+}
+
+/** Returns the size of the object allocated by @p node or 0. */
+static unsigned get_allocation_size(h2s_env_t *env, const ir_node *node)
+{
+	ir_node *size;
+	if (is_Alloc(node)) {
+		size = get_Alloc_size(node);
+	} else if (is_Call(node) && calls(node, env->malloc_id)
+	           && get_Call_n_params(node) == 1) {
+		ir_entity const *const callee = get_Call_callee(node);
+		if (!(get_entity_additional_properties(callee) & mtp_property_malloc))
+			return 0;
+		size = get_Call_param(node, 0);
+	} else {
+		return 0;
+	}
+	if (!is_Const(size) || !tarval_is_long(get_Const_tarval(size)))
+		return 0;
+	long const value = get_Const_long(size);
+	return value > 0 && value <= MAX_OBJECT_SIZE ? (unsigned)value : 0;
+}
+
+static void find_allocations(ir_node *node, void *data)
+{
+	h2s_env_t *env  = (h2s_env_t*)data;
+	unsigned   size = get_allocation_size(env, node);
+	if (size == 0)
+		return;
+
+	ir_node *res;
+	if (is_Alloc(node)) {
+		res = find_proj(node, pn_Alloc_res);
+	} else {
+		ir_node *const results = find_proj(node, pn_Call_T_result);
+		res = results != NULL ? find_proj(results, 0) : NULL;
+	}
+	if (res == NULL)
+		return;
+
+	allocation_t *alloc = XMALLOCZ(allocation_t);
+	alloc->node  = node;
+	alloc->res   = res;
+	alloc->size  = size;
+	alloc->align = is_Alloc(node) ? MAX(get_Alloc_alignment(node), 1u)
+	                              : MALLOC_ALIGNMENT;
+	alloc->frees = NEW_ARR_F(ir_node*, 0);
+	if (is_escaping(env, res, alloc, 0)) {
+		DEL_ARR_F(alloc->frees);
+		free(alloc);
+		return;
+	}
+	DB((dbg, LEVEL_2, "  %+F does not escape\n", node));
+	ARR_APP1(allocation_t*, env->allocations, alloc);
+}
+
+/**
+ * Returns the type of the object at @p res: the compound all accessed
+ * members belong to, the type of all Loads and Stores or a byte array.
+ */
+static ir_type *get_object_type(const allocation_t *alloc)
+{
+	ir_type *type = NULL;
+	foreach_irn_out_r(alloc->res, i, succ) {
+		ir_type *succ_type;
+		if (is_Member(succ)) {
+			succ_type = get_entity_owner(get_Member_entity(succ));
+		} else if (is_Load(succ)) {
+			succ_type = get_Load_type(succ);
+		} else if (is_Store(succ)) {
+			succ_type = get_Store_type(succ);
+		} else if (is_Call(succ) || is_Cmp(succ)) {
+			continue;
+		} else {
+			type = NULL;
+			break;
+		}
+		if (type != NULL && type != succ_type) {
+			type = NULL;
+			break;
+		}
+		type = succ_type;
+	}
+	if (type != NULL && get_type_size(type) == alloc->size
+	    && get_type_state(type) == layout_fixed && !is_Union_type(type))
+		return type;
+
+	ir_type *const bytes = new_type_array(get_type_for_mode(mode_Bu),
+	                                      alloc->size);
+	set_type_alignment(bytes, alloc->align);
+	return bytes;
+}
+
+/** Removes the memory operation @p node, which has no other results. */
+static void remove_memop(ir_node *node, ir_node *mem, unsigned pn_M,
+                         unsigned pn_X_regular, unsigned pn_X_except)
+{
+	ir_node *const proj_M = find_proj(node, pn_M);
+	if (proj_M != NULL)
+		exchange(proj_M, mem);
+	ir_node *const proj_regular = find_proj(node, pn_X_regular);
+	if (proj_regular != NULL)
+		exchange(proj_regular, new_r_Jmp(get_nodes_block(node)));
+	ir_node *const proj_except = find_proj(node, pn_X_except);
+	if (proj_except != NULL)
+		exchange(proj_except, new_r_Bad(get_irn_irg(node), mode_X));
+	kill_node(node);
+}
+
+/** Replaces the allocation @p alloc by a frame entity. */
+static void move_to_frame(ir_graph *irg, allocation_t *alloc)
+{
+	ir_type   *const frame  = get_irg_frame_type(irg);
+	ir_type   *const type   = get_object_type(alloc);
+	ir_entity *const entity = new_entity(frame, id_unique("heap_obj"), type);
+	DB((dbg, LEVEL_1, "  moving %+F to %+F\n", alloc->node, entity));
+
+	ir_node *const block  = get_irg_start_block(irg);
+	ir_node *const member = new_r_Member(block, get_irg_frame(irg), entity);
+	exchange(alloc->res, member);
+
+	ir_node *const node = alloc->node;
+	if (is_Alloc(node)) {
+		ir_node *const proj_M = find_proj(node, pn_Alloc_M);
+		if (proj_M != NULL)
+			exchange(proj_M, get_Alloc_mem(node));
+		kill_node(node);
+	} else {
+		remove_memop(node, get_Call_mem(node), pn_Call_M, pn_Call_X_regular,
+		             pn_Call_X_except);
+	}
+	for (size_t i = 0, n = ARR_LEN(alloc->frees); i < n; ++i) {
+		ir_node *const call = alloc->frees[i];
+		remove_memop(call, get_Call_mem(call), pn_Call_M, pn_Call_X_regular,
+		             pn_Call_X_except);
+	}
+}
+
+void opt_heap_to_stack(ir_graph *irg)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.opt.heap_to_stack");
+
+	assure_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUTS
+	                         | IR_GRAPH_PROPERTY_NO_TUPLES);
+
+	h2s_env_t env = {
+		.malloc_id   = new_id_from_str("malloc"),
+		.free_id     = new_id_from_str("free"),
+		.allocations = NEW_ARR_F(allocation_t*, 0),
+	};
+	DB((dbg, LEVEL_1, "heap to stack on %+F\n", irg));
+	irg_walk_graph(irg, NULL, find_allocations, &env);
+
+	/* the outs are invalid after the first transformation, so all objects
+	 * are analyzed first */
+	size_t const n = ARR_LEN(env.allocations);
+	for (size_t i = 0; i < n; ++i) {
+		allocation_t *const alloc = env.allocations[i];
+		move_to_frame(irg, alloc);
+		DEL_ARR_F(alloc->frees);
+		free(alloc);
+	}
+	DEL_ARR_F(env.allocations);
+
+	if (n == 0) {
+		confirm_irg_properties(irg, IR_GRAPH_PROPERTIES_ALL);
+		return;
+	}
+	confirm_irg_properties(irg, IR_GRAPH_PROPERTIES_NONE);
+	scalar_replacement_opt(irg);
+}
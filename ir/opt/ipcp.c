@@ -0,0 +1,471 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2012 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Interprocedural constant, known bits and value range propagation.
+ *
+ * The facts about a parameter of a method of which all calls are known are
+ * the meet of the facts about the arguments at all call sites. They are
+ * stored in the vrp information of the graph, where constbits, vrp and combo
+ * pick them up. The facts at a call site are computed by constbits in the
+ * caller, so they include the parameters of the caller and constants are
+ * passed down through several layers of methods.
+ * Results which are the same constant at all Returns are propagated back
+ * into the callers.
+ */
+#include "array.h"
+#include "constbits.h"
+#include "debug.h"
+#include "iredges_t.h"
+#include "irgmod.h"
+#include "irgraph_t.h"
+#include "irgwalk.h"
+#include "irmemory.h"
+#include "irnode_t.h"
+#include "iroptimize.h"
+#include "irprog_t.h"
+#include "irtools.h"
+#include "tv.h"
+#include "vrp.h"
+#include "xmalloc.h"
+
+/** Maximum number of passes over the whole program per propagation. */
+#define MAX_ROUNDS        8
+/** Maximum number of cloning steps. */
+#define MAX_CLONE_ROUNDS  2
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg;)
+
+typedef struct ipcp_graph_t {
+	ir_node **calls;    /**< all direct calls of the graph */
+	bool      closed;   /**< all calls of the graph are known */
+	bool      visited;  /**< used for computing the processing order */
+} ipcp_graph_t;
+
+typedef struct ipcp_env_t {
+	ipcp_graph_t  *graphs;  /**< infos indexed by graph index */
+	ir_graph     **order;   /**< graphs with callers before callees */
+	bool          *changed; /**< changed graphs indexed by graph index */
+} ipcp_env_t;
+
+static ipcp_graph_t *get_graph_info(const ipcp_env_t *env, const ir_graph *irg)
+{
+	return &env->graphs[get_irg_idx(irg)];
+}
+
+static ir_mode *get_param_mode(const ir_type *mtp, size_t pos)
+{
+	ir_mode *mode = get_type_mode(get_method_param_type(mtp, pos));
+	return mode != NULL && mode_is_int(mode) ? mode : NULL;
+}
+
+/** Walker: collects the direct calls of all graphs. */
+static void collect_calls(ir_node *node, void *ctx)
+{
+	ipcp_env_t *env = (ipcp_env_t*)ctx;
+	if (!is_Call(node))
+		return;
+	ir_entity *callee = get_Call_callee(node);
+	if (callee == NULL)
+		return;
+	ir_graph *callee_irg = get_entity_linktime_irg(callee);
+	if (callee_irg == NULL)
+		return;
+
+	ipcp_graph_t *info = get_graph_info(env, callee_irg);
+	ARR_APP1(ir_node*, info->calls, node);
+
+	/* calls not matching the method type hide the parameters */
+	ir_type *mtp      = get_entity_type(callee);
+	size_t   n_params = get_method_n_params(mtp);
+	if ((size_t)get_Call_n_params(node) != n_params) {
+		info->closed = false;
+		return;
+	}
+	for (size_t i = 0; i < n_params; ++i) {
+		ir_mode *mode = get_param_mode(mtp, i);
+		if (mode != NULL && get_irn_mode(get_Call_param(node, i)) != mode)
+			info->closed = false;
+	}
+}
+
+/** Appends @p irg to the processing order after all its callers. */
+static void add_to_order(ipcp_env_t *env, ir_graph *irg)
+{
+	ipcp_graph_t *info = get_graph_info(env, irg);
+	if (info->visited)
+		return;
+	info->visited = true;
+	for (size_t i = 0, n = ARR_LEN(info->calls); i < n; ++i)
+		add_to_order(env, get_irn_irg(info->calls[i]));
+	ARR_APP1(ir_graph*, env->order, irg);
+}
+
+static bool is_reachable(const ir_node *node)
+{
+	bitinfo const *b = get_bitinfo(get_nodes_block(node));
+	return b == NULL || b->z != tarval_b_false;
+}
+
+/**
+ * Computes the facts about the integer value @p value from the constbits
+ * information of its graph.
+ *
+ * @return false if the value is undefined
+ */
+static bool get_value_fact(const ir_node *value, vrp_attr *fact)
+{
+	ir_mode       *mode = get_irn_mode(value);
+	bitinfo const *b    = get_bitinfo(value);
+	if (b == NULL) {
+		fact->bits_set     = get_mode_null(mode);
+		fact->bits_not_set = get_mode_all_one(mode);
+	} else if (tarval_is_null(b->z) && tarval_is_all_one(b->o)) {
+		return false;
+	} else {
+		fact->bits_set     = b->o;
+		fact->bits_not_set = b->z;
+	}
+
+	ir_graph       *irg   = get_irn_irg(value);
+	const vrp_attr *param = NULL;
+	if (is_Proj(value) && get_Proj_pred(value) == get_irg_args(irg))
+		param = vrp_get_param_info(irg, get_Proj_num(value));
+
+	if (param != NULL && param->range_type == VRP_RANGE) {
+		fact->range_type   = VRP_RANGE;
+		fact->range_bottom = param->range_bottom;
+		fact->range_top    = param->range_top;
+	} else if (!mode_is_signed(mode)
+	           || tarval_is_negative(fact->bits_set)
+	              == tarval_is_negative(fact->bits_not_set)) {
+		/* with a known sign the known bits give a range */
+		fact->range_type   = VRP_RANGE;
+		fact->range_bottom = fact->bits_set;
+		fact->range_top    = fact->bits_not_set;
+	} else {
+		fact->range_type   = VRP_VARYING;
+	}
+	return true;
+}
+
+/** Combines the facts @p fact into @p res, which holds for both. */
+static void meet_fact(vrp_attr *res, const vrp_attr *fact)
+{
+	if (res->range_type == VRP_UNDEFINED) {
+		*res = *fact;
+		return;
+	}
+	res->bits_set     = tarval_and(res->bits_set, fact->bits_set);
+	res->bits_not_set = tarval_or(res->bits_not_set, fact->bits_not_set);
+	if (res->range_type == VRP_RANGE && fact->range_type == VRP_RANGE) {
+		if (tarval_cmp(fact->range_bottom, res->range_bottom) == ir_relation_less)
+			res->range_bottom = fact->range_bottom;
+		if (tarval_cmp(fact->range_top, res->range_top) == ir_relation_greater)
+			res->range_top = fact->range_top;
+	} else {
+		res->range_type = VRP_VARYING;
+	}
+}
+
+static bool is_constant_fact(const vrp_attr *fact)
+{
+	return fact->range_type != VRP_UNDEFINED
+	    && fact->bits_set == fact->bits_not_set;
+}
+
+static bool facts_equal(const vrp_attr *a, const vrp_attr *b)
+{
+	if (a->range_type != b->range_type)
+		return false;
+	if (a->range_type == VRP_UNDEFINED)
+		return true;
+	if (a->bits_set != b->bits_set || a->bits_not_set != b->bits_not_set)
+		return false;
+	return a->range_type != VRP_RANGE
+	    || (a->range_bottom == b->range_bottom && a->range_top == b->range_top);
+}
+
+/**
+ * Recomputes the facts about the parameters of @p irg from all its calls.
+ *
+ * @return true if the facts changed
+ */
+static bool update_params(ipcp_env_t *env, ir_graph *irg)
+{
+	ipcp_graph_t *info = get_graph_info(env, irg);
+	if (!info->closed)
+		return false;
+
+	ir_type  *mtp      = get_entity_type(get_irg_entity(irg));
+	size_t    n_params = get_method_n_params(mtp);
+	vrp_attr *facts    = ALLOCANZ(vrp_attr, n_params);
+	for (size_t c = 0, n_calls = ARR_LEN(info->calls); c < n_calls; ++c) {
+		ir_node *call = info->calls[c];
+		if (!is_reachable(call))
+			continue;
+		ir_graph *caller = get_irn_irg(call);
+		for (size_t i = 0; i < n_params; ++i) {
+			if (get_param_mode(mtp, i) == NULL)
+				continue;
+			ir_node *arg = get_Call_param(call, i);
+			/* passing a parameter on to itself adds no value */
+			if (caller == irg && is_Proj(arg)
+			    && get_Proj_pred(arg) == get_irg_args(irg)
+			    && get_Proj_num(arg) == i)
+				continue;
+			vrp_attr fact;
+			if (get_value_fact(arg, &fact))
+				meet_fact(&facts[i], &fact);
+		}
+	}
+
+	bool changed = false;
+	if (irg->vrp.params == NULL) {
+		irg->vrp.params     = OALLOCNZ(&irg->obst, vrp_attr, n_params);
+		irg->vrp.params_mtp = mtp;
+	}
+	for (size_t i = 0; i < n_params; ++i) {
+		vrp_attr *fact = &facts[i];
+		if (fact->range_type == VRP_VARYING && tarval_is_null(fact->bits_set)
+		    && tarval_is_all_one(fact->bits_not_set))
+			fact->range_type = VRP_UNDEFINED;
+		if (facts_equal(fact, &irg->vrp.params[i]))
+			continue;
+		DB((dbg, LEVEL_2, "%+F: parameter %zu is %T/%T\n", irg, i,
+		    fact->bits_set, fact->bits_not_set));
+		irg->vrp.params[i] = *fact;
+		changed = true;
+	}
+	return changed;
+}
+
+static void reanalyze(ir_graph *irg)
+{
+	constbits_clear(irg);
+	constbits_analyze(irg);
+}
+
+/** Propagates the parameter facts until a fixpoint is reached. */
+static void propagate_params(ipcp_env_t *env)
+{
+	for (unsigned round = 0; round < MAX_ROUNDS; ++round) {
+		bool changed = false;
+		for (size_t i = 0, n = ARR_LEN(env->order); i < n; ++i) {
+			ir_graph *irg = env->order[i];
+			if (update_params(env, irg)) {
+				reanalyze(irg);
+				changed = true;
+			}
+		}
+		if (!changed)
+			break;
+	}
+}
+
+/**
+ * Replaces the result @p pos of @p call by @p tv.
+ *
+ * @return true if a result was replaced
+ */
+static bool replace_result(ir_node *call, size_t pos, ir_tarval *tv)
+{
+	ir_graph *irg     = get_irn_irg(call);
+	bool      changed = false;
+	foreach_out_edge_safe(call, edge) {
+		ir_node *proj = get_edge_src_irn(edge);
+		if (!is_Proj(proj) || get_Proj_num(proj) != pn_Call_T_result)
+			continue;
+		foreach_out_edge_safe(proj, res_edge) {
+			ir_node *res = get_edge_src_irn(res_edge);
+			if (get_Proj_num(res) == pos
+			    && get_irn_mode(res) == get_tarval_mode(tv)) {
+				exchange(res, new_r_Const(irg, tv));
+				changed = true;
+			}
+		}
+	}
+	return changed;
+}
+
+/**
+ * Replaces the results of calls to @p irg which are the same constant at all
+ * Returns.
+ *
+ * @return true if a caller changed
+ */
+static bool propagate_results(ipcp_env_t *env, ir_graph *irg)
+{
+	ipcp_graph_t *info = get_graph_info(env, irg);
+	size_t        n_calls = ARR_LEN(info->calls);
+	if (n_calls == 0)
+		return false;
+
+	ir_type  *mtp   = get_entity_type(get_irg_entity(irg));
+	size_t    n_res = get_method_n_ress(mtp);
+	vrp_attr *facts = ALLOCANZ(vrp_attr, n_res);
+	bool     *known = ALLOCANZ(bool, n_res);
+	for (size_t i = 0; i < n_res; ++i) {
+		ir_mode *mode = get_type_mode(get_method_res_type(mtp, i));
+		known[i] = mode != NULL && mode_is_int(mode);
+	}
+	ir_node *end_block = get_irg_end_block(irg);
+	for (int p = 0, n_preds = get_Block_n_cfgpreds(end_block); p < n_preds;
+	     ++p) {
+		ir_node *ret = get_Block_cfgpred(end_block, p);
+		if (!is_Return(ret)) {
+			if (is_Bad(ret))
+				continue;
+			return false;
+		}
+		if (!is_reachable(ret))
+			continue;
+		if ((size_t)get_Return_n_ress(ret) != n_res)
+			return false;
+		for (size_t i = 0; i < n_res; ++i) {
+			vrp_attr fact;
+			if (known[i] && get_value_fact(get_Return_res(ret, i), &fact))
+				meet_fact(&facts[i], &fact);
+		}
+	}
+
+	bool changed = false;
+	for (size_t i = 0; i < n_res; ++i) {
+		if (!known[i] || !is_constant_fact(&facts[i]))
+			continue;
+		ir_tarval *tv = facts[i].bits_set;
+		for (size_t c = 0; c < n_calls; ++c) {
+			ir_node *call = info->calls[c];
+			if (!is_reachable(call) || !replace_result(call, i, tv))
+				continue;
+			DB((dbg, LEVEL_2, "result %zu of %+F is %T\n", i, call, tv));
+			ir_graph *caller = get_irn_irg(call);
+			reanalyze(caller);
+			env->changed[get_irg_idx(caller)] = true;
+			changed = true;
+		}
+	}
+	return changed;
+}
+
+/** Replaces the parameters of @p irg which are constant by Consts. */
+static bool apply_params(ir_graph *irg)
+{
+	if (irg->vrp.params == NULL)
+		return false;
+	bool     changed = false;
+	ir_node *args    = get_irg_args(irg);
+	foreach_out_edge_safe(args, edge) {
+		ir_node        *proj  = get_edge_src_irn(edge);
+		if (!is_Proj(proj))
+			continue;
+		const vrp_attr *param = vrp_get_param_info(irg, get_Proj_num(proj));
+		if (param == NULL || !is_constant_fact(param))
+			continue;
+		exchange(proj, new_r_Const(irg, param->bits_set));
+		changed = true;
+	}
+	return changed;
+}
+
+/**
+ * Replaces the constant arguments of the calls of @p irg by Consts, so that
+ * proc_cloning() can specialize @p irg.
+ */
+static void apply_args(ipcp_env_t *env, ir_graph *irg)
+{
+	ipcp_graph_t *info    = get_graph_info(env, irg);
+	ir_type      *mtp     = get_entity_type(get_irg_entity(irg));
+	for (size_t c = 0, n_calls = ARR_LEN(info->calls); c < n_calls; ++c) {
+		ir_node *call = info->calls[c];
+		if (!is_reachable(call)
+		    || (size_t)get_Call_n_params(call) != get_method_n_params(mtp))
+			continue;
+		for (size_t i = 0, n = get_Call_n_params(call); i < n; ++i) {
+			ir_node *arg = get_Call_param(call, i);
+			vrp_attr fact;
+			if (get_param_mode(mtp, i) == NULL || is_Const(arg)
+			    || !mode_is_int(get_irn_mode(arg))
+			    || !get_value_fact(arg, &fact) || !is_constant_fact(&fact))
+				continue;
+			ir_graph *caller = get_irn_irg(call);
+			set_Call_param(call, i, new_r_Const(caller, fact.bits_set));
+			env->changed[get_irg_idx(caller)] = true;
+		}
+	}
+}
+
+static void propagate(void)
+{
+	assure_irp_globals_entity_usage_computed();
+
+	ipcp_env_t env;
+	env.graphs = XMALLOCNZ(ipcp_graph_t, get_irp_last_idx());
+	env.order   = NEW_ARR_F(ir_graph*, 0);
+	env.changed = XMALLOCNZ(bool, get_irp_last_idx());
+	foreach_irp_irg(i, irg) {
+		ipcp_graph_t *info = get_graph_info(&env, irg);
+		ir_entity    *ent  = get_irg_entity(irg);
+		info->calls  = NEW_ARR_F(ir_node*, 0);
+		info->closed = get_entity_linktime_irg(ent) == irg
+		            && !entity_is_externally_visible(ent)
+		            && !(get_entity_usage(ent) & ir_usage_address_taken)
+		            && !is_method_variadic(get_entity_type(ent));
+		irg->vrp.params     = NULL;
+		irg->vrp.params_mtp = NULL;
+	}
+	foreach_irp_irg(i, irg) {
+		irg_walk_graph(irg, NULL, collect_calls, &env);
+	}
+	foreach_irp_irg(i, irg) {
+		add_to_order(&env, irg);
+		constbits_analyze(irg);
+	}
+
+	for (unsigned round = 0; round < MAX_ROUNDS; ++round) {
+		propagate_params(&env);
+		bool changed = false;
+		foreach_irp_irg(i, irg) {
+			changed |= propagate_results(&env, irg);
+		}
+		if (!changed)
+			break;
+	}
+
+	/* materialize the constants, the facts still hold afterwards */
+	foreach_irp_irg(i, irg) {
+		if (apply_params(irg))
+			env.changed[get_irg_idx(irg)] = true;
+	}
+	foreach_irp_irg(i, irg) {
+		apply_args(&env, irg);
+	}
+	foreach_irp_irg(i, irg) {
+		constbits_clear(irg);
+		if (env.changed[get_irg_idx(irg)])
+			confirm_irg_properties(irg, IR_GRAPH_PROPERTIES_CONTROL_FLOW);
+		DEL_ARR_F(get_graph_info(&env, irg)->calls);
+	}
+	free(env.changed);
+	DEL_ARR_F(env.order);
+	free(env.graphs);
+}
+
+void ipcp(float clone_threshold)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.opt.ipcp");
+
+	for (unsigned round = 0;; ++round) {
+		propagate();
+		if (round == MAX_CLONE_ROUNDS)
+			break;
+		/* the clones get constants which may propagate further */
+		size_t n_irgs = get_irp_n_irgs();
+		proc_cloning(clone_threshold);
+		if (get_irp_n_irgs() == n_irgs)
+			break;
+	}
+}
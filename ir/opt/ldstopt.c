@@ -20,6 +20,7 @@
 #include "irgraph_t.h"
 #include "irgwalk.h"
 #include "irhooks.h"
+#include "irloop.h"
 #include "irmemory.h"
 #include "irmode_t.h"
 #include "irnode_t.h"
@@ -28,7 +29,9 @@
 #include "iropt_t.h"
 #include "iroptimize.h"
 #include "irtools.h"
+#include "memssa.h"
 #include "panic.h"
+#include "pset_new.h"
 #include "set.h"
 #include "target_t.h"
 #include "tv_t.h"
@@ -620,7 +623,7 @@ static bool try_update_ptr_CopyB(track_load_env_t *env, ir_node *copyb)
 
 /**
  * Follow the memory chain as long as there are only Loads,
- * alias free Stores, and constant Calls and try to replace the
+ * alias free Stores, and Calls not writing the loaded memory and try to replace the
  * current Load by a previous ones.
  * Note that in unreachable loops it might happen that we reach
  * load again, as well as we can fall into a cycle.
@@ -697,6 +700,10 @@ static changes_t follow_load_mem_chain(track_load_env_t *env, ir_node *start)
 			if (rel != ir_no_alias)
 				break;
 			node = skip_Proj(get_CopyB_mem(node));
+		} else if (is_Call(node)
+		           && !(get_call_mod_ref(node, env->ptr) & ir_mod_ref_mod)) {
+			/* the call does not change the loaded value */
+			node = skip_Proj(get_Call_mem(node));
 		} else if (is_irn_const_memory(node)) {
 			node = skip_Proj(get_memop_mem(node));
 		} else {
@@ -1494,6 +1501,211 @@ static void do_load_store_optimize(ir_node *n, void *env)
 	}
 }
 
+/** Maximum number of definitions visited to prove a Store dead. */
+#define MAX_DSE_DEFS 64
+
+/**
+ * Replaces a Load by the value of the nearest Store of its alias class, which
+ * may be placed before loops and branches not touching the class.
+ */
+static changes_t forward_store_to_load(memssa_t *ms, ir_node *load)
+{
+	const ldst_info_t *info = (ldst_info_t *)get_irn_link(load);
+	if (get_Load_volatility(load) == volatility_is_volatile
+	    || info->projs[pn_Load_res] == NULL)
+		return NO_CHANGES;
+
+	memssa_def_t *def = memssa_get_clobber(ms, load);
+	if (def == NULL || def->kind != memssa_def_node || !is_Store(def->node))
+		return NO_CHANGES;
+	ir_node *store = def->node;
+	if (get_Store_volatility(store) == volatility_is_volatile)
+		return NO_CHANGES;
+
+	track_load_env_t env = { .load = load, .ptr = get_Load_ptr(load) };
+	get_base_and_offset(env.ptr, &env.base_offset);
+	return try_load_after_store(&env, store);
+}
+
+/** Checks whether the memory of @p store may be read by @p node. */
+static bool store_may_be_read(ir_node *store, ir_node *node)
+{
+	ir_node *ptr  = get_Store_ptr(store);
+	ir_type *type = get_Store_type(store);
+	unsigned size = get_mode_size_bytes(get_irn_mode(get_Store_value(store)));
+	switch (get_irn_opcode(node)) {
+	case iro_Load:
+		return get_alias_relation(ptr, type, size, get_Load_ptr(node),
+		                          get_Load_type(node),
+		                          get_mode_size_bytes(get_Load_mode(node)))
+		       != ir_no_alias;
+	case iro_Store:
+		return false;
+	case iro_CopyB: {
+		ir_type *copy_type = get_CopyB_type(node);
+		return get_alias_relation(ptr, type, size, get_CopyB_src(node),
+		                          copy_type, get_type_size(copy_type))
+		       != ir_no_alias;
+	}
+	case iro_Call:
+		return get_call_mod_ref(node, ptr) & ir_mod_ref_ref;
+	case iro_Phi:
+	case iro_Sync:
+		return false;
+	default:
+		return true;
+	}
+}
+
+/**
+ * Checks whether @p node overwrites all memory written by @p store. The
+ * same address node only denotes the same address if @p same_ptr is set.
+ */
+static bool store_is_covered(ir_node *store, ir_node *node, bool same_ptr)
+{
+	return same_ptr && is_Store(node)
+	    && get_Store_volatility(node) != volatility_is_volatile
+	    && !ir_throws_exception(node)
+	    && get_Store_ptr(node) == get_Store_ptr(store)
+	    && get_mode_size_bytes(get_irn_mode(get_Store_value(node)))
+	       >= get_mode_size_bytes(get_irn_mode(get_Store_value(store)));
+}
+
+/** Checks whether the blocks @p a and @p b are contained in a common loop. */
+static bool in_common_loop(ir_node *a, ir_node *b)
+{
+	ir_loop *la = get_irn_loop(a);
+	ir_loop *lb = get_irn_loop(b);
+	if (la == NULL || lb == NULL)
+		return true;
+	while (get_loop_depth(la) > get_loop_depth(lb))
+		la = get_loop_outer_loop(la);
+	while (get_loop_depth(lb) > get_loop_depth(la))
+		lb = get_loop_outer_loop(lb);
+	while (la != lb) {
+		la = get_loop_outer_loop(la);
+		lb = get_loop_outer_loop(lb);
+	}
+	return get_loop_depth(la) > 0;
+}
+
+typedef struct dse_env_t {
+	memssa_t   *ms;
+	ir_node    *store;
+	bool        invariant_ptr; /**< the address is the same in all loops
+	                                containing the Store */
+	pset_new_t  visited[2];    /**< visited definitions, indexed by whether
+	                                a merge was passed */
+	size_t      n_visited;
+} dse_env_t;
+
+/**
+ * Checks whether every path from the definition @p def reaches a Store
+ * overwriting the Store before its memory may be read. @p merged is set if a
+ * memory Phi was passed, which may be a loop header where the address of the
+ * Store changed.
+ */
+static bool is_overwritten(dse_env_t *env, memssa_def_t *def, bool merged)
+{
+	if (!pset_new_insert(&env->visited[merged], def))
+		return true;
+	if (++env->n_visited > MAX_DSE_DEFS)
+		return false;
+
+	bool const same_ptr = !merged || env->invariant_ptr;
+	for (memssa_use_t const *use = memssa_get_users(env->ms, def); use != NULL;
+	     use = use->next) {
+		ir_node *const node = use->node;
+		if (node == env->store)
+			continue;
+		if (store_is_covered(env->store, node, same_ptr))
+			continue;
+		if (store_may_be_read(env->store, node))
+			return false;
+		if (use->def != NULL
+		    && !is_overwritten(env, use->def, merged || is_Phi(node)))
+			return false;
+	}
+	return true;
+}
+
+/**
+ * Checks whether the Store @p store is overwritten on every path before
+ * being read and can be removed.
+ */
+static bool is_dead_store(memssa_t *ms, ir_node *store)
+{
+	const ldst_info_t *info = (ldst_info_t *)get_irn_link(store);
+	if (get_Store_volatility(store) == volatility_is_volatile
+	    || info->projs[pn_Store_X_except] != NULL
+	    || info->projs[pn_Store_M] == NULL)
+		return false;
+
+	unsigned const cls = memssa_get_class(ms, store);
+	memssa_def_t  *def = memssa_get_def(ms, info->projs[pn_Store_M], cls);
+
+	/* the address node computes another address after a back edge of a
+	 * loop containing both of them */
+	ir_node  *const ptr = get_Store_ptr(store);
+	dse_env_t       env = {
+		.ms            = ms,
+		.store         = store,
+		.invariant_ptr = !in_common_loop(get_nodes_block(store),
+		                                 get_nodes_block(ptr)),
+	};
+	pset_new_init(&env.visited[0]);
+	pset_new_init(&env.visited[1]);
+	bool const dead = is_overwritten(&env, def, false);
+	pset_new_destroy(&env.visited[1]);
+	pset_new_destroy(&env.visited[0]);
+	return dead;
+}
+
+/** Collects all Loads and Stores. */
+static void collect_loads_stores(ir_node *node, void *env)
+{
+	ir_node ***nodes = (ir_node***)env;
+	if (is_Load(node) || is_Store(node))
+		ARR_APP1(ir_node*, *nodes, node);
+}
+
+/**
+ * Uses the memory SSA overlay to forward Stores to Loads and to remove
+ * Stores which are overwritten before being read, across control flow.
+ */
+static changes_t optimize_memssa(ir_graph *irg)
+{
+	changes_t res   = NO_CHANGES;
+	ir_node **nodes = NEW_ARR_F(ir_node*, 0);
+	irg_walk_graph(irg, NULL, collect_loads_stores, &nodes);
+
+	memssa_t *ms = memssa_new(irg);
+	for (size_t i = 0, n = ARR_LEN(nodes); i < n; ++i) {
+		if (is_Load(nodes[i]))
+			res |= forward_store_to_load(ms, nodes[i]);
+	}
+
+	/* decide for all Stores before removing any of them */
+	ir_node **dead = NEW_ARR_F(ir_node*, 0);
+	for (size_t i = 0, n = ARR_LEN(nodes); i < n; ++i) {
+		if (is_Store(nodes[i]) && is_dead_store(ms, nodes[i]))
+			ARR_APP1(ir_node*, dead, nodes[i]);
+	}
+	memssa_free(ms);
+
+	for (size_t i = 0, n = ARR_LEN(dead); i < n; ++i) {
+		ir_node           *store = dead[i];
+		const ldst_info_t *info  = (ldst_info_t *)get_irn_link(store);
+		DB((dbg, LEVEL_1, "  Killing overwritten %+F\n", store));
+		exchange(info->projs[pn_Store_M], get_Store_mem(store));
+		kill_and_reduce_usage(store);
+		res |= DF_CHANGED;
+	}
+	DEL_ARR_F(dead);
+	DEL_ARR_F(nodes);
+	return res;
+}
+
 /**
  * Check if a store is dead and eliminate it.
  *
@@ -2301,6 +2513,7 @@ void optimize_load_store(ir_graph *irg)
 	                         | IR_GRAPH_PROPERTY_NO_TUPLES
 	                         | IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE
 	                         | IR_GRAPH_PROPERTY_CONSISTENT_POSTDOMINANCE
+	                         | IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO
 	                         | IR_GRAPH_PROPERTY_CONSISTENT_ENTITY_USAGE);
 
 	FIRM_DBG_REGISTER(dbg, "firm.opt.ldstopt");
@@ -2321,6 +2534,8 @@ void optimize_load_store(ir_graph *irg)
 	master_visited = 0;
 	irg_walk_graph(irg, firm_clear_link, collect_nodes, &env);
 
+	env.changes |= optimize_memssa(irg);
+
 	/* now we have collected enough information, optimize */
 	irg_walk_graph(irg, NULL, do_load_store_optimize, &env);
 
@@ -12,6 +12,7 @@
 
 #include "array.h"
 #include "debug.h"
+#include "execfreq.h"
 #include "irbackedge_t.h"
 #include "ircons_t.h"
 #include "irdom.h"
@@ -22,11 +23,15 @@
 #include "irloop_t.h"
 #include "irnode_t.h"
 #include "irnodemap.h"
+#include "irnodeset.h"
 #include "iroptimize.h"
 #include "irouts.h"
+#include "irprofile.h"
 #include "irtools.h"
 #include "opt_init.h"
 #include "panic.h"
+#include "scev.h"
+#include "target_t.h"
 #include "util.h"
 #include <math.h>
 #include <stdbool.h>
@@ -85,6 +90,9 @@ typedef struct loop_stats_t {
 	unsigned too_large_adapted;
 	unsigned cc_limit_reached;
 	unsigned calls_limit;
+	unsigned cold;
+	unsigned budget_limit;
+	unsigned register_limit;
 
 	unsigned u_simple_counting_loop;
 	unsigned constant_unroll;
@@ -111,6 +119,9 @@ static void print_stats(void)
 	DB((dbg, LEVEL_2, "too_large_adapted :   %d\n", stats.too_large_adapted));
 	DB((dbg, LEVEL_2, "cc_limit_reached  :   %d\n", stats.cc_limit_reached));
 	DB((dbg, LEVEL_2, "calls_limit       :   %d\n", stats.calls_limit));
+	DB((dbg, LEVEL_2, "cold              :   %d\n", stats.cold));
+	DB((dbg, LEVEL_2, "budget_limit      :   %d\n", stats.budget_limit));
+	DB((dbg, LEVEL_2, "register_limit    :   %d\n", stats.register_limit));
 	DB((dbg, LEVEL_2, "u_simple_counting :   %d\n", stats.u_simple_counting_loop));
 	DB((dbg, LEVEL_2, "constant_unroll   :   %d\n", stats.constant_unroll));
 	DB((dbg, LEVEL_2, "invariant_unroll  :   %d\n", stats.invariant_unroll));
@@ -131,10 +142,24 @@ typedef struct loop_opt_params_t {
 	bool     allow_const_unrolling;
 	bool     allow_invar_unrolling;
 	unsigned invar_unrolling_min_size;  /* [nodes] */
+
+	double   cold_loop_freq;    /* Head executions per call below which a loop is not unrolled */
+	double   hot_loop_freq;     /* Head executions per call from which a loop is hot */
+	unsigned hot_size_scale;    /* Scale of max_unrolled_loop_size for hot loops [factor] */
+	unsigned preferred_factor;  /* Preferred maximum unroll factor [number] */
+	unsigned hot_preferred_factor;
+	unsigned growth_budget;     /* Maximum growth of a function by unrolling [percent] */
+	unsigned min_growth_budget; /* [nodes] */
+	unsigned reserved_regs;     /* Registers not available for values [number] */
 } loop_opt_params_t;
 
 static loop_opt_params_t opt_params;
 
+/* Nodes the current function may still grow by unrolling. */
+static unsigned growth_budget;
+/* Number of general purpose registers of the target or 0 if unknown. */
+static unsigned n_value_regs;
+
 /* Loop analysis informations */
 typedef struct loop_info_t {
 	unsigned   nodes;      /* node count */
@@ -149,6 +174,9 @@ typedef struct loop_info_t {
 
 	/* for unrolling */
 	unsigned max_unroll;       /* Number of unrolls satisfying max_loop_size */
+	double   freq;             /* Executions of the head per function call */
+	unsigned carried;          /* Number of values carried by the head phis */
+	unsigned live_in;          /* Number of invariant values used in the loop */
 	unsigned exit_cond;        /* 1 if condition==true exits the loop.  */
 	unsigned latest_value:1;   /* 1 if condition is checked against latest counter value */
 	unsigned decreasing:1;     /* Step operation is_Sub, or step is<0 */
@@ -213,81 +241,122 @@ static bool is_own_backedge(const ir_node *const n, int const pos)
 	return is_backedge(n, pos) && is_in_loop(get_Block_cfgpred(n, pos));
 }
 
-/* Finds loop head and some loop_info as calls or else if necessary. */
-static void get_loop_info(ir_node *const node, void *const env)
+/* Returns true if the value of the node is kept in a register. */
+static bool needs_register(const ir_node *const node)
 {
-	(void)env;
+	if (!mode_is_data(get_irn_mode(node)))
+		return false;
 
-	bool const node_in_loop = is_in_loop(node);
+	switch (get_irn_opcode(node)) {
+	case iro_Address:
+	case iro_Align:
+	case iro_Const:
+	case iro_Offset:
+	case iro_Size:
+		return false;
+	default:
+		return true;
+	}
+}
 
-	/* collect some loop information */
-	if (node_in_loop) {
-		switch (get_irn_opcode(node)) {
-		case iro_Call:
-			++loop_info.calls;
-			goto count;
+/* Counts the node of cur_loop and collects the invariant values it uses. */
+static void get_node_info(ir_node *const node, ir_nodeset_t *const live_ins)
+{
+	switch (get_irn_opcode(node)) {
+	case iro_Call:
+		++loop_info.calls;
+		goto count;
 
-		case iro_Phi:
-			if (opt_params.count_phi)
-				goto count;
-			break;
+	case iro_Phi:
+		if (opt_params.count_phi)
+			goto count;
+		break;
 
-		case iro_Address:
-		case iro_Align:
-		case iro_Confirm:
-		case iro_Const:
-		case iro_Offset:
-		case iro_Proj:
-		case iro_Size:
-			break;
+	case iro_Address:
+	case iro_Align:
+	case iro_Confirm:
+	case iro_Const:
+	case iro_Offset:
+	case iro_Proj:
+	case iro_Size:
+		break;
 
-		default:
+	default:
 count:
-			++loop_info.nodes;
-			break;
-		}
+		++loop_info.nodes;
+		break;
 	}
 
-	foreach_irn_in_r(node, i, pred) {
-		bool pred_in_loop = is_in_loop(pred);
+	/* Phi preds from outside of the loop are start values. */
+	if (is_Phi(node) || is_Block(node))
+		return;
+
+	foreach_irn_in(node, i, pred) {
+		if (!is_in_loop(pred) && needs_register(pred))
+			ir_nodeset_insert(live_ins, pred);
+	}
+}
 
-		if (is_Block(node) && !node_in_loop && pred_in_loop) {
-			/* Count cf outs */
+/* Finds the loop head, counts branches and cf edges leaving the loop. */
+static void get_block_info(ir_node *const block)
+{
+	/* Count cf outs and innerloop branches */
+	unsigned outs_n = 0;
+	foreach_block_succ(block, edge) {
+		ir_node *const succ = get_edge_src_irn(edge);
+		if (!is_Block(succ))
+			continue;
+		if (is_in_loop(succ)) {
+			++outs_n;
+		} else {
 			++loop_info.cf_outs;
-			loop_info.cf_out = pred;
+			loop_info.cf_out = get_Block_cfgpred(succ, get_edge_src_pos(edge));
 		}
+	}
+	if (outs_n > 1)
+		++loop_info.branches;
 
-		/* Find the loops head/the blocks with cfpred outside of the loop */
-		if (is_Block(node)) {
-			unsigned outs_n = 0;
+	/* Find the loops head/the blocks with cfpred outside of the loop */
+	foreach_irn_in(block, i, pred) {
+		if (!loop_head_valid || is_in_loop(pred))
+			continue;
 
-			/* Count innerloop branches */
-			foreach_block_succ(node, edge) {
-				ir_node *succ = get_edge_src_irn(edge);
-				if (is_Block(succ) && is_in_loop(succ))
-					++outs_n;
-			}
-			if (outs_n > 1)
-				++loop_info.branches;
-
-			if (node_in_loop && !pred_in_loop && loop_head_valid) {
-				ir_node *cfgpred = get_Block_cfgpred(node, i);
-
-				if (!is_in_loop(cfgpred)) {
-					DB((dbg, LEVEL_5, "potential head %+F because inloop and pred %+F not inloop\n",
-					    node, pred));
-					/* another head? We do not touch this. */
-					if (loop_head && loop_head != node) {
-						loop_head_valid = false;
-					} else {
-						loop_head = node;
-					}
-				}
-			}
+		DB((dbg, LEVEL_5, "potential head %+F because inloop and pred %+F not inloop\n",
+		    block, pred));
+		/* another head? We do not touch this. */
+		if (loop_head && loop_head != block) {
+			loop_head_valid = false;
+		} else {
+			loop_head = block;
 		}
 	}
 }
 
+/* Finds loop head and some loop_info as calls or else if necessary.
+ * Only visits the blocks of cur_loop and their nodes. */
+static void get_loop_info(void)
+{
+	ir_nodeset_t live_ins;
+	ir_nodeset_init(&live_ins);
+
+	for (size_t i = 0, n = get_loop_n_elements(cur_loop); i < n; ++i) {
+		loop_element const element = get_loop_element(cur_loop, i);
+		if (*element.kind != k_ir_node)
+			continue;
+
+		ir_node *const block = element.node;
+		get_node_info(block, &live_ins);
+		get_block_info(block);
+		foreach_out_edge(block, edge) {
+			if (get_edge_src_pos(edge) == -1)
+				get_node_info(get_edge_src_irn(edge), &live_ins);
+		}
+	}
+
+	loop_info.live_in = ir_nodeset_size(&live_ins);
+	ir_nodeset_destroy(&live_ins);
+}
+
 /* Finds all edges with users outside of the loop
  * and definition inside the loop. */
 static void get_loop_entries(ir_node *const node, void *const env)
@@ -1196,7 +1265,8 @@ static void loop_inversion(ir_graph *const irg)
 
 		/* Duplicated blocks changed doms */
 		clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE
-		                   | IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO);
+		                   | IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO
+		                   | IR_GRAPH_PROPERTY_CONSISTENT_SCEV);
 
 		++stats.inverted;
 	}
@@ -1705,45 +1775,73 @@ static unsigned get_const_pred(ir_node *const node, ir_node **const const_pred,
 		return 1;
 }
 
-/* Returns 1 if loop exits within 2 steps of the iv.
- * Norm_proj means we do not exit the loop.*/
-static unsigned simulate_next(ir_tarval **const count_tar, ir_tarval *const stepped, ir_tarval *const step_tar, ir_tarval *const end_tar, ir_relation const norm_proj)
+/* Returns the number of executions of the loop head per function call,
+ * preferring profile information over the estimated frequencies. */
+static double get_loop_freq(ir_graph *const irg)
 {
-	DB((dbg, LEVEL_4, "Loop taken if (stepped)%ld %s (end)%ld ",
-	    get_tarval_long(stepped),
-	    get_relation_string((norm_proj)),
-	    get_tarval_long(end_tar)));
-	DB((dbg, LEVEL_4, "comparing latest value %d\n", loop_info.latest_value));
-
-	/* If current iv does not stay in the loop,
-	 * this run satisfied the exit condition. */
-	if (!(tarval_cmp(stepped, end_tar) & norm_proj))
-		return 1;
+	ir_node *const start_block = get_irg_start_block(irg);
+	if (ir_profile_has_block_execcount(loop_head)
+	    && ir_profile_has_block_execcount(start_block)) {
+		uint32_t const calls = ir_profile_get_block_execcount(start_block);
+		if (calls > 0)
+			return (double)ir_profile_get_block_execcount(loop_head) / calls;
+	}
 
-	DB((dbg, LEVEL_4, "Result: (stepped)%ld IS %s (end)%ld\n",
-	    get_tarval_long(stepped),
-	    get_relation_string(tarval_cmp(stepped, end_tar)),
-	    get_tarval_long(end_tar)));
+	double const start_freq = get_block_execfreq(start_block);
+	return get_block_execfreq(loop_head) / (start_freq > 0 ? start_freq : 1.0);
+}
 
-	/* next step */
-	ir_tarval *const next = is_Add(loop_info.add) ?
-		tarval_add(stepped, step_tar) :
-		tarval_sub(stepped, step_tar);
+/* Returns true if cur_loop is unrolled more aggressively. */
+static bool is_hot_loop(void)
+{
+	return loop_info.freq >= opt_params.hot_loop_freq;
+}
 
-	DB((dbg, LEVEL_4, "Loop taken if %ld %s %ld ",
-	    get_tarval_long(next),
-	    get_relation_string(norm_proj),
-	    get_tarval_long(end_tar)));
-	DB((dbg, LEVEL_4, "comparing latest value %d\n", loop_info.latest_value));
+/* Returns the maximum number of nodes of cur_loop after unrolling. */
+static unsigned get_max_unrolled_loop_size(void)
+{
+	unsigned const scale = is_hot_loop() ? opt_params.hot_size_scale : 1;
+	return opt_params.max_unrolled_loop_size * scale;
+}
 
-	/* Increase steps. */
-	*count_tar = tarval_add(*count_tar, get_mode_one(get_tarval_mode(*count_tar)));
+/* Returns the maximum unroll factor of cur_loop respecting the size limit,
+ * the growth budget of the function and the register pressure. */
+static unsigned get_max_unroll(void)
+{
+	unsigned max_unroll = get_max_unrolled_loop_size() / loop_info.nodes;
+	if (max_unroll < 2) {
+		++stats.too_large;
+		return max_unroll;
+	}
+
+	/* Every additional copy of the body consumes growth budget. */
+	unsigned const budget_unroll = 1 + growth_budget / loop_info.nodes;
+	if (budget_unroll < max_unroll) {
+		DB((dbg, LEVEL_4, "growth budget %u limits unroll factor to %u\n",
+			growth_budget, budget_unroll));
+		max_unroll = budget_unroll;
+		if (max_unroll < 2) {
+			++stats.budget_limit;
+			return max_unroll;
+		}
+	}
 
-	/* Next has to fail the loop condition, or we will never exit. */
-	if (!(tarval_cmp(next, end_tar) & norm_proj))
-		return 1;
-	else
-		return 0;
+	/* Invariant values stay alive during the whole loop. The values carried
+	 * to the next iteration are estimated to need a register for each copy
+	 * of the body, as the copies are scheduled interleaved. */
+	if (n_value_regs > 0 && loop_info.carried > 0) {
+		unsigned const free_regs = n_value_regs > loop_info.live_in
+			? n_value_regs - loop_info.live_in : 0;
+		unsigned const regs_unroll = free_regs / loop_info.carried;
+		if (regs_unroll < max_unroll) {
+			DB((dbg, LEVEL_4, "%u carried and %u invariant values limit unroll factor to %u\n",
+				loop_info.carried, loop_info.live_in, regs_unroll));
+			max_unroll = regs_unroll;
+			if (max_unroll < 2)
+				++stats.register_limit;
+		}
+	}
+	return max_unroll;
 }
 
 /* Check if loop meets requirements for a 'simple loop':
@@ -1763,13 +1861,11 @@ static ir_node *is_simple_loop(void)
 	DB((dbg, LEVEL_4, "1 loop exit\n"));
 
 	/* Calculate maximum unroll_nr keeping node count below limit. */
-	loop_info.max_unroll = (int)((double)opt_params.max_unrolled_loop_size / (double)loop_info.nodes);
-	if (loop_info.max_unroll < 2) {
-		++stats.too_large;
+	loop_info.max_unroll = get_max_unroll();
+	if (loop_info.max_unroll < 2)
 		return NULL;
-	}
 
-	DB((dbg, LEVEL_4, "maximum unroll factor %u, to not exceed node limit \n", opt_params.max_unrolled_loop_size));
+	DB((dbg, LEVEL_4, "maximum unroll factor %u\n", loop_info.max_unroll));
 
 	/* RETURN if we have more than 1 be. */
 	/* Get my backedges without alien bes. */
@@ -1919,6 +2015,9 @@ static unsigned get_unroll_decision_invariant(ir_graph *const irg)
 
 	DB((dbg, LEVEL_4, "step is not 0\n"));
 
+	/* The direction of the count check depends on the sign of the increment. */
+	loop_info.decreasing = tarval_is_negative(step_tar) != is_Sub(loop_info.add);
+
 	create_duffs_block(irg);
 
 	return loop_info.max_unroll;
@@ -1944,8 +2043,10 @@ static unsigned get_preferred_factor_constant(ir_tarval *const count_tar)
 	 *           |   `--'      |      `--'
 	 */
 	/* loop passes % {6, 5, 4, 3, 2} == 0  */
-	ir_mode *const mode = get_irn_mode(loop_info.end_val);
-	for (unsigned prefer = MIN(loop_info.max_unroll, 6); prefer != 1; --prefer) {
+	ir_mode *const mode      = get_tarval_mode(count_tar);
+	unsigned const preferred = is_hot_loop() ? opt_params.hot_preferred_factor
+	                                         : opt_params.preferred_factor;
+	for (unsigned prefer = MIN(loop_info.max_unroll, preferred); prefer > 1; --prefer) {
 		ir_tarval *const prefer_tv = new_tarval_from_long(prefer, mode);
 		if (tarval_is_null(tarval_mod(count_tar, prefer_tv))) {
 			DB((dbg, LEVEL_4, "preferred unroll factor %d\n", prefer));
@@ -1972,10 +2073,7 @@ static unsigned get_preferred_factor_constant(ir_tarval *const count_tar)
 }
 
 /* Check if cur_loop is a simple counting loop.
- * Start, step and end are constants.
- * TODO The whole constant case should use procedures similar to
- * the invariant case, as they are more versatile. */
-/* TODO split. */
+ * Start, step and end are constants. */
 static unsigned get_unroll_decision_constant(void)
 {
 	/* RETURN if loop is not 'simple' */
@@ -1983,166 +2081,34 @@ static unsigned get_unroll_decision_constant(void)
 	if (cmp == NULL)
 		return 0;
 
-	/* One in of the loop condition needs to be loop invariant. => end_val
-	 * The other in is assigned by an add. => add
-	 * The add uses a loop invariant value => step
-	 * and a phi with a loop invariant start_val and the add node as ins.
-	 *
-	 *  ^   ^
-	 *  |   | .-,
-	 *  |   Phi |
-	 *   \  |   |
-	 * ^  Add   |
-	 *  \  | \__|
-	 *   cond
-	 *    /\
-	*/
-
-	ir_node *iteration_path;
-	if (!get_const_pred(cmp, &loop_info.end_val, &iteration_path))
+	/* The number of iterations is computed by scalar evolution. The exit
+	 * test of our tail-controlled loop is executed once per iteration. */
+	scev_trip_count_t const *const tc
+		= scev_get_trip_count(get_irn_irg(cmp), cur_loop);
+	if (tc == NULL || tc->exit != loop_info.cf_out)
 		return 0;
 
-	DB((dbg, LEVEL_4, "End_val %N, other %N\n", loop_info.end_val, iteration_path));
-
-	/* We may find the add or the phi first.
-	 * Until now we only have end_val. */
-	unsigned is_latest_val;
-	if (is_Add(iteration_path) || is_Sub(iteration_path)) {
-		/* We test against the latest value of the iv. */
-		is_latest_val = 1;
-
-		loop_info.add = iteration_path;
-		DB((dbg, LEVEL_4, "Case 2: Got add %N (maybe not sane)\n", loop_info.add));
-
-		/* Preds of the add should be step and the iteration_phi */
-		if (!get_const_pred(loop_info.add, &loop_info.step, &loop_info.iteration_phi))
-			return 0;
-
-		DB((dbg, LEVEL_4, "Got step %N\n", loop_info.step));
-
-		if (!is_Phi(loop_info.iteration_phi))
-			return 0;
-
-		DB((dbg, LEVEL_4, "Got phi %N\n", loop_info.iteration_phi));
-
-		/* Find start_val.
-		 * Does necessary sanity check of add, if it is already set.  */
-		if (!get_start_and_add(constant))
-			return 0;
-
-		DB((dbg, LEVEL_4, "Got start %N\n", loop_info.start_val));
-	} else if (is_Phi(iteration_path)) {
-		/* We compare with the value the iv had entering this run. */
-		is_latest_val = 0;
-
-		loop_info.iteration_phi = iteration_path;
-		DB((dbg, LEVEL_4, "Case 1: Got phi %N \n", loop_info.iteration_phi));
-
-		/* Find start_val and add-node.
-		 * Does necessary sanity check of add, if it is already set.  */
-		if (!get_start_and_add(constant))
-			return 0;
-
-		DB((dbg, LEVEL_4, "Got start %N\n", loop_info.start_val));
-		DB((dbg, LEVEL_4, "Got add or sub %N\n", loop_info.add));
-
-		ir_node *new_iteration_phi;
-		if (!get_const_pred(loop_info.add, &loop_info.step, &new_iteration_phi))
-			return 0;
-
-		DB((dbg, LEVEL_4, "Got step %N\n", loop_info.step));
-
-		if (loop_info.iteration_phi != new_iteration_phi)
-			return 0;
-	} else {
-		return 0;
-	}
+	loop_info.iteration_phi = tc->iv->phi;
+	loop_info.start_val     = tc->iv->start;
+	loop_info.add           = tc->iv->next;
+	loop_info.step          = tc->iv->step;
+	loop_info.end_val       = tc->bound;
+	loop_info.latest_value  = tc->latest;
+	loop_info.decreasing    = tc->iv->step_tv != tarval_unknown
+	                       && tarval_is_negative(tc->iv->step_tv);
 
 	DB((dbg, LEVEL_4, "start %N, end %N, step %N\n", loop_info.start_val, loop_info.end_val, loop_info.step));
 
-	ir_mode *const mode = get_irn_mode(loop_info.end_val);
-	if (mode != mode_Is && mode != mode_Iu)
-		return 0;
-
-	/* TODO necessary? */
-	if (!are_mode_I(loop_info.start_val, loop_info.step, loop_info.end_val))
-		return 0;
-
-	DB((dbg, LEVEL_4, "mode integer\n"));
-
-	ir_tarval *const end_tar   = get_Const_tarval(loop_info.end_val);
-	ir_tarval *const start_tar = get_Const_tarval(loop_info.start_val);
-	ir_tarval *const step_tar  = get_Const_tarval(loop_info.step);
-
-	if (tarval_is_null(step_tar))
-		/* TODO Might be worth a warning. */
-		return 0;
-
-	DB((dbg, LEVEL_4, "step is not 0\n"));
-
-	if (!tarval_is_negative(step_tar) ^ !is_Sub(loop_info.add))
-		loop_info.decreasing = 1;
-
-	ir_tarval *const diff_tar = tarval_sub(end_tar, start_tar);
-
-	/* We need at least count_tar steps to be close to end_val, maybe more.
-	 * No way, that we have gone too many steps.
-	 * This represents the 'latest value'.
-	 * (If condition checks against latest value, is checked later) */
-	ir_tarval *count_tar = tarval_div(diff_tar, step_tar);
-
-	/* Iv will not pass end_val (except overflows).
-	 * Nothing done, as it would yield to no advantage. */
-	if (tarval_is_negative(count_tar)) {
-		DB((dbg, LEVEL_4, "Loop is endless or never taken."));
-		/* TODO Might be worth a warning. */
+	ir_tarval *const count_tar = tc->count;
+	if (count_tar == tarval_unknown || !tarval_is_long(count_tar)) {
+		DB((dbg, LEVEL_4, "Loop is endless or count unknown."));
 		return 0;
 	}
 
 	++stats.u_simple_counting_loop;
 
-	loop_info.latest_value = is_latest_val;
-
-	/* stepped can be negative, if step < 0 */
-	ir_tarval *stepped = tarval_mul(count_tar, step_tar);
-
-	/* step as close to end_val as possible, */
-	/* |stepped| <= |end_tar|, and dist(stepped, end_tar) is smaller than a step. */
-	stepped = is_Add(loop_info.add) ? tarval_add(start_tar, stepped)
-	                                : tarval_sub(start_tar, stepped);
-
-	DB((dbg, LEVEL_4, "stepped to %ld\n", get_tarval_long(stepped)));
-
-	ir_relation const relation      = get_Cmp_relation(cmp);
-	/* Assure that norm_relation is the stay-in-loop case. */
-	ir_relation const norm_relation = loop_info.exit_cond == 1 ?
-		get_negated_relation(relation) : relation;
-
-	DB((dbg, LEVEL_4, "normalized projection %s\n", get_relation_string(norm_relation)));
-	/* Executed at most once (stay in counting loop if a Eq b) */
-	if (norm_relation == ir_relation_equal)
-		/* TODO Might be worth a warning. */
-		return 0;
-
-	/* calculates next values and increases count_tar according to it */
-	if (!simulate_next(&count_tar, stepped, step_tar, end_tar, norm_relation))
-		return 0;
-
-	/* We run loop once more, if we compare to the
-	 * not yet in-/decreased iv. */
-	if (is_latest_val == 0) {
-		DB((dbg, LEVEL_4, "condition uses not latest iv value\n"));
-		count_tar = tarval_add(count_tar, get_mode_one(mode));
-	}
-
 	DB((dbg, LEVEL_4, "loop taken %ld times\n", get_tarval_long(count_tar)));
 
-	/* Assure the loop is taken at least 1 time. */
-	if (tarval_is_null(count_tar)) {
-		/* TODO Might be worth a warning. */
-		return 0;
-	}
-
 	return get_preferred_factor_constant(count_tar);
 }
 
@@ -2154,19 +2120,28 @@ static void unroll_loop(ir_graph *const irg)
 	if (loop_info.nodes <= 0)
 		return;
 
-	if (loop_info.nodes > opt_params.max_unrolled_loop_size) {
-		DB((dbg, LEVEL_2, "Nodes %d > allowed nodes %d\n",
-			loop_info.nodes, opt_params.max_unrolled_loop_size));
-		++stats.too_large;
-		return;
-	}
-
 	if (loop_info.calls > 0) {
 		DB((dbg, LEVEL_2, "Calls %d > allowed calls 0\n", loop_info.calls));
 		++stats.calls_limit;
 		return;
 	}
 
+	/* Unrolling cold loops only costs code size. */
+	loop_info.freq = get_loop_freq(irg);
+	if (loop_info.freq < opt_params.cold_loop_freq) {
+		DB((dbg, LEVEL_2, "Loop executed %.2f times per call, too cold\n",
+			loop_info.freq));
+		++stats.cold;
+		return;
+	}
+
+	if (loop_info.nodes > get_max_unrolled_loop_size()) {
+		DB((dbg, LEVEL_2, "Nodes %d > allowed nodes %d\n",
+			loop_info.nodes, get_max_unrolled_loop_size()));
+		++stats.too_large;
+		return;
+	}
+
 	unroll_nr = 0;
 
 	/* get_unroll_decision_constant and invariant are completely
@@ -2210,12 +2185,15 @@ static void unroll_loop(ir_graph *const irg)
 		 * leads to complex special cases. */
 		irg_walk_graph(irg, correct_phis, NULL, NULL);
 
+		growth_budget -= MIN(growth_budget, loop_info.nodes * (unroll_nr - 1));
+
 		if (loop_info.unroll_kind == constant)
 			++stats.constant_unroll;
 		else
 			++stats.invariant_unroll;
 
-		clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE);
+		clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE
+		                   | IR_GRAPH_PROPERTY_CONSISTENT_SCEV);
 
 		DEL_ARR_F(loop_entries);
 		obstack_free(&obst, NULL);
@@ -2237,7 +2215,7 @@ static void init_analyze(ir_graph *const irg, ir_loop *const loop, loop_op_t con
 	DB((dbg, LEVEL_1, "    >>>> current loop %ld <<<\n", get_loop_loop_nr(loop)));
 
 	/* Collect loop informations: head, node counts. */
-	irg_walk_graph(irg, get_loop_info, NULL, NULL);
+	get_loop_info();
 
 	/* RETURN if there is no valid head */
 	if (!loop_head || !loop_head_valid) {
@@ -2246,6 +2224,11 @@ static void init_analyze(ir_graph *const irg, ir_loop *const loop, loop_op_t con
 	}
 	DB((dbg, LEVEL_1, "Loophead: %N\n", loop_head));
 
+	for_each_phi(loop_head, phi) {
+		if (needs_register(phi))
+			++loop_info.carried;
+	}
+
 	if (loop_info.branches > opt_params.max_branches) {
 		DB((dbg, LEVEL_1, "Branches %d > allowed branches %d\n",
 			loop_info.branches, opt_params.max_branches));
@@ -2278,7 +2261,29 @@ static void find_innermost_loop(ir_loop *const loop)
 		ARR_APP1(ir_loop*, loops, loop);
 }
 
-static void set_loop_params(void)
+/* Returns the number of general purpose registers of the target. */
+static unsigned get_n_value_regs(void)
+{
+	if (!ir_target.isa_initialized)
+		return 0;
+
+	/* Registers of other classes usually hold values of a few modes only,
+	 * so only the general purpose registers are considered. */
+	arch_isa_if_t const *const isa   = ir_target.isa;
+	unsigned             const bits  = isa->pointer_size * 8;
+	unsigned                   n_regs = 0;
+	for (unsigned c = 0; c < isa->n_register_classes; ++c) {
+		arch_register_class_t const *const cls = &isa->register_classes[c];
+		if (!cls->manual_ra && cls->mode != NULL && mode_is_int(cls->mode)
+		    && get_mode_size_bits(cls->mode) == bits)
+			n_regs = MAX(n_regs, cls->n_regs);
+	}
+	if (n_regs <= opt_params.reserved_regs)
+		return 0;
+	return n_regs - opt_params.reserved_regs;
+}
+
+static void set_loop_params(ir_graph *const irg)
 {
 	opt_params.max_loop_size            =  100;
 	opt_params.depth_adaption           =  -50;
@@ -2290,6 +2295,19 @@ static void set_loop_params(void)
 	opt_params.invar_unrolling_min_size =   20;
 	opt_params.max_unrolled_loop_size   =  400;
 	opt_params.max_branches             = 9999;
+
+	opt_params.cold_loop_freq           =  2.0;
+	opt_params.hot_loop_freq            = 50.0;
+	opt_params.hot_size_scale           =    2;
+	opt_params.preferred_factor         =    6;
+	opt_params.hot_preferred_factor     =    8;
+	opt_params.growth_budget            =   50;
+	opt_params.min_growth_budget        =  400;
+	opt_params.reserved_regs            =    2;
+
+	growth_budget = MAX(get_irg_last_idx(irg) * opt_params.growth_budget / 100,
+	                    opt_params.min_growth_budget);
+	n_value_regs  = get_n_value_regs();
 }
 
 /**
@@ -2303,13 +2321,17 @@ static void set_loop_params(void)
  */
 static void loop_optimization(ir_graph *const irg, loop_op_t const loop_op)
 {
+	/* The unroll decision depends on the execution frequencies. */
+	if (loop_op == loop_op_unrolling)
+		ir_estimate_execfreq(irg);
+
 	/* Assure preconditions are met and go through all loops. */
 	assure_irg_properties(irg,
 		IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES
 		| IR_GRAPH_PROPERTY_CONSISTENT_OUTS
 		| IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO);
 
-	set_loop_params();
+	set_loop_params(irg);
 
 	/* Reset stats for this procedure */
 	reset_stats();
@@ -2338,14 +2360,14 @@ static void loop_optimization(ir_graph *const irg, loop_op_t const loop_op)
 		++stats.loops;
 
 		/* Analyze and handle loop */
+		unsigned const last_idx = get_irg_last_idx(irg);
 		init_analyze(irg, loop, loop_op);
 
-		/* Copied blocks do not have their phi list yet */
-		collect_phiprojs_and_start_block_nodes(irg);
-
-		/* Set links to NULL
-		 * TODO Still necessary? */
-		irg_walk_graph(irg, firm_clear_link, NULL, NULL);
+		/* Only a transformed loop has new nodes. Copied blocks do not have
+		 * their phi list yet. Links are always set before they are read, so
+		 * they need not be cleared for the next loop. */
+		if (get_irg_last_idx(irg) != last_idx)
+			collect_phiprojs_and_start_block_nodes(irg);
 	}
 
 	print_stats();
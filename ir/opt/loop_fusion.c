@@ -0,0 +1,934 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2017 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Loop fusion and loop distribution.
+ *
+ * Both transformations handle innermost loops consisting of a header with the
+ * exit condition and a single body block, as created for counting loops.
+ *
+ * Loop fusion merges a loop into the loop executed directly before it, if
+ * both loops are executed equally often and no dependence is reversed: the
+ * second loop must not use values computed by the first one and every pair of
+ * memory accesses of both loops, which includes a Store, must either not
+ * alias or access the same address in the same iteration.
+ *
+ * Loop distribution moves the Stores of a loop, which could be vectorized,
+ * into a copy of the loop executed before the original loop, if the loop also
+ * contains Stores preventing vectorization.  A Store is considered
+ * vectorizable if its address has unit stride and its value is computed from
+ * unit stride Loads, the induction variable and loop invariant values.  The
+ * dependence analysis decides whether the Stores may be executed before all
+ * iterations of the remaining memory operations.
+ */
+#include "array.h"
+#include "debug.h"
+#include "dependence.h"
+#include "ircons_t.h"
+#include "irdom.h"
+#include "iredges_t.h"
+#include "irgmod.h"
+#include "irgraph_t.h"
+#include "irgwalk.h"
+#include "irloop_t.h"
+#include "irmemory.h"
+#include "irnode_t.h"
+#include "irnodemap.h"
+#include "irnodeset.h"
+#include "iroptimize.h"
+#include "scev.h"
+#include "target_t.h"
+#include "tv_t.h"
+#include "util.h"
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg;)
+
+/** Maximum number of nodes in header and body of a transformed loop. */
+#define MAX_LOOP_NODES  128
+/** Maximum depth of the expressions analysed. */
+#define MAX_EXPR_DEPTH  8
+/** Maximum number of transformations per graph. */
+#define MAX_TRANSFORMS  32
+
+typedef struct floop_t {
+	ir_node                 *header;
+	ir_node                 *body;
+	int                      entry_pos; /**< position of the entry in header */
+	ir_node                 *exit;      /**< Proj leaving the loop */
+	ir_node                 *mem_phi;   /**< memory Phi of the header or NULL */
+	scev_trip_count_t const *tc;
+	ir_node                **memops;    /**< flexible array of Loads and Stores */
+} floop_t;
+
+/** Environment for copying the vectorizable part of a loop. */
+typedef struct copy_env_t {
+	floop_t const *loop;
+	ir_node       *header;  /**< copy of the header */
+	ir_node       *body;    /**< copy of the body */
+	ir_nodeset_t  *stores;  /**< the Stores copied */
+	ir_nodemap     map;     /**< original -> copy */
+} copy_env_t;
+
+static bool is_in_loop(floop_t const *const loop, ir_node const *const node)
+{
+	ir_node const *const block = get_nodes_block(node);
+	return block == loop->header || block == loop->body;
+}
+
+static ir_node *get_iv(floop_t const *const loop)
+{
+	return loop->tc->iv->phi;
+}
+
+static ir_node *get_memop_ptr(ir_node const *const node)
+{
+	return is_Load(node) ? get_Load_ptr(node) : get_Store_ptr(node);
+}
+
+static ir_type *get_memop_type(ir_node const *const node)
+{
+	return is_Load(node) ? get_Load_type(node) : get_Store_type(node);
+}
+
+static unsigned get_memop_size(ir_node const *const node)
+{
+	ir_mode *const mode = is_Load(node) ? get_Load_mode(node)
+	                                    : get_irn_mode(get_Store_value(node));
+	return get_mode_size_bytes(mode);
+}
+
+/** Returns the memory Proj of the Store @p store. */
+static ir_node *get_Store_M_proj(ir_node *const store)
+{
+	foreach_out_edge(store, edge) {
+		ir_node *const proj = get_edge_src_irn(edge);
+		if (is_Proj(proj) && get_Proj_num(proj) == pn_Store_M)
+			return proj;
+	}
+	return NULL;
+}
+
+/** Checks that all nodes of header and body can be moved or copied. */
+static bool analyze_nodes(floop_t *const loop)
+{
+	unsigned n_nodes = 0;
+	for (int i = 0; i < 2; ++i) {
+		ir_node *const block = i == 0 ? loop->header : loop->body;
+		foreach_out_edge(block, edge) {
+			ir_node *const node = get_edge_src_irn(edge);
+			ir_mode *const mode = get_irn_mode(node);
+			if (++n_nodes > MAX_LOOP_NODES)
+				return false;
+			if (is_Phi(node)) {
+				if (mode != mode_M)
+					continue;
+				if (loop->mem_phi != NULL)
+					return false;
+				loop->mem_phi = node;
+				continue;
+			}
+			if (is_cfop(node) || (is_Proj(node) && is_Cond(get_Proj_pred(node))))
+				continue;
+			if (is_Load(node) || is_Store(node)) {
+				if (block != loop->body || ir_throws_exception(node)
+				 || (is_Load(node) ? get_Load_volatility(node)
+				                   : get_Store_volatility(node))
+				    != volatility_non_volatile)
+					return false;
+				ARR_APP1(ir_node*, loop->memops, node);
+				continue;
+			}
+			if (is_Proj(node)) {
+				ir_node *const pred = get_Proj_pred(node);
+				if (is_Load(pred) || is_Store(pred))
+					continue;
+			}
+			if (mode == mode_M || mode == mode_T || mode == mode_X
+			 || get_irn_pinned(node) || is_irn_keep(node))
+				return false;
+		}
+	}
+	return true;
+}
+
+/** Recognizes a counting loop with header @p header. */
+static bool analyze_loop(floop_t *const loop, ir_node *const header)
+{
+	if (get_Block_n_cfgpreds(header) != 2)
+		return false;
+	ir_node *body_proj = NULL;
+	for (int i = 0; i < 2; ++i) {
+		ir_node *const pred = get_Block_cfgpred(header, i);
+		ir_node *const body = get_nodes_block(pred);
+		if (!is_Jmp(pred) || body == header || get_Block_n_cfgpreds(body) != 1)
+			continue;
+		ir_node *const proj = get_Block_cfgpred(body, 0);
+		if (!is_Proj(proj) || get_nodes_block(proj) != header
+		 || !is_Cond(get_Proj_pred(proj)))
+			continue;
+		loop->body      = body;
+		loop->entry_pos = 1 - i;
+		body_proj       = proj;
+	}
+	if (loop->body == NULL)
+		return false;
+	loop->header = header;
+
+	/* the loop consists of header and body only */
+	ir_loop *const irloop = get_irn_loop(header);
+	if (irloop == NULL || get_loop_depth(irloop) == 0
+	 || get_irn_loop(loop->body) != irloop
+	 || get_loop_n_elements(irloop) != 2
+	 || *get_loop_element(irloop, 0).kind != k_ir_node
+	 || *get_loop_element(irloop, 1).kind != k_ir_node)
+		return false;
+
+	scev_trip_count_t const *const tc
+		= scev_get_trip_count(get_irn_irg(header), irloop);
+	if (tc == NULL || get_nodes_block(tc->iv->phi) != header
+	 || get_nodes_block(tc->exit) != header
+	 || get_Proj_pred(tc->exit) != get_Proj_pred(body_proj))
+		return false;
+	loop->tc   = tc;
+	loop->exit = tc->exit;
+
+	return analyze_nodes(loop);
+}
+
+/** Checks whether two induction variables take the same sequence of values. */
+static bool is_same_iv(scev_t const *const iv0, scev_t const *const iv1)
+{
+	if (iv0->start != iv1->start
+	 && (!tarval_is_constant(iv0->start_tv) || iv0->start_tv != iv1->start_tv))
+		return false;
+	if (tarval_is_constant(iv0->step_tv) || tarval_is_constant(iv1->step_tv))
+		return iv0->step_tv == iv1->step_tv && !tarval_is_null(iv0->step_tv);
+	return iv0->step == iv1->step && iv0->negated == iv1->negated;
+}
+
+/** Checks whether two loops are executed equally often. */
+static bool is_same_trip_count(scev_trip_count_t const *const tc0,
+                               scev_trip_count_t const *const tc1)
+{
+	if (tarval_is_long(tc0->count) && tarval_is_long(tc1->count))
+		return get_tarval_long(tc0->count) == get_tarval_long(tc1->count);
+	return tc0->bound == tc1->bound && tc0->relation == tc1->relation
+	    && tc0->latest == tc1->latest && is_same_iv(tc0->iv, tc1->iv);
+}
+
+/**
+ * Checks whether the address @p a in loop @p l0 and the address @p b in loop
+ * @p l1 are equal in the same iteration.  @p varies is set if the address
+ * depends on the induction variable.  Only affine functions of the induction
+ * variable are accepted, so different iterations access different addresses.
+ */
+static bool is_same_address(floop_t const *const l0, ir_node *const a,
+                            floop_t const *const l1, ir_node *const b,
+                            bool *const varies, unsigned const depth)
+{
+	bool const in0 = is_in_loop(l0, a);
+	bool const in1 = is_in_loop(l1, b);
+	if (!in0 || !in1)
+		return !in0 && !in1 && a == b;
+	if (a == get_iv(l0) || b == get_iv(l1)) {
+		if (a != get_iv(l0) || b != get_iv(l1)
+		 || !is_same_iv(l0->tc->iv, l1->tc->iv))
+			return false;
+		*varies = true;
+		return true;
+	}
+	ir_mode *const mode = get_irn_mode(a);
+	if (depth >= MAX_EXPR_DEPTH || get_irn_opcode(a) != get_irn_opcode(b)
+	 || mode != get_irn_mode(b))
+		return false;
+
+	bool op_varies = false;
+	switch (get_irn_opcode(a)) {
+	case iro_Mul: {
+		ir_node *const right = get_Mul_right(a);
+		if (!is_Const(right) || is_Const_null(right))
+			return false;
+		goto binop;
+	}
+	case iro_Shl:
+		if (!is_Const(get_Shl_right(a)))
+			return false;
+		/* FALLTHROUGH */
+	case iro_Add:
+	case iro_Sub:
+binop:
+		if (!is_same_address(l0, get_binop_left(a), l1, get_binop_left(b),
+		                     &op_varies, depth + 1)
+		 || !is_same_address(l0, get_binop_right(a), l1, get_binop_right(b),
+		                     &op_varies, depth + 1))
+			return false;
+		break;
+	case iro_Conv:
+		if (!is_same_address(l0, get_Conv_op(a), l1, get_Conv_op(b),
+		                     &op_varies, depth + 1))
+			return false;
+		break;
+	case iro_Member:
+		if (get_Member_entity(a) != get_Member_entity(b)
+		 || !is_same_address(l0, get_Member_ptr(a), l1, get_Member_ptr(b),
+		                     &op_varies, depth + 1))
+			return false;
+		break;
+	case iro_Sel:
+		if (get_Sel_type(a) != get_Sel_type(b)
+		 || !is_same_address(l0, get_Sel_ptr(a), l1, get_Sel_ptr(b),
+		                     &op_varies, depth + 1)
+		 || !is_same_address(l0, get_Sel_index(a), l1, get_Sel_index(b),
+		                     &op_varies, depth + 1))
+			return false;
+		break;
+	default:
+		return false;
+	}
+	/* Arithmetic in modes smaller than a pointer might wrap around. */
+	if (op_varies && !is_Conv(a)
+	 && get_mode_size_bytes(mode) < ir_target_pointer_size())
+		return false;
+	*varies |= op_varies;
+	return true;
+}
+
+/**
+ * Checks whether @p a of loop @p l0 and @p b of loop @p l1 access the same
+ * memory in the same iteration and different memory in different iterations.
+ */
+static bool is_same_access(floop_t const *const l0, ir_node *const a,
+                           floop_t const *const l1, ir_node *const b)
+{
+	bool varies = false;
+	return get_memop_size(a) == get_memop_size(b)
+	    && is_same_address(l0, get_memop_ptr(a), l1, get_memop_ptr(b),
+	                       &varies, 0)
+	    && varies;
+}
+
+static bool is_no_alias(ir_node const *const a, ir_node const *const b)
+{
+	return get_alias_relation(get_memop_ptr(a), get_memop_type(a),
+	                          get_memop_size(a), get_memop_ptr(b),
+	                          get_memop_type(b), get_memop_size(b))
+	    == ir_no_alias;
+}
+
+/**
+ * Returns the loop executed directly before @p loop, i.e. whose exit reaches
+ * the entry of @p loop through blocks without side effects.
+ */
+static bool find_previous_loop(floop_t *const prev, floop_t const *const loop)
+{
+	ir_node *pred = get_Block_cfgpred(loop->header, loop->entry_pos);
+	while (is_Jmp(pred)) {
+		ir_node *const block = get_nodes_block(pred);
+		if (get_Block_n_cfgpreds(block) != 1)
+			return false;
+		foreach_out_edge(block, edge) {
+			ir_node *const node = get_edge_src_irn(edge);
+			if (get_irn_mode(node) == mode_M || get_irn_pinned(node)
+			 || is_irn_keep(node)) {
+				if (!is_Jmp(node))
+					return false;
+			}
+		}
+		pred = get_Block_cfgpred(block, 0);
+	}
+	if (!is_Proj(pred) || !is_Cond(get_Proj_pred(pred)))
+		return false;
+	ir_node *const header = get_nodes_block(pred);
+	return header != loop->header && analyze_loop(prev, header)
+	    && prev->exit == pred;
+}
+
+/** Checks whether loop @p second may be fused into loop @p first. */
+static bool may_fuse(floop_t const *const first, floop_t const *const second)
+{
+	if (!is_same_trip_count(first->tc, second->tc))
+		return false;
+	if (first->mem_phi != NULL && second->mem_phi != NULL
+	 && get_Phi_pred(second->mem_phi, second->entry_pos) != first->mem_phi)
+		return false;
+
+	/* The values used by the second loop must be available before the first
+	 * one.  Its memory is redirected to the memory of the first body. */
+	for (int i = 0; i < 2; ++i) {
+		ir_node *const block = i == 0 ? second->header : second->body;
+		foreach_out_edge(block, edge) {
+			ir_node *const node = get_edge_src_irn(edge);
+			foreach_irn_in(node, n, pred) {
+				if (is_in_loop(second, pred) || pred == first->mem_phi)
+					continue;
+				ir_node *const pred_block = get_nodes_block(pred);
+				if (pred_block == first->header
+				 || !block_dominates(pred_block, first->header))
+					return false;
+			}
+		}
+	}
+
+	for (size_t i = 0, n0 = ARR_LEN(first->memops); i < n0; ++i) {
+		ir_node *const a = first->memops[i];
+		for (size_t j = 0, n1 = ARR_LEN(second->memops); j < n1; ++j) {
+			ir_node *const b = second->memops[j];
+			if ((is_Load(a) && is_Load(b)) || is_same_access(first, a, second, b)
+			 || is_no_alias(a, b))
+				continue;
+			DB((dbg, LEVEL_2, "  %+F and %+F may depend on each other\n", a, b));
+			return false;
+		}
+	}
+	return true;
+}
+
+/** Moves the nodes of block @p from except Phis and control flow to @p to. */
+static void move_nodes(ir_node *const from, ir_node *const to)
+{
+	foreach_out_edge_safe(from, edge) {
+		ir_node *const node = get_edge_src_irn(edge);
+		if (is_Phi(node) || is_cfop(node)
+		 || (is_Proj(node) && is_cfop(get_Proj_pred(node))))
+			continue;
+		set_nodes_block(node, to);
+	}
+}
+
+/** Fuses loop @p second into loop @p first. */
+static void fuse_loops(floop_t const *const first, floop_t const *const second)
+{
+	ir_graph *const irg      = get_irn_irg(first->header);
+	ir_node  *const header   = first->header;
+	int       const entry    = first->entry_pos;
+	int       const entry2   = second->entry_pos;
+	ir_node  *const mem      = first->mem_phi;
+	ir_node  *const mem2     = second->mem_phi;
+	ir_node  *const body_mem = mem != NULL ? get_Phi_pred(mem, 1 - entry)
+	                                       : NULL;
+
+	DB((dbg, LEVEL_1, "fusing loop %+F into loop %+F\n", second->header,
+	    header));
+
+	/* Inside the loop the second body continues with the memory of the first
+	 * body, outside the memory of the fused loop is used. */
+	if (mem != NULL) {
+		foreach_out_edge_safe(mem, edge) {
+			ir_node *const user = get_edge_src_irn(edge);
+			if (user != mem2 && is_in_loop(second, user))
+				set_irn_n(user, get_edge_src_pos(edge), body_mem);
+		}
+		if (mem2 != NULL) {
+			ir_node *const back2 = get_Phi_pred(mem2, 1 - entry2);
+			foreach_out_edge_safe(mem2, edge) {
+				ir_node *const user = get_edge_src_irn(edge);
+				if (user != mem2)
+					set_irn_n(user, get_edge_src_pos(edge),
+					          is_in_loop(second, user) ? body_mem : mem);
+			}
+			set_Phi_pred(mem, 1 - entry, back2 == mem2 ? body_mem : back2);
+		}
+	}
+
+	/* The Phis of the second header move to the first one. */
+	scev_t const *const iv  = first->tc->iv;
+	scev_t const *const iv2 = second->tc->iv;
+	foreach_out_edge_safe(second->header, edge) {
+		ir_node *const phi = get_edge_src_irn(edge);
+		if (!is_Phi(phi) || (phi == mem2 && mem != NULL))
+			continue;
+		if (phi == iv2->phi && is_same_iv(iv, iv2)) {
+			exchange(phi, iv->phi);
+			continue;
+		}
+		ir_node *in[2];
+		in[entry]     = get_Phi_pred(phi, entry2);
+		in[1 - entry] = get_Phi_pred(phi, 1 - entry2);
+		set_nodes_block(phi, header);
+		set_irn_in(phi, ARRAY_SIZE(in), in);
+	}
+	move_nodes(second->header, header);
+	move_nodes(second->body, first->body);
+
+	/* The code after the second loop follows the fused loop. */
+	ir_node *const entry_x = get_Block_cfgpred(second->header, entry2);
+	foreach_out_edge_safe(second->exit, edge) {
+		ir_node *const user = get_edge_src_irn(edge);
+		set_irn_n(user, get_edge_src_pos(edge), entry_x);
+	}
+	ir_node *const bad  = new_r_Bad(irg, mode_X);
+	ir_node *const in[] = { bad, bad };
+	set_irn_in(second->header, ARRAY_SIZE(in), in);
+}
+
+/** Walker: collects blocks, which might be loop headers. */
+static void collect_headers(ir_node *block, void *data)
+{
+	ir_node ***const headers = (ir_node***)data;
+	if (get_Block_n_cfgpreds(block) == 2)
+		ARR_APP1(ir_node*, *headers, block);
+}
+
+static void init_loop(floop_t *const loop)
+{
+	memset(loop, 0, sizeof(*loop));
+	loop->memops = NEW_ARR_F(ir_node*, 0);
+}
+
+static void free_loop(floop_t *const loop)
+{
+	DEL_ARR_F(loop->memops);
+}
+
+/** Fuses one pair of loops, returns false if there was none. */
+static bool fuse_one(ir_graph *const irg)
+{
+	ir_node **headers = NEW_ARR_F(ir_node*, 0);
+	irg_block_walk_graph(irg, collect_headers, NULL, &headers);
+
+	bool fused = false;
+	for (size_t i = 0, n = ARR_LEN(headers); i < n && !fused; ++i) {
+		floop_t second;
+		floop_t first;
+		init_loop(&second);
+		init_loop(&first);
+		if (analyze_loop(&second, headers[i])
+		 && find_previous_loop(&first, &second) && may_fuse(&first, &second)) {
+			fuse_loops(&first, &second);
+			fused = true;
+		}
+		free_loop(&first);
+		free_loop(&second);
+	}
+	DEL_ARR_F(headers);
+	return fused;
+}
+
+void opt_loop_fusion(ir_graph *irg)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.opt.loop_fusion");
+
+	bool changed = false;
+	for (unsigned n = 0; n < MAX_TRANSFORMS; ++n) {
+		assure_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES
+		                         | IR_GRAPH_PROPERTY_NO_TUPLES
+		                         | IR_GRAPH_PROPERTY_NO_BADS
+		                         | IR_GRAPH_PROPERTY_NO_UNREACHABLE_CODE
+		                         | IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE
+		                         | IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO);
+		if (!fuse_one(irg))
+			break;
+		changed = true;
+		confirm_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES);
+	}
+
+	confirm_irg_properties(irg, changed ? IR_GRAPH_PROPERTIES_NONE
+	                                    : IR_GRAPH_PROPERTIES_ALL);
+}
+
+/**
+ * Computes the change of the value of @p node per iteration of @p loop.
+ * Returns false if the value is not an affine function of the induction
+ * variable or might wrap around.
+ */
+static bool get_stride(floop_t const *const loop, ir_node *const node,
+                       long *const stride, unsigned const depth)
+{
+	if (!is_in_loop(loop, node)) {
+		*stride = 0;
+		return true;
+	}
+	if (node == get_iv(loop)) {
+		return tarval_is_long(loop->tc->iv->step_tv)
+		    && (*stride = get_tarval_long(loop->tc->iv->step_tv), true);
+	}
+	if (depth >= MAX_EXPR_DEPTH)
+		return false;
+
+	ir_mode *const mode = get_irn_mode(node);
+	long           s0;
+	long           s1;
+	switch (get_irn_opcode(node)) {
+	case iro_Add:
+	case iro_Sub:
+		if (!get_stride(loop, get_binop_left(node), &s0, depth + 1)
+		 || !get_stride(loop, get_binop_right(node), &s1, depth + 1))
+			return false;
+		*stride = is_Add(node) ? s0 + s1 : s0 - s1;
+		break;
+	case iro_Mul: {
+		ir_node *const right = get_Mul_right(node);
+		if (!is_Const(right) || !tarval_is_long(get_Const_tarval(right))
+		 || !get_stride(loop, get_Mul_left(node), &s0, depth + 1))
+			return false;
+		*stride = s0 * get_Const_long(right);
+		break;
+	}
+	case iro_Shl: {
+		ir_node *const right = get_Shl_right(node);
+		if (!is_Const(right)
+		 || !get_stride(loop, get_Shl_left(node), &s0, depth + 1))
+			return false;
+		long const shift = get_Const_long(right);
+		if (shift < 0 || shift >= 16)
+			return false;
+		*stride = s0 << shift;
+		break;
+	}
+	case iro_Conv:
+		return get_stride(loop, get_Conv_op(node), stride, depth + 1);
+	case iro_Member:
+		return get_stride(loop, get_Member_ptr(node), stride, depth + 1);
+	default:
+		return false;
+	}
+	if (*stride != 0 && get_mode_size_bytes(mode) < ir_target_pointer_size())
+		return false;
+	return true;
+}
+
+static bool has_unit_stride(floop_t const *const loop, ir_node *const memop)
+{
+	long stride;
+	return get_stride(loop, get_memop_ptr(memop), &stride, 0)
+	    && stride == (long)get_memop_size(memop);
+}
+
+/**
+ * Checks whether @p value is computed from unit stride Loads, the induction
+ * variable and loop invariant values only.
+ */
+static bool is_regular_value(floop_t const *const loop, ir_node *const value,
+                             unsigned const depth)
+{
+	if (!is_in_loop(loop, value) || value == get_iv(loop))
+		return true;
+	if (depth >= MAX_EXPR_DEPTH || is_Phi(value))
+		return false;
+	if (is_Proj(value)) {
+		ir_node *const load = get_Proj_pred(value);
+		return is_Load(load) && get_Proj_num(value) == pn_Load_res
+		    && has_unit_stride(loop, load);
+	}
+	foreach_irn_in(value, i, pred) {
+		if (!is_regular_value(loop, pred, depth + 1))
+			return false;
+	}
+	return true;
+}
+
+/** Adds @p node and the loop nodes its value depends on to @p set. */
+static void mark_operands(floop_t const *const loop, ir_nodeset_t *const set,
+                          ir_node *const node)
+{
+	if (!is_in_loop(loop, node) || !ir_nodeset_insert(set, node))
+		return;
+	if (is_Phi(node)) {
+		if (node != loop->mem_phi)
+			mark_operands(loop, set, get_Phi_pred(node, 1 - loop->entry_pos));
+		return;
+	}
+	foreach_irn_in(node, i, pred) {
+		if (get_irn_mode(pred) != mode_M)
+			mark_operands(loop, set, pred);
+	}
+}
+
+/**
+ * Returns the position of @p memop in the memory chain of the loop, Loads
+ * are placed directly behind the operation they depend on.
+ */
+static size_t get_mem_pos(floop_t const *const loop, ir_node **const chain,
+                          ir_node *const memop)
+{
+	for (size_t i = 0, n = ARR_LEN(chain); i < n; ++i) {
+		if (chain[i] == memop)
+			return 2 * i + 2;
+	}
+	ir_node *const mem = get_memop_mem(memop);
+	if (mem == loop->mem_phi || !is_in_loop(loop, mem))
+		return 1;
+	return get_mem_pos(loop, chain, get_Proj_pred(mem)) + 1;
+}
+
+/**
+ * Checks that moving @p first of the regular part before all iterations of
+ * @p second of the remaining part keeps their dependence.
+ */
+static bool may_precede(floop_t const *const loop, ir_node **const chain,
+                        ir_node *const first, ir_node *const second)
+{
+	ir_dependence_t dep;
+	switch (get_dependence(first, second, &dep)) {
+	case dep_none:
+		return true;
+	case dep_exists: {
+		/* first must not depend on second of an earlier iteration */
+		unsigned const n = dep.n_loops;
+		if (n == 0 || dep.loops[n - 1] != get_irn_loop(loop->header)
+		 || (dep.directions[n - 1] & dep_dir_greater))
+			return false;
+		return !(dep.directions[n - 1] & dep_dir_equal)
+		    || get_mem_pos(loop, chain, first) < get_mem_pos(loop, chain, second);
+	}
+	case dep_unknown:
+		break;
+	}
+	if (is_no_alias(first, second))
+		return true;
+	return is_same_access(loop, first, loop, second)
+	    && get_mem_pos(loop, chain, first) < get_mem_pos(loop, chain, second);
+}
+
+/**
+ * Determines the vectorizable Stores of @p loop, which may be moved into a
+ * loop executed before @p loop.
+ */
+static bool analyze_distribution(floop_t const *const loop,
+                                 ir_nodeset_t *const regular)
+{
+	if (loop->mem_phi == NULL)
+		return false;
+
+	/* The Stores must form a single memory chain. */
+	ir_node **chain = NEW_ARR_F(ir_node*, 0);
+	ir_node  *mem   = get_Phi_pred(loop->mem_phi, 1 - loop->entry_pos);
+	while (mem != loop->mem_phi) {
+		if (!is_Proj(mem) || !is_in_loop(loop, mem))
+			goto fail;
+		ir_node *const op = get_Proj_pred(mem);
+		if (!is_Load(op) && !is_Store(op))
+			goto fail;
+		ARR_APP1(ir_node*, chain, op);
+		mem = get_memop_mem(op);
+	}
+	for (size_t i = 0, n = ARR_LEN(chain); i < n / 2; ++i) {
+		ir_node *const t = chain[i];
+		chain[i]         = chain[n - 1 - i];
+		chain[n - 1 - i] = t;
+	}
+
+	size_t n_irregular = 0;
+	for (size_t i = 0, n = ARR_LEN(loop->memops); i < n; ++i) {
+		ir_node *const memop = loop->memops[i];
+		if (!is_Store(memop))
+			continue;
+		if (get_mem_pos(loop, chain, memop) % 2 != 0)
+			goto fail;
+		if (has_unit_stride(loop, memop)
+		 && is_regular_value(loop, get_Store_value(memop), 0))
+			ir_nodeset_insert(regular, memop);
+		else
+			++n_irregular;
+	}
+	if (ir_nodeset_size(regular) == 0 || n_irregular == 0)
+		goto fail;
+
+	/* Values needed by each part, including the exit condition and the values
+	 * used after the loop in the remaining part. */
+	ir_nodeset_t used_regular;
+	ir_nodeset_t used_rest;
+	ir_nodeset_init(&used_regular);
+	ir_nodeset_init(&used_rest);
+	for (int b = 0; b < 2; ++b) {
+		ir_node *const block = b == 0 ? loop->header : loop->body;
+		foreach_out_edge(block, edge) {
+			ir_node *const node = get_edge_src_irn(edge);
+			if (is_Store(node)) {
+				ir_nodeset_t *const set = ir_nodeset_contains(regular, node)
+					? &used_regular : &used_rest;
+				mark_operands(loop, set, get_Store_ptr(node));
+				mark_operands(loop, set, get_Store_value(node));
+			} else if (is_Phi(node) || is_cfop(node)) {
+				mark_operands(loop, &used_rest, node);
+			} else if (get_irn_mode(node) != mode_X) {
+				foreach_out_edge(node, user_edge) {
+					if (!is_in_loop(loop, get_edge_src_irn(user_edge)))
+						mark_operands(loop, &used_rest, node);
+				}
+			}
+		}
+	}
+
+	bool legal = true;
+	foreach_ir_nodeset(regular, store, iter) {
+		for (size_t i = 0, n = ARR_LEN(loop->memops); i < n && legal; ++i) {
+			ir_node *const memop = loop->memops[i];
+			if (is_Store(memop)) {
+				legal = ir_nodeset_contains(regular, memop)
+				     || may_precede(loop, chain, store, memop);
+				continue;
+			}
+			if (ir_nodeset_contains(&used_rest, memop))
+				legal = may_precede(loop, chain, store, memop);
+			if (legal && ir_nodeset_contains(&used_regular, memop)) {
+				/* Loads of the regular part must not see later Stores */
+				for (size_t j = 0; j < n && legal; ++j) {
+					ir_node *const other = loop->memops[j];
+					if (is_Store(other) && !ir_nodeset_contains(regular, other))
+						legal = may_precede(loop, chain, memop, other);
+				}
+			}
+		}
+		if (!legal)
+			break;
+	}
+	ir_nodeset_destroy(&used_rest);
+	ir_nodeset_destroy(&used_regular);
+	DEL_ARR_F(chain);
+	return legal;
+
+fail:
+	DEL_ARR_F(chain);
+	return false;
+}
+
+static ir_node *copy_node(copy_env_t *env, ir_node *node);
+
+/** Returns the copy of memory @p mem, skipping all operations not copied. */
+static ir_node *copy_mem(copy_env_t *const env, ir_node *mem)
+{
+	for (;;) {
+		if (!is_in_loop(env->loop, mem) || mem == env->loop->mem_phi)
+			return copy_node(env, mem);
+		ir_node *const op = get_Proj_pred(mem);
+		if (is_Store(op) && ir_nodeset_contains(env->stores, op))
+			return copy_node(env, mem);
+		mem = get_memop_mem(op);
+	}
+}
+
+/**
+ * Copies @p node into the copied loop.  Nodes outside of the loop are used
+ * directly, the Phis of the header must have been mapped before.
+ */
+static ir_node *copy_node(copy_env_t *const env, ir_node *const node)
+{
+	if (!is_in_loop(env->loop, node))
+		return node;
+	ir_node *res = ir_nodemap_get(ir_node, &env->map, node);
+	if (res != NULL)
+		return res;
+	assert(!is_Phi(node));
+
+	int       const arity = get_irn_arity(node);
+	ir_node **const ins   = ALLOCAN(ir_node*, arity);
+	for (int i = 0; i < arity; ++i) {
+		ir_node *const pred = get_irn_n(node, i);
+		ins[i] = get_irn_mode(pred) == mode_M ? copy_mem(env, pred)
+		                                      : copy_node(env, pred);
+	}
+	ir_node *const block = get_nodes_block(node) == env->loop->header
+		? env->header : env->body;
+	res = new_similar_node(node, block, ins);
+	ir_nodemap_insert(&env->map, node, res);
+	return res;
+}
+
+/** Creates a Phi in @p block with entry value @p init at @p entry. */
+static ir_node *new_loop_Phi(ir_node *const block, ir_node *const init,
+                             int const entry)
+{
+	ir_graph *const irg  = get_irn_irg(block);
+	ir_mode  *const mode = get_irn_mode(init);
+	ir_node        *in[2];
+	in[entry]     = init;
+	in[1 - entry] = new_r_Dummy(irg, mode);
+	return new_r_Phi(block, ARRAY_SIZE(in), in, mode);
+}
+
+/** Moves the Stores in @p regular into a copy of @p loop executed before. */
+static void distribute_loop(floop_t const *const loop,
+                            ir_nodeset_t *const regular)
+{
+	ir_graph *const irg     = get_irn_irg(loop->header);
+	ir_node  *const header  = loop->header;
+	int       const entry   = loop->entry_pos;
+	ir_node  *const iv      = get_iv(loop);
+	ir_node  *const mem_phi = loop->mem_phi;
+
+	DB((dbg, LEVEL_1, "distributing loop %+F, moving %zu Stores\n", header,
+	    ir_nodeset_size(regular)));
+
+	ir_node *const entry_x    = get_Block_cfgpred(header, entry);
+	ir_node *const head_in[]  = { entry_x, entry_x };
+	copy_env_t     env;
+	env.loop   = loop;
+	env.header = new_r_Block(irg, ARRAY_SIZE(head_in), head_in);
+	env.body   = new_r_Block(irg, 1, &entry_x);
+	env.stores = regular;
+	ir_nodemap_init(&env.map, irg);
+
+	ir_node *const civ  = new_loop_Phi(env.header, get_Phi_pred(iv, entry),
+	                                   entry);
+	ir_node *const cmem = new_loop_Phi(env.header,
+	                                   get_Phi_pred(mem_phi, entry), entry);
+	ir_nodemap_insert(&env.map, iv, civ);
+	ir_nodemap_insert(&env.map, mem_phi, cmem);
+	set_Phi_pred(civ, 1 - entry, copy_node(&env, get_Phi_pred(iv, 1 - entry)));
+	set_Phi_pred(cmem, 1 - entry,
+	             copy_mem(&env, get_Phi_pred(mem_phi, 1 - entry)));
+
+	ir_node *const body_x = get_Block_cfgpred(loop->body, 0);
+	set_Block_cfgpred(env.body, 0, copy_node(&env, body_x));
+	set_Block_cfgpred(env.header, 1 - entry, new_r_Jmp(env.body));
+	ir_node *const exit_x  = copy_node(&env, loop->exit);
+	ir_node *const between = new_r_Block(irg, 1, &exit_x);
+	ir_nodemap_destroy(&env.map);
+
+	/* The original loop follows its copy and keeps the other Stores. */
+	set_Block_cfgpred(header, entry, new_r_Jmp(between));
+	set_Phi_pred(mem_phi, entry, cmem);
+	foreach_ir_nodeset(regular, store, iter) {
+		ir_node *const proj = get_Store_M_proj(store);
+		exchange(proj, get_Store_mem(store));
+		kill_node(store);
+	}
+}
+
+/** Distributes one loop, returns false if there was none. */
+static bool distribute_one(ir_graph *const irg)
+{
+	ir_node **headers = NEW_ARR_F(ir_node*, 0);
+	irg_block_walk_graph(irg, collect_headers, NULL, &headers);
+
+	bool distributed = false;
+	for (size_t i = 0, n = ARR_LEN(headers); i < n && !distributed; ++i) {
+		floop_t loop;
+		init_loop(&loop);
+		ir_nodeset_t regular;
+		ir_nodeset_init(&regular);
+		if (analyze_loop(&loop, headers[i])
+		 && analyze_distribution(&loop, &regular)) {
+			distribute_loop(&loop, &regular);
+			distributed = true;
+		}
+		ir_nodeset_destroy(&regular);
+		free_loop(&loop);
+	}
+	DEL_ARR_F(headers);
+	return distributed;
+}
+
+void opt_loop_distribution(ir_graph *irg)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.opt.loop_fusion");
+
+	bool changed = false;
+	for (unsigned n = 0; n < MAX_TRANSFORMS; ++n) {
+		assure_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES
+		                         | IR_GRAPH_PROPERTY_NO_TUPLES
+		                         | IR_GRAPH_PROPERTY_NO_BADS
+		                         | IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO);
+		if (!distribute_one(irg))
+			break;
+		changed = true;
+		confirm_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES);
+	}
+
+	confirm_irg_properties(irg, changed ? IR_GRAPH_PROPERTIES_NONE
+	                                    : IR_GRAPH_PROPERTIES_ALL);
+}
@@ -0,0 +1,631 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2017 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Loop unswitching.
+ *
+ * A Cond inside a loop whose selector is loop invariant decides the same way
+ * in every iteration. The loop is duplicated: a new preheader evaluates the
+ * condition once and enters the original loop, in which the Cond always
+ * takes its true successor, or the copy, in which it always takes its false
+ * successor. The dead parts of both loops are removed by later control flow
+ * optimizations. The exits of the copy join the exits of the original loop,
+ * values defined in the loop are merged by Phis there.
+ *
+ * The outermost loop for which the selector is invariant is unswitched, as
+ * long as it is not too large. Unswitching pays off if the Cond is executed
+ * considerably more often than the loop is entered, which is estimated from
+ * the execution frequencies. Code growth is limited per loop and per graph.
+ */
+#include "array.h"
+#include "debug.h"
+#include "execfreq.h"
+#include "ircons.h"
+#include "iredges_t.h"
+#include "irgmod.h"
+#include "irgraph_t.h"
+#include "irgwalk.h"
+#include "irloop_t.h"
+#include "irnode_t.h"
+#include "irnodemap.h"
+#include "iroptimize.h"
+#include "irtools.h"
+#include "loop_unswitch.h"
+#include "pmap.h"
+#include "util.h"
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg;)
+
+/** Maximum number of nodes in an unswitched loop. */
+#define MAX_LOOP_NODES    256
+/** Maximum growth of a graph in percent of its initial size. */
+#define MAX_GROWTH        100
+/** Maximum number of loops unswitched in a graph. */
+#define MAX_UNSWITCHES    16
+/**
+ * Minimum number of executions of the Cond per entry of the loop for
+ * unswitching to be beneficial.
+ */
+#define MIN_BENEFIT       2.0
+/** Maximum depth of a loop invariant expression inside the loop. */
+#define MAX_EXPR_DEPTH    8
+
+/** Facts about a loop. */
+typedef struct loop_info_t {
+	ir_loop  *loop;
+	ir_node  *header;      /**< the only block entered from outside */
+	bool      irreducible; /**< entered at more than one block */
+	unsigned  n_nodes;     /**< number of nodes in the loop and nested loops */
+	double    entry_freq;  /**< execution frequency of the loop entries */
+} loop_info_t;
+
+/** An invariant Cond and the loop it could be unswitched from. */
+typedef struct candidate_t {
+	ir_node     *cond;
+	loop_info_t *info;
+	double       benefit; /**< saved executions of the Cond */
+} candidate_t;
+
+typedef struct unswitch_env_t {
+	pmap         *loops;      /**< maps loops to their loop_info_t */
+	candidate_t  *candidates; /**< the invariant Conds */
+	unsigned      budget;     /**< number of nodes which may be added */
+} unswitch_env_t;
+
+/** Checks whether @p inner is @p loop or one of its nested loops. */
+static bool loop_contains(const ir_loop *loop, const ir_loop *inner)
+{
+	if (inner == NULL)
+		return false;
+	unsigned const depth = get_loop_depth(loop);
+	while (get_loop_depth(inner) > depth)
+		inner = get_loop_outer_loop(inner);
+	return inner == loop;
+}
+
+static bool is_block_in_loop(const ir_node *block, const ir_loop *loop)
+{
+	return loop_contains(loop, get_irn_loop(block));
+}
+
+static bool is_in_loop(const ir_node *node, const ir_loop *loop)
+{
+	return is_block_in_loop(get_block_const(node), loop);
+}
+
+static bool is_root_loop(const ir_loop *loop)
+{
+	return get_loop_outer_loop(loop) == loop;
+}
+
+/**
+ * Checks whether the value of @p node does not change inside @p loop: it is
+ * defined outside or computed by floating nodes from such values.
+ */
+static bool is_invariant(const ir_node *node, const ir_loop *loop,
+                         unsigned depth)
+{
+	if (!is_in_loop(node, loop))
+		return true;
+	if (depth >= MAX_EXPR_DEPTH || is_Phi(node)
+	    || get_irn_pinned(node) != op_pin_state_floats)
+		return false;
+	foreach_irn_in(node, i, pred) {
+		if (!is_invariant(pred, loop, depth + 1))
+			return false;
+	}
+	return true;
+}
+
+/** Copies the invariant expression @p node of @p loop into @p block. */
+static ir_node *copy_invariant(ir_node *node, const ir_loop *loop,
+                               ir_node *block)
+{
+	if (!is_in_loop(node, loop))
+		return node;
+	ir_node *const copy = exact_copy(node);
+	set_nodes_block(copy, block);
+	foreach_irn_in(node, i, pred) {
+		set_irn_n(copy, i, copy_invariant(pred, loop, block));
+	}
+	return copy;
+}
+
+static loop_info_t *get_loop_info(unswitch_env_t *env, ir_loop *loop)
+{
+	loop_info_t *info = pmap_get(loop_info_t, env->loops, loop);
+	if (info == NULL) {
+		info       = XMALLOCZ(loop_info_t);
+		info->loop = loop;
+		pmap_insert(env->loops, loop, info);
+	}
+	return info;
+}
+
+/** Counts the nodes of all loops and finds their headers. */
+static void analyze_node(ir_node *node, void *data)
+{
+	unswitch_env_t *const env   = (unswitch_env_t*)data;
+	ir_node        *const block = get_block(node);
+	for (ir_loop *loop = get_irn_loop(block); loop != NULL
+	     && !is_root_loop(loop); loop = get_loop_outer_loop(loop)) {
+		++get_loop_info(env, loop)->n_nodes;
+	}
+	if (!is_Block(node))
+		return;
+
+	for (int i = 0, n = get_Block_n_cfgpreds(node); i < n; ++i) {
+		ir_node *const pred = get_Block_cfgpred_block(node, i);
+		/* the edge enters all loops containing node but not pred */
+		for (ir_loop *loop = get_irn_loop(node); loop != NULL
+		     && !is_root_loop(loop) && !is_block_in_loop(pred, loop);
+		     loop = get_loop_outer_loop(loop)) {
+			loop_info_t *const info = get_loop_info(env, loop);
+			if (info->header != NULL && info->header != node)
+				info->irreducible = true;
+			info->header      = node;
+			info->entry_freq += get_block_execfreq(pred);
+		}
+	}
+}
+
+/**
+ * Returns the outermost loop in which the selector of @p cond is invariant
+ * and which may be unswitched.
+ */
+static loop_info_t *find_loop(unswitch_env_t *env, ir_node *cond)
+{
+	ir_node     *const selector = get_Cond_selector(cond);
+	loop_info_t       *result   = NULL;
+	for (ir_loop *loop = get_irn_loop(get_nodes_block(cond)); loop != NULL
+	     && !is_root_loop(loop) && is_invariant(selector, loop, 0);
+	     loop = get_loop_outer_loop(loop)) {
+		loop_info_t *const info = get_loop_info(env, loop);
+		if (info->header == NULL || info->irreducible
+		    || info->n_nodes > MAX_LOOP_NODES || info->n_nodes > env->budget)
+			break;
+		result = info;
+	}
+	return result;
+}
+
+static void collect_conds(ir_node *node, void *data)
+{
+	unswitch_env_t *const env = (unswitch_env_t*)data;
+	if (!is_Cond(node) || is_Const(get_Cond_selector(node)))
+		return;
+	loop_info_t *const info = find_loop(env, node);
+	if (info == NULL || info->entry_freq <= 0)
+		return;
+	double const freq = get_block_execfreq(get_nodes_block(node));
+	if (freq < MIN_BENEFIT * info->entry_freq)
+		return;
+	candidate_t const candidate = {
+		.cond    = node,
+		.info    = info,
+		.benefit = freq - info->entry_freq,
+	};
+	ARR_APP1(candidate_t, env->candidates, candidate);
+}
+
+static int cmp_candidates(const void *p1, const void *p2)
+{
+	candidate_t const *const c1 = (candidate_t const*)p1;
+	candidate_t const *const c2 = (candidate_t const*)p2;
+	if (c1->benefit != c2->benefit)
+		return c1->benefit < c2->benefit ? 1 : -1;
+	return get_irn_idx(c1->cond) < get_irn_idx(c2->cond) ? -1 : 1;
+}
+
+typedef struct collect_env_t {
+	ir_loop  *loop;
+	ir_node **nodes;  /**< the nodes of the loop */
+	bool      failed; /**< the loop cannot be duplicated */
+} collect_env_t;
+
+static void collect_loop_node(ir_node *node, void *data)
+{
+	collect_env_t *const env = (collect_env_t*)data;
+	if (!is_in_loop(node, env->loop))
+		return;
+	ARR_APP1(ir_node*, env->nodes, node);
+
+	if (is_Block(node)) {
+		/* labels must be unique */
+		if (get_Block_entity(node) != NULL)
+			env->failed = true;
+		return;
+	}
+	/* no Phis with mode_b may be created at the exits */
+	if (get_irn_mode(node) == mode_b) {
+		foreach_out_edge(node, edge) {
+			if (!is_in_loop(get_edge_src_irn(edge), env->loop))
+				env->failed = true;
+		}
+	}
+}
+
+static ir_node *ssa_second_def;
+static ir_node *ssa_second_def_block;
+
+static ir_node *search_def_and_create_phis(ir_node *block, ir_mode *mode,
+                                           bool first)
+{
+	/* the second definition may only be used if we walked at least one
+	 * block away from a user in its block */
+	if (block == ssa_second_def_block && !first)
+		return ssa_second_def;
+
+	/* already processed this block? */
+	if (irn_visited(block))
+		return (ir_node*)get_irn_link(block);
+
+	ir_graph *const irg = get_irn_irg(block);
+	assert(block != get_irg_start_block(irg));
+
+	/* a Block with only 1 predecessor needs no Phi */
+	int const n_cfgpreds = get_Block_n_cfgpreds(block);
+	if (n_cfgpreds == 1) {
+		ir_node *const pred_block = get_Block_cfgpred_block(block, 0);
+		ir_node *const value      = pred_block == NULL ? new_r_Bad(irg, mode)
+			: search_def_and_create_phis(pred_block, mode, false);
+		set_irn_link(block, value);
+		mark_irn_visited(block);
+		return value;
+	}
+
+	/* create a new Phi */
+	ir_node **const in    = ALLOCAN(ir_node*, n_cfgpreds);
+	ir_node  *const dummy = new_r_Dummy(irg, mode);
+	for (int i = 0; i < n_cfgpreds; ++i)
+		in[i] = dummy;
+	ir_node *const phi = mode == mode_M ? new_r_Phi_loop(block, n_cfgpreds, in)
+	                                    : new_r_Phi(block, n_cfgpreds, in, mode);
+	set_irn_link(block, phi);
+	mark_irn_visited(block);
+
+	/* set Phi predecessors */
+	for (int i = 0; i < n_cfgpreds; ++i) {
+		ir_node *const pred_block = get_Block_cfgpred_block(block, i);
+		ir_node *const pred_val   = pred_block == NULL ? new_r_Bad(irg, mode)
+			: search_def_and_create_phis(pred_block, mode, false);
+		set_irn_n(phi, i, pred_val);
+	}
+	return phi;
+}
+
+/**
+ * Reconstructs SSA form for the users of @p orig_val outside of the loop
+ * @p loop, which are reached by @p orig_val or its copy @p second_val.
+ */
+static void construct_ssa(ir_loop *loop, ir_node *orig_val,
+                          ir_node *second_val)
+{
+	ir_graph *const irg = get_irn_irg(orig_val);
+	inc_irg_visited(irg);
+
+	ir_node *const orig_block = get_nodes_block(orig_val);
+	set_irn_link(orig_block, orig_val);
+	mark_irn_visited(orig_block);
+	ssa_second_def_block = get_nodes_block(second_val);
+	ssa_second_def       = second_val;
+
+	ir_mode *const mode = get_irn_mode(orig_val);
+	foreach_out_edge_safe(orig_val, edge) {
+		ir_node *const user = get_edge_src_irn(edge);
+		if (is_End(user) || is_in_loop(user, loop))
+			continue;
+
+		int      const pos        = get_edge_src_pos(edge);
+		ir_node *const user_block = get_nodes_block(user);
+		ir_node       *newval;
+		if (is_Phi(user)) {
+			ir_node *const pred_block = get_Block_cfgpred_block(user_block, pos);
+			newval = pred_block == NULL ? new_r_Bad(irg, mode)
+				: search_def_and_create_phis(pred_block, mode, true);
+		} else {
+			newval = search_def_and_create_phis(user_block, mode, true);
+		}
+		if (newval != user)
+			set_irn_n(user, pos, newval);
+	}
+}
+
+static ir_node *get_copy(ir_nodemap *map, ir_node *node)
+{
+	ir_node *const copy = ir_nodemap_get(ir_node, map, node);
+	return copy != NULL ? copy : node;
+}
+
+/** Appends @p pred to the inputs of the Block or Phi @p node. */
+static void append_pred(ir_node *node, ir_node *pred)
+{
+	int       const n  = get_irn_arity(node);
+	ir_node **const in = ALLOCAN(ir_node*, n + 1);
+	MEMCPY(in, get_irn_in(node), n);
+	in[n] = pred;
+	set_irn_in(node, n + 1, in);
+}
+
+/** Replaces @p cond by a jump to its successor @p pn. */
+static void fold_cond(ir_node *cond, unsigned pn)
+{
+	ir_node *const block = get_nodes_block(cond);
+	ir_graph *const irg  = get_irn_irg(cond);
+	foreach_out_edge_safe(cond, edge) {
+		ir_node *const proj = get_edge_src_irn(edge);
+		if (get_Proj_num(proj) == pn)
+			exchange(proj, new_r_Jmp(block));
+		else
+			exchange(proj, new_r_Bad(irg, mode_X));
+	}
+}
+
+/**
+ * Lets the entries of the loop @p header and its copy enter a new preheader
+ * instead, which branches on @p selector.
+ */
+static void create_preheader(ir_nodemap *map, ir_loop *loop, ir_node *header,
+                             ir_node *selector)
+{
+	ir_graph *const irg     = get_irn_irg(header);
+	int       const arity   = get_Block_n_cfgpreds(header);
+	ir_node **const entries = ALLOCAN(ir_node*, arity);
+	ir_node **const in      = ALLOCAN(ir_node*, arity + 1);
+	ir_node **const in_cp   = ALLOCAN(ir_node*, arity + 1);
+	int             n_entries = 0;
+	int             n_in      = 1;
+	for (int i = 0; i < arity; ++i) {
+		ir_node *const pred = get_Block_cfgpred(header, i);
+		if (is_block_in_loop(get_Block_cfgpred_block(header, i), loop)) {
+			in[n_in]      = pred;
+			in_cp[n_in++] = get_copy(map, pred);
+		} else {
+			entries[n_entries++] = pred;
+		}
+	}
+	ir_node *const preheader = new_r_Block(irg, n_entries, entries);
+	ir_node *const cond      = new_r_Cond(preheader,
+	                                       copy_invariant(selector, loop,
+	                                                      preheader));
+	in[0]    = new_r_Proj(cond, mode_X, pn_Cond_true);
+	in_cp[0] = new_r_Proj(cond, mode_X, pn_Cond_false);
+	DB((dbg, LEVEL_2, "  preheader %+F\n", preheader));
+
+	ir_node **const vals     = ALLOCAN(ir_node*, arity + 1);
+	ir_node **const vals_cp  = ALLOCAN(ir_node*, arity + 1);
+	ir_node **const vals_pre = ALLOCAN(ir_node*, arity);
+	foreach_out_edge_safe(header, edge) {
+		ir_node *const phi = get_edge_src_irn(edge);
+		if (!is_Phi(phi))
+			continue;
+		int n_pre = 0;
+		int n_val = 1;
+		for (int i = 0; i < arity; ++i) {
+			ir_node *const val = get_Phi_pred(phi, i);
+			if (is_block_in_loop(get_Block_cfgpred_block(header, i), loop)) {
+				vals[n_val]      = val;
+				vals_cp[n_val++] = get_copy(map, val);
+			} else {
+				vals_pre[n_pre++] = val;
+			}
+		}
+		ir_mode *const mode = get_irn_mode(phi);
+		vals[0] = n_pre == 1 ? vals_pre[0]
+		                     : new_r_Phi(preheader, n_pre, vals_pre, mode);
+		vals_cp[0] = vals[0];
+		set_irn_in(get_copy(map, phi), n_val, vals_cp);
+		set_irn_in(phi, n_val, vals);
+	}
+	set_irn_in(get_copy(map, header), n_in, in_cp);
+	set_irn_in(header, n_in, in);
+}
+
+/**
+ * Duplicates the loop @p loop with the header @p header consisting of
+ * @p nodes. The original loop is entered if @p selector is true, the copy
+ * otherwise. Records the copies in @p map.
+ */
+static void copy_loop(ir_loop *loop, ir_node *header, ir_node *selector,
+                      ir_node **nodes, ir_nodemap *map)
+{
+	ir_graph *const irg = get_irn_irg(header);
+
+	/* find the exits before the loop is copied */
+	typedef struct exit_t { ir_node *block; int pos; } exit_t;
+	exit_t *exits = NEW_ARR_F(exit_t, 0);
+	for (size_t i = 0, n = ARR_LEN(nodes); i < n; ++i) {
+		ir_node *const node = nodes[i];
+		if (get_irn_mode(node) != mode_X)
+			continue;
+		foreach_out_edge(node, edge) {
+			ir_node *const succ = get_edge_src_irn(edge);
+			if (is_Block(succ) && !is_block_in_loop(succ, loop)) {
+				exit_t const exit = { succ, get_edge_src_pos(edge) };
+				ARR_APP1(exit_t, exits, exit);
+			}
+		}
+	}
+
+	/* copy the loop */
+	for (size_t i = 0, n = ARR_LEN(nodes); i < n; ++i)
+		ir_nodemap_insert(map, nodes[i], exact_copy(nodes[i]));
+	for (size_t i = 0, n = ARR_LEN(nodes); i < n; ++i) {
+		ir_node *const node = nodes[i];
+		ir_node *const copy = get_copy(map, node);
+		if (!is_Block(node))
+			set_nodes_block(copy, get_copy(map, get_nodes_block(node)));
+		foreach_irn_in(node, j, pred) {
+			set_irn_n(copy, j, get_copy(map, pred));
+		}
+	}
+
+	/* make sure the copies are kept alive if the originals were */
+	ir_node *const end = get_irg_end(irg);
+	for (int i = 0, n = get_End_n_keepalives(end); i < n; ++i) {
+		ir_node *const keep = get_End_keepalive(end, i);
+		ir_node *const copy = get_copy(map, keep);
+		if (copy != keep)
+			add_End_keepalive(end, copy);
+	}
+
+	create_preheader(map, loop, header, selector);
+
+	/* the exits of the copy lead to the same blocks */
+	for (size_t i = 0, n = ARR_LEN(exits); i < n; ++i) {
+		ir_node *const block = exits[i].block;
+		int      const pos   = exits[i].pos;
+		foreach_out_edge_safe(block, edge) {
+			ir_node *const phi = get_edge_src_irn(edge);
+			if (is_Phi(phi))
+				append_pred(phi, get_copy(map, get_Phi_pred(phi, pos)));
+		}
+		append_pred(block, get_copy(map, get_Block_cfgpred(block, pos)));
+	}
+	DEL_ARR_F(exits);
+
+	/* merge the values used after the loop */
+	for (size_t i = 0, n = ARR_LEN(nodes); i < n; ++i) {
+		ir_node *const node = nodes[i];
+		ir_mode *const mode = get_irn_mode(node);
+		if (is_Block(node) || mode == mode_X || mode == mode_T)
+			continue;
+		construct_ssa(loop, node, get_copy(map, node));
+	}
+}
+
+/** Duplicates the loop of @p info and specializes @p cond in both copies. */
+static void unswitch(loop_info_t *info, ir_node *cond, ir_node **nodes)
+{
+	ir_loop  *const loop   = info->loop;
+	ir_node  *const header = info->header;
+	DB((dbg, LEVEL_1, "unswitching %+F from loop %ld (%u nodes)\n", cond,
+	    get_loop_loop_nr(loop), info->n_nodes));
+
+	ir_nodemap map;
+	ir_nodemap_init(&map, get_irn_irg(header));
+	copy_loop(loop, header, get_Cond_selector(cond), nodes, &map);
+	fold_cond(get_copy(&map, cond), pn_Cond_false);
+	fold_cond(cond, pn_Cond_true);
+	ir_nodemap_destroy(&map);
+}
+
+/** Unswitches the most beneficial candidate. Returns its size or 0. */
+static unsigned unswitch_candidate(unswitch_env_t *env)
+{
+	candidate_t *const candidates = env->candidates;
+	size_t       const n          = ARR_LEN(candidates);
+	QSORT(candidates, n, cmp_candidates);
+	for (size_t i = 0; i < n; ++i) {
+		loop_info_t *const info = candidates[i].info;
+		ir_graph    *const irg  = get_irn_irg(info->header);
+		collect_env_t cenv = {
+			.loop   = info->loop,
+			.nodes  = NEW_ARR_F(ir_node*, 0),
+			.failed = false,
+		};
+		irg_walk_graph(irg, NULL, collect_loop_node, &cenv);
+		if (!cenv.failed) {
+			ir_reserve_resources(irg, IR_RESOURCE_IRN_VISITED
+			                        | IR_RESOURCE_IRN_LINK);
+			unswitch(info, candidates[i].cond, cenv.nodes);
+			ir_free_resources(irg, IR_RESOURCE_IRN_VISITED
+			                     | IR_RESOURCE_IRN_LINK);
+		}
+		DEL_ARR_F(cenv.nodes);
+		if (!cenv.failed)
+			return info->n_nodes;
+	}
+	return 0;
+}
+
+/**
+ * Returns the only block of @p loop entered from outside or NULL if the loop
+ * is irreducible.
+ */
+static ir_node *get_loop_header(const ir_loop *loop)
+{
+	ir_node *header = NULL;
+	for (size_t i = 0, n = get_loop_n_elements(loop); i < n; ++i) {
+		loop_element const element = get_loop_element(loop, i);
+		if (*element.kind != k_ir_node)
+			continue;
+		ir_node *const block = element.node;
+		for (int j = 0, arity = get_Block_n_cfgpreds(block); j < arity; ++j) {
+			ir_node *const pred = get_Block_cfgpred_block(block, j);
+			if (pred == NULL || is_block_in_loop(pred, loop))
+				continue;
+			if (header != NULL && header != block)
+				return NULL;
+			header = block;
+		}
+	}
+	return header;
+}
+
+unsigned version_loop(ir_loop *loop, ir_node *selector, unsigned max_nodes,
+                      ir_nodemap *map)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.opt.unswitch");
+	ir_node *const header = get_loop_header(loop);
+	if (header == NULL)
+		return 0;
+
+	ir_graph *const irg = get_irn_irg(header);
+	collect_env_t cenv = {
+		.loop   = loop,
+		.nodes  = NEW_ARR_F(ir_node*, 0),
+		.failed = false,
+	};
+	irg_walk_graph(irg, NULL, collect_loop_node, &cenv);
+	size_t const n_nodes = ARR_LEN(cenv.nodes);
+	if (!cenv.failed && n_nodes <= max_nodes) {
+		DB((dbg, LEVEL_1, "versioning loop %ld on %+F (%zu nodes)\n",
+		    get_loop_loop_nr(loop), selector, n_nodes));
+		ir_reserve_resources(irg, IR_RESOURCE_IRN_VISITED
+		                        | IR_RESOURCE_IRN_LINK);
+		copy_loop(loop, header, selector, cenv.nodes, map);
+		ir_free_resources(irg, IR_RESOURCE_IRN_VISITED | IR_RESOURCE_IRN_LINK);
+	} else {
+		cenv.failed = true;
+	}
+	DEL_ARR_F(cenv.nodes);
+	return cenv.failed ? 0 : (unsigned)n_nodes;
+}
+
+void do_loop_unswitching(ir_graph *irg)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.opt.unswitch");
+	DB((dbg, LEVEL_1, "loop unswitching on %+F\n", irg));
+
+	unswitch_env_t env = {
+		.budget = get_irg_last_idx(irg) * MAX_GROWTH / 100,
+	};
+	bool changed = false;
+	for (unsigned n = 0; n < MAX_UNSWITCHES; ++n) {
+		/* also assures the loop tree and out edges */
+		ir_estimate_execfreq(irg);
+
+		env.loops      = pmap_create();
+		env.candidates = NEW_ARR_F(candidate_t, 0);
+		irg_walk_graph(irg, analyze_node, NULL, &env);
+		irg_walk_graph(irg, collect_conds, NULL, &env);
+		unsigned const size = unswitch_candidate(&env);
+		DEL_ARR_F(env.candidates);
+		foreach_pmap(env.loops, entry) {
+			free(entry->value);
+		}
+		pmap_destroy(env.loops);
+
+		if (size == 0)
+			break;
+		env.budget -= size;
+		changed     = true;
+		confirm_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES);
+	}
+	confirm_irg_properties(irg, changed ? IR_GRAPH_PROPERTIES_NONE
+	                                    : IR_GRAPH_PROPERTIES_ALL);
+}
@@ -0,0 +1,34 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2017 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Loop versioning shared by loop optimizations.
+ */
+#ifndef FIRM_OPT_LOOP_UNSWITCH_H
+#define FIRM_OPT_LOOP_UNSWITCH_H
+
+#include "firm_types.h"
+#include "irnodemap.h"
+
+/**
+ * Duplicates the loop @p loop. A new preheader enters the original loop if
+ * the loop invariant @p selector is true and the copy otherwise. The nodes
+ * of @p selector inside the loop are copied into the preheader. The exits of
+ * both loops join, values used after the loop are merged by Phis.
+ *
+ * Requires consistent out edges and loop information, the latter is
+ * invalidated.
+ *
+ * @param loop       the loop to duplicate
+ * @param selector   the loop invariant mode_b value choosing the loop
+ * @param max_nodes  maximum number of nodes to copy
+ * @param map        initialized map, receives the copies of the loop nodes
+ * @return the number of copied nodes or 0 if the loop was not duplicated
+ */
+unsigned version_loop(ir_loop *loop, ir_node *selector, unsigned max_nodes,
+                      ir_nodemap *map);
+
+#endif
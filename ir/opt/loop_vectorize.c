@@ -0,0 +1,1012 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2017 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Vectorization of innermost counted loops.
+ *
+ * Simple innermost loops consisting of a header with the exit condition and
+ * a single body block are versioned: a guard block checks that the loop
+ * counter cannot overflow and that the memory ranges accessed by the loop do
+ * not overlap.  If the checks succeed a vector loop is executed, which
+ * processes VF iterations at once.  The remaining iterations are executed by
+ * the original loop, which serves as epilogue.
+ *
+ * There are no vector modes in Firm, so the body of the vector loop consists
+ * of VF copies of the scalar body.  The memory operations of the copies are
+ * combined by the SLP vectorizer, which is told about the runtime checks.
+ * Reductions (sums, products, bitwise operations, minimum and maximum) use
+ * one accumulator per lane, which are combined after the vector loop.
+ */
+#include "array.h"
+#include "debug.h"
+#include "ircons_t.h"
+#include "iredges_t.h"
+#include "irgmod.h"
+#include "irgraph_t.h"
+#include "irloop.h"
+#include "irmemory.h"
+#include "irnode_t.h"
+#include "irnodemap.h"
+#include "iroptimize.h"
+#include "irtools.h"
+#include "slp_vectorize.h"
+#include "target_t.h"
+#include "tv_t.h"
+#include "type_t.h"
+#include "util.h"
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg;)
+
+/** Maximum number of nodes in header and body of a vectorized loop. */
+#define MAX_LOOP_NODES     64
+/** Maximum number of pairwise overlap checks in the guard. */
+#define MAX_RUNTIME_CHECKS 8
+/** Maximum vectorization factor. */
+#define MAX_VF             8
+/** Vectorization factor of loops without packable Stores. */
+#define REDUCTION_VF       4
+/** Maximum depth of the address expressions analysed. */
+#define MAX_EXPR_DEPTH     16
+
+typedef enum reduction_kind_t {
+	RED_ADD,
+	RED_SUB,    /**< r - x, the lanes are combined with Add */
+	RED_MUL,
+	RED_AND,
+	RED_OR,
+	RED_EOR,
+	RED_MINMAX, /**< Mux(Cmp(r, x), r, x) in any operand order */
+} reduction_kind_t;
+
+typedef struct reduction_t {
+	ir_node         *phi;            /**< the accumulator Phi in the header */
+	ir_node         *next;           /**< value for the next iteration */
+	reduction_kind_t kind;
+	ir_node         *accs[MAX_VF];   /**< per lane accumulators */
+} reduction_t;
+
+/** A pair of memory accesses, whose ranges are checked at runtime. */
+typedef struct checked_pair_t {
+	ir_node const *ptr0;
+	ir_node const *ptr1;
+} checked_pair_t;
+
+typedef struct vloop_t {
+	ir_graph       *irg;
+	ir_node        *header;
+	ir_node        *body;
+	int             entry_pos;  /**< position of the entry in the header */
+	ir_node        *iv;         /**< induction variable Phi, step 1 */
+	ir_node        *bound;      /**< loop invariant bound */
+	ir_relation     relation;   /**< iv @c relation bound keeps looping */
+	ir_node        *mem_phi;
+	reduction_t    *reductions; /**< flexible array of reductions */
+	ir_node       **memops;     /**< flexible array of Loads and Stores */
+	checked_pair_t *checked;    /**< flexible array of checked pairs */
+	unsigned        vf;         /**< vectorization factor */
+	ir_nodemap      orig_ptr;   /**< lane address -> original address */
+	ir_node        *vhead;      /**< header of the vector loop */
+	ir_node        *viv;        /**< induction variable of the vector loop */
+	ir_node        *vmem;       /**< memory Phi of the vector loop */
+	ir_node        *vexit;      /**< exit Proj of the vector loop */
+} vloop_t;
+
+/** Environment for copying loop nodes. */
+typedef struct copy_env_t {
+	vloop_t    *loop;
+	ir_node    *block;    /**< target block */
+	unsigned    lane;     /**< the lane copied, 0 for the guard */
+	ir_nodemap  map;      /**< original -> copy */
+	ir_nodemap *lane0;    /**< original memop -> lane 0 address */
+} copy_env_t;
+
+static bool is_in_loop(vloop_t const *const loop, ir_node const *const node)
+{
+	ir_node const *const block = get_nodes_block(node);
+	return block == loop->header || block == loop->body;
+}
+
+static bool is_load_store(ir_node const *const node)
+{
+	return is_Load(node) || is_Store(node);
+}
+
+static ir_node *get_memop_ptr(ir_node const *const node)
+{
+	return is_Load(node) ? get_Load_ptr(node) : get_Store_ptr(node);
+}
+
+static ir_type *get_memop_type(ir_node const *const node)
+{
+	return is_Load(node) ? get_Load_type(node) : get_Store_type(node);
+}
+
+static unsigned get_memop_size(ir_node const *const node)
+{
+	ir_mode *const mode = is_Load(node) ? get_Load_mode(node)
+	                                    : get_irn_mode(get_Store_value(node));
+	return get_mode_size_bytes(mode);
+}
+
+/**
+ * Computes the coefficient of the induction variable in the value of @p node,
+ * which must be an affine function of the induction variable.  Arithmetic on
+ * the induction variable must not be performed in modes smaller than a
+ * pointer, as it might wrap around.
+ */
+static bool get_iv_coefficient(vloop_t const *const loop, ir_node *const node,
+                               long *const coef, unsigned const depth)
+{
+	if (node == loop->iv) {
+		*coef = 1;
+		return true;
+	}
+	if (!is_in_loop(loop, node)) {
+		*coef = 0;
+		return true;
+	}
+	if (depth >= MAX_EXPR_DEPTH)
+		return false;
+
+	ir_mode *const mode = get_irn_mode(node);
+	long           c0;
+	long           c1;
+	switch (get_irn_opcode(node)) {
+	case iro_Add:
+	case iro_Sub:
+		if (!get_iv_coefficient(loop, get_binop_left(node), &c0, depth + 1)
+		 || !get_iv_coefficient(loop, get_binop_right(node), &c1, depth + 1))
+			return false;
+		*coef = is_Add(node) ? c0 + c1 : c0 - c1;
+		break;
+	case iro_Mul: {
+		ir_node *left  = get_Mul_left(node);
+		ir_node *right = get_Mul_right(node);
+		if (is_Const(left)) {
+			ir_node *const t = left;
+			left  = right;
+			right = t;
+		}
+		if (!is_Const(right) || !tarval_is_long(get_Const_tarval(right))
+		 || !get_iv_coefficient(loop, left, &c0, depth + 1))
+			return false;
+		*coef = c0 * get_Const_long(right);
+		break;
+	}
+	case iro_Shl: {
+		ir_node *const right = get_Shl_right(node);
+		if (!is_Const(right)
+		 || !get_iv_coefficient(loop, get_Shl_left(node), &c0, depth + 1))
+			return false;
+		long const shift = get_Const_long(right);
+		if (shift < 0 || shift >= 16)
+			return false;
+		*coef = c0 << shift;
+		break;
+	}
+	case iro_Minus:
+		if (!get_iv_coefficient(loop, get_Minus_op(node), &c0, depth + 1))
+			return false;
+		*coef = -c0;
+		break;
+	case iro_Conv: {
+		ir_node *const op      = get_Conv_op(node);
+		ir_mode *const op_mode = get_irn_mode(op);
+		if (!mode_is_int(mode) && !mode_is_reference(mode))
+			return false;
+		if (!get_iv_coefficient(loop, op, &c0, depth + 1))
+			return false;
+		/* only widening of small values keeps the value exact */
+		unsigned const size    = get_mode_size_bytes(mode);
+		unsigned const op_size = get_mode_size_bytes(op_mode);
+		if (c0 != 0 && (size < op_size
+		 || (size == op_size && op_size < ir_target_pointer_size())))
+			return false;
+		*coef = c0;
+		return true;
+	}
+	case iro_Member:
+		return get_iv_coefficient(loop, get_Member_ptr(node), coef, depth + 1);
+	case iro_Sel: {
+		ir_type *const elem = get_array_element_type(get_Sel_type(node));
+		if (!get_iv_coefficient(loop, get_Sel_ptr(node), &c0, depth + 1)
+		 || !get_iv_coefficient(loop, get_Sel_index(node), &c1, depth + 1))
+			return false;
+		*coef = c0 + c1 * (long)get_type_size(elem);
+		break;
+	}
+	default:
+		return false;
+	}
+	if (*coef != 0 && get_mode_size_bytes(mode) < ir_target_pointer_size())
+		return false;
+	return true;
+}
+
+/** Returns the loop invariant pointer an address is based on. */
+static ir_node *get_root(vloop_t const *const loop, ir_node *ptr)
+{
+	while (is_in_loop(loop, ptr)) {
+		if (is_Add(ptr)) {
+			ir_node *const left = get_Add_left(ptr);
+			ptr = mode_is_reference(get_irn_mode(left)) ? left
+			                                            : get_Add_right(ptr);
+		} else if (is_Sub(ptr)) {
+			ptr = get_Sub_left(ptr);
+		} else if (is_Member(ptr)) {
+			ptr = get_Member_ptr(ptr);
+		} else if (is_Sel(ptr)) {
+			ptr = get_Sel_ptr(ptr);
+		} else {
+			return NULL;
+		}
+	}
+	return ptr;
+}
+
+/** Recognizes the reduction computed by header Phi @p phi. */
+static bool analyze_reduction(vloop_t *const loop, ir_node *const phi)
+{
+	ir_mode *const mode = get_irn_mode(phi);
+	if (!mode_is_int(mode))
+		return false;
+	ir_node *const next = get_Phi_pred(phi, 1 - loop->entry_pos);
+	if (!is_in_loop(loop, next) || get_irn_n_edges(next) != 1)
+		return false;
+
+	unsigned n_loop_users = 0;
+	foreach_out_edge(phi, edge) {
+		if (is_in_loop(loop, get_edge_src_irn(edge)))
+			++n_loop_users;
+	}
+
+	reduction_kind_t kind;
+	if (is_Mux(next)) {
+		ir_node *const sel = get_Mux_sel(next);
+		ir_node *const f   = get_Mux_false(next);
+		ir_node *const t   = get_Mux_true(next);
+		if (!is_Cmp(sel) || get_irn_n_edges(sel) != 1 || n_loop_users != 2)
+			return false;
+		ir_node *const l = get_Cmp_left(sel);
+		ir_node *const r = get_Cmp_right(sel);
+		ir_node *const x = f == phi ? t : f;
+		if ((f != phi && t != phi) || x == phi
+		 || !((l == phi && r == x) || (l == x && r == phi)))
+			return false;
+		kind = RED_MINMAX;
+	} else {
+		if (n_loop_users != 1)
+			return false;
+		switch (get_irn_opcode(next)) {
+		case iro_Add: kind = RED_ADD; break;
+		case iro_Sub: kind = RED_SUB; break;
+		case iro_Mul: kind = RED_MUL; break;
+		case iro_And: kind = RED_AND; break;
+		case iro_Or:  kind = RED_OR;  break;
+		case iro_Eor: kind = RED_EOR; break;
+		default:      return false;
+		}
+		ir_node *const left  = get_binop_left(next);
+		ir_node *const right = get_binop_right(next);
+		if (kind == RED_SUB ? left != phi : (left != phi && right != phi))
+			return false;
+		if (left == right)
+			return false;
+	}
+
+	reduction_t red;
+	memset(&red, 0, sizeof(red));
+	red.phi  = phi;
+	red.next = next;
+	red.kind = kind;
+	ARR_APP1(reduction_t, loop->reductions, red);
+	return true;
+}
+
+/** Analyses the header Phis. */
+static bool analyze_phis(vloop_t *const loop)
+{
+	int const back_pos = 1 - loop->entry_pos;
+	foreach_out_edge(loop->header, edge) {
+		ir_node *const phi = get_edge_src_irn(edge);
+		if (!is_Phi(phi))
+			continue;
+		ir_mode *const mode = get_irn_mode(phi);
+		ir_node *const next = get_Phi_pred(phi, back_pos);
+		if (mode == mode_M) {
+			if (loop->mem_phi != NULL)
+				return false;
+			loop->mem_phi = phi;
+			continue;
+		}
+		if (loop->iv == NULL && mode_is_int(mode) && is_Add(next)) {
+			ir_node *const left  = get_Add_left(next);
+			ir_node *const right = get_Add_right(next);
+			ir_node *const step  = left == phi ? right : left;
+			if ((left == phi || right == phi) && is_Const(step)
+			 && is_Const_one(step)) {
+				loop->iv = phi;
+				continue;
+			}
+		}
+		if (!analyze_reduction(loop, phi))
+			return false;
+	}
+	return loop->iv != NULL;
+}
+
+/** Analyses the exit condition of the header. */
+static bool analyze_exit(vloop_t *const loop)
+{
+	ir_node *const proj = get_Block_cfgpred(loop->body, 0);
+	ir_node *const cond = get_Proj_pred(proj);
+	ir_node *const cmp  = get_Cond_selector(cond);
+	if (!is_Cmp(cmp))
+		return false;
+
+	ir_relation relation = get_Cmp_relation(cmp);
+	if (get_Proj_num(proj) == pn_Cond_false)
+		relation = get_negated_relation(relation) & ~ir_relation_unordered;
+	ir_node *bound = get_Cmp_right(cmp);
+	if (get_Cmp_left(cmp) != loop->iv) {
+		if (bound != loop->iv)
+			return false;
+		bound    = get_Cmp_left(cmp);
+		relation = get_inversed_relation(relation);
+	}
+	if (is_in_loop(loop, bound)
+	 || (relation != ir_relation_less && relation != ir_relation_less_equal))
+		return false;
+	loop->bound    = bound;
+	loop->relation = relation;
+	return true;
+}
+
+/** Checks that the nodes of header and body can be copied. */
+static bool analyze_nodes(vloop_t *const loop)
+{
+	unsigned n_nodes = 0;
+	for (int i = 0; i < 2; ++i) {
+		ir_node *const block = i == 0 ? loop->header : loop->body;
+		foreach_out_edge(block, edge) {
+			ir_node *const node = get_edge_src_irn(edge);
+			ir_mode *const mode = get_irn_mode(node);
+			if (++n_nodes > MAX_LOOP_NODES)
+				return false;
+			if (is_Phi(node) || is_cfop(node)
+			 || (is_Proj(node) && is_Cond(get_Proj_pred(node))))
+				continue;
+			if (is_load_store(node)) {
+				if (block != loop->body || ir_throws_exception(node)
+				 || (is_Load(node) ? get_Load_volatility(node)
+				                   : get_Store_volatility(node))
+				    != volatility_non_volatile)
+					return false;
+				ARR_APP1(ir_node*, loop->memops, node);
+				continue;
+			}
+			if (is_Proj(node) && is_load_store(get_Proj_pred(node)))
+				continue;
+			if (is_Sync(node) && block == loop->body)
+				continue;
+			if (mode == mode_M || mode == mode_T || mode == mode_X
+			 || is_Phi(node) || get_irn_pinned(node)
+			 || is_irn_keep(node))
+				return false;
+		}
+	}
+	return true;
+}
+
+/** Checks whether @p value can be computed lane-wise by the SLP vectorizer. */
+static bool is_packable_value(vloop_t const *const loop, ir_node *const value,
+                              unsigned const size, unsigned const depth)
+{
+	if (depth >= MAX_EXPR_DEPTH || !mode_is_int(get_irn_mode(value)))
+		return false;
+	if (is_Const(value))
+		return true;
+	if (!is_in_loop(loop, value))
+		return false;
+	if (is_Conv(value))
+		return is_packable_value(loop, get_Conv_op(value), size, depth + 1);
+	if (is_Not(value))
+		return is_packable_value(loop, get_Not_op(value), size, depth + 1);
+	if (is_And(value) || is_Or(value) || is_Eor(value)) {
+		return is_packable_value(loop, get_binop_left(value), size, depth + 1)
+		    && is_packable_value(loop, get_binop_right(value), size, depth + 1);
+	}
+	if (is_Proj(value) && get_Proj_num(value) == pn_Load_res) {
+		ir_node *const load = get_Proj_pred(value);
+		long           coef;
+		return is_Load(load) && get_memop_size(load) == size
+		    && get_iv_coefficient(loop, get_Load_ptr(load), &coef, 0)
+		    && coef == (long)size;
+	}
+	return false;
+}
+
+/**
+ * Checks that all memory accesses have unit stride, determines the
+ * vectorization factor and the needed runtime checks.
+ */
+static bool analyze_memops(vloop_t *const loop)
+{
+	unsigned const pointer_size = ir_target_pointer_size();
+	size_t   const n_memops     = ARR_LEN(loop->memops);
+	bool           has_stores   = false;
+	unsigned       min_size     = 0;
+	for (size_t i = 0; i < n_memops; ++i) {
+		ir_node *const memop = loop->memops[i];
+		if (is_Store(memop))
+			has_stores = true;
+	}
+	for (size_t i = 0; i < n_memops; ++i) {
+		ir_node *const memop = loop->memops[i];
+		unsigned const size  = get_memop_size(memop);
+		long           coef;
+		if (!get_iv_coefficient(loop, get_memop_ptr(memop), &coef, 0)
+		 || get_root(loop, get_memop_ptr(memop)) == NULL)
+			return false;
+		if (coef != (long)size && (coef != 0 || has_stores))
+			return false;
+		if (is_Store(memop) && size < pointer_size && is_po2_or_zero(size)
+		 && size != 0
+		 && is_packable_value(loop, get_Store_value(memop), size, 0)
+		 && (min_size == 0 || size < min_size))
+			min_size = size;
+	}
+
+	if (min_size == 0) {
+		loop->vf = ARR_LEN(loop->reductions) > 0 ? REDUCTION_VF : 0;
+		return loop->vf != 0;
+	}
+	loop->vf = MIN(pointer_size / min_size, MAX_VF);
+
+	/* Accesses to different objects, which might alias, are checked at
+	 * runtime.  Accesses to the same object cannot be checked. */
+	for (size_t i = 0; i < n_memops; ++i) {
+		ir_node *const a     = loop->memops[i];
+		ir_node *const ptr_a = get_memop_ptr(a);
+		for (size_t j = i + 1; j < n_memops; ++j) {
+			ir_node *const b     = loop->memops[j];
+			ir_node *const ptr_b = get_memop_ptr(b);
+			if ((is_Load(a) && is_Load(b))
+			 || get_root(loop, ptr_a) == get_root(loop, ptr_b))
+				continue;
+			ir_alias_relation const rel = get_alias_relation(
+				ptr_a, get_memop_type(a), get_memop_size(a),
+				ptr_b, get_memop_type(b), get_memop_size(b));
+			if (rel == ir_no_alias)
+				continue;
+			if (ARR_LEN(loop->checked) >= MAX_RUNTIME_CHECKS)
+				return false;
+			checked_pair_t const pair = { ptr_a, ptr_b };
+			ARR_APP1(checked_pair_t, loop->checked, pair);
+		}
+	}
+	return true;
+}
+
+/** Recognizes an innermost loop @p irloop, which may be vectorized. */
+static bool analyze_loop(vloop_t *const loop, ir_loop *const irloop)
+{
+	/* the loop consists of header and body only */
+	if (get_loop_n_elements(irloop) != 2
+	 || *get_loop_element(irloop, 0).kind != k_ir_node
+	 || *get_loop_element(irloop, 1).kind != k_ir_node)
+		return false;
+	for (size_t i = 0; i < 2; ++i) {
+		ir_node *const header = get_loop_element(irloop, i).node;
+		ir_node *const body   = get_loop_element(irloop, 1 - i).node;
+		if (get_Block_n_cfgpreds(header) != 2 || get_Block_n_cfgpreds(body) != 1)
+			continue;
+		ir_node *const proj = get_Block_cfgpred(body, 0);
+		if (!is_Proj(proj) || get_nodes_block(proj) != header
+		 || !is_Cond(get_Proj_pred(proj)))
+			continue;
+		for (int p = 0; p < 2; ++p) {
+			ir_node *const pred = get_Block_cfgpred(header, p);
+			if (is_Jmp(pred) && get_nodes_block(pred) == body) {
+				loop->header    = header;
+				loop->body      = body;
+				loop->entry_pos = 1 - p;
+			}
+		}
+	}
+	if (loop->header == NULL)
+		return false;
+
+	return analyze_phis(loop) && analyze_exit(loop) && analyze_nodes(loop)
+	    && analyze_memops(loop);
+}
+
+static ir_node *copy_node(copy_env_t *env, ir_node *node);
+
+/** Creates the address of lane @p env->lane of memory operation @p memop. */
+static ir_node *get_lane_ptr(copy_env_t *const env, ir_node *const memop)
+{
+	ir_node *const orig = get_memop_ptr(memop);
+	ir_node       *ptr;
+	long           coef;
+	if (env->lane == 0) {
+		ptr = copy_node(env, orig);
+		ir_nodemap_insert(env->lane0, memop, ptr);
+	} else if (get_iv_coefficient(env->loop, orig, &coef, 0) && coef == 0) {
+		/* a loop invariant address is the same in all lanes */
+		ptr = ir_nodemap_get(ir_node, env->lane0, memop);
+	} else {
+		ir_graph *const irg    = get_irn_irg(memop);
+		ir_node  *const lane0  = ir_nodemap_get(ir_node, env->lane0, memop);
+		ir_mode  *const mode   = get_reference_offset_mode(get_irn_mode(orig));
+		long      const offset = (long)(env->lane * get_memop_size(memop));
+		ir_node  *const cnst   = new_r_Const_long(irg, mode, offset);
+		ptr = new_r_Add(env->block, lane0, cnst);
+	}
+	ir_nodemap_insert(&env->loop->orig_ptr, ptr, orig);
+	return ptr;
+}
+
+/**
+ * Copies @p node for the current lane.  Nodes outside of the loop are used
+ * directly, the Phis of the header must have been mapped before.
+ */
+static ir_node *copy_node(copy_env_t *const env, ir_node *const node)
+{
+	if (!is_in_loop(env->loop, node))
+		return node;
+	ir_node *res = ir_nodemap_get(ir_node, &env->map, node);
+	if (res != NULL)
+		return res;
+	assert(!is_Phi(node));
+
+	int       const arity   = get_irn_arity(node);
+	int       const ptr_pos = is_Load(node)  ? n_Load_ptr
+	                        : is_Store(node) ? n_Store_ptr : -1;
+	ir_node **const ins     = ALLOCAN(ir_node*, arity);
+	for (int i = 0; i < arity; ++i) {
+		if (i == ptr_pos)
+			ins[i] = get_lane_ptr(env, node);
+		else
+			ins[i] = copy_node(env, get_irn_n(node, i));
+	}
+	res = new_similar_node(node, env->block, ins);
+	ir_nodemap_insert(&env->map, node, res);
+	return res;
+}
+
+/** Computes the address of @p memop in the iteration @p iv in @p block. */
+static ir_node *copy_address(vloop_t *const loop, ir_node *const memop,
+                             ir_node *const block, ir_node *const iv)
+{
+	copy_env_t env;
+	env.loop  = loop;
+	env.block = block;
+	env.lane  = 0;
+	env.lane0 = NULL;
+	ir_nodemap_init(&env.map, loop->irg);
+	ir_nodemap_insert(&env.map, loop->iv, iv);
+	ir_node *const res = copy_node(&env, get_memop_ptr(memop));
+	ir_nodemap_destroy(&env.map);
+	return res;
+}
+
+/** Returns the address range [lo, hi) accessed by @p memop. */
+static void build_range(vloop_t *const loop, ir_node *const block,
+                        ir_node *const memop, ir_node **const lo,
+                        ir_node **const hi)
+{
+	ir_graph *const irg   = loop->irg;
+	ir_node  *const start = get_Phi_pred(loop->iv, loop->entry_pos);
+	ir_node        *end   = loop->bound;
+	if (loop->relation == ir_relation_less_equal) {
+		ir_node *const one = new_r_Const_one(irg, get_irn_mode(end));
+		end = new_r_Add(block, end, one);
+	}
+	*lo = copy_address(loop, memop, block, start);
+	*hi = copy_address(loop, memop, block, end);
+}
+
+static ir_node *find_memop(vloop_t const *const loop, ir_node const *const ptr)
+{
+	for (size_t i = 0, n = ARR_LEN(loop->memops); i < n; ++i) {
+		if (get_memop_ptr(loop->memops[i]) == ptr)
+			return loop->memops[i];
+	}
+	panic("no memop for address");
+}
+
+/** Blocks checking the preconditions of the vector loop. */
+typedef struct guard_t {
+	ir_node  *block;     /**< current guard block */
+	ir_node **to_scalar; /**< flexible array of failed checks */
+} guard_t;
+
+/** Continues in a new guard block if @p cmp holds. */
+static void guard_check(guard_t *const guard, ir_node *const cmp)
+{
+	ir_node *const cond = new_r_Cond(guard->block, cmp);
+	ir_node *const pass = new_r_Proj(cond, mode_X, pn_Cond_true);
+	ir_node *const fail = new_r_Proj(cond, mode_X, pn_Cond_false);
+	ARR_APP1(ir_node*, guard->to_scalar, fail);
+	guard->block = new_r_Block(get_irn_irg(cond), 1, &pass);
+}
+
+/** Continues in a new guard block if @p cmp0 or @p cmp1 holds. */
+static void guard_check_either(guard_t *const guard, ir_node *const cmp0,
+                               ir_node *const cmp1)
+{
+	ir_graph *const irg   = get_irn_irg(guard->block);
+	ir_node  *const cond  = new_r_Cond(guard->block, cmp0);
+	ir_node  *const pass0 = new_r_Proj(cond, mode_X, pn_Cond_true);
+	ir_node  *const other = new_r_Proj(cond, mode_X, pn_Cond_false);
+	guard->block = new_r_Block(irg, 1, &other);
+	guard_check(guard, cmp1);
+	ir_node *const pass1 = new_r_Jmp(guard->block);
+	ir_node *const in[]  = { pass0, pass1 };
+	guard->block = new_r_Block(irg, ARRAY_SIZE(in), in);
+}
+
+/**
+ * Builds the guard blocks: the counter does not overflow in the vector loop
+ * and the checked pairs of memory ranges are disjoint.
+ */
+static void build_guard(vloop_t *const loop, guard_t *const guard)
+{
+	ir_graph  *const irg   = loop->irg;
+	ir_node   *const start = get_Phi_pred(loop->iv, loop->entry_pos);
+	ir_node   *const bound = loop->bound;
+	ir_mode   *const mode  = get_irn_mode(bound);
+	ir_tarval *const vf    = new_tarval_from_long(loop->vf, mode);
+	ir_tarval *const limit = tarval_sub(get_mode_max(mode), vf);
+	ir_node   *const cnst  = new_r_Const(irg, limit);
+	guard_check(guard, new_r_Cmp(guard->block, bound, cnst, ir_relation_less_equal));
+	guard_check(guard, new_r_Cmp(guard->block, start, bound, ir_relation_less_equal));
+
+	for (size_t i = 0, n = ARR_LEN(loop->checked); i < n; ++i) {
+		checked_pair_t const *const pair  = &loop->checked[i];
+		ir_node              *const block = guard->block;
+		ir_node *lo0;
+		ir_node *hi0;
+		ir_node *lo1;
+		ir_node *hi1;
+		build_range(loop, block, find_memop(loop, pair->ptr0), &lo0, &hi0);
+		build_range(loop, block, find_memop(loop, pair->ptr1), &lo1, &hi1);
+		ir_node *const before = new_r_Cmp(block, hi0, lo1, ir_relation_less_equal);
+		ir_node *const after  = new_r_Cmp(block, hi1, lo0, ir_relation_less_equal);
+		guard_check_either(guard, before, after);
+	}
+}
+
+/** Returns the value the accumulator of a lane starts with. */
+static ir_node *get_identity(reduction_t const *const red, ir_node *const init,
+                             unsigned const lane)
+{
+	if (lane == 0 || red->kind == RED_MINMAX)
+		return init;
+	ir_graph *const irg  = get_irn_irg(init);
+	ir_mode  *const mode = get_irn_mode(init);
+	switch (red->kind) {
+	case RED_MUL: return new_r_Const_one(irg, mode);
+	case RED_AND: return new_r_Const(irg, get_mode_all_one(mode));
+	default:      return new_r_Const_null(irg, mode);
+	}
+}
+
+/** Combines the accumulators @p a and @p b of reduction @p red. */
+static ir_node *combine(reduction_t const *const red, ir_node *const block,
+                        ir_node *const a, ir_node *const b)
+{
+	switch (red->kind) {
+	case RED_ADD:
+	case RED_SUB: return new_r_Add(block, a, b);
+	case RED_MUL: return new_r_Mul(block, a, b);
+	case RED_AND: return new_r_And(block, a, b);
+	case RED_OR:  return new_r_Or(block, a, b);
+	case RED_EOR: return new_r_Eor(block, a, b);
+	case RED_MINMAX: {
+		ir_node *const next = red->next;
+		ir_node *const phi  = red->phi;
+		ir_node *const sel  = get_Mux_sel(next);
+		ir_node *const l    = get_Cmp_left(sel) == phi ? a : b;
+		ir_node *const r    = get_Cmp_right(sel) == phi ? a : b;
+		ir_node *const f    = get_Mux_false(next) == phi ? a : b;
+		ir_node *const t    = get_Mux_true(next) == phi ? a : b;
+		ir_node *const cmp  = new_r_Cmp(block, l, r, get_Cmp_relation(sel));
+		return new_r_Mux(block, cmp, f, t);
+	}
+	}
+	panic("invalid reduction");
+}
+
+static bool is_checked(ir_node const *const ptr0, ir_node const *const ptr1,
+                       void *const data)
+{
+	vloop_t const *const loop  = (vloop_t const*)data;
+	ir_node const *const orig0 = ir_nodemap_get(ir_node const, &loop->orig_ptr, ptr0);
+	ir_node const *const orig1 = ir_nodemap_get(ir_node const, &loop->orig_ptr, ptr1);
+	if (orig0 == NULL || orig1 == NULL)
+		return false;
+	for (size_t i = 0, n = ARR_LEN(loop->checked); i < n; ++i) {
+		checked_pair_t const *const pair = &loop->checked[i];
+		if ((pair->ptr0 == orig0 && pair->ptr1 == orig1)
+		 || (pair->ptr0 == orig1 && pair->ptr1 == orig0))
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Creates a Phi in the two-predecessor loop header @p block with entry value
+ * @p init.  The value of the backedge is set later with replace_dummy().
+ */
+static ir_node *new_loop_Phi(ir_node *const block, ir_node *const init)
+{
+	ir_graph *const irg  = get_irn_irg(block);
+	ir_mode  *const mode = get_irn_mode(init);
+	ir_node  *const in[] = { init, new_r_Dummy(irg, mode) };
+	return new_r_Phi(block, ARRAY_SIZE(in), in, mode);
+}
+
+/** Replaces the Dummy input @p pos of @p node by @p value. */
+static void replace_dummy(ir_node *const node, int const pos,
+                          ir_node *const value)
+{
+	ir_node *const dummy = get_irn_n(node, pos);
+	assert(is_Dummy(dummy));
+	set_irn_n(node, pos, value);
+	if (get_irn_n_edges(dummy) == 0)
+		kill_node(dummy);
+}
+
+/** Appends @p pred to the predecessors of @p node. */
+static void append_pred(ir_node *const node, ir_node *const pred)
+{
+	int       const arity = get_irn_arity(node);
+	ir_node **const ins   = ALLOCAN(ir_node*, arity + 1);
+	for (int i = 0; i < arity; ++i)
+		ins[i] = get_irn_n(node, i);
+	ins[arity] = pred;
+	set_irn_in(node, arity + 1, ins);
+}
+
+/** Collects the nodes of @p block and their operands in the start block. */
+static void collect_dead(ir_node *const block, ir_node ***const dead,
+                         ir_node ***const operands)
+{
+	foreach_out_edge(block, edge) {
+		ir_node *const node = get_edge_src_irn(edge);
+		ARR_APP1(ir_node*, *dead, node);
+		foreach_irn_in(node, i, op) {
+			if (is_irn_start_block_placed(op))
+				ARR_APP1(ir_node*, *operands, op);
+		}
+	}
+	foreach_irn_in(block, i, pred) {
+		if (is_irn_start_block_placed(pred))
+			ARR_APP1(ir_node*, *operands, pred);
+	}
+}
+
+/**
+ * Removes the vector loop consisting of @p vhead and @p vbody again, together
+ * with the constants only used by it.
+ */
+static void kill_vector_loop(ir_node *const vhead, ir_node *const vbody)
+{
+	ir_node **dead     = NEW_ARR_F(ir_node*, 0);
+	ir_node **operands = NEW_ARR_F(ir_node*, 0);
+	collect_dead(vhead, &dead, &operands);
+	collect_dead(vbody, &dead, &operands);
+
+	/* The blocks are killed first, as the edges of a block are found through
+	 * its control flow predecessors. */
+	kill_node(vhead);
+	kill_node(vbody);
+	for (size_t i = 0, n = ARR_LEN(dead); i < n; ++i)
+		kill_node(dead[i]);
+	for (size_t i = 0, n = ARR_LEN(operands); i < n; ++i) {
+		ir_node *const op = operands[i];
+		if (!is_Deleted(op) && get_irn_n_edges(op) == 0)
+			kill_node(op);
+	}
+	DEL_ARR_F(operands);
+	DEL_ARR_F(dead);
+}
+
+/**
+ * Builds the vector loop.  The entry of its header is connected to the guard
+ * later.
+ *
+ * @return false if the SLP vectorizer packed nothing and there are no
+ *         reductions, the vector loop is removed again in this case
+ */
+static bool build_vector_loop(vloop_t *const loop)
+{
+	ir_graph *const irg     = loop->irg;
+	int       const entry   = loop->entry_pos;
+	unsigned  const vf      = loop->vf;
+	size_t    const n_reds  = ARR_LEN(loop->reductions);
+	ir_node  *const iv      = loop->iv;
+	ir_mode  *const iv_mode = get_irn_mode(iv);
+
+	/* vector loop header, the predecessors are set later */
+	ir_node *const dummy      = new_r_Dummy(irg, mode_X);
+	ir_node *const vhead_in[] = { dummy, dummy };
+	ir_node *const vhead      = new_r_Block(irg, ARRAY_SIZE(vhead_in), vhead_in);
+	ir_node *const viv        = new_loop_Phi(vhead, get_Phi_pred(iv, entry));
+	ir_node       *vmem       = NULL;
+	if (loop->mem_phi != NULL)
+		vmem = new_loop_Phi(vhead, get_Phi_pred(loop->mem_phi, entry));
+	for (size_t i = 0; i < n_reds; ++i) {
+		reduction_t *const red  = &loop->reductions[i];
+		ir_node     *const init = get_Phi_pred(red->phi, entry);
+		for (unsigned l = 0; l < vf; ++l)
+			red->accs[l] = new_loop_Phi(vhead, get_identity(red, init, l));
+	}
+	ir_node *const last_c  = new_r_Const_long(irg, iv_mode, vf - 1);
+	ir_node *const last    = new_r_Add(vhead, viv, last_c);
+	ir_node *const vcmp    = new_r_Cmp(vhead, last, loop->bound, loop->relation);
+	ir_node *const vcond   = new_r_Cond(vhead, vcmp);
+	ir_node *const to_body = new_r_Proj(vcond, mode_X, pn_Cond_true);
+	ir_node *const to_exit = new_r_Proj(vcond, mode_X, pn_Cond_false);
+
+	/* vector loop body: vf copies of the scalar body */
+	ir_node   *const vbody = new_r_Block(irg, 1, &to_body);
+	ir_nodemap       lane0;
+	ir_nodemap_init(&lane0, irg);
+	ir_node         *mem   = vmem;
+	for (unsigned l = 0; l < vf; ++l) {
+		copy_env_t env;
+		env.loop  = loop;
+		env.block = vbody;
+		env.lane  = l;
+		env.lane0 = &lane0;
+		ir_nodemap_init(&env.map, irg);
+		ir_node *lane_iv = viv;
+		if (l > 0) {
+			ir_node *const cnst = new_r_Const_long(irg, iv_mode, l);
+			lane_iv = new_r_Add(vbody, viv, cnst);
+		}
+		ir_nodemap_insert(&env.map, iv, lane_iv);
+		if (loop->mem_phi != NULL)
+			ir_nodemap_insert(&env.map, loop->mem_phi, mem);
+		for (size_t i = 0; i < n_reds; ++i) {
+			reduction_t const *const red = &loop->reductions[i];
+			ir_nodemap_insert(&env.map, red->phi, red->accs[l]);
+		}
+
+		if (loop->mem_phi != NULL)
+			mem = copy_node(&env, get_Phi_pred(loop->mem_phi, 1 - entry));
+		for (size_t i = 0; i < n_reds; ++i) {
+			reduction_t *const red  = &loop->reductions[i];
+			ir_node     *const next = copy_node(&env, red->next);
+			replace_dummy(red->accs[l], 1, next);
+		}
+		ir_nodemap_destroy(&env.map);
+	}
+	ir_nodemap_destroy(&lane0);
+
+	ir_node *const vf_c    = new_r_Const_long(irg, iv_mode, vf);
+	ir_node *const viv_nxt = new_r_Add(vbody, viv, vf_c);
+	replace_dummy(viv, 1, viv_nxt);
+	if (vmem != NULL)
+		replace_dummy(vmem, 1, mem);
+	set_Block_cfgpred(vhead, 1, new_r_Jmp(vbody));
+
+	/* Without packed memory operations the vector loop is only useful for
+	 * reductions. */
+	if (!slp_vectorize_block(vbody, is_checked, loop) && n_reds == 0) {
+		DB((dbg, LEVEL_2, "nothing packed in %+F, giving up\n", vbody));
+		kill_vector_loop(vhead, vbody);
+		return false;
+	}
+	loop->vhead = vhead;
+	loop->viv   = viv;
+	loop->vmem  = vmem;
+	loop->vexit = to_exit;
+	return true;
+}
+
+/**
+ * Builds guard and vector loop in front of the loop.
+ *
+ * @return true if the loop was vectorized
+ */
+static bool vectorize_loop(vloop_t *const loop)
+{
+	ir_graph *const irg    = loop->irg;
+	ir_node  *const header = loop->header;
+	int       const entry  = loop->entry_pos;
+	unsigned  const vf     = loop->vf;
+
+	DB((dbg, LEVEL_1, "vectorizing loop %+F with factor %u, %zu checks\n",
+	    header, vf, ARR_LEN(loop->checked)));
+
+	if (!build_vector_loop(loop))
+		return false;
+
+	/* guard */
+	ir_node *const entry_x = get_Block_cfgpred(header, entry);
+	guard_t        guard;
+	guard.block     = new_r_Block(irg, 1, &entry_x);
+	guard.to_scalar = NEW_ARR_F(ir_node*, 0);
+	build_guard(loop, &guard);
+	ir_node *const scalar = new_r_Block(irg, ARR_LEN(guard.to_scalar), guard.to_scalar);
+	set_Block_cfgpred(header, entry, new_r_Jmp(scalar));
+	replace_dummy(loop->vhead, 0, new_r_Jmp(guard.block));
+	DEL_ARR_F(guard.to_scalar);
+
+	/* combine the accumulators and continue with the scalar loop */
+	ir_node *const vexit = new_r_Block(irg, 1, &loop->vexit);
+	append_pred(header, new_r_Jmp(vexit));
+	append_pred(loop->iv, loop->viv);
+	if (loop->vmem != NULL)
+		append_pred(loop->mem_phi, loop->vmem);
+	for (size_t i = 0, n = ARR_LEN(loop->reductions); i < n; ++i) {
+		reduction_t const *const red = &loop->reductions[i];
+		ir_node           *accs[MAX_VF];
+		memcpy(accs, red->accs, sizeof(accs));
+		for (unsigned step = 1; step < vf; step *= 2) {
+			for (unsigned l = 0; l + step < vf; l += 2 * step)
+				accs[l] = combine(red, vexit, accs[l], accs[l + step]);
+		}
+		append_pred(red->phi, accs[0]);
+	}
+	return true;
+}
+
+/** Collects the innermost loops in the loop tree @p loop. */
+static void collect_loops(ir_loop *const loop, ir_loop ***const loops)
+{
+	bool is_innermost = true;
+	for (size_t i = 0, n = get_loop_n_elements(loop); i < n; ++i) {
+		loop_element const element = get_loop_element(loop, i);
+		if (*element.kind == k_ir_loop) {
+			collect_loops(element.son, loops);
+			is_innermost = false;
+		}
+	}
+	if (is_innermost && get_loop_depth(loop) > 0)
+		ARR_APP1(ir_loop*, *loops, loop);
+}
+
+void opt_loop_vectorize(ir_graph *irg)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.opt.loop_vectorize");
+
+	assure_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES
+	                         | IR_GRAPH_PROPERTY_NO_TUPLES
+	                         | IR_GRAPH_PROPERTY_NO_BADS
+	                         | IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO);
+
+	/* The loop tree is not updated while vectorizing, which is fine as the
+	 * innermost loops are disjoint. */
+	ir_loop **loops = NEW_ARR_F(ir_loop*, 0);
+	collect_loops(get_irg_loop(irg), &loops);
+
+	bool changed = false;
+	for (size_t i = 0, n = ARR_LEN(loops); i < n; ++i) {
+		vloop_t loop;
+		memset(&loop, 0, sizeof(loop));
+		loop.irg        = irg;
+		loop.reductions = NEW_ARR_F(reduction_t, 0);
+		loop.memops     = NEW_ARR_F(ir_node*, 0);
+		loop.checked    = NEW_ARR_F(checked_pair_t, 0);
+		if (analyze_loop(&loop, loops[i])) {
+			ir_nodemap_init(&loop.orig_ptr, irg);
+			changed |= vectorize_loop(&loop);
+			ir_nodemap_destroy(&loop.orig_ptr);
+		}
+		DEL_ARR_F(loop.checked);
+		DEL_ARR_F(loop.memops);
+		DEL_ARR_F(loop.reductions);
+	}
+	DEL_ARR_F(loops);
+
+	confirm_irg_properties(irg, changed ? IR_GRAPH_PROPERTIES_NONE
+	                                    : IR_GRAPH_PROPERTIES_ALL);
+}
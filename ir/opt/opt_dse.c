@@ -0,0 +1,551 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2017 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Global dead store elimination for frame entities.
+ *
+ * Frame entities whose address is only used by Loads, Stores, CopyBs and
+ * memset destinations at constant offsets cannot be accessed by any other
+ * node. For them the bytes which may still be read are computed backwards
+ * over the memory graph: a Load or CopyB source makes its bytes live, a
+ * Store, CopyB destination or memset kills them and nothing is live at a
+ * Return, where the frame dies. Stores writing no live byte are removed,
+ * CopyBs and memsets are shrunk to the live byte range.
+ */
+#include "array.h"
+#include "bitfiddle.h"
+#include "debug.h"
+#include "entity_t.h"
+#include "ircons.h"
+#include "iredges_t.h"
+#include "irgmod.h"
+#include "irgraph_t.h"
+#include "irgwalk.h"
+#include "irnode_t.h"
+#include "irnodehashmap.h"
+#include "iroptimize.h"
+#include "obst.h"
+#include "panic.h"
+#include "raw_bitset.h"
+#include "tv.h"
+#include "type_t.h"
+#include "util.h"
+
+/** Maximum number of frame bytes tracked per graph. */
+#define MAX_TRACKED_BYTES 4096
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg;)
+
+/** An access of a memory node to the bytes [from, to) of an entity. */
+typedef struct access_t access_t;
+struct access_t {
+	unsigned  from;  /**< first tracked byte */
+	unsigned  to;    /**< first byte after the access */
+	bool      write;
+	bool      exact; /**< false if only the entity but not the bytes is known */
+	ir_node  *node;
+	access_t *next;
+};
+
+typedef struct dse_env_t {
+	ir_graph         *irg;
+	struct obstack    obst;
+	ident            *memset_id;
+	unsigned          n_bytes;   /**< number of tracked bytes */
+	ir_nodehashmap_t  accesses;  /**< memory node -> access list */
+	ir_nodehashmap_t  live;      /**< memory value -> live bytes */
+	ir_node         **mem_nodes; /**< all memory values in post order */
+	ir_node         **writers;   /**< all nodes writing tracked bytes */
+	access_t        **pending;   /**< accesses of the current entity */
+	bool              escaped;
+} dse_env_t;
+
+/** Returns the tuple Proj @p num of @p node or NULL. */
+static ir_node *find_proj(const ir_node *node, unsigned num)
+{
+	foreach_out_edge(node, edge) {
+		ir_node *const proj = get_edge_src_irn(edge);
+		if (is_Proj(proj) && get_Proj_num(proj) == num)
+			return proj;
+	}
+	return NULL;
+}
+
+/**
+ * Checks whether @p call is a call of memset whose destination pointer
+ * @p ptr is not returned.
+ */
+static bool is_memset_dst(const dse_env_t *env, const ir_node *call,
+                          const ir_node *ptr)
+{
+	ir_node *const callee = get_Call_ptr(call);
+	if (!is_Address(callee)
+	    || get_entity_ident(get_Address_entity(callee)) != env->memset_id
+	    || get_Call_n_params(call) != 3
+	    || get_Call_param(call, 0) != ptr
+	    || get_Call_param(call, 1) == ptr
+	    || !is_Const(get_Call_param(call, 2))
+	    || !tarval_is_long(get_Const_tarval(get_Call_param(call, 2))))
+		return false;
+	ir_node *const results = find_proj(call, pn_Call_T_result);
+	return results == NULL || get_irn_n_edges(results) == 0;
+}
+
+static void add_access(dse_env_t *env, ir_node *node, unsigned from,
+                       unsigned to, bool write, bool exact)
+{
+	access_t *access = OALLOCZ(&env->obst, access_t);
+	access->from  = from;
+	access->to    = to;
+	access->write = write;
+	access->exact = exact;
+	access->node  = node;
+	ARR_APP1(access_t*, env->pending, access);
+}
+
+/** Records the pending accesses of an entity which does not escape. */
+static void commit_accesses(dse_env_t *env)
+{
+	for (size_t i = 0, n = ARR_LEN(env->pending); i < n; ++i) {
+		access_t *const access = env->pending[i];
+		ir_node  *const node   = access->node;
+		access_t *const first
+			= ir_nodehashmap_get(access_t, &env->accesses, node);
+		bool has_write = false;
+		for (access_t const *a = first; a != NULL; a = a->next)
+			has_write |= a->write;
+		if (access->write && !has_write)
+			ARR_APP1(ir_node*, env->writers, node);
+		access->next = first;
+		ir_nodehashmap_insert(&env->accesses, node, access);
+	}
+}
+
+/**
+ * Records the accesses through the address @p ptr which points @p offset
+ * bytes into the entity tracked at @p base with size @p size. A negative
+ * offset denotes an unknown position inside the entity.
+ */
+static void analyze_address(dse_env_t *env, ir_node *ptr, unsigned base,
+                            unsigned size, long offset)
+{
+	foreach_out_edge(ptr, edge) {
+		if (env->escaped)
+			return;
+		ir_node *const succ = get_edge_src_irn(edge);
+		int const      pos  = get_edge_src_pos(edge);
+		unsigned       len;
+		bool           write;
+		switch (get_irn_opcode(succ)) {
+		case iro_Member: {
+			ir_entity *const member = get_Member_entity(succ);
+			if (get_entity_bitfield_size(member) != 0)
+				goto escape;
+			long const       moff   = offset < 0 ? -1
+			                        : offset + get_entity_offset(member);
+			analyze_address(env, succ, base, size, moff);
+			continue;
+		}
+		case iro_Sel: {
+			if (pos != n_Sel_ptr)
+				goto escape;
+			ir_node *const index = get_Sel_index(succ);
+			ir_type *const elem  = get_array_element_type(get_Sel_type(succ));
+			long           soff  = -1;
+			if (offset >= 0 && is_Const(index)
+			    && tarval_is_long(get_Const_tarval(index))) {
+				long const idx = get_Const_long(index);
+				if (idx >= 0)
+					soff = offset + idx * (long)get_type_size(elem);
+			}
+			analyze_address(env, succ, base, size, soff);
+			continue;
+		}
+		case iro_Add:
+		case iro_Sub: {
+			ir_node *const other = get_irn_n(succ, 1 - pos);
+			if (!mode_is_reference(get_irn_mode(succ)))
+				goto escape;
+			long aoff = -1;
+			if (offset >= 0 && is_Const(other)
+			    && tarval_is_long(get_Const_tarval(other))) {
+				long const c = get_Const_long(other);
+				aoff = is_Add(succ) ? offset + c : offset - c;
+			}
+			analyze_address(env, succ, base, size, aoff);
+			continue;
+		}
+		case iro_Load:
+			len   = get_mode_size_bytes(get_Load_mode(succ));
+			write = false;
+			break;
+		case iro_Store:
+			if (pos != n_Store_ptr)
+				goto escape;
+			len   = get_mode_size_bytes(get_irn_mode(get_Store_value(succ)));
+			write = true;
+			break;
+		case iro_CopyB:
+			len   = get_type_size(get_CopyB_type(succ));
+			write = pos == n_CopyB_dst;
+			break;
+		case iro_Call:
+			if (!is_memset_dst(env, succ, ptr))
+				goto escape;
+			len   = get_Const_long(get_Call_param(succ, 2));
+			write = true;
+			break;
+		default:
+			goto escape;
+		}
+
+		if (len == 0) {
+			/* does not access memory */
+		} else if (offset >= 0 && (unsigned long)offset + len <= size) {
+			add_access(env, succ, base + offset, base + offset + len, write,
+			           true);
+		} else if (offset < 0 && len <= size) {
+			add_access(env, succ, base, base + size, write, false);
+		} else {
+			goto escape;
+		}
+		continue;
+escape:
+		DB((dbg, LEVEL_3, "  address %+F escapes at %+F\n", ptr, succ));
+		env->escaped = true;
+		return;
+	}
+}
+
+/**
+ * Tracks the frame entity @p entity if all of its accesses are known.
+ * @return true if the entity is tracked
+ */
+static bool track_entity(dse_env_t *env, ir_entity *entity)
+{
+	unsigned const size = get_type_size(get_entity_type(entity));
+	if (size == 0 || env->n_bytes + size > MAX_TRACKED_BYTES)
+		return false;
+	/* nothing to remove if the entity is never written */
+	if (!(get_entity_usage(entity) & ir_usage_write))
+		return false;
+
+	env->escaped = false;
+	ARR_SHRINKLEN(env->pending, 0);
+	ir_node *const frame = get_irg_frame(env->irg);
+	foreach_out_edge(frame, edge) {
+		ir_node *const member = get_edge_src_irn(edge);
+		if (is_Member(member) && get_Member_entity(member) == entity)
+			analyze_address(env, member, env->n_bytes, size, 0);
+		if (env->escaped)
+			break;
+	}
+	if (env->escaped)
+		return false;
+	commit_accesses(env);
+	DB((dbg, LEVEL_2, "  tracking %+F at byte %u\n", entity, env->n_bytes));
+	env->n_bytes += size;
+	return true;
+}
+
+static void collect_mem_nodes(ir_node *node, void *data)
+{
+	dse_env_t *env = (dse_env_t*)data;
+	if (get_irn_mode(node) == mode_M)
+		ARR_APP1(ir_node*, env->mem_nodes, node);
+}
+
+static unsigned *get_live(dse_env_t *env, const ir_node *node)
+{
+	return ir_nodehashmap_get(unsigned, &env->live, node);
+}
+
+/** Computes the bytes live after the memory node @p node. */
+static void get_live_after(dse_env_t *env, const ir_node *node, unsigned *live)
+{
+	if (get_irn_mode(node) == mode_M) {
+		rbitset_or(live, get_live(env, node), env->n_bytes + 1);
+		return;
+	}
+	foreach_out_edge(node, edge) {
+		ir_node *const proj = get_edge_src_irn(edge);
+		if (is_Proj(proj) && get_irn_mode(proj) == mode_M)
+			rbitset_or(live, get_live(env, proj), env->n_bytes + 1);
+	}
+}
+
+/** Checks whether the write @p access of @p node surely happens. */
+static bool kills(const ir_node *node, const access_t *access)
+{
+	if (!access->write || !access->exact
+	    || (is_fragile_op(node) && ir_throws_exception(node)))
+		return false;
+	switch (get_irn_opcode(node)) {
+	case iro_Store:
+		return get_Store_volatility(node) != volatility_is_volatile;
+	case iro_CopyB:
+		return get_CopyB_volatility(node) != volatility_is_volatile;
+	default:
+		return true;
+	}
+}
+
+/** Computes the bytes live before the memory user @p user into @p live. */
+static void add_live_before(dse_env_t *env, ir_node *user, unsigned *live,
+                            unsigned *tmp)
+{
+	size_t const n_bits = env->n_bytes + 1;
+	switch (get_irn_opcode(user)) {
+	case iro_Phi:
+	case iro_Sync:
+		rbitset_or(live, get_live(env, user), n_bits);
+		return;
+	case iro_Return:
+	case iro_End:
+	case iro_Anchor:
+		/* the frame is dead */
+		return;
+	default:
+		break;
+	}
+	if (!is_memop(user)) {
+		rbitset_set_all(live, n_bits);
+		return;
+	}
+
+	rbitset_clear_all(tmp, n_bits);
+	get_live_after(env, user, tmp);
+	access_t const *const accesses
+		= ir_nodehashmap_get(access_t, &env->accesses, user);
+	for (access_t const *a = accesses; a != NULL; a = a->next) {
+		if (kills(user, a))
+			rbitset_set_range(tmp, a->from, a->to, false);
+	}
+	for (access_t const *a = accesses; a != NULL; a = a->next) {
+		if (!a->write)
+			rbitset_set_range(tmp, a->from, a->to, true);
+	}
+	rbitset_or(live, tmp, n_bits);
+}
+
+/** Computes the live bytes of all memory values until a fixpoint. */
+static void compute_liveness(dse_env_t *env)
+{
+	size_t const n_bits = env->n_bytes + 1;
+	size_t const n      = ARR_LEN(env->mem_nodes);
+	for (size_t i = 0; i < n; ++i) {
+		ir_node *const node = env->mem_nodes[i];
+		ir_nodehashmap_insert(&env->live, node,
+		                      rbitset_obstack_alloc(&env->obst, n_bits));
+	}
+
+	unsigned *live = rbitset_malloc(n_bits);
+	unsigned *tmp  = rbitset_malloc(n_bits);
+	bool      changed;
+	do {
+		changed = false;
+		for (size_t i = n; i-- > 0; ) {
+			ir_node *const node = env->mem_nodes[i];
+			rbitset_clear_all(live, n_bits);
+			foreach_out_edge(node, edge) {
+				add_live_before(env, get_edge_src_irn(edge), live, tmp);
+			}
+			unsigned *const old = get_live(env, node);
+			if (!rbitsets_equal(old, live, n_bits)) {
+				rbitset_copy(old, live, n_bits);
+				changed = true;
+			}
+		}
+	} while (changed);
+	free(tmp);
+	free(live);
+}
+
+/** Returns a new address @p offset bytes after @p ptr. */
+static ir_node *new_offset_address(ir_node *block, ir_node *ptr, long offset)
+{
+	if (offset == 0)
+		return ptr;
+	ir_graph *const irg  = get_irn_irg(ptr);
+	ir_mode  *const mode = get_reference_offset_mode(get_irn_mode(ptr));
+	ir_node  *const cnst = new_r_Const_long(irg, mode, offset);
+	return new_r_Add(block, ptr, cnst);
+}
+
+static bool remove_dead_store(ir_node *store)
+{
+	if (get_Store_volatility(store) == volatility_is_volatile
+	    || ir_throws_exception(store))
+		return false;
+	DB((dbg, LEVEL_1, "  removing dead %+F\n", store));
+	ir_node *const mem  = get_Store_mem(store);
+	ir_node *const proj = find_proj(store, pn_Store_M);
+	if (proj != NULL)
+		exchange(proj, mem);
+	kill_node(store);
+	return true;
+}
+
+static bool shrink_copyb(ir_node *copyb, unsigned from, unsigned to)
+{
+	if (get_CopyB_volatility(copyb) == volatility_is_volatile)
+		return false;
+	if (from == to) {
+		DB((dbg, LEVEL_1, "  removing dead %+F\n", copyb));
+		exchange(copyb, get_CopyB_mem(copyb));
+		return true;
+	}
+
+	/* keep the alignment of the copied type */
+	ir_type  *const type  = get_CopyB_type(copyb);
+	unsigned  const align = MAX(get_type_alignment(type), 1u);
+	unsigned  const size  = get_type_size(type);
+	from = from / align * align;
+	to   = MIN(round_up2(to, align), size);
+	if (from == 0 && to == size)
+		return false;
+
+	DB((dbg, LEVEL_1, "  shrinking %+F to bytes [%u,%u)\n", copyb, from, to));
+	ir_type *const part = new_type_array(get_type_for_mode(mode_Bu), to - from);
+	set_type_alignment(part, align);
+	ir_node *const block = get_nodes_block(copyb);
+	set_CopyB_dst(copyb, new_offset_address(block, get_CopyB_dst(copyb), from));
+	set_CopyB_src(copyb, new_offset_address(block, get_CopyB_src(copyb), from));
+	set_CopyB_type(copyb, part);
+	return true;
+}
+
+static bool shrink_memset(ir_node *call, unsigned from, unsigned to)
+{
+	ir_node  *const len  = get_Call_param(call, 2);
+	unsigned  const size = get_Const_long(len);
+	if (from == to) {
+		if (find_proj(call, pn_Call_X_regular) != NULL
+		    || find_proj(call, pn_Call_X_except) != NULL)
+			return false;
+		DB((dbg, LEVEL_1, "  removing dead %+F\n", call));
+		ir_node *const proj = find_proj(call, pn_Call_M);
+		if (proj != NULL)
+			exchange(proj, get_Call_mem(call));
+		kill_node(call);
+		return true;
+	}
+	if (from == 0 && to == size)
+		return false;
+
+	DB((dbg, LEVEL_1, "  shrinking %+F to bytes [%u,%u)\n", call, from, to));
+	ir_graph *const irg   = get_irn_irg(call);
+	ir_node  *const block = get_nodes_block(call);
+	ir_node  *const dst   = get_Call_param(call, 0);
+	set_Call_param(call, 0, new_offset_address(block, dst, from));
+	set_Call_param(call, 2, new_r_Const_long(irg, get_irn_mode(len), to - from));
+	return true;
+}
+
+/**
+ * Removes or shrinks the writer @p node according to the bytes live after
+ * it.
+ */
+static bool optimize_writer(dse_env_t *env, ir_node *node, unsigned *live)
+{
+	size_t const n_bits = env->n_bytes + 1;
+	rbitset_clear_all(live, n_bits);
+	get_live_after(env, node, live);
+
+	access_t const *write = NULL;
+	for (access_t const *a = ir_nodehashmap_get(access_t, &env->accesses, node);
+	     a != NULL; a = a->next) {
+		if (a->write)
+			write = a;
+	}
+	assert(write != NULL);
+
+	/* find the live bytes written */
+	unsigned from = write->to;
+	unsigned to   = write->from;
+	for (unsigned b = write->from; b < write->to; ++b) {
+		if (rbitset_is_set(live, b)) {
+			from = MIN(from, b);
+			to   = b + 1;
+		}
+	}
+	bool const dead = from >= to;
+	if (!write->exact && !dead)
+		return false;
+
+	switch (get_irn_opcode(node)) {
+	case iro_Store:
+		return dead && remove_dead_store(node);
+	case iro_CopyB:
+		if (!write->exact)
+			return shrink_copyb(node, 0, 0);
+		return dead ? shrink_copyb(node, 0, 0)
+		            : shrink_copyb(node, from - write->from, to - write->from);
+	case iro_Call:
+		if (!write->exact)
+			return shrink_memset(node, 0, 0);
+		return dead ? shrink_memset(node, 0, 0)
+		            : shrink_memset(node, from - write->from, to - write->from);
+	default:
+		panic("unexpected writer %+F", node);
+	}
+}
+
+void opt_dead_stores(ir_graph *irg)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.opt.dse");
+
+	assure_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES
+	                         | IR_GRAPH_PROPERTY_CONSISTENT_ENTITY_USAGE
+	                         | IR_GRAPH_PROPERTY_NO_TUPLES);
+
+	dse_env_t env = { .irg = irg, .memset_id = new_id_from_str("memset") };
+	obstack_init(&env.obst);
+	ir_nodehashmap_init(&env.accesses);
+	ir_nodehashmap_init(&env.live);
+	env.mem_nodes = NEW_ARR_F(ir_node*, 0);
+	env.writers   = NEW_ARR_F(ir_node*, 0);
+	env.pending   = NEW_ARR_F(access_t*, 0);
+
+	DB((dbg, LEVEL_1, "DSE on %+F\n", irg));
+	ir_type *const frame_type = get_irg_frame_type(irg);
+	bool           tracked    = false;
+	/* all frame entities escape if the frame is used by anything but a
+	 * Member */
+	bool           opaque     = false;
+	foreach_out_edge(get_irg_frame(irg), edge) {
+		ir_node *const succ = get_edge_src_irn(edge);
+		opaque |= !is_Member(succ) && !is_Anchor(succ);
+	}
+	for (size_t i = 0, n = opaque ? 0 : get_compound_n_members(frame_type);
+	     i < n; ++i) {
+		ir_entity *const entity = get_compound_member(frame_type, i);
+		tracked |= track_entity(&env, entity);
+	}
+
+	bool changed = false;
+	if (tracked && ARR_LEN(env.writers) > 0) {
+		irg_walk_graph(irg, NULL, collect_mem_nodes, &env);
+		compute_liveness(&env);
+
+		/* decide with the liveness of the unchanged graph: removing or
+		 * shrinking a writer only drops bytes which are dead after it */
+		unsigned *const live = rbitset_malloc(env.n_bytes + 1);
+		for (size_t i = 0, n = ARR_LEN(env.writers); i < n; ++i)
+			changed |= optimize_writer(&env, env.writers[i], live);
+		free(live);
+	}
+
+	DEL_ARR_F(env.pending);
+	DEL_ARR_F(env.writers);
+	DEL_ARR_F(env.mem_nodes);
+	ir_nodehashmap_destroy(&env.live);
+	ir_nodehashmap_destroy(&env.accesses);
+	obstack_free(&env.obst, NULL);
+
+	confirm_irg_properties(irg, changed ? IR_GRAPH_PROPERTIES_CONTROL_FLOW
+	                                    : IR_GRAPH_PROPERTIES_ALL);
+}
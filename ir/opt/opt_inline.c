@@ -10,10 +10,14 @@
  */
 #include "analyze_irg_args.h"
 #include "array.h"
+#include "bitfiddle.h"
+#include "callgraph.h"
 #include "cgana.h"
 #include "debug.h"
 #include "entity_t.h"
+#include "execfreq.h"
 #include "irbackedge_t.h"
+#include "irdom.h"
 #include "ircons_t.h"
 #include "iredges_t.h"
 #include "irflag_t.h"
@@ -30,6 +34,7 @@
 #include "iropt_t.h"
 #include "iroptimize.h"
 #include "irouts_t.h"
+#include "irprofile.h"
 #include "irprog_t.h"
 #include "irtools.h"
 #include "list.h"
@@ -623,6 +628,19 @@ static bool inline_method(ir_node *const call, ir_graph *called_graph)
 
 static struct obstack  temp_obst;
 
+/** Functions smaller than this are inlined in almost every case. */
+#define SMALL_FUNCTION_SIZE 30
+
+/** Code size budget of the inliner. */
+static struct {
+	bool     use_profile;   /**< weight calls by their execution count */
+	bool     limit_growth;  /**< Set, if the budget below is used. */
+	unsigned caller_growth; /**< allowed growth of a graph in percent */
+	unsigned unit_growth;   /**< allowed growth of the program in percent */
+	uint64_t unit_size;     /**< number of nodes of all graphs */
+	uint64_t unit_limit;    /**< allowed number of nodes of all graphs */
+} budget;
+
 /** Represents a possible inlinable call in a graph. */
 typedef struct call_entry {
 	ir_node    *call;       /**< The Call node. */
@@ -630,7 +648,9 @@ typedef struct call_entry {
 	list_head  list;        /**< List head for linking the next one. */
 	int        loop_depth;  /**< The loop depth of this call. */
 	int        benefice;    /**< The calculated benefice of this call. */
+	uint32_t   count;       /**< The profiled execution count of this call. */
 	bool       all_const:1; /**< Set if this call has only constant parameters. */
+	bool       has_count:1; /**< Set if the execution count is known. */
 } call_entry;
 
 /**
@@ -748,6 +768,13 @@ static void collect_calls2(ir_node *node, void *ctx)
 		entry->loop_depth = get_irn_loop(get_nodes_block(node))->depth;
 		entry->benefice   = 0;
 		entry->all_const  = false;
+		entry->has_count  = false;
+		entry->count      = 0;
+		ir_node *const block = get_nodes_block(node);
+		if (budget.use_profile && ir_profile_has_block_execcount(block)) {
+			entry->has_count = true;
+			entry->count     = ir_profile_get_block_execcount(block);
+		}
 
 		list_add_tail(&entry->list, &x->calls);
 	}
@@ -758,18 +785,34 @@ static void collect_calls2(ir_node *node, void *ctx)
  *
  * @param entry     the original entry to duplicate
  * @param new_call  the new call node
- * @param loop_depth_delta
- *                  delta value for the loop depth
+ * @param site      the entry of the inlined call containing the original
  */
 static call_entry *duplicate_call_entry(const call_entry *entry,
-                                        ir_node *new_call, int loop_depth_delta)
+                                        ir_node *new_call,
+                                        const call_entry *site)
 {
 	call_entry *nentry = OALLOC(&temp_obst, call_entry);
 	nentry->call       = new_call;
 	nentry->callee     = entry->callee;
 	nentry->benefice   = entry->benefice;
-	nentry->loop_depth = entry->loop_depth + loop_depth_delta;
+	nentry->loop_depth = entry->loop_depth + site->loop_depth;
 	nentry->all_const  = entry->all_const;
+	nentry->has_count  = false;
+	nentry->count      = 0;
+
+	/* scale the count by the share of the inlined call in all executions of
+	 * its callee */
+	ir_node *const start_block = get_irg_start_block(site->callee);
+	if (entry->has_count && site->has_count
+	    && ir_profile_has_block_execcount(start_block)) {
+		uint32_t const entry_count = ir_profile_get_block_execcount(start_block);
+		if (entry_count != 0) {
+			uint64_t const count
+				= (uint64_t)entry->count * site->count / entry_count;
+			nentry->has_count = true;
+			nentry->count     = (uint32_t)MIN(count, UINT32_MAX);
+		}
+	}
 
 	return nentry;
 }
@@ -947,7 +990,7 @@ static int calc_inline_benefice(call_entry *entry, ir_graph *callee)
 		weight = weight * 3 / 2;
 
 	/* and one for small non-recursive functions: we want them to be inlined in mostly every case */
-	if (callee_env->n_nodes < 30 && !callee_env->recursive)
+	if (callee_env->n_nodes < SMALL_FUNCTION_SIZE && !callee_env->recursive)
 		weight += 2000;
 
 	/* and finally for leafs: they do not increase the register pressure
@@ -956,10 +999,16 @@ static int calc_inline_benefice(call_entry *entry, ir_graph *callee)
 		weight += 400;
 
 	/** it's important to inline inner loops first */
-	if (entry->loop_depth > 30)
+	if (entry->has_count) {
+		/* the profile tells how often the call is executed, which the loop
+		 * depth only estimates */
+		unsigned hotness = entry->count != 0 ? log2_floor(entry->count) + 1 : 0;
+		weight += MIN(hotness, 30) * 1024;
+	} else if (entry->loop_depth > 30) {
 		weight += 30 * 1024;
-	else
+	} else {
 		weight += entry->loop_depth * 1024;
+	}
 
 	/*
 	 * All arguments constant is probably a good sign, give an extra bonus
@@ -971,22 +1020,60 @@ static int calc_inline_benefice(call_entry *entry, ir_graph *callee)
 	return entry->benefice = weight;
 }
 
+/** Depth first numbering of a graph for finding the call graph SCCs. */
+typedef struct scc_info_t {
+	size_t dfn;      /**< depth first number, 0 if not visited yet */
+	size_t low;      /**< smallest dfn reachable */
+	bool   in_stack;
+} scc_info_t;
+
 typedef struct walk_env_t {
 	ir_graph **irgs;
 	size_t     last_irg;
+	ir_graph **stack;
+	size_t     next_dfn;
 } walk_env_t;
 
 /**
- * Call graph walker, collect all visited graphs.
+ * Tarjan's algorithm on the call graph. Appends the graphs of each SCC to
+ * the list as soon as the SCC is complete, so callees come before their
+ * callers.
  */
-static void callgraph_walker(ir_graph *irg, void *data)
+static void find_sccs(walk_env_t *env, ir_graph *irg)
 {
-	walk_env_t *env = (walk_env_t *)data;
-	env->irgs[env->last_irg++] = irg;
+	scc_info_t *info = (scc_info_t*)get_irg_link(irg);
+	info->dfn      = ++env->next_dfn;
+	info->low      = info->dfn;
+	info->in_stack = true;
+	ARR_APP1(ir_graph*, env->stack, irg);
+
+	for (size_t i = 0, n = get_irg_n_callees(irg); i < n; ++i) {
+		ir_graph   *callee      = get_irg_callee(irg, i);
+		scc_info_t *callee_info = (scc_info_t*)get_irg_link(callee);
+		if (callee_info->dfn == 0) {
+			find_sccs(env, callee);
+			info->low = MIN(info->low, callee_info->low);
+		} else if (callee_info->in_stack) {
+			info->low = MIN(info->low, callee_info->dfn);
+		}
+	}
+
+	if (info->low != info->dfn)
+		return;
+	ir_graph *member;
+	do {
+		size_t n = ARR_LEN(env->stack);
+		member = env->stack[n - 1];
+		ARR_SHRINKLEN(env->stack, n - 1);
+		((scc_info_t*)get_irg_link(member))->in_stack = false;
+		env->irgs[env->last_irg++] = member;
+	} while (member != irg);
 }
 
 /**
- * Creates an inline order for all graphs.
+ * Creates an inline order for all graphs: the strongly connected components
+ * of the call graph bottom-up, so that leaf functions are inlined into their
+ * callers after they got their own calls inlined.
  *
  * @return the list of graphs.
  */
@@ -1002,10 +1089,26 @@ static ir_graph **create_irg_list(void)
 	walk_env_t env;
 	env.irgs     = XMALLOCNZ(ir_graph*, n_irgs);
 	env.last_irg = 0;
+	env.stack    = NEW_ARR_F(ir_graph*, 0);
+	env.next_dfn = 0;
 
-	callgraph_walk(NULL, callgraph_walker, &env);
+	foreach_irp_irg(i, irg) {
+		set_irg_link(irg, OALLOCZ(&temp_obst, scc_info_t));
+	}
+	/* roots are methods which have no callers in the current program */
+	foreach_irp_irg(i, irg) {
+		if (get_irg_n_callers(irg) == 0
+		    && ((scc_info_t*)get_irg_link(irg))->dfn == 0)
+			find_sccs(&env, irg);
+	}
+	/* in case of unreachable call loops we haven't visited some irgs yet */
+	foreach_irp_irg(i, irg) {
+		if (((scc_info_t*)get_irg_link(irg))->dfn == 0)
+			find_sccs(&env, irg);
+	}
 	assert(n_irgs == env.last_irg);
 
+	DEL_ARR_F(env.stack);
 	free_callgraph();
 
 	return env.irgs;
@@ -1049,9 +1152,36 @@ static void maybe_push_call(pqueue_t *pqueue, call_entry *call,
 		return;
 	}
 
+	/* do not bloat code which was never executed */
+	inline_irg_env *callee_env = (inline_irg_env*)get_irg_link(callee);
+	if (call->has_count && call->count == 0
+	    && !(callee_props & mtp_property_always_inline)
+	    && callee_env->n_nodes >= SMALL_FUNCTION_SIZE) {
+		DB((dbg, LEVEL_2, "In %+F Call %+F to %+F is cold\n",
+		    caller, call->call, callee));
+		return;
+	}
+
 	pqueue_put(pqueue, call, benefice);
 }
 
+/**
+ * Returns true if inlining a callee with environment @p callee_env into the
+ * graph with environment @p env exceeds the code size budget.
+ */
+static bool exceeds_budget(const inline_irg_env *env,
+                           const inline_irg_env *callee_env)
+{
+	if (!budget.limit_growth)
+		return false;
+	if (budget.unit_size + callee_env->n_nodes > budget.unit_limit)
+		return true;
+	/* small graphs may always get a few small functions inlined */
+	uint64_t limit = (uint64_t)env->n_nodes_orig * (100 + budget.caller_growth) / 100;
+	limit = MAX(limit, (uint64_t)env->n_nodes_orig + SMALL_FUNCTION_SIZE);
+	return env->n_nodes + callee_env->n_nodes > limit;
+}
+
 /**
  * Try to inline calls into a graph.
  *
@@ -1101,6 +1231,12 @@ static void inline_into(ir_graph *irg, unsigned maxsize,
 			    env->n_nodes, callee, callee_env->n_nodes));
 			continue;
 		}
+		if (!(props & mtp_property_always_inline)
+		    && exceeds_budget(env, callee_env)) {
+			DB((dbg, LEVEL_2, "%+F: budget exceeded by %+F (%d)\n", irg,
+			    callee, callee_env->n_nodes));
+			continue;
+		}
 
 		ir_graph *calleee = pmap_get(ir_graph, copied_graphs, callee);
 		if (calleee != NULL) {
@@ -1196,7 +1332,6 @@ static void inline_into(ir_graph *irg, unsigned maxsize,
 		--env->n_call_nodes;
 
 		/* we just generate a bunch of new calls */
-		int loop_depth = curr_call->loop_depth;
 		list_for_each_entry(call_entry, centry, &callee_env->calls, list) {
 			inline_irg_env *penv = (inline_irg_env*)get_irg_link(centry->callee);
 
@@ -1218,7 +1353,7 @@ static void inline_into(ir_graph *irg, unsigned maxsize,
 			assert(is_Call(new_call));
 
 			call_entry *new_entry
-				= duplicate_call_entry(centry, new_call, loop_depth);
+				= duplicate_call_entry(centry, new_call, curr_call);
 			list_add_tail(&new_entry->list, &env->calls);
 			maybe_push_call(pqueue, new_entry, inline_threshold);
 		}
@@ -1226,18 +1361,15 @@ static void inline_into(ir_graph *irg, unsigned maxsize,
 
 		env->n_call_nodes += callee_env->n_call_nodes;
 		env->n_nodes += callee_env->n_nodes;
+		budget.unit_size += callee_env->n_nodes;
 		--callee_env->n_callers;
 	}
 	ir_free_resources(irg, IR_RESOURCE_IRN_LINK|IR_RESOURCE_PHI_LIST);
 	del_pqueue(pqueue);
 }
 
-/*
- * Heuristic inliner. Calculates a benefice value for every call and inlines
- * those calls with a value higher than the threshold.
- */
-void inline_functions(unsigned maxsize, int inline_threshold,
-                      opt_ptr after_inline_opt)
+static void do_inline_functions(unsigned maxsize, int inline_threshold,
+                                opt_ptr after_inline_opt)
 {
 	ir_graph *rem = current_ir_graph;
 	obstack_init(&temp_obst);
@@ -1265,6 +1397,13 @@ void inline_functions(unsigned maxsize, int inline_threshold,
 		irg_walk_graph(irg, NULL, collect_calls2, &wenv);
 	}
 
+	budget.unit_size = 0;
+	for (size_t i = 0; i < n_irgs; ++i) {
+		inline_irg_env *env = (inline_irg_env*)get_irg_link(irgs[i]);
+		budget.unit_size += env->n_nodes;
+	}
+	budget.unit_limit = budget.unit_size * (100 + budget.unit_growth) / 100;
+
 	/* -- and now inline. -- */
 	for (size_t i = 0; i < n_irgs; ++i) {
 		ir_graph *irg = irgs[i];
@@ -1303,6 +1442,417 @@ void inline_functions(unsigned maxsize, int inline_threshold,
 	current_ir_graph = rem;
 }
 
+/*
+ * Heuristic inliner. Calculates a benefice value for every call and inlines
+ * those calls with a value higher than the threshold.
+ */
+void inline_functions(unsigned maxsize, int inline_threshold,
+                      opt_ptr after_inline_opt)
+{
+	budget.use_profile  = false;
+	budget.limit_growth = false;
+	do_inline_functions(maxsize, inline_threshold, after_inline_opt);
+}
+
+void inline_functions_profiled(unsigned maxsize, int inline_threshold,
+                               unsigned caller_growth, unsigned unit_growth,
+                               opt_ptr after_inline_opt)
+{
+	budget.use_profile   = true;
+	budget.limit_growth  = true;
+	budget.caller_growth = caller_growth;
+	budget.unit_growth   = unit_growth;
+	do_inline_functions(maxsize, inline_threshold, after_inline_opt);
+}
+
+/** Maximum number of blocks in the entry region of a partially inlined graph. */
+#define MAX_ENTRY_BLOCKS 4
+
+/** Number of nodes added to the inlined part for calling the outlined part. */
+#define STUB_CALL_SIZE 3
+
+/**
+ * Returns the only node ending @p block or NULL if there are several, e.g.
+ * because of exception edges.
+ */
+static ir_node *get_block_cfop(const ir_node *block)
+{
+	ir_node *cfop = NULL;
+	foreach_irn_out_r(block, i, node) {
+		if (!is_cfop(node) && get_irn_mode(node) != mode_X)
+			continue;
+		if (is_Proj(node) && is_Cond(get_Proj_pred(node)))
+			continue;
+		if (cfop != NULL)
+			return NULL;
+		cfop = node;
+	}
+	return cfop;
+}
+
+/**
+ * Finds the Cond ending the entry region of @p irg: a chain of blocks
+ * starting at the start block, in which each block is the only successor of
+ * the previous one.
+ *
+ * @param region    if not NULL, receives the blocks of the entry region
+ * @param n_region  if not NULL, receives the number of blocks in the region
+ */
+static ir_node *find_entry_cond(ir_graph *irg, ir_node **region,
+                                unsigned *n_region)
+{
+	assure_irg_outs(irg);
+	ir_node *block = get_irg_start_block(irg);
+	for (unsigned i = 0; i < MAX_ENTRY_BLOCKS; ++i) {
+		if (region != NULL) {
+			region[i]   = block;
+			*n_region = i + 1;
+		}
+		ir_node *cfop = get_block_cfop(block);
+		if (cfop == NULL)
+			return NULL;
+		if (is_Cond(cfop))
+			return cfop;
+		if (!is_Jmp(cfop) || get_irn_n_outs(cfop) != 1)
+			return NULL;
+		ir_node *succ = get_irn_out(cfop, 0);
+		if (!is_Block(succ) || get_Block_n_cfgpreds(succ) != 1
+		    || succ == get_irg_end_block(irg))
+			return NULL;
+		block = succ;
+	}
+	return NULL;
+}
+
+/** Returns the Proj of @p cond with number @p pn or NULL. */
+static ir_node *get_cond_proj(const ir_node *cond, unsigned pn)
+{
+	foreach_irn_out_r(cond, i, proj) {
+		if (is_Proj(proj) && get_Proj_num(proj) == pn)
+			return proj;
+	}
+	return NULL;
+}
+
+/** Returns the block entered by the control flow Proj @p proj or NULL. */
+static ir_node *get_proj_block(const ir_node *proj)
+{
+	if (proj == NULL || get_irn_n_outs(proj) != 1)
+		return NULL;
+	ir_node *block = get_irn_out(proj, 0);
+	return is_Block(block) ? block : NULL;
+}
+
+typedef struct entry_env_t {
+	ir_node  *region[MAX_ENTRY_BLOCKS];
+	unsigned  n_region;
+	bool      repeatable; /**< the entry region can be executed twice */
+} entry_env_t;
+
+/**
+ * Walker: checks that the entry region does not access memory except by
+ * non-volatile Loads.
+ */
+static void check_entry_node(ir_node *node, void *ctx)
+{
+	entry_env_t *env = (entry_env_t*)ctx;
+	if (is_Block(node) || is_Proj(node))
+		return;
+	ir_node *block     = get_nodes_block(node);
+	bool     in_region = false;
+	for (unsigned i = 0; i < env->n_region; ++i)
+		in_region |= env->region[i] == block;
+	if (!in_region)
+		return;
+
+	if (is_Load(node)) {
+		if (get_Load_volatility(node) == volatility_is_volatile)
+			env->repeatable = false;
+		return;
+	}
+	foreach_irn_in(node, i, pred) {
+		if (get_irn_mode(pred) == mode_M)
+			env->repeatable = false;
+	}
+}
+
+typedef struct split_env_t {
+	ir_node  *cold_block; /**< first block of the outlined part */
+	unsigned  n_stub;     /**< nodes of the inlined part */
+	unsigned  n_cold;     /**< nodes of the outlined part */
+} split_env_t;
+
+/**
+ * Walker: counts the nodes of both parts. Constants are placed in the start
+ * block wherever they are used and are not counted.
+ */
+static void count_split_node(ir_node *node, void *ctx)
+{
+	split_env_t *env = (split_env_t*)ctx;
+	if (is_nop(node) || is_Block(node) || is_irn_constlike(node))
+		return;
+	if (block_dominates(env->cold_block, get_nodes_block(node)))
+		++env->n_cold;
+	else
+		++env->n_stub;
+}
+
+/**
+ * Returns true if @p a is executed less often than @p b according to the
+ * profile or the estimated execution frequencies.
+ */
+static bool is_colder(const ir_node *a, const ir_node *b)
+{
+	if (ir_profile_has_block_execcount(a)
+	    && ir_profile_has_block_execcount(b))
+		return ir_profile_get_block_execcount(a)
+		     < ir_profile_get_block_execcount(b);
+	return get_block_execfreq(a) < get_block_execfreq(b);
+}
+
+static bool has_aggregate_types(const ir_type *mtp)
+{
+	for (size_t i = 0, n = get_method_n_params(mtp); i < n; ++i) {
+		if (is_aggregate_type(get_method_param_type(mtp, i)))
+			return true;
+	}
+	for (size_t i = 0, n = get_method_n_ress(mtp); i < n; ++i) {
+		if (is_aggregate_type(get_method_res_type(mtp, i)))
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Checks whether @p irg starts with a cheap test leading to an early exit
+ * and an expensive remainder.
+ *
+ * @return the Proj number of the edge into the remainder or -1
+ */
+static int find_partial_split(ir_graph *irg, unsigned max_stub_size)
+{
+	ir_entity *ent = get_irg_entity(irg);
+	ir_type   *mtp = get_entity_type(ent);
+	if ((get_entity_additional_properties(ent) & mtp_property_noinline)
+	    || is_method_variadic(mtp) || has_aggregate_types(mtp))
+		return -1;
+
+	entry_env_t entry = { .n_region = 0, .repeatable = true };
+	ir_node    *cond  = find_entry_cond(irg, entry.region, &entry.n_region);
+	if (cond == NULL)
+		return -1;
+	/* the remainder repeats the entry region instead of getting its values */
+	irg_walk_graph(irg, NULL, check_entry_node, &entry);
+	if (!entry.repeatable)
+		return -1;
+
+	assure_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE
+	                         | IR_GRAPH_PROPERTY_CONSISTENT_POSTDOMINANCE);
+	ir_estimate_execfreq(irg);
+
+	ir_node    *cond_block = get_nodes_block(cond);
+	int         cold_pn    = -1;
+	split_env_t split      = { .cold_block = NULL, .n_stub = 0, .n_cold = 0 };
+	for (unsigned pn = pn_Cond_false; pn <= pn_Cond_true; ++pn) {
+		ir_node *block = get_proj_block(get_cond_proj(cond, pn));
+		ir_node *other = get_proj_block(get_cond_proj(cond, !pn));
+		if (block == NULL || other == NULL
+		    || get_Block_n_cfgpreds(block) != 1)
+			continue;
+		/* without an exit avoiding the block there is no early exit */
+		if (block_postdominates(block, cond_block))
+			continue;
+		if (is_colder(other, block))
+			continue;
+
+		split_env_t env = { .cold_block = block, .n_stub = 0, .n_cold = 0 };
+		irg_walk_graph(irg, NULL, count_split_node, &env);
+		if (cold_pn < 0 || env.n_cold > split.n_cold) {
+			cold_pn = pn;
+			split   = env;
+		}
+	}
+	if (cold_pn < 0)
+		return -1;
+
+	DB((dbg, LEVEL_2, "%+F: split at %+F, %u nodes inlined, %u outlined\n",
+	    irg, split.cold_block, split.n_stub, split.n_cold));
+	if (split.n_stub + STUB_CALL_SIZE > max_stub_size
+	    || split.n_cold < split.n_stub)
+		return -1;
+	return cold_pn;
+}
+
+/**
+ * Creates a method for the remainder of @p irg: a copy of @p irg which
+ * always takes the edge @p cold_pn of its entry Cond.
+ */
+static ir_entity *create_outlined_method(ir_graph *irg, unsigned cold_pn)
+{
+	ir_entity *ent  = get_irg_entity(irg);
+	ident     *name = id_unique(new_id_fmt("%s.cold", get_entity_ident(ent)));
+	ir_entity *cold = clone_entity(ent, name, get_entity_owner(ent));
+	set_entity_visibility(cold, ir_visibility_local);
+	/* inlining the remainder again would defeat the purpose */
+	add_entity_additional_properties(cold, mtp_property_noinline);
+
+	ir_graph *copy = create_irg_copy(irg);
+	set_irg_entity(copy, cold);
+	set_entity_irg(cold, copy);
+	add_irp_irg(copy);
+
+	ir_node *cond      = find_entry_cond(copy, NULL, NULL);
+	ir_node *cold_proj = get_cond_proj(cond, cold_pn);
+	ir_node *fast_proj = get_cond_proj(cond, !cold_pn);
+	exchange(cold_proj, new_r_Jmp(get_nodes_block(cond)));
+	exchange(fast_proj, new_r_Bad(copy, mode_X));
+	confirm_irg_properties(copy, IR_GRAPH_PROPERTIES_NONE);
+
+	remove_unreachable_code(copy);
+	remove_bads(copy);
+	return cold;
+}
+
+/**
+ * Creates the part of @p irg which is inlined: a copy of @p irg in which the
+ * edge @p cold_pn of the entry Cond leads to a call of @p cold.
+ */
+static ir_graph *create_stub(ir_graph *irg, unsigned cold_pn, ir_entity *cold)
+{
+	ir_graph *stub = create_irg_copy(irg);
+	set_irg_entity(stub, get_irg_entity(irg));
+
+	ir_node *cond       = find_entry_cond(stub, NULL, NULL);
+	ir_node *cold_proj  = get_cond_proj(cond, cold_pn);
+	ir_node *cold_block = get_proj_block(cold_proj);
+	set_Block_cfgpred(cold_block, 0, new_r_Bad(stub, mode_X));
+
+	ir_type  *mtp      = get_entity_type(cold);
+	size_t    n_params = get_method_n_params(mtp);
+	ir_node  *irg_args = get_irg_args(stub);
+	ir_node **args     = ALLOCAN(ir_node*, n_params);
+	for (size_t i = 0; i < n_params; ++i) {
+		ir_mode *mode = get_type_mode(get_method_param_type(mtp, i));
+		args[i] = new_r_Proj(irg_args, mode, i);
+	}
+
+	/* the entry region does not change memory */
+	ir_node *block    = new_r_Block(stub, 1, &cold_proj);
+	ir_node *mem      = get_irg_initial_mem(stub);
+	ir_node *addr     = new_r_Address(stub, cold);
+	ir_node *call     = new_r_Call(block, mem, addr, n_params, args, mtp);
+	ir_node *call_mem = new_r_Proj(call, mode_M, pn_Call_M);
+
+	size_t    n_res       = get_method_n_ress(mtp);
+	ir_node  *call_res    = new_r_Proj(call, mode_T, pn_Call_T_result);
+	ir_node **res         = ALLOCAN(ir_node*, n_res);
+	for (size_t i = 0; i < n_res; ++i) {
+		ir_mode *mode = get_type_mode(get_method_res_type(mtp, i));
+		res[i] = new_r_Proj(call_res, mode, i);
+	}
+	ir_node *ret = new_r_Return(block, call_mem, n_res, res);
+
+	ir_node  *end_block = get_irg_end_block(stub);
+	int       n_preds   = get_Block_n_cfgpreds(end_block);
+	ir_node **in        = ALLOCAN(ir_node*, n_preds + 1);
+	for (int i = 0; i < n_preds; ++i)
+		in[i] = get_Block_cfgpred(end_block, i);
+	in[n_preds] = ret;
+	set_irn_in(end_block, n_preds + 1, in);
+	confirm_irg_properties(stub, IR_GRAPH_PROPERTIES_NONE);
+
+	remove_unreachable_code(stub);
+	remove_bads(stub);
+	return stub;
+}
+
+/** Walker: collects the direct calls of each method. */
+static void collect_call_sites(ir_node *node, void *ctx)
+{
+	pmap *sites = (pmap*)ctx;
+	if (!is_Call(node))
+		return;
+	ir_entity *callee = get_Call_callee(node);
+	if (callee == NULL)
+		return;
+	ir_node **calls = pmap_get(ir_node*, sites, callee);
+	if (calls == NULL)
+		calls = NEW_ARR_F(ir_node*, 0);
+	ARR_APP1(ir_node*, calls, node);
+	pmap_insert(sites, callee, calls);
+}
+
+static void add_changed_graph(ir_graph ***changed, ir_graph *irg)
+{
+	for (size_t i = 0, n = ARR_LEN(*changed); i < n; ++i) {
+		if ((*changed)[i] == irg)
+			return;
+	}
+	ARR_APP1(ir_graph*, *changed, irg);
+}
+
+void partial_inline_functions(unsigned max_stub_size, opt_ptr after_inline_opt)
+{
+	ir_graph *rem = current_ir_graph;
+
+	pmap *sites = pmap_create();
+	foreach_irp_irg(i, irg) {
+		free_callee_info(irg);
+		irg_walk_graph(irg, NULL, collect_call_sites, sites);
+	}
+
+	/* the outlined graphs are appended to the list and not visited */
+	ir_graph **changed = NEW_ARR_F(ir_graph*, 0);
+	for (size_t i = 0, n_irgs = get_irp_n_irgs(); i < n_irgs; ++i) {
+		ir_graph  *irg   = get_irp_irg(i);
+		ir_entity *ent   = get_irg_entity(irg);
+		ir_node  **calls = pmap_get(ir_node*, sites, ent);
+		if (calls == NULL || get_entity_linktime_irg(ent) != irg)
+			continue;
+		int cold_pn = find_partial_split(irg, max_stub_size);
+		if (cold_pn < 0)
+			continue;
+
+		ir_entity *cold = create_outlined_method(irg, cold_pn);
+		ir_graph  *stub = create_stub(irg, cold_pn, cold);
+		add_changed_graph(&changed, get_entity_irg(cold));
+
+		for (size_t c = 0, n_calls = ARR_LEN(calls); c < n_calls; ++c) {
+			ir_node  *call   = calls[c];
+			ir_graph *caller = get_irn_irg(call);
+			if (caller == irg)
+				continue;
+
+			current_ir_graph = caller;
+			ir_reserve_resources(caller, IR_RESOURCE_IRN_LINK|IR_RESOURCE_PHI_LIST);
+			collect_phiprojs_and_start_block_nodes(caller);
+			ir_reserve_resources(stub, IR_RESOURCE_IRN_LINK);
+			if (inline_method(call, stub)) {
+				DB((dbg, LEVEL_1, "partially inlined %+F into %+F\n", irg,
+				    caller));
+				add_changed_graph(&changed, caller);
+			}
+			ir_free_resources(stub, IR_RESOURCE_IRN_LINK);
+			ir_free_resources(caller, IR_RESOURCE_IRN_LINK|IR_RESOURCE_PHI_LIST);
+		}
+
+		/* reset the entity, otherwise it will be deleted */
+		set_irg_entity(stub, NULL);
+		free_ir_graph(stub);
+	}
+
+	if (after_inline_opt != NULL) {
+		for (size_t i = 0, n = ARR_LEN(changed); i < n; ++i)
+			after_inline_opt(changed[i]);
+	}
+	DEL_ARR_F(changed);
+	foreach_pmap(sites, entry) {
+		DEL_ARR_F((ir_node**)entry->value);
+	}
+	pmap_destroy(sites);
+	current_ir_graph = rem;
+}
+
 void firm_init_inline(void)
 {
 	FIRM_DBG_REGISTER(dbg, "firm.opt.inline");
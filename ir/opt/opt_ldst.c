@@ -47,6 +47,7 @@ enum memop_flags {
 	FLAG_KILLED_NODE = 2, /**< this node was killed */
 	FLAG_EXCEPTION   = 4, /**< this node has exception flow */
 	FLAG_IGNORE      = 8, /**< ignore this node (volatile or other) */
+	FLAG_KILL_CALL   = 16, /**< KILL addresses accessed by a Call */
 };
 
 /**
@@ -149,6 +150,8 @@ static void dump_block_list(ldst_env *env)
 				DB((dbg, LEVEL_2, "X"));
 			else if (op->flags & FLAG_KILL_ALL)
 				DB((dbg, LEVEL_2, "K"));
+			else if (op->flags & FLAG_KILL_CALL)
+				DB((dbg, LEVEL_2, "C"));
 			DB((dbg, LEVEL_2, ", "));
 
 			i = (i + 1) & 3;
@@ -699,7 +702,7 @@ static void update_Call_memop(memop_t *m)
 	if (is_Call_pure(call)) {
 		m->flags = 0;
 	} else {
-		m->flags = FLAG_KILL_ALL;
+		m->flags = FLAG_KILL_CALL;
 	}
 
 	foreach_irn_out_r(call, i, proj) {
@@ -936,6 +939,30 @@ static void kill_memops(const value_t *value)
 	}
 }
 
+/**
+ * Kill memops from the current set whose memory may be accessed by a Call.
+ * Stores are killed if the Call reads their memory, too: they must not be
+ * removed as overwritten by a later Store.
+ *
+ * @param call  the Call node
+ */
+static void kill_call_memops(const ir_node *call)
+{
+	size_t end = env.rbs_size - 1;
+
+	for (size_t pos = rbitset_next(env.curr_set, 0, 1); pos < end; pos = rbitset_next(env.curr_set, pos + 1, 1)) {
+		memop_t    *op      = env.curr_id_2_memop[pos];
+		ir_mod_ref  mod_ref = get_call_mod_ref(call, op->value.address);
+
+		if ((mod_ref & ir_mod_ref_mod)
+		    || (mod_ref != ir_mod_ref_none && is_Store(op->node))) {
+			rbitset_clear(env.curr_set, pos);
+			env.curr_id_2_memop[pos] = NULL;
+			DB((dbg, LEVEL_2, "KILLING %+F because of %+F\n", op->node, call));
+		}
+	}
+}
+
 /**
  * Add the value of a memop to the current set.
  *
@@ -1103,6 +1130,8 @@ static void calc_gen_kill_avail(block_t *bl)
 		default:
 			if (op->flags & FLAG_KILL_ALL)
 				kill_all();
+			else if (op->flags & FLAG_KILL_CALL)
+				kill_call_memops(op->node);
 		}
 	}
 }
@@ -1234,6 +1263,8 @@ static int backward_antic(block_t *bl)
 		default:
 			if (op->flags & FLAG_KILL_ALL)
 				kill_all();
+			else if (op->flags & FLAG_KILL_CALL)
+				kill_call_memops(op->node);
 		}
 	}
 
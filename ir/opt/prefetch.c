@@ -0,0 +1,323 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2017 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Software prefetching for strided Loads in loops.
+ *
+ * The address of a Load in an innermost loop which changes by a constant
+ * stride per iteration is expressed as a function of the induction variables
+ * found by the scalar evolution analysis. A prefetch Builtin for the address
+ * accessed a given number of bytes ahead is inserted before the Load. Loads
+ * whose addresses differ only by a constant smaller than a cache line share
+ * one prefetch. Loops with a small constant trip count are skipped, data of
+ * loops touching more memory than fits into the caches is prefetched as
+ * non-temporal.
+ */
+#include <stdlib.h>
+
+#include "array.h"
+#include "debug.h"
+#include "ircons.h"
+#include "irgraph_t.h"
+#include "irgwalk.h"
+#include "irloop_t.h"
+#include "irnode_t.h"
+#include "iroptimize.h"
+#include "pmap.h"
+#include "scev.h"
+#include "tv.h"
+#include "type_t.h"
+#include "util.h"
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg;)
+
+/** Loops with a smaller known number of iterations are not considered. */
+#define MIN_TRIP_COUNT    64
+/** Maximum number of prefetches inserted per loop. */
+#define MAX_PREFETCHES    8
+/** Accesses within this range are covered by the same prefetch. */
+#define CACHE_LINE_SIZE   64
+/** Loops touching more bytes per Load use non-temporal prefetches. */
+#define NTA_FOOTPRINT     (4 << 20)
+/** Maximum absolute stride in bytes considered. */
+#define MAX_STRIDE        (1 << 16)
+/** Maximum depth of an address expression. */
+#define MAX_EXPR_DEPTH    8
+
+/** A prefetched address of a loop. */
+typedef struct prefetch_t {
+	ir_node *base;   /**< the address without constant offset */
+	long     offset; /**< the constant offset of the address */
+	long     stride; /**< the change of the address per iteration */
+} prefetch_t;
+
+typedef struct prefetch_env_t {
+	unsigned  distance; /**< number of bytes to prefetch ahead */
+	pmap     *loops;    /**< maps innermost loops to their prefetch_t array */
+	ir_node **loads;    /**< the Loads to prefetch for */
+	ir_type  *type;     /**< method type of the prefetch Builtin */
+	unsigned  n_prefetches;
+} prefetch_env_t;
+
+static bool is_innermost_loop(const ir_loop *loop)
+{
+	for (size_t i = 0, n = get_loop_n_elements(loop); i < n; ++i) {
+		if (*get_loop_element(loop, i).kind == k_ir_loop)
+			return false;
+	}
+	return true;
+}
+
+static bool is_in_loop(const ir_node *node, const ir_loop *loop)
+{
+	return get_irn_loop(get_block_const(node)) == loop;
+}
+
+/** Returns the signed value of the constant @p tv in @p value. */
+static bool get_signed_long(ir_tarval *tv, long *value)
+{
+	if (!tarval_is_long(tv))
+		return false;
+	long           result = get_tarval_long(tv);
+	ir_mode *const mode   = get_tarval_mode(tv);
+	unsigned const bits   = get_mode_size_bits(mode);
+	if (!mode_is_signed(mode) && bits < sizeof(long) * 8
+	    && result >= 1L << (bits - 1))
+		result -= 1L << (bits - 1) << 1;
+	*value = result;
+	return true;
+}
+
+/**
+ * Computes the change of the value of @p node per iteration of the innermost
+ * loop @p loop. Returns false if the value is not an affine function of the
+ * induction variables of the loop.
+ */
+static bool get_stride(ir_node *node, const ir_loop *loop, unsigned depth,
+                       long *stride)
+{
+	if (!is_in_loop(node, loop)) {
+		*stride = 0;
+		return true;
+	}
+	if (depth >= MAX_EXPR_DEPTH)
+		return false;
+
+	long left;
+	long right;
+	long value;
+	switch (get_irn_opcode(node)) {
+	case iro_Const:
+		*stride = 0;
+		return true;
+	case iro_Phi: {
+		scev_t const *const iv = scev_get_phi(node);
+		if (iv == NULL || iv->loop != loop
+		    || !get_signed_long(iv->step_tv, stride))
+			return false;
+		break;
+	}
+	case iro_Add:
+		if (!get_stride(get_Add_left(node), loop, depth + 1, &left)
+		    || !get_stride(get_Add_right(node), loop, depth + 1, &right))
+			return false;
+		*stride = left + right;
+		break;
+	case iro_Sub:
+		if (!get_stride(get_Sub_left(node), loop, depth + 1, &left)
+		    || !get_stride(get_Sub_right(node), loop, depth + 1, &right))
+			return false;
+		*stride = left - right;
+		break;
+	case iro_Mul:
+		if (!is_Const(get_Mul_right(node))
+		    || !get_signed_long(get_Const_tarval(get_Mul_right(node)), &value)
+		    || labs(value) > MAX_STRIDE
+		    || !get_stride(get_Mul_left(node), loop, depth + 1, &left))
+			return false;
+		*stride = left * value;
+		break;
+	case iro_Shl:
+		if (!is_Const(get_Shl_right(node))
+		    || !get_signed_long(get_Const_tarval(get_Shl_right(node)), &value)
+		    || value < 0 || value >= 16
+		    || !get_stride(get_Shl_left(node), loop, depth + 1, &left))
+			return false;
+		*stride = left * (1L << value);
+		break;
+	case iro_Conv: {
+		ir_node *const op = get_Conv_op(node);
+		if (!mode_is_int(get_irn_mode(op))
+		    || !get_stride(op, loop, depth + 1, stride))
+			return false;
+		break;
+	}
+	case iro_Member:
+		if (!get_stride(get_Member_ptr(node), loop, depth + 1, stride))
+			return false;
+		break;
+	default:
+		return false;
+	}
+	return labs(*stride) <= MAX_STRIDE;
+}
+
+/** Splits @p ptr into a base address and a constant offset. */
+static ir_node *split_offset(ir_node *ptr, long *offset)
+{
+	*offset = 0;
+	if (is_Add(ptr) && is_Const(get_Add_right(ptr))
+	    && get_signed_long(get_Const_tarval(get_Add_right(ptr)), offset))
+		return get_Add_left(ptr);
+	return ptr;
+}
+
+/** Returns the prefetches inserted into @p loop. */
+static prefetch_t **get_loop_prefetches(prefetch_env_t *env, ir_loop *loop)
+{
+	prefetch_t **prefetches = pmap_get(prefetch_t*, env->loops, loop);
+	if (prefetches == NULL) {
+		prefetches  = XMALLOC(prefetch_t*);
+		*prefetches = NEW_ARR_F(prefetch_t, 0);
+		pmap_insert(env->loops, loop, prefetches);
+	}
+	return prefetches;
+}
+
+/**
+ * Returns the known number of iterations of @p loop or 0 if it is not
+ * known.
+ */
+static long get_loop_trip_count(ir_loop *loop, ir_graph *irg)
+{
+	scev_trip_count_t const *const tc = scev_get_trip_count(irg, loop);
+	if (tc == NULL || !tarval_is_long(tc->count))
+		return 0;
+	return get_tarval_long(tc->count);
+}
+
+/** Returns the builtin type for prefetch(ptr, rw, locality). */
+static ir_type *get_prefetch_type(prefetch_env_t *env)
+{
+	if (env->type == NULL) {
+		ir_type *const int_type = get_type_for_mode(mode_Is);
+		ir_type *const type     = new_type_method(3, 0, false, cc_cdecl_set,
+		                                          mtp_no_property);
+		set_method_param_type(type, 0, get_type_for_mode(mode_P));
+		set_method_param_type(type, 1, int_type);
+		set_method_param_type(type, 2, int_type);
+		env->type = type;
+	}
+	return env->type;
+}
+
+/** Inserts a prefetch for the address accessed by @p load ahead. */
+static void insert_prefetch(prefetch_env_t *env, ir_node *load, long stride,
+                            long trip_count)
+{
+	ir_graph *const irg   = get_irn_irg(load);
+	ir_node  *const block = get_nodes_block(load);
+	ir_node  *const ptr   = get_Load_ptr(load);
+	ir_mode  *const mode  = get_irn_mode(ptr);
+
+	/* prefetch a whole number of iterations ahead */
+	long const abs_stride = labs(stride);
+	long const iterations = MAX(1, ((long)env->distance + abs_stride - 1)
+	                               / abs_stride);
+	ir_mode *const offset_mode = get_reference_offset_mode(mode);
+	ir_node *const ahead       = new_r_Const_long(irg, offset_mode,
+	                                              iterations * stride);
+	ir_node *const addr        = new_r_Add(block, ptr, ahead);
+
+	/* data of large loops does not stay in the caches anyway */
+	bool     const streaming = trip_count > 0
+	                        && trip_count * abs_stride >= NTA_FOOTPRINT;
+	ir_node *const in[] = {
+		addr,
+		new_r_Const_long(irg, mode_Is, 0),
+		new_r_Const_long(irg, mode_Is, streaming ? 0 : 3),
+	};
+	ir_node *const prefetch = new_r_Builtin(block, get_Load_mem(load),
+	                                        ARRAY_SIZE(in), in, ir_bk_prefetch,
+	                                        get_prefetch_type(env));
+	set_Load_mem(load, new_r_Proj(prefetch, mode_M, pn_Builtin_M));
+	DB((dbg, LEVEL_2, "  prefetching %+F with stride %ld%s\n", load, stride,
+	    streaming ? " (non-temporal)" : ""));
+	++env->n_prefetches;
+}
+
+static void collect_loads(ir_node *node, void *data)
+{
+	prefetch_env_t *const env = (prefetch_env_t*)data;
+	if (!is_Load(node) || get_Load_volatility(node) == volatility_is_volatile)
+		return;
+	ir_loop *const loop = get_irn_loop(get_nodes_block(node));
+	if (loop == NULL || get_loop_depth(loop) == 0 || !is_innermost_loop(loop))
+		return;
+	ARR_APP1(ir_node*, env->loads, node);
+}
+
+static void prefetch_load(prefetch_env_t *env, ir_node *load)
+{
+	ir_graph *const irg  = get_irn_irg(load);
+	ir_loop  *const loop = get_irn_loop(get_nodes_block(load));
+	long stride;
+	if (!get_stride(get_Load_ptr(load), loop, 0, &stride) || stride == 0)
+		return;
+
+	long const trip_count = get_loop_trip_count(loop, irg);
+	if (trip_count > 0 && trip_count < MIN_TRIP_COUNT)
+		return;
+
+	/* share prefetches of nearby addresses */
+	prefetch_t **const prefetches = get_loop_prefetches(env, loop);
+	long               offset;
+	ir_node     *const base       = split_offset(get_Load_ptr(load), &offset);
+	size_t       const n          = ARR_LEN(*prefetches);
+	if (n >= MAX_PREFETCHES)
+		return;
+	for (size_t i = 0; i < n; ++i) {
+		prefetch_t const *const other = &(*prefetches)[i];
+		if (other->base == base && other->stride == stride
+		    && labs(other->offset - offset) < CACHE_LINE_SIZE)
+			return;
+	}
+	prefetch_t const prefetch = {
+		.base   = base,
+		.offset = offset,
+		.stride = stride,
+	};
+	ARR_APP1(prefetch_t, *prefetches, prefetch);
+	insert_prefetch(env, load, stride, trip_count);
+}
+
+void opt_prefetch(ir_graph *irg, unsigned distance)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.opt.prefetch");
+	DB((dbg, LEVEL_1, "prefetching on %+F\n", irg));
+
+	assure_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO);
+
+	prefetch_env_t env = {
+		.distance = MAX(distance, 1u),
+		.loops    = pmap_create(),
+		.loads    = NEW_ARR_F(ir_node*, 0),
+	};
+	irg_walk_graph(irg, NULL, collect_loads, &env);
+	for (size_t i = 0, n = ARR_LEN(env.loads); i < n; ++i)
+		prefetch_load(&env, env.loads[i]);
+
+	foreach_pmap(env.loops, entry) {
+		prefetch_t **const prefetches = (prefetch_t**)entry->value;
+		DEL_ARR_F(*prefetches);
+		free(prefetches);
+	}
+	pmap_destroy(env.loops);
+	DEL_ARR_F(env.loads);
+
+	confirm_irg_properties(irg, env.n_prefetches > 0
+		? IR_GRAPH_PROPERTIES_CONTROL_FLOW : IR_GRAPH_PROPERTIES_ALL);
+}
@@ -328,6 +328,8 @@ static void set_preds(ir_node *irn, void *env)
  *
  * @param irg  irg that must be cloned.
  * @param pos  The position of the argument.
+ *
+ * @return the argument or NULL if it is unused
  */
 static ir_node *get_irg_arg(ir_graph *irg, size_t pos)
 {
@@ -344,7 +346,6 @@ static ir_node *get_irg_arg(ir_graph *irg, size_t pos)
 			arg = proj;
 		}
 	}
-	assert(arg && "Argument not found");
 	return arg;
 }
 
@@ -388,7 +389,14 @@ static void create_clone_proc_irg(ir_entity *ent, const quadruple_t *q)
 	ir_graph *const clone_irg  = new_ir_graph(ent, 0);
 	clone_frame(method_irg, clone_irg, q->pos);
 
-	ir_node *const arg        = get_irg_arg(get_entity_irg(q->ent), q->pos);
+	ir_node       *arg        = get_irg_arg(method_irg, q->pos);
+	bool     const unused     = arg == NULL;
+	if (unused) {
+		/* a Proj without users, so the other arguments are renumbered */
+		ir_type *const mtp  = get_entity_type(q->ent);
+		ir_mode *const mode = get_type_mode(get_method_param_type(mtp, q->pos));
+		arg = new_r_Proj(get_irg_args(method_irg), mode, q->pos);
+	}
 	/* we will replace the argument in position "q->pos" by this constant. */
 	ir_node *const const_arg  = new_r_Const(clone_irg, q->tv);
 
@@ -405,6 +413,8 @@ static void create_clone_proc_irg(ir_entity *ent, const quadruple_t *q)
 	/* The "cloned" graph must be matured. */
 	irg_finalize_cons(clone_irg);
 	ir_free_resources(method_irg, IR_RESOURCE_IRN_LINK);
+	if (unused)
+		kill_node(arg);
 }
 
 /**
@@ -511,6 +521,8 @@ static void exchange_calls(quadruple_t *q, ir_entity *cloned_ent)
 		 * clone graph must be exchanged with new one. */
 		ir_node *const new_call = new_cl_Call(call, cloned_ent, pos);
 		exchange(call, new_call);
+		confirm_irg_properties(get_irn_irg(new_call),
+		                       IR_GRAPH_PROPERTIES_CONTROL_FLOW);
 	}
 }
 
@@ -0,0 +1,711 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2017 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Scalar promotion of memory locations accessed inside loops.
+ *
+ * A memory location which is stored inside a loop is kept in a register
+ * instead: it is loaded once in a new preheader, the Loads and Stores of the
+ * location inside the loop are removed and its value is stored back on every
+ * exit of the loop. The value of the location at a point of the loop is
+ * determined by following the memory chain: it is the value of the preceding
+ * Store to the location, the value loaded in the preheader or a Phi merging
+ * these at a memory Phi.
+ *
+ * A location is promoted if its address is loop invariant, all Loads and
+ * Stores accessing it use the same mode and all other memory operations of
+ * the loop do not alias it. Loops containing calls which may access memory
+ * are not handled. As the location is accessed even where the loop would not
+ * have done so, it must be a local variable whose address does not escape or
+ * a Store to it must be executed before the loop is left.
+ */
+#include "array.h"
+#include "debug.h"
+#include "entity_t.h"
+#include "ircons.h"
+#include "irdom.h"
+#include "iredges_t.h"
+#include "irgmod.h"
+#include "irgraph_t.h"
+#include "irgwalk.h"
+#include "irloop_t.h"
+#include "irmemory.h"
+#include "irnode_t.h"
+#include "iroptimize.h"
+#include "irtools.h"
+#include "pmap.h"
+#include "util.h"
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg;)
+
+/** Maximum number of locations promoted in a graph. */
+#define MAX_PROMOTIONS    64
+/** Maximum depth of a loop invariant address computed inside the loop. */
+#define MAX_EXPR_DEPTH    8
+
+/** Facts about a loop. */
+typedef struct loop_info_t {
+	ir_loop  *loop;
+	ir_node  *header;      /**< the only block entered from outside */
+	bool      irreducible; /**< entered at more than one block */
+	unsigned  n_entries;   /**< number of control flow edges entering */
+	ir_node **memops;      /**< memory operations and memory Phis */
+	ir_node **cfops;       /**< control flow nodes */
+} loop_info_t;
+
+/** A control flow edge leaving the loop. */
+typedef struct exit_t {
+	ir_node *block; /**< the block outside of the loop */
+	int      pos;   /**< the predecessor of block leaving the loop */
+	ir_node *mem;   /**< the memory state when leaving the loop */
+	ir_node *store; /**< the Store writing back the location */
+} exit_t;
+
+/** A location promoted in a loop. */
+typedef struct promote_env_t {
+	loop_info_t *info;
+	ir_node     *mem_phi;  /**< the memory Phi of the loop header */
+	ir_node     *ptr;      /**< the loop invariant address */
+	ir_mode     *mode;
+	ir_type     *type;
+	ir_node    **accesses; /**< the Loads and Stores of the location */
+	exit_t      *exits;
+	ir_node     *init;     /**< the value loaded in the preheader */
+	pmap        *values;   /**< maps memory states to values of the location */
+} promote_env_t;
+
+/** Checks whether @p inner is @p loop or one of its nested loops. */
+static bool loop_contains(const ir_loop *loop, const ir_loop *inner)
+{
+	if (inner == NULL)
+		return false;
+	unsigned const depth = get_loop_depth(loop);
+	while (get_loop_depth(inner) > depth)
+		inner = get_loop_outer_loop(inner);
+	return inner == loop;
+}
+
+static bool is_block_in_loop(const ir_node *block, const ir_loop *loop)
+{
+	return loop_contains(loop, get_irn_loop(block));
+}
+
+static bool is_in_loop(const ir_node *node, const ir_loop *loop)
+{
+	return is_block_in_loop(get_block_const(node), loop);
+}
+
+static bool is_root_loop(const ir_loop *loop)
+{
+	return get_loop_outer_loop(loop) == loop;
+}
+
+/**
+ * Checks whether the value of @p node does not change inside @p loop: it is
+ * defined outside or computed by floating nodes from such values.
+ */
+static bool is_invariant(const ir_node *node, const ir_loop *loop,
+                         unsigned depth)
+{
+	if (!is_in_loop(node, loop))
+		return true;
+	if (depth >= MAX_EXPR_DEPTH || is_Phi(node)
+	    || get_irn_pinned(node) != op_pin_state_floats)
+		return false;
+	foreach_irn_in(node, i, pred) {
+		if (!is_invariant(pred, loop, depth + 1))
+			return false;
+	}
+	return true;
+}
+
+/** Copies the invariant expression @p node of @p loop into @p block. */
+static ir_node *copy_invariant(ir_node *node, const ir_loop *loop,
+                               ir_node *block)
+{
+	if (!is_in_loop(node, loop))
+		return node;
+	ir_node *const copy = exact_copy(node);
+	set_nodes_block(copy, block);
+	foreach_irn_in(node, i, pred) {
+		set_irn_n(copy, i, copy_invariant(pred, loop, block));
+	}
+	return copy;
+}
+
+static loop_info_t *get_loop_info(pmap *loops, ir_loop *loop)
+{
+	loop_info_t *info = pmap_get(loop_info_t, loops, loop);
+	if (info == NULL) {
+		info         = XMALLOCZ(loop_info_t);
+		info->loop   = loop;
+		info->memops = NEW_ARR_F(ir_node*, 0);
+		info->cfops  = NEW_ARR_F(ir_node*, 0);
+		pmap_insert(loops, loop, info);
+	}
+	return info;
+}
+
+/** Collects the memory and control flow nodes of all loops. */
+static void analyze_node(ir_node *node, void *data)
+{
+	pmap    *const loops = (pmap*)data;
+	ir_node *const block = get_block(node);
+	ir_mode *const mode  = get_irn_mode(node);
+	bool     const memop = is_memop(node) || (mode == mode_M && !is_Proj(node));
+	for (ir_loop *loop = get_irn_loop(block); loop != NULL
+	     && !is_root_loop(loop); loop = get_loop_outer_loop(loop)) {
+		loop_info_t *const info = get_loop_info(loops, loop);
+		if (memop)
+			ARR_APP1(ir_node*, info->memops, node);
+		if (mode == mode_X)
+			ARR_APP1(ir_node*, info->cfops, node);
+	}
+	if (!is_Block(node))
+		return;
+
+	for (int i = 0, n = get_Block_n_cfgpreds(node); i < n; ++i) {
+		ir_node *const pred = get_Block_cfgpred_block(node, i);
+		/* the edge enters all loops containing node but not pred */
+		for (ir_loop *loop = get_irn_loop(node); loop != NULL
+		     && !is_root_loop(loop) && !is_block_in_loop(pred, loop);
+		     loop = get_loop_outer_loop(loop)) {
+			loop_info_t *const info = get_loop_info(loops, loop);
+			if (info->header != NULL && info->header != node)
+				info->irreducible = true;
+			info->header = node;
+			++info->n_entries;
+		}
+	}
+}
+
+static int cmp_loop_infos(const void *p1, const void *p2)
+{
+	loop_info_t const *const i1 = *(loop_info_t const**)p1;
+	loop_info_t const *const i2 = *(loop_info_t const**)p2;
+	unsigned const d1 = get_loop_depth(i1->loop);
+	unsigned const d2 = get_loop_depth(i2->loop);
+	/* inner loops first */
+	if (d1 != d2)
+		return d1 < d2 ? 1 : -1;
+	return QSORT_CMP(get_loop_loop_nr(i1->loop), get_loop_loop_nr(i2->loop));
+}
+
+/** Returns the memory Proj of @p node or NULL. */
+static ir_node *get_mem_proj(const ir_node *node)
+{
+	foreach_out_edge(node, edge) {
+		ir_node *const proj = get_edge_src_irn(edge);
+		if (is_Proj(proj) && get_irn_mode(proj) == mode_M)
+			return proj;
+	}
+	return NULL;
+}
+
+/**
+ * Returns true if @p call neither reads nor writes memory, so the promoted
+ * value may stay in a register across it.
+ */
+static bool is_pure_call(const ir_node *call)
+{
+	mtp_additional_properties props
+		= get_method_additional_properties(get_Call_type(call));
+	ir_entity const *const callee = get_Call_callee(call);
+	if (callee != NULL)
+		props |= get_entity_additional_properties(callee);
+	mtp_additional_properties const required
+		= mtp_property_pure | mtp_property_no_write;
+	return (props & required) == required;
+}
+
+static bool is_access(const promote_env_t *env, const ir_node *node)
+{
+	for (size_t i = 0, n = ARR_LEN(env->accesses); i < n; ++i) {
+		if (env->accesses[i] == node)
+			return true;
+	}
+	return false;
+}
+
+/** Returns the memory state before the accesses preceding @p mem. */
+static ir_node *skip_accesses(const promote_env_t *env, ir_node *mem)
+{
+	while (is_Proj(mem) && is_access(env, get_Proj_pred(mem)))
+		mem = get_memop_mem(get_Proj_pred(mem));
+	return mem;
+}
+
+/**
+ * Checks whether @p mem is replaced by a later memory state in its block
+ * @p block.
+ */
+static bool is_overwritten_in_block(const ir_node *mem, const ir_node *block)
+{
+	foreach_out_edge(mem, edge) {
+		ir_node *const user = get_edge_src_irn(edge);
+		if (!is_Phi(user) && !is_End(user) && get_nodes_block(user) == block
+		    && (is_Sync(user) || get_mem_proj(user) != NULL))
+			return true;
+	}
+	return false;
+}
+
+/** Returns the memory state at the end of @p block of the loop or NULL. */
+static ir_node *get_block_mem(const loop_info_t *info, ir_node *block)
+{
+	for (;;) {
+		ir_node *result       = NULL;
+		unsigned n_candidates = 0;
+		unsigned n_used       = 0;
+		for (size_t i = 0, n = ARR_LEN(info->memops); i < n; ++i) {
+			ir_node *const node = info->memops[i];
+			if (get_nodes_block(node) != block)
+				continue;
+			ir_node *const mem = is_memop(node) ? get_mem_proj(node) : node;
+			if (mem == NULL || is_overwritten_in_block(mem, block))
+				continue;
+			/* dead memory states are only used if there is no other */
+			++n_candidates;
+			if (get_irn_n_edges(mem) > 0) {
+				++n_used;
+				result = mem;
+			} else if (n_used == 0) {
+				result = mem;
+			}
+		}
+		if (n_used > 1 || (n_used == 0 && n_candidates > 1))
+			return NULL;
+		if (result != NULL)
+			return result;
+		/* the memory state of the dominator reaches blocks without memory
+		 * operations, the header always has a memory Phi */
+		block = get_Block_idom(block);
+	}
+}
+
+/** Finds the exits of the loop and the memory states leaving it. */
+static bool analyze_exits(promote_env_t *env)
+{
+	loop_info_t *const info = env->info;
+	ir_graph    *const irg  = get_irn_irg(info->header);
+	ARR_RESIZE(exit_t, env->exits, 0);
+	for (size_t i = 0, n = ARR_LEN(info->cfops); i < n; ++i) {
+		ir_node *const cfop = info->cfops[i];
+		foreach_out_edge(cfop, edge) {
+			ir_node *const succ = get_edge_src_irn(edge);
+			if (!is_Block(succ) || is_block_in_loop(succ, info->loop))
+				continue;
+			/* the memory state at an exception is not known */
+			if (succ == get_irg_end_block(irg) || is_x_except_Proj(cfop))
+				return false;
+			ir_node *const mem = get_block_mem(info, get_nodes_block(cfop));
+			if (mem == NULL
+			    || !is_in_loop(skip_accesses(env, mem), info->loop))
+				return false;
+			exit_t const exit = {
+				.block = succ,
+				.pos   = get_edge_src_pos(edge),
+				.mem   = mem,
+			};
+			ARR_APP1(exit_t, env->exits, exit);
+		}
+	}
+	return ARR_LEN(env->exits) > 0;
+}
+
+/**
+ * Checks whether @p ptr addresses a local variable whose address does not
+ * escape, so no other code can observe the additional accesses.
+ */
+static bool is_private_entity(ir_graph *irg, const ir_node *ptr)
+{
+	if (!is_Member(ptr))
+		return false;
+	while (is_Member(get_Member_ptr(ptr)))
+		ptr = get_Member_ptr(ptr);
+	if (get_Member_ptr(ptr) != get_irg_frame(irg))
+		return false;
+	ir_entity const *const entity = get_Member_entity(ptr);
+	return !(get_entity_usage(entity) & ir_usage_address_taken);
+}
+
+/**
+ * Checks whether the location may be accessed in the preheader and at the
+ * exits of the loop: it is a private local variable or stored before every
+ * exit. Global variables need the Store as well, as another thread may write
+ * them while the loop does not.
+ */
+static bool is_safe_to_access(const promote_env_t *env)
+{
+	ir_graph *const irg = get_irn_irg(env->info->header);
+	if (is_private_entity(irg, env->ptr))
+		return true;
+	for (size_t a = 0, n_accesses = ARR_LEN(env->accesses); a < n_accesses;
+	     ++a) {
+		ir_node *const access = env->accesses[a];
+		if (!is_Store(access))
+			continue;
+		ir_node *const block = get_nodes_block(access);
+		bool           all   = true;
+		for (size_t i = 0, n = ARR_LEN(env->exits); i < n; ++i) {
+			exit_t const *const exit = &env->exits[i];
+			if (!block_dominates(block, get_Block_cfgpred_block(exit->block,
+			                                                    exit->pos))) {
+				all = false;
+				break;
+			}
+		}
+		if (all)
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Checks whether the location stored by @p store may be promoted in the loop
+ * and collects its accesses.
+ */
+static bool analyze_location(promote_env_t *env, ir_node *store)
+{
+	loop_info_t *const info = env->info;
+	ir_node     *const ptr  = get_Store_ptr(store);
+	if (!is_invariant(ptr, info->loop, 0))
+		return false;
+	env->ptr  = ptr;
+	env->mode = get_irn_mode(get_Store_value(store));
+	env->type = get_Store_type(store);
+	ARR_RESIZE(ir_node*, env->accesses, 0);
+
+	unsigned const size = get_mode_size_bytes(env->mode);
+	for (size_t i = 0, n = ARR_LEN(info->memops); i < n; ++i) {
+		ir_node *const node = info->memops[i];
+		ir_node       *node_ptr;
+		ir_mode       *node_mode;
+		ir_type       *node_type;
+		switch (get_irn_opcode(node)) {
+		case iro_Phi:
+		case iro_Div:
+		case iro_Mod:
+			continue;
+		case iro_Call:
+			if (!is_pure_call(node))
+				return false;
+			continue;
+		case iro_Load:
+			if (get_Load_volatility(node) == volatility_is_volatile
+			    || get_Load_unaligned(node) == align_non_aligned)
+				return false;
+			node_ptr  = get_Load_ptr(node);
+			node_mode = get_Load_mode(node);
+			node_type = get_Load_type(node);
+			break;
+		case iro_Store:
+			if (get_Store_volatility(node) == volatility_is_volatile
+			    || get_Store_unaligned(node) == align_non_aligned)
+				return false;
+			node_ptr  = get_Store_ptr(node);
+			node_mode = get_irn_mode(get_Store_value(node));
+			node_type = get_Store_type(node);
+			break;
+		default:
+			return false;
+		}
+		ir_alias_relation const rel = node_ptr == ptr ? ir_sure_alias
+			: get_alias_relation(ptr, env->type, size, node_ptr, node_type,
+			                     get_mode_size_bytes(node_mode));
+		if (rel == ir_no_alias)
+			continue;
+		if (rel != ir_sure_alias || node_mode != env->mode
+		    || ir_throws_exception(node))
+			return false;
+		ARR_APP1(ir_node*, env->accesses, node);
+	}
+	return analyze_exits(env) && is_safe_to_access(env);
+}
+
+/** Returns the value of the location in the memory state @p mem. */
+static ir_node *get_location_value(promote_env_t *env, ir_node *mem)
+{
+	if (!is_in_loop(mem, env->info->loop))
+		return env->init;
+	ir_node *value = pmap_get(ir_node, env->values, mem);
+	if (value != NULL)
+		return value;
+
+	if (is_Phi(mem)) {
+		ir_graph *const irg   = get_irn_irg(mem);
+		int       const arity = get_Phi_n_preds(mem);
+		ir_node **const in    = ALLOCAN(ir_node*, arity);
+		ir_node  *const dummy = new_r_Dummy(irg, env->mode);
+		for (int i = 0; i < arity; ++i)
+			in[i] = dummy;
+		ir_node *const phi = new_r_Phi(get_nodes_block(mem), arity, in,
+		                               env->mode);
+		pmap_insert(env->values, mem, phi);
+		for (int i = 0; i < arity; ++i)
+			set_Phi_pred(phi, i, get_location_value(env, get_Phi_pred(mem, i)));
+		return phi;
+	}
+
+	ir_node *const node = get_Proj_pred(mem);
+	if (is_Store(node) && is_access(env, node))
+		value = get_Store_value(node);
+	else
+		value = get_location_value(env, get_memop_mem(node));
+	pmap_insert(env->values, mem, value);
+	return value;
+}
+
+static bool is_exit_store(const promote_env_t *env, const ir_node *node)
+{
+	for (size_t i = 0, n = ARR_LEN(env->exits); i < n; ++i) {
+		if (env->exits[i].store == node)
+			return true;
+	}
+	return false;
+}
+
+static ir_node *search_def_and_create_phis(ir_node *block)
+{
+	/* already processed this block? */
+	if (irn_visited(block))
+		return (ir_node*)get_irn_link(block);
+
+	ir_graph *const irg = get_irn_irg(block);
+	assert(block != get_irg_start_block(irg));
+
+	/* a Block with only 1 predecessor needs no Phi */
+	int const n_cfgpreds = get_Block_n_cfgpreds(block);
+	if (n_cfgpreds == 1) {
+		ir_node *const pred_block = get_Block_cfgpred_block(block, 0);
+		ir_node *const value      = pred_block == NULL ? new_r_Bad(irg, mode_M)
+			: search_def_and_create_phis(pred_block);
+		set_irn_link(block, value);
+		mark_irn_visited(block);
+		return value;
+	}
+
+	/* create a new Phi */
+	ir_node **const in    = ALLOCAN(ir_node*, n_cfgpreds);
+	ir_node  *const dummy = new_r_Dummy(irg, mode_M);
+	for (int i = 0; i < n_cfgpreds; ++i)
+		in[i] = dummy;
+	ir_node *const phi = new_r_Phi_loop(block, n_cfgpreds, in);
+	set_irn_link(block, phi);
+	mark_irn_visited(block);
+
+	/* set Phi predecessors */
+	for (int i = 0; i < n_cfgpreds; ++i) {
+		ir_node *const pred_block = get_Block_cfgpred_block(block, i);
+		ir_node *const pred_val   = pred_block == NULL ? new_r_Bad(irg, mode_M)
+			: search_def_and_create_phis(pred_block);
+		set_irn_n(phi, i, pred_val);
+	}
+	return phi;
+}
+
+/**
+ * Lets the users of memory states of the loop after the loop use the memory
+ * states of the Stores at the exits instead.
+ */
+static void construct_ssa(promote_env_t *env)
+{
+	loop_info_t *const info = env->info;
+	ir_graph    *const irg  = get_irn_irg(info->header);
+	inc_irg_visited(irg);
+	for (size_t i = 0, n = ARR_LEN(env->exits); i < n; ++i) {
+		ir_node *const store = env->exits[i].store;
+		ir_node *const block = get_nodes_block(store);
+		set_irn_link(block, get_mem_proj(store));
+		mark_irn_visited(block);
+	}
+
+	for (size_t i = 0, n = ARR_LEN(info->memops); i < n; ++i) {
+		ir_node *const node = info->memops[i];
+		ir_node *const mem  = is_memop(node) ? get_mem_proj(node) : node;
+		if (mem == NULL)
+			continue;
+		foreach_out_edge_safe(mem, edge) {
+			ir_node *const user = get_edge_src_irn(edge);
+			if (is_End(user) || is_in_loop(user, info->loop)
+			    || is_exit_store(env, user))
+				continue;
+
+			int      const pos        = get_edge_src_pos(edge);
+			ir_node *const user_block = get_nodes_block(user);
+			ir_node       *newval;
+			if (is_Phi(user)) {
+				ir_node *const pred_block
+					= get_Block_cfgpred_block(user_block, pos);
+				newval = pred_block == NULL ? new_r_Bad(irg, mode_M)
+					: search_def_and_create_phis(pred_block);
+			} else {
+				newval = search_def_and_create_phis(user_block);
+			}
+			if (newval != user)
+				set_irn_n(user, pos, newval);
+		}
+	}
+}
+
+/** Keeps the location of @p env in a register inside its loop. */
+static void promote(promote_env_t *env)
+{
+	loop_info_t *const info   = env->info;
+	ir_loop     *const loop   = info->loop;
+	ir_node     *const header = info->header;
+	ir_graph    *const irg    = get_irn_irg(header);
+	DB((dbg, LEVEL_1, "promoting %+F in loop %ld (%zu accesses)\n", env->ptr,
+	    get_loop_loop_nr(loop), ARR_LEN(env->accesses)));
+
+	/* load the location in a new preheader */
+	int entry = 0;
+	while (is_block_in_loop(get_Block_cfgpred_block(header, entry), loop))
+		++entry;
+	ir_node *const entry_pred = get_Block_cfgpred(header, entry);
+	ir_node *const preheader  = new_r_Block(irg, 1, &entry_pred);
+	set_Block_cfgpred(header, entry, new_r_Jmp(preheader));
+	ir_node *const ptr  = copy_invariant(env->ptr, loop, preheader);
+	ir_node *const load = new_r_Load(preheader,
+	                                 get_Phi_pred(env->mem_phi, entry), ptr,
+	                                 env->mode, env->type, cons_none);
+	set_Phi_pred(env->mem_phi, entry, new_r_Proj(load, mode_M, pn_Load_M));
+	env->init = new_r_Proj(load, env->mode, pn_Load_res);
+
+	/* determine the values while the memory chain is unchanged */
+	size_t    const n_accesses = ARR_LEN(env->accesses);
+	size_t    const n_exits    = ARR_LEN(env->exits);
+	ir_node **const values     = ALLOCAN(ir_node*, n_accesses + n_exits);
+	for (size_t i = 0; i < n_accesses; ++i) {
+		ir_node *const access = env->accesses[i];
+		values[i] = is_Load(access)
+			? get_location_value(env, get_Load_mem(access)) : NULL;
+	}
+	for (size_t i = 0; i < n_exits; ++i)
+		values[n_accesses + i] = get_location_value(env, env->exits[i].mem);
+
+	/* store the location on a new block on every exit edge */
+	for (size_t i = 0; i < n_exits; ++i) {
+		exit_t  *const exit  = &env->exits[i];
+		ir_node *const pred  = get_Block_cfgpred(exit->block, exit->pos);
+		ir_node *const block = new_r_Block(irg, 1, &pred);
+		set_Block_cfgpred(exit->block, exit->pos, new_r_Jmp(block));
+		ir_node *const store = new_r_Store(block, skip_accesses(env, exit->mem),
+		                                   ptr, values[n_accesses + i],
+		                                   env->type, cons_none);
+		new_r_Proj(store, mode_M, pn_Store_M);
+		exit->store = store;
+	}
+	construct_ssa(env);
+
+	for (size_t i = 0; i < n_accesses; ++i) {
+		ir_node *const access = env->accesses[i];
+		ir_node *const mem    = get_memop_mem(access);
+		foreach_out_edge_safe(access, edge) {
+			ir_node *const proj = get_edge_src_irn(edge);
+			exchange(proj, get_irn_mode(proj) == mode_M ? mem : values[i]);
+		}
+		kill_node(access);
+	}
+}
+
+/** Promotes a location in the loop of @p info. */
+static bool promote_in_loop(loop_info_t *info)
+{
+	if (info->header == NULL || info->irreducible || info->n_entries != 1)
+		return false;
+
+	ir_node *mem_phi = NULL;
+	foreach_out_edge(info->header, edge) {
+		ir_node *const phi = get_edge_src_irn(edge);
+		if (!is_Phi(phi) || get_irn_mode(phi) != mode_M)
+			continue;
+		if (mem_phi != NULL)
+			return false;
+		mem_phi = phi;
+	}
+	if (mem_phi == NULL)
+		return false;
+
+	promote_env_t env = {
+		.info     = info,
+		.mem_phi  = mem_phi,
+		.accesses = NEW_ARR_F(ir_node*, 0),
+		.exits    = NEW_ARR_F(exit_t, 0),
+	};
+	bool changed = false;
+	for (size_t i = 0, n = ARR_LEN(info->memops); i < n; ++i) {
+		ir_node *const store = info->memops[i];
+		if (!is_Store(store))
+			continue;
+		/* each location once */
+		bool seen = false;
+		for (size_t j = 0; j < i && !seen; ++j) {
+			ir_node *const other = info->memops[j];
+			seen = is_Store(other)
+			    && get_Store_ptr(other) == get_Store_ptr(store);
+		}
+		if (seen || !analyze_location(&env, store))
+			continue;
+
+		ir_graph *const irg = get_irn_irg(store);
+		env.values = pmap_create();
+		ir_reserve_resources(irg, IR_RESOURCE_IRN_VISITED
+		                        | IR_RESOURCE_IRN_LINK);
+		promote(&env);
+		ir_free_resources(irg, IR_RESOURCE_IRN_VISITED | IR_RESOURCE_IRN_LINK);
+		pmap_destroy(env.values);
+		changed = true;
+		break;
+	}
+	DEL_ARR_F(env.exits);
+	DEL_ARR_F(env.accesses);
+	return changed;
+}
+
+void opt_scalar_promotion(ir_graph *irg)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.opt.scalar_promotion");
+	DB((dbg, LEVEL_1, "scalar promotion on %+F\n", irg));
+
+	bool changed = false;
+	for (unsigned n = 0; n < MAX_PROMOTIONS; ++n) {
+		assure_irg_properties(irg, IR_GRAPH_PROPERTY_NO_BADS
+		                         | IR_GRAPH_PROPERTY_NO_TUPLES
+		                         | IR_GRAPH_PROPERTY_NO_UNREACHABLE_CODE
+		                         | IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES
+		                         | IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE
+		                         | IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO
+		                         | IR_GRAPH_PROPERTY_CONSISTENT_ENTITY_USAGE);
+
+		pmap *const loops = pmap_create();
+		irg_walk_graph(irg, analyze_node, NULL, loops);
+		loop_info_t **infos = NEW_ARR_F(loop_info_t*, 0);
+		foreach_pmap(loops, entry) {
+			ARR_APP1(loop_info_t*, infos, (loop_info_t*)entry->value);
+		}
+		size_t const n_infos = ARR_LEN(infos);
+		QSORT_ARR(infos, cmp_loop_infos);
+
+		bool promoted = false;
+		for (size_t i = 0; i < n_infos && !promoted; ++i)
+			promoted = promote_in_loop(infos[i]);
+		for (size_t i = 0; i < n_infos; ++i) {
+			DEL_ARR_F(infos[i]->memops);
+			DEL_ARR_F(infos[i]->cfops);
+			free(infos[i]);
+		}
+		DEL_ARR_F(infos);
+		pmap_destroy(loops);
+
+		if (!promoted)
+			break;
+		changed = true;
+		confirm_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES);
+	}
+	confirm_irg_properties(irg, changed ? IR_GRAPH_PROPERTIES_NONE
+	                                    : IR_GRAPH_PROPERTIES_ALL);
+}
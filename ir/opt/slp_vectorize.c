@@ -0,0 +1,816 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2017 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Superword level parallelism (SLP) vectorization of basic blocks.
+ *
+ * Isomorphic scalar operations on adjacent memory are combined into single
+ * operations on a wider integer mode ("SIMD within a register").  Packs are
+ * seeded by Stores to adjacent addresses and grown along the use-def chains
+ * of the stored values.  Only lane-independent operations (And, Or, Eor, Not
+ * and truncating Convs) can be packed this way, other lanes are gathered with
+ * shifts.  A pack is only built if the cost model predicts fewer operations.
+ * Vector registers are not used, so arithmetic and floating point lanes are
+ * never packed.
+ */
+#include "array.h"
+#include "debug.h"
+#include "ircons_t.h"
+#include "iredges_t.h"
+#include "irgmod.h"
+#include "irgraph_t.h"
+#include "irgwalk.h"
+#include "irmemory.h"
+#include "irmode_t.h"
+#include "irnode_t.h"
+#include "iroptimize.h"
+#include "irtools.h"
+#include "obst.h"
+#include "slp_vectorize.h"
+#include "target_t.h"
+#include "tv_t.h"
+#include "type_t.h"
+#include "util.h"
+
+DEBUG_ONLY(static firm_dbg_module_t *dbg;)
+
+/** Upper bound for the number of memory operations in one run, limits the
+ * quadratic legality check. */
+#define MAX_RUN_LENGTH 256
+
+typedef enum pack_kind_t {
+	PACK_STORE,  /**< Stores to adjacent addresses */
+	PACK_LOAD,   /**< Loads from adjacent addresses */
+	PACK_BINOP,  /**< lane-wise And, Or or Eor */
+	PACK_NOT,    /**< lane-wise Not */
+	PACK_CONST,  /**< constant lanes */
+	PACK_GATHER, /**< arbitrary scalar lanes, combined with shifts */
+} pack_kind_t;
+
+/** A pack of isomorphic scalar nodes, one per lane. */
+typedef struct pack_t pack_t;
+struct pack_t {
+	pack_kind_t kind;
+	unsigned    n_lanes;
+	ir_mode    *lane_mode;  /**< unsigned mode of one lane */
+	ir_mode    *wide_mode;  /**< unsigned mode of all lanes */
+	ir_node   **lanes;      /**< the scalar nodes, lane 0 has lowest address */
+	pack_t     *ops[2];     /**< operand packs */
+	unsigned    insert_pos; /**< position of the wide memory operation */
+	ir_node    *wide;       /**< the constructed wide node */
+};
+
+/** Information about a Load or Store inside a memory run. */
+typedef struct memop_info_t {
+	unsigned pos;  /**< position in the memory run */
+	pack_t  *pack; /**< the pack this operation is merged into */
+	ir_node *base; /**< base address */
+	long     offset; /**< constant offset from base address */
+} memop_info_t;
+
+typedef struct slp_env_t {
+	struct obstack     obst;
+	ir_node          **run_starts;    /**< first operations of all memory runs */
+	ir_node          **run;           /**< the memory run currently optimized */
+	pack_t           **packs;         /**< packs of memory operations in the run */
+	unsigned           n_lanes;
+	unsigned           lane_size;     /**< size of one lane in bytes */
+	ir_mode           *lane_mode;     /**< unsigned mode of one lane */
+	ir_mode           *wide_mode;     /**< unsigned mode of all lanes */
+	slp_no_alias_func *no_alias;      /**< additional independence oracle */
+	void              *no_alias_data; /**< data passed to no_alias */
+	bool               changed;
+} slp_env_t;
+
+static void get_base_and_offset(ir_node *ptr, ir_node **base, long *offset)
+{
+	long     res  = 0;
+	ir_mode *mode = get_irn_mode(ptr);
+	for (;;) {
+		if (is_Add(ptr)) {
+			ir_node *l = get_Add_left(ptr);
+			ir_node *r = get_Add_right(ptr);
+			if (get_irn_mode(l) != mode || !is_Const(r))
+				break;
+			res += get_Const_long(r);
+			ptr  = l;
+		} else if (is_Sub(ptr)) {
+			ir_node *r = get_Sub_right(ptr);
+			if (!is_Const(r))
+				break;
+			res -= get_Const_long(r);
+			ptr  = get_Sub_left(ptr);
+		} else if (is_Member(ptr)) {
+			ir_entity *entity = get_Member_entity(ptr);
+			ir_type   *owner  = get_entity_owner(entity);
+			if (get_type_state(owner) != layout_fixed
+			 || get_entity_bitfield_size(entity) != 0)
+				break;
+			res += get_entity_offset(entity);
+			ptr  = get_Member_ptr(ptr);
+		} else {
+			break;
+		}
+	}
+	*base   = ptr;
+	*offset = res;
+}
+
+static bool is_memop_candidate(ir_node const *const node)
+{
+	if (is_Load(node)) {
+		return get_Load_volatility(node) == volatility_non_volatile
+		    && !ir_throws_exception(node);
+	} else if (is_Store(node)) {
+		return get_Store_volatility(node) == volatility_non_volatile
+		    && !ir_throws_exception(node);
+	}
+	return false;
+}
+
+static ir_node *get_memop_ptr(ir_node const *const node)
+{
+	return is_Load(node) ? get_Load_ptr(node) : get_Store_ptr(node);
+}
+
+static ir_type *get_memop_type(ir_node const *const node)
+{
+	return is_Load(node) ? get_Load_type(node) : get_Store_type(node);
+}
+
+static unsigned get_memop_size(ir_node const *const node)
+{
+	ir_mode *const mode = is_Load(node) ? get_Load_mode(node)
+	                                    : get_irn_mode(get_Store_value(node));
+	return get_mode_size_bytes(mode);
+}
+
+static ir_node *get_memop_M(ir_node const *const node)
+{
+	return get_Proj_for_pn(node, is_Load(node) ? pn_Load_M : pn_Store_M);
+}
+
+/**
+ * Returns the memory operation following @p node in the same memory run or
+ * NULL if the run ends at @p node.
+ */
+static ir_node *get_run_successor(ir_node const *const node)
+{
+	ir_node *const mem = get_memop_M(node);
+	if (mem == NULL || get_irn_n_edges(mem) != 1)
+		return NULL;
+	ir_node *const succ = get_edge_src_irn(get_irn_out_edge_first(mem));
+	if (!is_memop_candidate(succ)
+	 || get_nodes_block(succ) != get_nodes_block(node)
+	 || get_memop_mem(succ) != mem)
+		return NULL;
+	return succ;
+}
+
+/** Walker: collect the first operation of all memory runs. */
+static void collect_run_starts(ir_node *node, void *data)
+{
+	slp_env_t *const env = (slp_env_t*)data;
+	if (!is_memop_candidate(node))
+		return;
+
+	ir_node *const mem = get_memop_mem(node);
+	if (is_Proj(mem)) {
+		ir_node *const pred = get_Proj_pred(mem);
+		if (is_memop_candidate(pred) && get_run_successor(pred) == node)
+			return;
+	}
+	ARR_APP1(ir_node*, env->run_starts, node);
+}
+
+static memop_info_t *get_memop_info(ir_node const *const node)
+{
+	return (memop_info_t*)get_irn_link(node);
+}
+
+static unsigned get_new_pos(memop_info_t const *const info)
+{
+	return info->pack != NULL ? info->pack->insert_pos : info->pos;
+}
+
+static bool has_single_user(ir_node const *const node)
+{
+	return get_irn_n_edges(node) == 1;
+}
+
+static bool is_lane_compatible(slp_env_t const *const env,
+                               ir_node const *const node)
+{
+	ir_mode *const mode = get_irn_mode(node);
+	return mode_is_int(mode)
+	    && get_mode_arithmetic(mode) == irma_twos_complement
+	    && get_mode_size_bytes(mode) >= env->lane_size;
+}
+
+/**
+ * Skips Convs which do not change the low lane bits of a value.
+ */
+static ir_node *skip_lane_Conv(slp_env_t const *const env, ir_node *node,
+                               int *saved)
+{
+	while (is_Conv(node) && has_single_user(node)) {
+		ir_node *const op = get_Conv_op(node);
+		if (!is_lane_compatible(env, op))
+			break;
+		++*saved;
+		node = op;
+	}
+	return node;
+}
+
+static pack_t *new_pack(slp_env_t *const env, pack_kind_t const kind,
+                        ir_node **const lanes)
+{
+	pack_t *const pack = OALLOCZ(&env->obst, pack_t);
+	pack->kind      = kind;
+	pack->n_lanes   = env->n_lanes;
+	pack->lane_mode = env->lane_mode;
+	pack->wide_mode = env->wide_mode;
+	pack->lanes     = lanes;
+	return pack;
+}
+
+/** Returns true if the wide memory access is known to be aligned. */
+static bool is_aligned(slp_env_t const *const env, ir_node const *const memop)
+{
+	if (ir_target.fast_unaligned_memaccess)
+		return true;
+
+	memop_info_t const *const info = get_memop_info(memop);
+	ir_node            *const base = info->base;
+	ir_entity                *entity;
+	if (is_Address(base))
+		entity = get_Address_entity(base);
+	else if (is_Member(base))
+		entity = get_Member_entity(base);
+	else
+		return false;
+	unsigned alignment = get_entity_alignment(entity);
+	if (alignment == 0)
+		alignment = get_type_alignment(get_entity_type(entity));
+	unsigned const size = env->n_lanes * env->lane_size;
+	return alignment >= size && alignment % size == 0
+	    && info->offset % (long)size == 0;
+}
+
+static bool can_pack_loads(slp_env_t const *const env, ir_node **const lanes)
+{
+	ir_node *base0   = NULL;
+	long     offset0 = 0;
+	for (unsigned i = 0; i < env->n_lanes; ++i) {
+		ir_node *const lane = lanes[i];
+		if (!is_Proj(lane) || get_Proj_num(lane) != pn_Load_res
+		 || !has_single_user(lane))
+			return false;
+		ir_node *const load = get_Proj_pred(lane);
+		if (!is_Load(load))
+			return false;
+		memop_info_t const *const info = get_memop_info(load);
+		if (info == NULL || info->pack != NULL
+		 || get_mode_size_bytes(get_Load_mode(load)) != env->lane_size)
+			return false;
+		if (i == 0) {
+			if (!is_aligned(env, load))
+				return false;
+			base0   = info->base;
+			offset0 = info->offset;
+		} else if (info->base != base0
+		        || info->offset != offset0 + (long)(i * env->lane_size)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * Builds the pack tree for the given lanes and computes the number of scalar
+ * operations saved minus the number of operations needed after packing.
+ */
+static pack_t *build_pack(slp_env_t *const env, ir_node **const lanes,
+                          int *const benefit)
+{
+	unsigned const n_lanes = env->n_lanes;
+	int            saved   = 0;
+	for (unsigned i = 0; i < n_lanes; ++i) {
+		if (!is_lane_compatible(env, lanes[i]))
+			goto gather;
+		lanes[i] = skip_lane_Conv(env, lanes[i], &saved);
+	}
+
+	ir_node *const lane0 = lanes[0];
+	bool           same  = true;
+	for (unsigned i = 1; i < n_lanes; ++i) {
+		if (get_irn_op(lanes[i]) != get_irn_op(lane0))
+			same = false;
+	}
+
+	if (same && is_Const(lane0)) {
+		*benefit += saved - 1;
+		return new_pack(env, PACK_CONST, lanes);
+	}
+
+	bool single_users = true;
+	for (unsigned i = 0; i < n_lanes; ++i) {
+		if (!has_single_user(lanes[i]))
+			single_users = false;
+	}
+
+	if (can_pack_loads(env, lanes)) {
+		/* the wide Load replaces the Load of lane 0 as the address of the
+		 * other lanes may not be available at their positions */
+		pack_t *const pack = new_pack(env, PACK_LOAD, lanes);
+		for (unsigned i = 0; i < n_lanes; ++i)
+			get_memop_info(get_Proj_pred(lanes[i]))->pack = pack;
+		pack->insert_pos = get_memop_info(get_Proj_pred(lane0))->pos;
+		ARR_APP1(pack_t*, env->packs, pack);
+		*benefit += saved + (int)n_lanes - 1;
+		return pack;
+	}
+
+	if (same && single_users && (is_And(lane0) || is_Or(lane0) || is_Eor(lane0))) {
+		ir_node **const left  = OALLOCN(&env->obst, ir_node*, n_lanes);
+		ir_node **const right = OALLOCN(&env->obst, ir_node*, n_lanes);
+		for (unsigned i = 0; i < n_lanes; ++i) {
+			left[i]  = get_binop_left(lanes[i]);
+			right[i] = get_binop_right(lanes[i]);
+		}
+		pack_t *const pack = new_pack(env, PACK_BINOP, lanes);
+		*benefit += saved + (int)n_lanes - 1;
+		pack->ops[0] = build_pack(env, left, benefit);
+		pack->ops[1] = build_pack(env, right, benefit);
+		return pack;
+	}
+
+	if (same && single_users && is_Not(lane0)) {
+		ir_node **const ops = OALLOCN(&env->obst, ir_node*, n_lanes);
+		for (unsigned i = 0; i < n_lanes; ++i)
+			ops[i] = get_Not_op(lanes[i]);
+		pack_t *const pack = new_pack(env, PACK_NOT, lanes);
+		*benefit += saved + (int)n_lanes - 1;
+		pack->ops[0] = build_pack(env, ops, benefit);
+		return pack;
+	}
+
+gather:
+	/* each lane needs a zero extension, a shift and an Or */
+	*benefit -= 3 * (int)n_lanes - 2;
+	return new_pack(env, PACK_GATHER, lanes);
+}
+
+/** Forgets the packing decision for all memory operations in @p pack. */
+static void unpack(pack_t *const pack)
+{
+	if (pack->kind == PACK_LOAD) {
+		for (unsigned i = 0; i < pack->n_lanes; ++i) {
+			ir_node *const load = get_Proj_pred(pack->lanes[i]);
+			get_memop_info(load)->pack = NULL;
+		}
+	}
+	for (unsigned i = 0; i < ARRAY_SIZE(pack->ops); ++i) {
+		if (pack->ops[i] != NULL)
+			unpack(pack->ops[i]);
+	}
+}
+
+/**
+ * Checks that reordering the memory operations of the run according to the
+ * current packs does not swap dependent operations.
+ */
+static bool is_reordering_legal(slp_env_t const *const env)
+{
+	ir_node **const run   = env->run;
+	size_t    const n_ops = ARR_LEN(run);
+	for (size_t i = 0; i < n_ops; ++i) {
+		ir_node            *const a      = run[i];
+		memop_info_t const *const info_a = get_memop_info(a);
+		unsigned            const pos_a  = get_new_pos(info_a);
+		for (size_t j = i + 1; j < n_ops; ++j) {
+			ir_node            *const b      = run[j];
+			memop_info_t const *const info_b = get_memop_info(b);
+			if (get_new_pos(info_b) >= pos_a
+			 || (info_b->pack != NULL && info_b->pack == info_a->pack)
+			 || (is_Load(a) && is_Load(b)))
+				continue;
+			ir_node          *const ptr_a = get_memop_ptr(a);
+			ir_node          *const ptr_b = get_memop_ptr(b);
+			ir_alias_relation const rel   = get_alias_relation(
+				ptr_a, get_memop_type(a), get_memop_size(a),
+				ptr_b, get_memop_type(b), get_memop_size(b));
+			if (rel != ir_no_alias
+			 && (env->no_alias == NULL
+			  || !env->no_alias(ptr_a, ptr_b, env->no_alias_data))) {
+				DB((dbg, LEVEL_3, "cannot move %+F across %+F\n", a, b));
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+static bool try_pack_stores(slp_env_t *const env, ir_node **const stores)
+{
+	unsigned const n_lanes = env->n_lanes;
+	if (!is_aligned(env, stores[0]))
+		return false;
+
+	ir_node **const values = OALLOCN(&env->obst, ir_node*, n_lanes);
+	ir_node **const lanes  = OALLOCN(&env->obst, ir_node*, n_lanes);
+	unsigned        pos    = 0;
+	for (unsigned i = 0; i < n_lanes; ++i) {
+		lanes[i]  = stores[i];
+		values[i] = get_Store_value(stores[i]);
+		pos       = MAX(pos, get_memop_info(stores[i])->pos);
+	}
+
+	size_t const n_packs = ARR_LEN(env->packs);
+	pack_t *const pack   = new_pack(env, PACK_STORE, lanes);
+	pack->insert_pos     = pos;
+	int benefit = (int)n_lanes - 1;
+	pack->ops[0] = build_pack(env, values, &benefit);
+	for (unsigned i = 0; i < n_lanes; ++i)
+		get_memop_info(stores[i])->pack = pack;
+
+	if (benefit > 0 && is_reordering_legal(env)) {
+		DB((dbg, LEVEL_2, "packing %u stores starting at %+F (benefit %d)\n",
+		    n_lanes, stores[0], benefit));
+		ARR_APP1(pack_t*, env->packs, pack);
+		return true;
+	}
+
+	DB((dbg, LEVEL_3, "not packing %u stores starting at %+F (benefit %d)\n",
+	    n_lanes, stores[0], benefit));
+	for (unsigned i = 0; i < n_lanes; ++i)
+		get_memop_info(stores[i])->pack = NULL;
+	unpack(pack->ops[0]);
+	ARR_SHRINKLEN(env->packs, n_packs);
+	return false;
+}
+
+static int cmp_base_offset(void const *const p0, void const *const p1)
+{
+	memop_info_t const *const info0 = get_memop_info(*(ir_node*const*)p0);
+	memop_info_t const *const info1 = get_memop_info(*(ir_node*const*)p1);
+	if (info0->base != info1->base) {
+		long const nr0 = get_irn_node_nr(info0->base);
+		long const nr1 = get_irn_node_nr(info1->base);
+		return QSORT_CMP(nr0, nr1);
+	}
+	if (info0->offset != info1->offset)
+		return QSORT_CMP(info0->offset, info1->offset);
+	return QSORT_CMP(info0->pos, info1->pos);
+}
+
+/** Sets up the lane modes for Stores of mode @p mode. */
+static bool init_lanes(slp_env_t *const env, ir_mode *const mode,
+                       unsigned const n_lanes)
+{
+	if (!mode_is_int(mode) || get_mode_arithmetic(mode) != irma_twos_complement)
+		return false;
+	ir_mode *const lane_mode = find_unsigned_mode(mode);
+	if (lane_mode == NULL)
+		return false;
+	ir_mode *wide_mode = lane_mode;
+	for (unsigned n = 1; n < n_lanes; n *= 2) {
+		wide_mode = find_double_bits_int_mode(wide_mode);
+		if (wide_mode == NULL)
+			return false;
+	}
+	env->n_lanes   = n_lanes;
+	env->lane_size = get_mode_size_bytes(mode);
+	env->lane_mode = lane_mode;
+	env->wide_mode = wide_mode;
+	return true;
+}
+
+/** Creates the type of a wide memory access. */
+static ir_type *get_pack_type(pack_t const *const pack, ir_node **const memops)
+{
+	ir_type *const type0 = get_memop_type(memops[0]);
+	for (unsigned i = 1; i < pack->n_lanes; ++i) {
+		if (get_memop_type(memops[i]) != type0)
+			return get_type_for_mode(pack->wide_mode);
+	}
+	return new_type_array(type0, pack->n_lanes);
+}
+
+/** Returns the bit offset of lane @p i in the wide value. */
+static unsigned get_lane_shift(pack_t const *const pack, unsigned const i)
+{
+	unsigned const n_lanes = pack->n_lanes;
+	unsigned const lane    = ir_target_big_endian() ? n_lanes - 1 - i : i;
+	return lane * get_mode_size_bits(pack->lane_mode);
+}
+
+static ir_cons_flags get_cons_flags(void)
+{
+	/* without fast unaligned accesses we only pack aligned accesses */
+	return ir_target.fast_unaligned_memaccess ? cons_unaligned : cons_none;
+}
+
+static ir_node *build_wide(slp_env_t *const env, pack_t *const pack,
+                           ir_node *const block, ir_node *const mem)
+{
+	if (pack->wide != NULL)
+		return pack->wide;
+
+	ir_graph *const irg   = get_irn_irg(block);
+	ir_node **const lanes = pack->lanes;
+	ir_node  *const lane0 = lanes[0];
+	dbg_info *const dbgi  = get_irn_dbg_info(lane0);
+	ir_mode  *const mode  = pack->wide_mode;
+	ir_node        *res;
+	switch (pack->kind) {
+	case PACK_STORE: {
+		ir_node *const value = build_wide(env, pack->ops[0], block, mem);
+		ir_node *const ptr   = get_Store_ptr(lane0);
+		ir_type *const type  = get_pack_type(pack, lanes);
+		res = new_rd_Store(dbgi, block, mem, ptr, value, type, get_cons_flags());
+		break;
+	}
+	case PACK_LOAD: {
+		ir_node **const loads = OALLOCN(&env->obst, ir_node*, pack->n_lanes);
+		for (unsigned i = 0; i < pack->n_lanes; ++i)
+			loads[i] = get_Proj_pred(lanes[i]);
+		ir_node *const load0 = loads[0];
+		ir_node *const ptr   = get_Load_ptr(load0);
+		ir_type *const type  = get_pack_type(pack, loads);
+		ir_node *const load  = new_rd_Load(get_irn_dbg_info(load0), block, mem,
+		                                   ptr, mode, type, get_cons_flags());
+		pack->wide = load;
+		return new_r_Proj(load, mode, pn_Load_res);
+	}
+	case PACK_BINOP: {
+		ir_node *const left  = build_wide(env, pack->ops[0], block, mem);
+		ir_node *const right = build_wide(env, pack->ops[1], block, mem);
+		res = is_And(lane0) ? new_rd_And(dbgi, block, left, right)
+		    : is_Or(lane0)  ? new_rd_Or(dbgi, block, left, right)
+		    :                 new_rd_Eor(dbgi, block, left, right);
+		break;
+	}
+	case PACK_NOT:
+		res = new_rd_Not(dbgi, block, build_wide(env, pack->ops[0], block, mem));
+		break;
+	case PACK_CONST: {
+		ir_tarval *tv = get_mode_null(mode);
+		for (unsigned i = 0; i < pack->n_lanes; ++i) {
+			ir_tarval *const lane_tv = get_Const_tarval(lanes[i]);
+			ir_tarval *const low     = tarval_convert_to(lane_tv, pack->lane_mode);
+			ir_tarval *const wide    = tarval_convert_to(low, mode);
+			tv = tarval_or(tv, tarval_shl_unsigned(wide, get_lane_shift(pack, i)));
+		}
+		res = new_r_Const(irg, tv);
+		break;
+	}
+	case PACK_GATHER:
+		res = NULL;
+		for (unsigned i = 0; i < pack->n_lanes; ++i) {
+			ir_node *const lane = lanes[i];
+			ir_node *const low  = new_r_Conv(block, lane, pack->lane_mode);
+			ir_node       *val  = new_r_Conv(block, low, mode);
+			unsigned const shift = get_lane_shift(pack, i);
+			if (shift != 0) {
+				ir_node *const cnst = new_r_Const_long(irg, mode_Iu, shift);
+				val = new_r_Shl(block, val, cnst);
+			}
+			res = res == NULL ? val : new_r_Or(block, res, val);
+		}
+		break;
+	default:
+		panic("invalid pack");
+	}
+	pack->wide = res;
+	return res;
+}
+
+static int cmp_new_pos(void const *const p0, void const *const p1)
+{
+	unsigned const pos0 = get_memop_info(*(ir_node*const*)p0)->pos;
+	unsigned const pos1 = get_memop_info(*(ir_node*const*)p1)->pos;
+	return QSORT_CMP(pos0, pos1);
+}
+
+/**
+ * Builds the wide operations for all packs and relinks the memory chain of
+ * the run in the new order.
+ */
+static void apply_packs(slp_env_t *const env)
+{
+	ir_node **const run       = env->run;
+	ir_node  *const first     = run[0];
+	ir_node  *const last      = run[ARR_LEN(run) - 1];
+	ir_node  *const block     = get_nodes_block(first);
+	ir_node  *const start_mem = get_memop_mem(first);
+	ir_node  *const end_mem   = get_memop_M(last);
+
+	/* collect the remaining and the new operations */
+	ir_node **order = NEW_ARR_F(ir_node*, 0);
+	for (size_t i = 0, n = ARR_LEN(run); i < n; ++i) {
+		ir_node *const node = run[i];
+		if (get_memop_info(node)->pack == NULL)
+			ARR_APP1(ir_node*, order, node);
+	}
+	for (size_t i = 0, n = ARR_LEN(env->packs); i < n; ++i) {
+		pack_t *const pack = env->packs[i];
+		if (pack->kind == PACK_STORE)
+			build_wide(env, pack, block, start_mem);
+	}
+	for (size_t i = 0, n = ARR_LEN(env->packs); i < n; ++i) {
+		pack_t       *const pack = env->packs[i];
+		memop_info_t *const info = OALLOCZ(&env->obst, memop_info_t);
+		info->pos = pack->insert_pos;
+		set_irn_link(pack->wide, info);
+		ARR_APP1(ir_node*, order, pack->wide);
+	}
+	QSORT_ARR(order, cmp_new_pos);
+
+	/* relink the memory chain */
+	ir_node *mem = start_mem;
+	for (size_t i = 0, n = ARR_LEN(order); i < n; ++i) {
+		ir_node *const node = order[i];
+		set_memop_mem(node, mem);
+		mem = get_memop_M(node);
+		if (mem == NULL) {
+			unsigned const pn = is_Load(node) ? pn_Load_M : pn_Store_M;
+			mem = new_r_Proj(node, mode_M, pn);
+		}
+	}
+	if (end_mem != NULL && end_mem != mem)
+		exchange(end_mem, mem);
+
+	for (size_t i = 0, n = ARR_LEN(order); i < n; ++i)
+		set_irn_link(order[i], NULL);
+	DEL_ARR_F(order);
+}
+
+/** Tries to find groups of Stores to adjacent addresses in the current run. */
+static void optimize_run(slp_env_t *const env)
+{
+	ir_node **const run   = env->run;
+	size_t    const n_ops = ARR_LEN(run);
+	ir_node **stores      = NEW_ARR_F(ir_node*, 0);
+	for (size_t i = 0; i < n_ops; ++i) {
+		ir_node      *const node = run[i];
+		memop_info_t *const info = OALLOCZ(&env->obst, memop_info_t);
+		info->pos = (unsigned)i;
+		get_base_and_offset(get_memop_ptr(node), &info->base, &info->offset);
+		set_irn_link(node, info);
+		if (is_Store(node))
+			ARR_APP1(ir_node*, stores, node);
+	}
+	QSORT_ARR(stores, cmp_base_offset);
+
+	unsigned const pointer_size = ir_target_pointer_size();
+	size_t   const n_stores     = ARR_LEN(stores);
+	for (size_t i = 0; i < n_stores; ) {
+		ir_node            *const store0 = stores[i];
+		memop_info_t const *const info0  = get_memop_info(store0);
+		ir_mode            *const mode   = get_irn_mode(get_Store_value(store0));
+		unsigned            const size   = get_mode_size_bytes(mode);
+		if (size == 0 || size >= pointer_size || !is_po2_or_zero(size)) {
+			++i;
+			continue;
+		}
+
+		/* count Stores to adjacent addresses, the lanes are combined as
+		 * integers, so a float lane would be converted instead of being
+		 * reinterpreted */
+		size_t n_adjacent = 1;
+		while (i + n_adjacent < n_stores && n_adjacent * size < pointer_size) {
+			ir_node            *const store = stores[i + n_adjacent];
+			memop_info_t const *const info  = get_memop_info(store);
+			if (info->base != info0->base
+			 || info->offset != info0->offset + (long)(n_adjacent * size)
+			 || get_irn_mode(get_Store_value(store)) != mode)
+				break;
+			++n_adjacent;
+		}
+
+		unsigned n_lanes = 1;
+		while (n_lanes * 2 <= n_adjacent)
+			n_lanes *= 2;
+		bool packed = false;
+		for (; n_lanes >= 2; n_lanes /= 2) {
+			if (init_lanes(env, mode, n_lanes)
+			 && try_pack_stores(env, &stores[i])) {
+				packed = true;
+				break;
+			}
+		}
+		i += packed ? n_lanes : 1;
+	}
+	DEL_ARR_F(stores);
+
+	if (ARR_LEN(env->packs) > 0) {
+		apply_packs(env);
+		env->changed = true;
+		ARR_SHRINKLEN(env->packs, 0);
+	}
+}
+
+/**
+ * Collects the memory run starting at @p start.
+ *
+ * @return the operation following the run if it was cut at MAX_RUN_LENGTH,
+ *         NULL otherwise
+ */
+static ir_node *collect_run(slp_env_t *const env, ir_node *const start)
+{
+	ARR_SHRINKLEN(env->run, 0);
+	for (ir_node *node = start; node != NULL; node = get_run_successor(node)) {
+		if (ARR_LEN(env->run) >= MAX_RUN_LENGTH)
+			return node;
+		ARR_APP1(ir_node*, env->run, node);
+	}
+	return NULL;
+}
+
+static void init_env(slp_env_t *const env)
+{
+	memset(env, 0, sizeof(*env));
+	obstack_init(&env->obst);
+	env->run_starts = NEW_ARR_F(ir_node*, 0);
+	env->run        = NEW_ARR_F(ir_node*, 0);
+	env->packs      = NEW_ARR_F(pack_t*, 0);
+}
+
+static void free_env(slp_env_t *const env)
+{
+	DEL_ARR_F(env->packs);
+	DEL_ARR_F(env->run);
+	DEL_ARR_F(env->run_starts);
+	obstack_free(&env->obst, NULL);
+}
+
+/** Optimizes all collected memory runs, irn links must be cleared. */
+static void optimize_runs(slp_env_t *const env)
+{
+	for (size_t i = 0, n = ARR_LEN(env->run_starts); i < n; ++i) {
+		/* Overlong chains are split into several runs.  The successor is
+		 * determined before optimizing, as packing rewires the memory
+		 * edges of the run. */
+		for (ir_node *start = env->run_starts[i]; start != NULL;) {
+			ir_node *const next = collect_run(env, start);
+			if (ARR_LEN(env->run) >= 2) {
+				optimize_run(env);
+				for (size_t j = 0, n_ops = ARR_LEN(env->run); j < n_ops; ++j)
+					set_irn_link(env->run[j], NULL);
+			}
+			start = next;
+		}
+	}
+}
+
+bool slp_vectorize_block(ir_node *const block,
+                         slp_no_alias_func *const no_alias, void *const data)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.opt.slp");
+
+	ir_graph *const irg = get_irn_irg(block);
+	slp_env_t env;
+	init_env(&env);
+	env.no_alias      = no_alias;
+	env.no_alias_data = data;
+
+	ir_reserve_resources(irg, IR_RESOURCE_IRN_LINK);
+	foreach_out_edge(block, edge) {
+		ir_node *const node = get_edge_src_irn(edge);
+		set_irn_link(node, NULL);
+	}
+	foreach_out_edge(block, edge) {
+		collect_run_starts(get_edge_src_irn(edge), &env);
+	}
+	optimize_runs(&env);
+	ir_free_resources(irg, IR_RESOURCE_IRN_LINK);
+
+	free_env(&env);
+	return env.changed;
+}
+
+void opt_slp_vectorize(ir_graph *irg)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.opt.slp");
+
+	assure_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES
+	                         | IR_GRAPH_PROPERTY_NO_TUPLES);
+
+	slp_env_t env;
+	init_env(&env);
+
+	ir_reserve_resources(irg, IR_RESOURCE_IRN_LINK);
+	irg_walk_graph(irg, firm_clear_link, collect_run_starts, &env);
+	optimize_runs(&env);
+	ir_free_resources(irg, IR_RESOURCE_IRN_LINK);
+
+	free_env(&env);
+
+	confirm_irg_properties(irg, env.changed ? IR_GRAPH_PROPERTIES_CONTROL_FLOW
+	                                        : IR_GRAPH_PROPERTIES_ALL);
+}
@@ -0,0 +1,36 @@
+/*
+ * This file is part of libFirm.
+ * Copyright (C) 2017 University of Karlsruhe.
+ */
+
+/**
+ * @file
+ * @brief   Superword level parallelism vectorization of a single block.
+ */
+#ifndef FIRM_OPT_SLP_VECTORIZE_H
+#define FIRM_OPT_SLP_VECTORIZE_H
+
+#include "firm_types.h"
+#include <stdbool.h>
+
+/**
+ * Callback returning true if the memory accessed through @p ptr0 and @p ptr1
+ * is known not to overlap although alias analysis cannot prove it, for
+ * example because a runtime check guards the block.
+ */
+typedef bool slp_no_alias_func(ir_node const *ptr0, ir_node const *ptr1,
+                               void *data);
+
+/**
+ * Performs SLP vectorization of the memory operations in @p block.
+ * The graph must have consistent out edges.
+ *
+ * @param block     the block
+ * @param no_alias  additional independence oracle, may be NULL
+ * @param data      passed to @p no_alias
+ * @return true if the block was changed
+ */
+bool slp_vectorize_block(ir_node *block, slp_no_alias_func *no_alias,
+                         void *data);
+
+#endif
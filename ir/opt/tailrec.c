@@ -5,7 +5,7 @@
 
 /**
  * @file
- * @brief   Tail-recursion call optimization.
+ * @brief   Tail-recursion call optimization and detection of tail calls.
  * @date    08.06.2004
  * @author  Michael Beck
  */
@@ -610,3 +610,95 @@ void opt_tail_rec_irg(ir_graph *irg)
 	free(env.parameter_projs);
 	ir_free_resources(irg, IR_RESOURCE_IRN_LINK);
 }
+
+static void check_alloc(ir_node *node, void *data)
+{
+	bool *const has_alloc = (bool*)data;
+	if (is_Alloc(node))
+		*has_alloc = true;
+}
+
+/**
+ * Checks whether a method type has compound parameters or results.
+ */
+static bool has_compound_values(ir_type const *const mtp)
+{
+	for (size_t i = 0, n = get_method_n_params(mtp); i < n; ++i) {
+		if (is_aggregate_type(get_method_param_type(mtp, i)))
+			return true;
+	}
+	for (size_t i = 0, n = get_method_n_ress(mtp); i < n; ++i) {
+		if (is_aggregate_type(get_method_res_type(mtp, i)))
+			return true;
+	}
+	return false;
+}
+
+/**
+ * Checks whether @p ret returns exactly the results of @p call.
+ */
+static bool returns_call_results(ir_node *const ret, ir_node *const call,
+                                 ir_type const *const mtp)
+{
+	ir_type const *const call_type = get_Call_type(call);
+	size_t         const n_ress    = get_Return_n_ress(ret);
+	if (n_ress != get_method_n_ress(call_type))
+		return false;
+	for (size_t i = 0; i < n_ress; ++i) {
+		ir_node *const res = get_Return_res(ret, i);
+		if (!is_Proj(res) || get_Proj_num(res) != i)
+			return false;
+		ir_node *const pred = get_Proj_pred(res);
+		if (!is_Proj(pred) || get_Proj_pred(pred) != call
+		 || get_Proj_num(pred) != pn_Call_T_result)
+			return false;
+		/* the results must be passed the same way */
+		if (get_type_mode(get_method_res_type(mtp, i))
+		    != get_type_mode(get_method_res_type(call_type, i)))
+			return false;
+	}
+	return true;
+}
+
+void mark_tail_calls(ir_graph *irg)
+{
+	FIRM_DBG_REGISTER(dbg, "firm.opt.tailrec");
+	assure_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUTS);
+
+	/* The stack frame of the caller is gone when the callee runs. */
+	ir_type *const mtp       = get_entity_type(get_irg_entity(irg));
+	bool           has_alloc = false;
+	irg_walk_graph(irg, NULL, check_alloc, &has_alloc);
+	if (has_alloc || is_method_variadic(mtp) || has_compound_values(mtp)
+	 || !check_lifetime_of_locals(irg))
+		goto end;
+
+	ir_node *const end_block = get_irg_end_block(irg);
+	for (int i = get_Block_n_cfgpreds(end_block); i-- > 0; ) {
+		ir_node *const ret = get_Block_cfgpred(end_block, i);
+		if (!is_Return(ret))
+			continue;
+
+		/* the Call must be the last operation before the Return */
+		ir_node *const mem = get_Return_mem(ret);
+		if (!is_Proj(mem))
+			continue;
+		ir_node *const call = get_Proj_pred(mem);
+		if (!is_Call(call) || get_nodes_block(call) != get_nodes_block(ret)
+		 || ir_throws_exception(call))
+			continue;
+
+		ir_type *const call_type = get_Call_type(call);
+		if (has_compound_values(call_type)
+		 || (get_method_additional_properties(call_type)
+		     & mtp_property_returns_twice)
+		 || !returns_call_results(ret, call, mtp))
+			continue;
+
+		DB((dbg, LEVEL_2, "  %+F is a tail call\n", call));
+		set_Call_tail_call(call, true);
+	}
+
+end:
+	confirm_irg_properties(irg, IR_GRAPH_PROPERTIES_ALL);
+}
@@ -292,6 +292,8 @@ class Call(Node):
     attrs = [
         Attribute("type", type="ir_type*",
                   comment="type of the call (usually type of the called procedure)"),
+        Attribute("tail_call", type="int", init="0",
+                  comment="whether the Call may be executed as a tail call reusing the stack frame of the calling function"),
     ]
     attr_struct = "call_attr"
     pinned = "exception"
@@ -0,0 +1,186 @@
+#include "firm.h"
+#include <assert.h>
+#include <stdbool.h>
+
+/*
+ * Test for the control flow edge helpers, which update the analysis
+ * information instead of invalidating it:
+ *
+ *   void f(int c)
+ *   {
+ *       if (c) {
+ *           then1: ;
+ *           then2: ;
+ *       } else {
+ *           other: ;
+ *       }
+ *       merge: ;
+ *       tail:  ;
+ *   }
+ *
+ * Removing and restoring the edge from then2 to merge has to give the same
+ * dominator tree as recomputing it.
+ *
+ *   void g(int n)
+ *   {
+ *       for (int i = 0; i < n; ++i) {}
+ *   }
+ *
+ * Splitting the back edge has to keep the loop information, the new block
+ * belongs to the loop.
+ */
+
+static ir_graph *new_graph(char const *const name, ir_type *const type_int,
+                           int const n_loc)
+{
+	ir_type *const mtp = new_type_method(1, 0, false, cc_cdecl_set,
+	                                     mtp_no_property);
+	set_method_param_type(mtp, 0, type_int);
+	ir_entity *const ent = new_global_entity(get_glob_type(),
+	                                         new_id_from_str(name), mtp,
+	                                         ir_visibility_external,
+	                                         IR_LINKAGE_DEFAULT);
+	ir_graph  *const irg = new_ir_graph(ent, n_loc);
+	set_current_ir_graph(irg);
+	return irg;
+}
+
+static void finish_graph(ir_graph *const irg)
+{
+	ir_node *const ret = new_Return(get_store(), 0, NULL);
+	add_immBlock_pred(get_irg_end_block(irg), ret);
+	irg_finalize_cons(irg);
+}
+
+static ir_node *new_block(ir_node *const pred)
+{
+	ir_node *const block = new_immBlock();
+	add_immBlock_pred(block, pred);
+	mature_immBlock(block);
+	set_cur_block(block);
+	return block;
+}
+
+#define MAX_BLOCKS 8
+#define N_BLOCKS(blocks) (sizeof(blocks) / sizeof(*(blocks)))
+
+/** Checks dominance by walking up the dominator tree. */
+static bool walk_dominates(ir_node const *const dom, ir_node const *block)
+{
+	for (; block != NULL; block = get_Block_idom(block)) {
+		if (block == dom)
+			return true;
+	}
+	return false;
+}
+
+/** Checks the dominator tree of @p blocks against a recomputed one. */
+static void check_doms(ir_graph *const irg, ir_node *const *const blocks,
+                       size_t const n_blocks)
+{
+	assert(irg_has_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE));
+	assert(n_blocks <= MAX_BLOCKS);
+	ir_node *idoms[MAX_BLOCKS];
+	for (size_t i = 0; i < n_blocks; ++i) {
+		idoms[i] = get_Block_idom(blocks[i]);
+		for (size_t j = 0; j < n_blocks; ++j) {
+			assert(block_dominates(blocks[i], blocks[j])
+			       == walk_dominates(blocks[i], blocks[j]));
+		}
+	}
+	clear_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE);
+	assure_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE);
+	for (size_t i = 0; i < n_blocks; ++i)
+		assert(get_Block_idom(blocks[i]) == idoms[i]);
+}
+
+static void test_replace(ir_type *const type_int)
+{
+	ir_graph *const irg  = new_graph("f", type_int, 0);
+	ir_node  *const c    = new_Proj(get_irg_args(irg), mode_Is, 0);
+	ir_node  *const cmp  = new_Cmp(c, new_Const_long(mode_Is, 0),
+	                               ir_relation_less_greater);
+	ir_node  *const cond = new_Cond(cmp);
+	ir_node  *const head = get_cur_block();
+
+	ir_node  *const then1 = new_block(new_Proj(cond, mode_X, pn_Cond_true));
+	ir_node  *const then2 = new_block(new_Jmp());
+	ir_node  *const jmp   = new_Jmp();
+	ir_node  *const other = new_block(new_Proj(cond, mode_X, pn_Cond_false));
+	ir_node  *const merge = new_immBlock();
+	add_immBlock_pred(merge, jmp);
+	add_immBlock_pred(merge, new_Jmp());
+	mature_immBlock(merge);
+	set_cur_block(merge);
+	ir_node  *const tail  = new_block(new_Jmp());
+	finish_graph(irg);
+
+	assure_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES
+	                         | IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE);
+	ir_node *const blocks[] = { head, then1, then2, other, merge, tail };
+	assert(get_Block_idom(merge) == head);
+
+	/* merge is only reachable over other, then2 has to stay alive */
+	keep_alive(then2);
+	replace_cf_edge(merge, 0, new_r_Bad(irg, mode_X));
+	assert(get_Block_idom(merge) == other);
+	check_doms(irg, blocks, N_BLOCKS(blocks));
+
+	replace_cf_edge(merge, 0, jmp);
+	assert(get_Block_idom(merge) == head);
+	check_doms(irg, blocks, N_BLOCKS(blocks));
+}
+
+static void test_split(ir_type *const type_int)
+{
+	ir_graph *const irg = new_graph("g", type_int, 1);
+	ir_node  *const n   = new_Proj(get_irg_args(irg), mode_Is, 0);
+	set_value(0, new_Const_long(mode_Is, 0));
+	ir_node  *const entry = new_Jmp();
+
+	ir_node  *const header = new_immBlock();
+	add_immBlock_pred(header, entry);
+	set_cur_block(header);
+	ir_node  *const cmp  = new_Cmp(get_value(0, mode_Is), n, ir_relation_less);
+	ir_node  *const cond = new_Cond(cmp);
+
+	ir_node  *const body = new_block(new_Proj(cond, mode_X, pn_Cond_true));
+	set_value(0, new_Add(get_value(0, mode_Is), new_Const_long(mode_Is, 1)));
+	add_immBlock_pred(header, new_Jmp());
+	mature_immBlock(header);
+
+	new_block(new_Proj(cond, mode_X, pn_Cond_false));
+	finish_graph(irg);
+
+	assure_irg_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_OUT_EDGES
+	                         | IR_GRAPH_PROPERTY_CONSISTENT_DOMINANCE
+	                         | IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO);
+	ir_loop *const loop = get_irn_loop(body);
+	assert(loop != get_irg_loop(irg));
+
+	int pos = -1;
+	for (int i = 0, n_preds = get_Block_n_cfgpreds(header); i < n_preds; ++i) {
+		if (get_Block_cfgpred_block(header, i) == body)
+			pos = i;
+	}
+	assert(pos >= 0);
+	ir_node *const split = split_cf_edge(header, pos);
+	assert(irg_has_properties(irg, IR_GRAPH_PROPERTY_CONSISTENT_LOOPINFO));
+	assert(get_irn_loop(split) == loop);
+	assert(get_Block_idom(split) == body);
+
+	ir_node *const blocks[] = { header, body, split };
+	check_doms(irg, blocks, N_BLOCKS(blocks));
+}
+
+int main(void)
+{
+	ir_init();
+
+	ir_type *const type_int = get_type_for_mode(mode_Is);
+	test_replace(type_int);
+	test_split(type_int);
+
+	ir_finish();
+	return 0;
+}
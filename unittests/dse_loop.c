@@ -0,0 +1,167 @@
+#include "firm.h"
+#include <assert.h>
+#include <stdbool.h>
+
+/*
+ * Regression test for dead store elimination across loops:
+ *
+ *   void f(int *p, int n)
+ *   {
+ *       for (int i = 0; i < n; ++i) {
+ *           *p = i;
+ *           p += 4;
+ *       }
+ *       *p = 0;
+ *   }
+ *
+ * Both Stores use the Phi of p, but the Store after the loop writes another
+ * address than the Store of the last iteration, which must be kept.
+ *
+ *   void g(int *p, int *q, int c)
+ *   {
+ *       *p = 1;
+ *       if (c)
+ *           *q = 2;
+ *       *p = 3;
+ *   }
+ *
+ * Outside of loops the first Store is still overwritten across the merge.
+ */
+
+static void count_stores(ir_node *const node, void *const env)
+{
+	unsigned *const n_stores = (unsigned*)env;
+	if (is_Store(node))
+		++*n_stores;
+}
+
+static unsigned get_n_stores(ir_graph *const irg)
+{
+	unsigned n_stores = 0;
+	irg_walk_graph(irg, NULL, count_stores, &n_stores);
+	return n_stores;
+}
+
+static ir_graph *new_graph(char const *const name, ir_type *const mtp,
+                           int const n_loc)
+{
+	ir_entity *const ent = new_global_entity(get_glob_type(),
+	                                         new_id_from_str(name), mtp,
+	                                         ir_visibility_external,
+	                                         IR_LINKAGE_DEFAULT);
+	ir_graph  *const irg = new_ir_graph(ent, n_loc);
+	set_current_ir_graph(irg);
+	return irg;
+}
+
+static void finish_graph(ir_graph *const irg, ir_node *const mem)
+{
+	ir_node *const ret = new_Return(mem, 0, NULL);
+	add_immBlock_pred(get_irg_end_block(irg), ret);
+	irg_finalize_cons(irg);
+}
+
+static ir_graph *build_loop(ir_type *const type_int, ir_type *const type_ptr)
+{
+	ir_type *const mtp = new_type_method(2, 0, false, cc_cdecl_set,
+	                                     mtp_no_property);
+	set_method_param_type(mtp, 0, type_ptr);
+	set_method_param_type(mtp, 1, type_int);
+	ir_graph *const irg = new_graph("f", mtp, 2);
+
+	ir_node *const args = get_irg_args(irg);
+	ir_node *const n    = new_Proj(args, mode_Is, 1);
+	set_value(0, new_Proj(args, mode_P, 0));
+	set_value(1, new_Const_long(mode_Is, 0));
+	ir_node *const entry = new_Jmp();
+
+	ir_node *const header = new_immBlock();
+	add_immBlock_pred(header, entry);
+	set_cur_block(header);
+	ir_node *const cmp  = new_Cmp(get_value(1, mode_Is), n, ir_relation_less);
+	ir_node *const cond = new_Cond(cmp);
+
+	ir_node *const body = new_immBlock();
+	add_immBlock_pred(body, new_Proj(cond, mode_X, pn_Cond_true));
+	mature_immBlock(body);
+	set_cur_block(body);
+	ir_node *const p     = get_value(0, mode_P);
+	ir_node *const i     = get_value(1, mode_Is);
+	ir_node *const store = new_Store(get_store(), p, i, type_int, cons_none);
+	set_store(new_Proj(store, mode_M, pn_Store_M));
+	ir_mode *const mode_offset = get_reference_offset_mode(mode_P);
+	set_value(0, new_Add(p, new_Const_long(mode_offset, 16)));
+	set_value(1, new_Add(i, new_Const_long(mode_Is, 1)));
+	add_immBlock_pred(header, new_Jmp());
+	mature_immBlock(header);
+
+	ir_node *const exit = new_immBlock();
+	add_immBlock_pred(exit, new_Proj(cond, mode_X, pn_Cond_false));
+	mature_immBlock(exit);
+	set_cur_block(exit);
+	ir_node *const last = new_Store(get_store(), get_value(0, mode_P),
+	                                new_Const_long(mode_Is, 0), type_int,
+	                                cons_none);
+	finish_graph(irg, new_Proj(last, mode_M, pn_Store_M));
+	return irg;
+}
+
+static ir_graph *build_branch(ir_type *const type_int, ir_type *const type_ptr)
+{
+	ir_type *const mtp = new_type_method(3, 0, false, cc_cdecl_set,
+	                                     mtp_no_property);
+	set_method_param_type(mtp, 0, type_ptr);
+	set_method_param_type(mtp, 1, type_ptr);
+	set_method_param_type(mtp, 2, type_int);
+	ir_graph *const irg = new_graph("g", mtp, 0);
+
+	ir_node *const args  = get_irg_args(irg);
+	ir_node *const p     = new_Proj(args, mode_P, 0);
+	ir_node *const q     = new_Proj(args, mode_P, 1);
+	ir_node *const c     = new_Proj(args, mode_Is, 2);
+	ir_node *const first = new_Store(get_store(), p, new_Const_long(mode_Is, 1),
+	                                 type_int, cons_none);
+	set_store(new_Proj(first, mode_M, pn_Store_M));
+	ir_node *const cmp   = new_Cmp(c, new_Const_long(mode_Is, 0),
+	                               ir_relation_less_greater);
+	ir_node *const cond  = new_Cond(cmp);
+
+	ir_node *const then  = new_immBlock();
+	add_immBlock_pred(then, new_Proj(cond, mode_X, pn_Cond_true));
+	mature_immBlock(then);
+	set_cur_block(then);
+	ir_node *const store_q = new_Store(get_store(), q,
+	                                   new_Const_long(mode_Is, 2), type_int,
+	                                   cons_none);
+	set_store(new_Proj(store_q, mode_M, pn_Store_M));
+	ir_node *const jmp   = new_Jmp();
+
+	ir_node *const merge = new_immBlock();
+	add_immBlock_pred(merge, new_Proj(cond, mode_X, pn_Cond_false));
+	add_immBlock_pred(merge, jmp);
+	mature_immBlock(merge);
+	set_cur_block(merge);
+	ir_node *const last  = new_Store(get_store(), p, new_Const_long(mode_Is, 3),
+	                                 type_int, cons_none);
+	finish_graph(irg, new_Proj(last, mode_M, pn_Store_M));
+	return irg;
+}
+
+int main(void)
+{
+	ir_init();
+
+	ir_type *const type_int = get_type_for_mode(mode_Is);
+	ir_type *const type_ptr = new_type_pointer(type_int);
+
+	ir_graph *const loop = build_loop(type_int, type_ptr);
+	optimize_load_store(loop);
+	assert(get_n_stores(loop) == 2);
+
+	ir_graph *const branch = build_branch(type_int, type_ptr);
+	optimize_load_store(branch);
+	assert(get_n_stores(branch) == 2);
+
+	ir_finish();
+	return 0;
+}
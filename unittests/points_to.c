@@ -0,0 +1,142 @@
+#include "firm.h"
+#include <assert.h>
+#include <stdbool.h>
+
+/*
+ * Test for the points-to analysis and its use by the mod/ref summaries:
+ *
+ *   static int a, b;
+ *   static int *gp = &a;
+ *   extern void use(int *p);
+ *   static void store(int *p) { *p = b; }
+ *   static void set_gp(void) { *gp = 2; }
+ *   void entry(void) { store(&a); set_gp(); use(&b); }
+ *
+ * The parameter p of store() only points to a and set_gp() only writes a,
+ * although the address of b is taken as well.
+ */
+
+static ir_type *type_int;
+static ir_type *type_ptr;
+
+static ir_entity *new_method(char const *const name, ir_type *const mtp,
+                             ir_visibility const visibility)
+{
+	return new_global_entity(get_glob_type(), new_id_from_str(name), mtp,
+	                         visibility, IR_LINKAGE_DEFAULT);
+}
+
+static ir_entity *new_variable(char const *const name, ir_type *const type)
+{
+	return new_global_entity(get_glob_type(), new_id_from_str(name), type,
+	                         ir_visibility_local, IR_LINKAGE_DEFAULT);
+}
+
+static void finish_graph(ir_graph *const irg)
+{
+	ir_node *const ret = new_Return(get_store(), 0, NULL);
+	add_immBlock_pred(get_irg_end_block(irg), ret);
+	mature_immBlock(get_r_cur_block(irg));
+	irg_finalize_cons(irg);
+}
+
+/** Builds store(), returns the Store. */
+static ir_node *build_store(ir_entity *const ent, ir_entity *const b)
+{
+	ir_graph *const irg = new_ir_graph(ent, 0);
+	set_current_ir_graph(irg);
+	ir_node *const p     = new_Proj(get_irg_args(irg), mode_P, 0);
+	ir_node *const load  = new_Load(get_store(), new_Address(b), mode_Is,
+	                                type_int, cons_none);
+	ir_node *const val   = new_Proj(load, mode_Is, pn_Load_res);
+	set_store(new_Proj(load, mode_M, pn_Load_M));
+	ir_node *const store = new_Store(get_store(), p, val, type_int, cons_none);
+	set_store(new_Proj(store, mode_M, pn_Store_M));
+	finish_graph(irg);
+	return store;
+}
+
+static void build_set_gp(ir_entity *const ent, ir_entity *const gp)
+{
+	ir_graph *const irg = new_ir_graph(ent, 0);
+	set_current_ir_graph(irg);
+	ir_node *const load  = new_Load(get_store(), new_Address(gp), mode_P,
+	                                type_ptr, cons_none);
+	ir_node *const ptr   = new_Proj(load, mode_P, pn_Load_res);
+	set_store(new_Proj(load, mode_M, pn_Load_M));
+	ir_node *const store = new_Store(get_store(), ptr,
+	                                 new_Const_long(mode_Is, 2), type_int,
+	                                 cons_none);
+	set_store(new_Proj(store, mode_M, pn_Store_M));
+	finish_graph(irg);
+}
+
+static ir_node *new_call(ir_entity *const callee, int const arity,
+                         ir_node *const *const in)
+{
+	ir_node *const call = new_Call(get_store(), new_Address(callee), arity, in,
+	                               get_entity_type(callee));
+	set_store(new_Proj(call, mode_M, pn_Call_M));
+	return call;
+}
+
+int main(void)
+{
+	ir_init();
+	type_int = get_type_for_mode(mode_Is);
+	type_ptr = new_type_pointer(type_int);
+
+	ir_entity *const a  = new_variable("a", type_int);
+	ir_entity *const b  = new_variable("b", type_int);
+	ir_entity *const gp = new_variable("gp", type_ptr);
+	ir_node   *const ga = new_r_Address(get_const_code_irg(), a);
+	set_entity_initializer(gp, create_initializer_const(ga));
+
+	ir_type *const mtp_void = new_type_method(0, 0, false, cc_cdecl_set,
+	                                          mtp_no_property);
+	ir_type *const mtp_ptr  = new_type_method(1, 0, false, cc_cdecl_set,
+	                                          mtp_no_property);
+	set_method_param_type(mtp_ptr, 0, type_ptr);
+	ir_entity *const use    = new_method("use", mtp_ptr, ir_visibility_external);
+	ir_entity *const store  = new_method("store", mtp_ptr, ir_visibility_local);
+	ir_entity *const set_gp = new_method("set_gp", mtp_void, ir_visibility_local);
+	ir_entity *const entry  = new_method("entry", mtp_void,
+	                                     ir_visibility_external);
+
+	ir_node *const st = build_store(store, b);
+	build_set_gp(set_gp, gp);
+
+	ir_graph *const irg = new_ir_graph(entry, 0);
+	set_current_ir_graph(irg);
+	ir_node *const addr_a = new_Address(a);
+	ir_node *const addr_b = new_Address(b);
+	new_call(store, 1, &addr_a);
+	ir_node *const call = new_call(set_gp, 0, NULL);
+	new_call(use, 1, &addr_b);
+	finish_graph(irg);
+
+	/* the address of b in store() */
+	ir_node *const p      = get_Store_ptr(st);
+	ir_node *const load_b = get_Proj_pred(get_Store_value(st));
+	ir_node *const st_b   = get_Load_ptr(load_b);
+
+	assure_irp_globals_entity_usage_computed();
+	assert(get_alias_relation(p, type_int, 4, st_b, type_int, 4)
+	       == ir_may_alias);
+
+	compute_irp_points_to(ir_points_to_andersen);
+	assert(get_alias_relation(p, type_int, 4, st_b, type_int, 4)
+	       == ir_no_alias);
+	compute_irp_points_to(ir_points_to_steensgaard);
+	assert(get_alias_relation(p, type_int, 4, st_b, type_int, 4)
+	       == ir_no_alias);
+
+	/* the summaries compute the points-to information themselves */
+	free_irp_points_to();
+	compute_irp_mod_ref();
+	assert(get_call_mod_ref(call, addr_a) == ir_mod_ref_mod);
+	assert(get_call_mod_ref(call, addr_b) == ir_mod_ref_none);
+
+	ir_finish();
+	return 0;
+}
@@ -0,0 +1,159 @@
+#include "firm.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*
+ * Test for the normal scheduler on huge basic blocks, like in machine
+ * generated table initialisers and state machines.  The backend verifier
+ * checks that the schedules are valid topological orders and every selection
+ * is compared with the original linear scan of the precomputed order.
+ *
+ * Pass a block size as argument to use it as benchmark instead: the check is
+ * disabled then and the time of each backend phase is printed.
+ */
+
+/**
+ * Builds void huge_block(int *dst, int const *src, int x) with n independent
+ * dst[i] = src[i] * x + i in a single block.
+ */
+static ir_graph *build_huge_block(unsigned const n)
+{
+	ir_type *const type_int = get_type_for_mode(mode_Is);
+	ir_type *const type_ptr = new_type_pointer(type_int);
+	ir_type *const mtp      = new_type_method(3, 0, false, cc_cdecl_set,
+	                                          mtp_no_property);
+	set_method_param_type(mtp, 0, type_ptr);
+	set_method_param_type(mtp, 1, type_ptr);
+	set_method_param_type(mtp, 2, type_int);
+
+	ident     *const id  = new_id_from_str("huge_block");
+	ir_entity *const ent = new_global_entity(get_glob_type(), id, mtp,
+	                                         ir_visibility_external,
+	                                         IR_LINKAGE_DEFAULT);
+	ir_graph  *const irg = new_ir_graph(ent, 0);
+	set_current_ir_graph(irg);
+
+	ir_mode *const mode_offset = get_reference_offset_mode(mode_P);
+	ir_node *const args        = get_irg_args(irg);
+	ir_node *const dst         = new_Proj(args, mode_P, 0);
+	ir_node *const src         = new_Proj(args, mode_P, 1);
+	ir_node *const x           = new_Proj(args, mode_Is, 2);
+	ir_node *const init_mem    = get_store();
+
+	ir_node *mem = init_mem;
+	for (unsigned i = 0; i < n; ++i) {
+		ir_node *const offset = new_Const_long(mode_offset, (long)i * 4);
+		ir_node *const src_i  = new_Add(src, offset);
+		ir_node *const load   = new_Load(init_mem, src_i, mode_Is, type_int,
+		                                 cons_none);
+		ir_node *const val    = new_Proj(load, mode_Is, pn_Load_res);
+		ir_node *const c      = new_Const_long(mode_Is, (long)i);
+		ir_node *const res    = new_Add(new_Mul(val, x), c);
+		ir_node *const dst_i  = new_Add(dst, offset);
+		ir_node *const store  = new_Store(mem, dst_i, res, type_int,
+		                                  cons_none);
+		mem = new_Proj(store, mode_M, pn_Store_M);
+	}
+	ir_node *const ret = new_Return(mem, 0, NULL);
+	add_immBlock_pred(get_irg_end_block(irg), ret);
+	mature_immBlock(get_r_cur_block(irg));
+	irg_finalize_cons(irg);
+	return irg;
+}
+
+/**
+ * Builds void huge_loop(int *src, int x) with a single block loop updating n
+ * state variables s[i] = s[i] * x + src[i], which makes the scheduler see n
+ * Phis in the block.
+ */
+static ir_graph *build_huge_loop(unsigned const n)
+{
+	ir_type *const type_int = get_type_for_mode(mode_Is);
+	ir_type *const type_ptr = new_type_pointer(type_int);
+	ir_type *const mtp      = new_type_method(2, 0, false, cc_cdecl_set,
+	                                          mtp_no_property);
+	set_method_param_type(mtp, 0, type_ptr);
+	set_method_param_type(mtp, 1, type_int);
+
+	ident     *const id  = new_id_from_str("huge_loop");
+	ir_entity *const ent = new_global_entity(get_glob_type(), id, mtp,
+	                                         ir_visibility_external,
+	                                         IR_LINKAGE_DEFAULT);
+	ir_graph  *const irg = new_ir_graph(ent, n + 1);
+	set_current_ir_graph(irg);
+
+	ir_mode *const mode_offset = get_reference_offset_mode(mode_P);
+	ir_node *const args        = get_irg_args(irg);
+	ir_node *const src         = new_Proj(args, mode_P, 0);
+	ir_node *const x           = new_Proj(args, mode_Is, 1);
+	for (unsigned i = 0; i <= n; ++i)
+		set_value(i, new_Const_long(mode_Is, (long)i));
+	ir_node *const jmp = new_Jmp();
+
+	ir_node *const loop = new_immBlock();
+	add_immBlock_pred(loop, jmp);
+	set_cur_block(loop);
+	ir_node *const mem = get_store();
+	for (unsigned i = 0; i < n; ++i) {
+		ir_node *const offset = new_Const_long(mode_offset, (long)i * 4);
+		ir_node *const load   = new_Load(mem, new_Add(src, offset), mode_Is,
+		                                 type_int, cons_none);
+		ir_node *const val    = new_Proj(load, mode_Is, pn_Load_res);
+		set_value(i, new_Add(new_Mul(get_value(i, mode_Is), x), val));
+	}
+	ir_node *const cnt  = new_Add(get_value(n, mode_Is), new_Const_long(mode_Is, 1));
+	set_value(n, cnt);
+	ir_node *const cmp  = new_Cmp(cnt, x, ir_relation_less);
+	ir_node *const cond = new_Cond(cmp);
+	add_immBlock_pred(loop, new_Proj(cond, mode_X, pn_Cond_true));
+	mature_immBlock(loop);
+
+	ir_node *const exit = new_immBlock();
+	add_immBlock_pred(exit, new_Proj(cond, mode_X, pn_Cond_false));
+	mature_immBlock(exit);
+	set_cur_block(exit);
+	ir_node *sum = get_value(n, mode_Is);
+	for (unsigned i = 0; i < n; ++i)
+		sum = new_Eor(sum, get_value(i, mode_Is));
+	ir_node *const store = new_Store(get_store(), src, sum, type_int, cons_none);
+	ir_node *const ret = new_Return(new_Proj(store, mode_M, pn_Store_M), 0, NULL);
+	add_immBlock_pred(get_irg_end_block(irg), ret);
+	irg_finalize_cons(irg);
+	return irg;
+}
+
+int main(int argc, char **argv)
+{
+	bool     const benchmark = argc > 1;
+	unsigned const n         = benchmark ? (unsigned)atoi(argv[1]) : 400;
+
+	ir_init();
+	if (!ir_target_set("i686-linux-gnu"))
+		return 1;
+	if (!ir_target_option("scheduler=normal") || !ir_target_option("verify"))
+		return 1;
+	/* print the time spent in each backend phase or check the selection */
+	if (!ir_target_option(benchmark ? "time" : "normalsched-check"))
+		return 1;
+	ir_target_init();
+
+	build_huge_block(n);
+	build_huge_loop(n / 4);
+
+	FILE *const out = tmpfile();
+	if (out == NULL)
+		return 1;
+	clock_t const start = clock();
+	be_lower_for_target();
+	be_main(out, "sched_huge_block");
+	clock_t const end = clock();
+	fclose(out);
+
+	if (benchmark) {
+		printf("huge blocks of size %u: %.2fs\n", n,
+		       (double)(end - start) / CLOCKS_PER_SEC);
+	}
+	return 0;
+}